@@ -65,6 +65,112 @@ JS4D::StringRef JS4D::VStringToString( const VString& inString)
 	return jsString;
 }
 
+
+static const char *sPropertyNames[JS4D::ePropertyName_Count] =
+{
+	"Date",
+	"getDate",
+	"getMonth",
+	"getYear",
+	"getTime",
+	"length",
+	"splice",
+	"toJSON"
+};
+
+// JSStringRef are immutable, thread safe and not bound to a context group: all runtimes can share them.
+static JSStringRef sPropertyNameStrings[JS4D::ePropertyName_Count];
+
+
+JS4D::StringRef JS4D::GetPropertyName( EPropertyName inName)
+{
+	xbox_assert( (inName >= 0) && (inName < ePropertyName_Count));
+
+	JSStringRef jsString = sPropertyNameStrings[inName];
+	if (jsString == NULL)
+	{
+		jsString = JSStringCreateWithUTF8CString( sPropertyNames[inName]);
+		JSStringRef previous = (JSStringRef) VInterlocked::CompareExchangePtr( (void**) &sPropertyNameStrings[inName], NULL, jsString);
+		if (previous != NULL)
+		{
+			// another task was faster
+			JSStringRelease( jsString);
+			jsString = previous;
+		}
+	}
+	return jsString;
+}
+
+
+/*
+	Strings made by VStringToPropertyName for the current task, indexed by their hash value.
+	A slot keeps the last string that fell into it.
+*/
+class VJSPropertyNameCache
+{
+public:
+	enum { kSlotCount = 256, kMaxLength = 64 };
+
+								VJSPropertyNameCache()		{ ::memset( fSlots, 0, sizeof( fSlots));}
+								~VJSPropertyNameCache()
+								{
+									for( sLONG i = 0 ; i < kSlotCount ; ++i)
+									{
+										if (fSlots[i] != NULL)
+											JSStringRelease( fSlots[i]);
+									}
+								}
+
+			JSStringRef			fSlots[kSlotCount];
+};
+
+static VTaskDataKey		sPropertyNameCacheKey = 0;
+static VCriticalSection	sPropertyNameCacheMutex;
+
+
+static void _DisposePropertyNameCache( void *inData)
+{
+	delete (VJSPropertyNameCache*) inData;
+}
+
+
+JS4D::StringRef JS4D::VStringToPropertyName( const VString& inName)
+{
+	VIndex length = inName.GetLength();
+	if ( (length > VJSPropertyNameCache::kMaxLength) || (VTask::GetCurrent() == NULL) )
+		return VStringToString( inName);
+
+	if (sPropertyNameCacheKey == 0)
+	{
+		StLocker<VCriticalSection> lock( &sPropertyNameCacheMutex);
+		if (sPropertyNameCacheKey == 0)
+			sPropertyNameCacheKey = VTask::CreateDataKey( _DisposePropertyNameCache);
+	}
+
+	VJSPropertyNameCache *cache = (VJSPropertyNameCache*) VTask::GetCurrentData( sPropertyNameCacheKey);
+	if (cache == NULL)
+	{
+		cache = new VJSPropertyNameCache;
+		VTask::SetCurrentData( sPropertyNameCacheKey, cache);
+	}
+
+	JSStringRef& slot = cache->fSlots[inName.GetHashValue() % VJSPropertyNameCache::kSlotCount];
+	if ( (slot != NULL) && (JSStringGetLength( slot) == (size_t) length)
+		&& (::memcmp( JSStringGetCharactersPtr( slot), inName.GetCPointer(), length * sizeof( UniChar)) == 0) )
+	{
+		return JSStringRetain( slot);
+	}
+
+	JSStringRef jsString = VStringToString( inName);
+	if (jsString != NULL)
+	{
+		if (slot != NULL)
+			JSStringRelease( slot);
+		slot = JSStringRetain( jsString);
+	}
+	return jsString;
+}
+
 #endif
 
 bool JS4D::StringToVString( StringRef inJSString, VString& outString)
@@ -409,9 +515,7 @@ JS4D::ObjectRef JS4D::VTimeToObject(ContextRef inContext, const VTime& inTime, E
 		JSValueRef	args[1];
 		JSStringRef jsarg = JS4D::VStringToString(s);
 		args[0] = JSValueMakeString(inContext, jsarg);
-		JSStringRef jsClassName = JSStringCreateWithUTF8CString("Date");
-		JSObjectRef constructor = JSValueToObject(inContext, JSObjectGetProperty(inContext, JSContextGetGlobalObject(inContext), jsClassName, NULL), NULL);
-		JSStringRelease(jsClassName);
+		JSObjectRef constructor = JSValueToObject(inContext, JSObjectGetProperty(inContext, JSContextGetGlobalObject(inContext), GetPropertyName( ePropertyName_Date), NULL), NULL);
 		date = JSObjectCallAsConstructor(inContext, constructor, 1, args, outException);
 		JSStringRelease(jsarg);
 	}
@@ -431,9 +535,7 @@ JS4D::ObjectRef JS4D::VTimeToObject(ContextRef inContext, const VTime& inTime, E
 #if NEW_WEBKIT
 		date = JSObjectMakeDate( inContext, 7, args, outException);
 #else
-		JSStringRef jsClassName = JSStringCreateWithUTF8CString("Date");
-		JSObjectRef constructor = JSValueToObject(inContext, JSObjectGetProperty(inContext, JSContextGetGlobalObject(inContext), jsClassName, NULL), NULL);
-		JSStringRelease(jsClassName);
+		JSObjectRef constructor = JSValueToObject(inContext, JSObjectGetProperty(inContext, JSContextGetGlobalObject(inContext), GetPropertyName( ePropertyName_Date), NULL), NULL);
 		date = JSObjectCallAsConstructor(inContext, constructor, 7, args, outException);
 #endif
 	}
@@ -566,19 +668,13 @@ bool JS4D::DateObjectToVTime( ContextRef inContext, ObjectRef inObject, VTime& o
 
 	if (simpleDate)
 	{
-		JSStringRef jsStringGetDate = JSStringCreateWithUTF8CString( "getDate");
-		JSStringRef jsStringGetMonth = JSStringCreateWithUTF8CString( "getMonth");
-		JSStringRef jsStringGetYear = JSStringCreateWithUTF8CString( "getYear");
-		JSValueRef getDate = JSObjectGetProperty( inContext, inObject, jsStringGetDate, outException);
-		JSValueRef getMonth = JSObjectGetProperty( inContext, inObject, jsStringGetMonth, outException);
-		JSValueRef getYear = JSObjectGetProperty( inContext, inObject, jsStringGetYear, outException);
+		JSValueRef getDate = JSObjectGetProperty( inContext, inObject, GetPropertyName( ePropertyName_getDate), outException);
+		JSValueRef getMonth = JSObjectGetProperty( inContext, inObject, GetPropertyName( ePropertyName_getMonth), outException);
+		JSValueRef getYear = JSObjectGetProperty( inContext, inObject, GetPropertyName( ePropertyName_getYear), outException);
 
 		JSValueRef day =  JS4DObjectCallAsFunction( inContext, JSValueToObject( inContext, getDate, outException), inObject, 0, NULL, outException);
 		JSValueRef month =  JSObjectCallAsFunction( inContext, JSValueToObject( inContext, getMonth, outException), inObject, 0, NULL, outException);
 		JSValueRef year =  JSObjectCallAsFunction( inContext, JSValueToObject( inContext, getYear, outException), inObject, 0, NULL, outException);
-		JSStringRelease( jsStringGetDate);
-		JSStringRelease( jsStringGetMonth);
-		JSStringRelease( jsStringGetYear);
 
 		ok = true;
 		outTime.FromUTCTime(JSValueToNumber( inContext, year, outException)+1900, JSValueToNumber( inContext, month, outException)+1, JSValueToNumber( inContext, day, outException), 0, 0, 0, 0);
@@ -587,10 +683,8 @@ bool JS4D::DateObjectToVTime( ContextRef inContext, ObjectRef inObject, VTime& o
 	}
 	else
 	{
-		JSStringRef jsString = JSStringCreateWithUTF8CString( "getTime");
-		JSValueRef getTime = JSObjectGetProperty( inContext, inObject, jsString, outException);
+		JSValueRef getTime = JSObjectGetProperty( inContext, inObject, GetPropertyName( ePropertyName_getTime), outException);
 		JSObjectRef getTimeFunction = JSValueToObject( inContext, getTime, outException);
-		JSStringRelease( jsString);
 		JSValueRef result = (getTime != NULL) ? JS4DObjectCallAsFunction( inContext, getTimeFunction, inObject, 0, NULL, outException) : NULL;
 		if (result != NULL)
 		{
@@ -1474,7 +1568,7 @@ void JS4D::_VJSONValueToValue(VJSValue& ioValue, const VJSONValue& inValue, JS4D
 						for( VJSONPropertyConstOrderedIterator i( inValue.GetObject()) ; i.IsValid() && (exception == NULL) ; ++i)
 						{
 							const VString& name = i.GetName();
-							JSStringRef jsName = JSStringCreateWithCharacters( name.GetCPointer(), name.GetLength());
+							JSStringRef jsName = JS4D::VStringToPropertyName( name);
 
 							VJSValue	tmpVal(ioValue.fContext);
 							_VJSONValueToValue(tmpVal, i.GetValue(), &exception, ioConvertedObjects);
@@ -1619,12 +1713,9 @@ static bool _ValueToVJSONValue( JS4D::ContextRef inContext, JS4D::ValueRef inVal
 				{
 					// get count of array elements
 					JSObjectRef arrayObject = JSValueToObject( inContext, inValue, &exception);
-					JSStringRef jsString = JSStringCreateWithUTF8CString( "length");
-					JSValueRef result = (jsString != NULL) ? JSObjectGetProperty( inContext, arrayObject, jsString, &exception) : NULL;
+					JSValueRef result = JSObjectGetProperty( inContext, arrayObject, JS4D::GetPropertyName( JS4D::ePropertyName_length), &exception);
 					double r = (result != NULL) ? JSValueToNumber( inContext, result, NULL) : 0;
 					size_t length = (size_t) r;
-					if (jsString != NULL)
-						JSStringRelease( jsString);
 
 					VJSONArray *jsonArray = new VJSONArray;
 					if ( (jsonArray != NULL) && jsonArray->Resize( length) && (exception == NULL) )
@@ -1669,9 +1760,7 @@ static bool _ValueToVJSONValue( JS4D::ContextRef inContext, JS4D::ValueRef inVal
 					{
 						// if the object has a function property named 'toJSON', let's use it instead of collecting its properties
 						// this is so that native objects like Date() are properly interpreted.
-						JSStringRef jsFunctionName = JSStringCreateWithUTF8CString( "toJSON");
-						JSValueRef toJSONValue = JSObjectGetProperty( inContext, jsObject, jsFunctionName, &exception);
-						JSStringRelease( jsFunctionName);
+						JSValueRef toJSONValue = JSObjectGetProperty( inContext, jsObject, JS4D::GetPropertyName( JS4D::ePropertyName_toJSON), &exception);
 						JSObjectRef toJSONObject = ((toJSONValue != NULL) && JSValueIsObject( inContext, toJSONValue)) ? JSValueToObject( inContext, toJSONValue, &exception) : NULL;
 						if ( (toJSONObject != NULL) && JSObjectIsFunction( inContext, toJSONObject))
 						{
@@ -2190,7 +2279,7 @@ bool JS4D::ValueIsInstanceOf( ContextRef inContext, ValueRef inValue, const VStr
 	}
 	return false;
 #else
-	JSStringRef jsString = JS4D::VStringToString( inConstructorName);
+	JSStringRef jsString = JS4D::VStringToPropertyName( inConstructorName);
 	JSObjectRef globalObject = JSContextGetGlobalObject( inContext);
 	JSObjectRef constructor = JSValueToObject( inContext, JSObjectGetProperty( inContext, globalObject, jsString, outException), outException);
 	xbox_assert( constructor != NULL);
@@ -219,6 +219,26 @@ public:
 	static	bool					ValueToString(ContextRef inContext, ValueRef inValue, XBOX::VString& outString, ExceptionRef *outException = NULL);
 	static	StringRef				VStringToString( const XBOX::VString& inString);
 	static	bool					StringToVString( StringRef inJSString, XBOX::VString& outString);
+
+	// names used by the conversions. Their strings are created once and must not be released.
+	typedef enum
+	{
+		ePropertyName_Date = 0,
+		ePropertyName_getDate,
+		ePropertyName_getMonth,
+		ePropertyName_getYear,
+		ePropertyName_getTime,
+		ePropertyName_length,
+		ePropertyName_splice,
+		ePropertyName_toJSON,
+		ePropertyName_Count
+	} EPropertyName;
+
+	static	StringRef				GetPropertyName( EPropertyName inName);
+
+	// same as VStringToString but short strings like property names are shared through a small per task cache.
+	// the result must be released with JSStringRelease as well.
+	static	StringRef				VStringToPropertyName( const XBOX::VString& inName);
 #endif	
 	// various wakanda apis accepts accepts a file path or an url. This method centralizes the detection algorithm.
 	// returns true if the url is valid
@@ -37,22 +37,14 @@ using namespace v8;
 #include "VJSGlobalClass.h"
 #include "VJSJSON.h"
 #include "VJSModule.h"
+#include "VJSScriptCache.h"
 
 BEGIN_TOOLBOX_NAMESPACE
 
 
 static bool LoadScriptFile( VFile *inFile, VString& outScript)
 {
-	VFileStream stream( inFile);
-	VError err = stream.OpenReading();
-	if (err == VE_OK)
-	{
-		err = stream.GuessCharSetFromLeadingBytes( VTC_DefaultTextExport );		// sc 18/03/2011 instead of VTC_UTF_8
-		stream.SetCarriageReturnMode( eCRM_NATIVE );
-		if (err == VE_OK)
-			err = stream.GetText( outScript);
-	}
-	stream.CloseReading();
+	VError err = VJSScriptCache::Get()->LoadScript( *inFile, outScript);
 	return err == VE_OK;
 }
 
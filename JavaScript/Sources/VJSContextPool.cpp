@@ -0,0 +1,530 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VJavaScriptPrecompiled.h"
+
+#include "VJSContextPool.h"
+
+#include "VJSValue.h"
+#include "VJSClass.h"
+#include "VJSGlobalClass.h"
+#include "VJSWorker.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+
+// Key of the pool in the runtime delegate specifics.
+static const char	kPoolSignature[]	= "JSContextPool";
+
+
+// Property names only need a consistent order: compared as VJSScriptCache compares paths, case sensitive.
+typedef struct
+{
+	inline bool operator() ( const VString& inFirst, const VString& inSecond) const
+	{
+		VIndex length = (inFirst.GetLength() < inSecond.GetLength()) ? inFirst.GetLength() : inSecond.GetLength();
+		int result = ::memcmp( inFirst.GetCPointer(), inSecond.GetCPointer(), length * sizeof( UniChar));
+		return (result < 0) || ((result == 0) && (inFirst.GetLength() < inSecond.GetLength()));
+	}
+} _NameLess;
+
+
+// Sorted names of all own properties of inObject, given by the Object.getOwnPropertyNames() function of the context creation
+// (the global one may have been replaced). VJSObject::GetPropertyNames() is not enough: it skips the non enumerable ones,
+// as the built-ins or properties added with Object.defineProperty().
+static bool _GetOwnPropertyNames( const VJSObject& inGetOwnPropertyNames, const VJSObject& inObject, std::vector<VString>& outNames)
+{
+	outNames.clear();
+
+	std::vector<VJSValue> arguments;
+	arguments.push_back( inObject);
+
+	VJSValue result( inObject.GetContext());
+	VJSException exception;
+	if (!VJSObject( inObject).CallFunction( inGetOwnPropertyNames, &arguments, &result, exception) || !exception.IsEmpty() || !result.IsArray())
+		return false;
+
+	VJSArray names( result, false);
+	size_t count = names.GetLength();
+	outNames.reserve( count);
+	for( size_t i = 0 ; i < count ; ++i)
+	{
+		VString name;
+		if (!names.GetValueAt( i).GetString( name))
+			return false;
+		outNames.push_back( name);
+	}
+	std::sort( outNames.begin(), outNames.end(), _NameLess());
+
+	return true;
+}
+
+
+static bool _HasName( const std::vector<VString>& inSortedNames, const VString& inName)
+{
+	return std::binary_search( inSortedNames.begin(), inSortedNames.end(), inName, _NameLess());
+}
+
+
+static bool _IsSameNames( const std::vector<VString>& inSortedNames1, const std::vector<VString>& inSortedNames2)
+{
+	if (inSortedNames1.size() != inSortedNames2.size())
+		return false;
+
+	for( size_t i = 0 ; i < inSortedNames1.size() ; ++i)
+	{
+		if (!inSortedNames1[i].EqualToStringRaw( inSortedNames2[i]))
+			return false;
+	}
+	return true;
+}
+
+
+// Objects are compared by reference. Primitive values can't be modified but aren't always the same reference.
+static bool _IsSameValue( const VJSValue& inValue1, const VJSValue& inValue2)
+{
+	if (inValue1.IsObject() || inValue2.IsObject())
+		return inValue1.IsObject() && inValue2.IsObject() && (inValue1.GetObject() == inValue2.GetObject());
+
+	if (inValue1.IsUndefined() || inValue2.IsUndefined() || inValue1.IsNull() || inValue2.IsNull())
+		return (inValue1.IsUndefined() == inValue2.IsUndefined()) && (inValue1.IsNull() == inValue2.IsNull());
+
+	VString string1, string2;
+	return (inValue1.IsString() == inValue2.IsString()) && (inValue1.IsNumber() == inValue2.IsNumber()) && (inValue1.IsBoolean() == inValue2.IsBoolean())
+		&& inValue1.GetString( string1) && inValue2.GetString( string2) && string1.EqualToStringRaw( string2);
+}
+
+
+// False if the property can't be read or is computed anew at each read (some host objects), it's not checked then.
+static bool _GetStableProperty( const VJSObject& inObject, const VString& inName, VJSValue& outValue)
+{
+	VJSException exception;
+	outValue = inObject.GetProperty( inName, exception);
+	if (!exception.IsEmpty())
+		return false;
+
+	VJSValue secondValue( inObject.GetProperty( inName, exception));
+	return exception.IsEmpty() && _IsSameValue( outValue, secondValue);
+}
+
+
+VCriticalSection	VJSContextPool::sPoolsMutex;
+
+
+VJSContextPool::VJSContextPool( IJSRuntimeDelegate *inRuntimeDelegate, sLONG inMinimumIdleCount, sLONG inMaximumIdleCount, sLONG inMaximumUseCount)
+: fRuntimeDelegate( inRuntimeDelegate)
+, fMinimumIdleCount( inMinimumIdleCount)
+, fMaximumIdleCount( (inMaximumIdleCount < inMinimumIdleCount) ? inMinimumIdleCount : inMaximumIdleCount)
+, fMaximumUseCount( inMaximumUseCount)
+{
+	::memset( &fStatistics, 0, sizeof( fStatistics));
+}
+
+
+VJSContextPool::~VJSContextPool()
+{
+	// contexts still in use keep their own reference
+	xbox_assert( fStatistics.fInUseCount == 0);
+	VectorOfDisposedContext contexts;
+	for( MapOfContext::iterator i = fContexts.begin() ; i != fContexts.end() ; ++i)
+		contexts.push_back( DisposedContext( i->first, i->second.fKeptValues));
+	_DisposeContexts( contexts);
+}
+
+
+VJSContextPool *VJSContextPool::RetainPool( IJSRuntimeDelegate *inRuntimeDelegate)
+{
+	VJSContextPool *pool = NULL;
+	bool isNew = false;
+	{
+		StLocker<VCriticalSection> lock( &sPoolsMutex);
+
+		IRefCountable *specific = inRuntimeDelegate->RetainRuntimeSpecific( kPoolSignature);
+		pool = dynamic_cast<VJSContextPool*>( specific);
+		if (pool == NULL)
+		{
+			ReleaseRefCountable( &specific);
+			pool = new VJSContextPool( inRuntimeDelegate);
+			inRuntimeDelegate->SetRuntimeSpecific( kPoolSignature, pool);
+			isNew = true;
+		}
+	}
+
+	if (isNew)
+		pool->PreWarm();
+
+	return pool;
+}
+
+
+VJSGlobalContext *VJSContextPool::RetainContext()
+{
+	sLONG8 startCounter;
+	VSystem::GetProfilingCounter( startCounter);
+
+	VJSGlobalContext *context = NULL;
+	VectorOfDisposedContext expiredContexts;
+	{
+		StLocker<VCriticalSection> lock( &fMutex);
+
+		if (!fIdleContexts.empty())
+		{
+			context = fIdleContexts.back();
+			fIdleContexts.pop_back();
+			++fStatistics.fReuseCount;
+		}
+		_CollectExpiredContexts( expiredContexts);
+	}
+
+	_DisposeContexts( expiredContexts);
+
+	if (context == NULL)
+	{
+		SContextInfo info;
+		context = _CreateContext( info);
+		if (context == NULL)
+			return NULL;
+
+		StLocker<VCriticalSection> lock( &fMutex);
+		fContexts.insert( MapOfContext::value_type( context, info));
+	}
+
+	sLONG8 now;
+	VSystem::GetProfilingCounter( now);
+	uLONG8 duration = (uLONG8) (((Real) (now - startCounter) * 1000000.0) / (Real) VSystem::GetProfilingFrequency());
+
+	{
+		StLocker<VCriticalSection> lock( &fMutex);
+
+		++fStatistics.fAcquireCount;
+		++fStatistics.fInUseCount;
+		fStatistics.fIdleCount = (sLONG) fIdleContexts.size();
+		fStatistics.fTotalAcquireDuration += duration;
+		if (duration > fStatistics.fMaxAcquireDuration)
+			fStatistics.fMaxAcquireDuration = duration;
+	}
+
+	context->Retain();		// the caller's reference
+	return context;
+}
+
+
+void VJSContextPool::ReleaseContext( VJSGlobalContext *inContext)
+{
+	if (!testAssert( inContext != NULL))
+		return;
+
+	SContextInfo *info = NULL;
+	{
+		StLocker<VCriticalSection> lock( &fMutex);
+
+		MapOfContext::iterator i = fContexts.find( inContext);
+		if (testAssert( i != fContexts.end()))
+			info = &i->second;
+	}
+
+	bool keep = false;
+	if (info != NULL)
+	{
+		// the info of a context in use is only accessed by its user, it can't be erased meanwhile
+		++info->fUseCount;
+		keep = (info->fUseCount < fMaximumUseCount) && _ResetContext( inContext, *info);
+	}
+
+	VectorOfDisposedContext disposedContexts;
+	{
+		StLocker<VCriticalSection> lock( &fMutex);
+
+		--fStatistics.fInUseCount;
+		if (keep && ((sLONG) fIdleContexts.size() < fMaximumIdleCount))
+		{
+			info->fIdleSince = VSystem::GetCurrentTime();
+			fIdleContexts.push_back( inContext);
+		}
+		else if (info != NULL)
+		{
+			disposedContexts.push_back( DisposedContext( inContext, info->fKeptValues));
+			fContexts.erase( inContext);
+			++fStatistics.fDiscardedCount;
+		}
+		_CollectExpiredContexts( disposedContexts);
+		fStatistics.fIdleCount = (sLONG) fIdleContexts.size();
+	}
+
+	_DisposeContexts( disposedContexts);	// the pool references
+
+	inContext->Release();	// the caller's reference
+}
+
+
+void VJSContextPool::PreWarm()
+{
+	for(;;)
+	{
+		{
+			StLocker<VCriticalSection> lock( &fMutex);
+			if ((sLONG) fIdleContexts.size() >= fMinimumIdleCount)
+				break;
+		}
+
+		SContextInfo info;
+		VJSGlobalContext *context = _CreateContext( info);
+		if (context == NULL)
+			break;
+
+		StLocker<VCriticalSection> lock( &fMutex);
+
+		info.fIdleSince = VSystem::GetCurrentTime();
+		fContexts.insert( MapOfContext::value_type( context, info));
+		fIdleContexts.push_back( context);
+		fStatistics.fIdleCount = (sLONG) fIdleContexts.size();
+	}
+}
+
+
+void VJSContextPool::Purge()
+{
+	VectorOfDisposedContext idleContexts;
+	{
+		StLocker<VCriticalSection> lock( &fMutex);
+
+		for( std::vector<VJSGlobalContext*>::iterator i = fIdleContexts.begin() ; i != fIdleContexts.end() ; ++i)
+		{
+			idleContexts.push_back( DisposedContext( *i, fContexts[*i].fKeptValues));
+			fContexts.erase( *i);
+		}
+		fIdleContexts.clear();
+		fStatistics.fDiscardedCount += idleContexts.size();
+		fStatistics.fIdleCount = 0;
+	}
+
+	_DisposeContexts( idleContexts);
+}
+
+
+void VJSContextPool::GetStatistics( VJSContextPoolStatistics& outStatistics) const
+{
+	StLocker<VCriticalSection> lock( &fMutex);
+
+	outStatistics = fStatistics;
+}
+
+
+VJSGlobalContext *VJSContextPool::_CreateContext( SContextInfo& outInfo)
+{
+	VJSGlobalContext *globalContext = VJSGlobalContext::Create( fRuntimeDelegate);
+	if (globalContext != NULL)
+	{
+		// without the initial state, a reset would delete the built-ins
+		outInfo.fKeptValues = NULL;
+		bool ok;
+		{
+			VJSContext context( globalContext);
+			ok = _TakeSnapshot( context, outInfo);
+		}
+		if (!ok)
+		{
+			VectorOfDisposedContext contexts( 1, DisposedContext( globalContext, outInfo.fKeptValues));
+			_DisposeContexts( contexts);
+			return NULL;
+		}
+
+		outInfo.fUseCount = 0;
+		outInfo.fIdleSince = 0;
+
+		StLocker<VCriticalSection> lock( &fMutex);
+		++fStatistics.fCreatedCount;
+	}
+	return globalContext;
+}
+
+
+bool VJSContextPool::_TakeSnapshot( const VJSContext& inContext, SContextInfo& outInfo)
+{
+	outInfo.fSnapshots.clear();
+	outInfo.fKeptValues = new VJSArray( inContext);
+	outInfo.fKeptValues->Protect();
+
+	VJSObject globalObject( inContext.GetGlobalObject());
+	VJSObject getOwnPropertyNames( globalObject.GetPropertyAsObject( "Object").GetPropertyAsObject( "getOwnPropertyNames"));
+	if (!getOwnPropertyNames.IsFunction())
+		return false;
+	outInfo.fKeptValues->PushValue( getOwnPropertyNames);	// at 0
+
+	// The global object, the objects of its properties (constructors, JSON, Math, require...) and their prototypes.
+	std::vector<VJSObject> objects;
+	std::vector<sLONG> depths;
+	objects.push_back( globalObject);
+	depths.push_back( 0);
+	for( size_t i = 0 ; i < objects.size() ; ++i)
+	{
+		outInfo.fSnapshots.push_back( SObjectSnapshot());
+		SObjectSnapshot& snapshot = outInfo.fSnapshots.back();
+		if (!_GetOwnPropertyNames( getOwnPropertyNames, objects[i], snapshot.fNames))
+			return false;
+
+		snapshot.fObjectIndex = outInfo.fKeptValues->GetLength();
+		outInfo.fKeptValues->PushValue( objects[i]);
+		snapshot.fFirstValueIndex = outInfo.fKeptValues->GetLength();
+		for( std::vector<VString>::const_iterator j = snapshot.fNames.begin() ; j != snapshot.fNames.end() ; ++j)
+		{
+			VJSValue value( inContext);
+			bool checked = _GetStableProperty( objects[i], *j, value);
+			if (!checked)
+				value.SetUndefined();
+			snapshot.fChecked.push_back( checked);
+			outInfo.fKeptValues->PushValue( value);
+
+			if (checked && value.IsObject() && ((depths[i] == 0) || ((depths[i] == 1) && j->EqualToStringRaw( CVSTR( "prototype")))))
+			{
+				VJSObject object( value.GetObject());
+				if (std::find( objects.begin(), objects.end(), object) == objects.end())
+				{
+					objects.push_back( object);
+					depths.push_back( depths[i] + 1);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+
+bool VJSContextPool::_CheckSnapshot( const SContextInfo& inInfo, std::vector<VString>& outAddedGlobalNames)
+{
+	VJSObject getOwnPropertyNames( inInfo.fKeptValues->GetValueAt( 0).GetObject());
+
+	std::vector<VString> names;
+	for( std::vector<SObjectSnapshot>::const_iterator i = inInfo.fSnapshots.begin() ; i != inInfo.fSnapshots.end() ; ++i)
+	{
+		VJSObject object( inInfo.fKeptValues->GetValueAt( i->fObjectIndex).GetObject());
+		if (!_GetOwnPropertyNames( getOwnPropertyNames, object, names))
+			return false;
+
+		if (i == inInfo.fSnapshots.begin())
+		{
+			// globals added by the user can be reset, deleted ones can't be restored
+			for( std::vector<VString>::const_iterator j = i->fNames.begin() ; j != i->fNames.end() ; ++j)
+			{
+				if (!_HasName( names, *j))
+					return false;
+			}
+			for( std::vector<VString>::const_iterator j = names.begin() ; j != names.end() ; ++j)
+			{
+				if (!_HasName( i->fNames, *j))
+					outAddedGlobalNames.push_back( *j);
+			}
+		}
+		else if (!_IsSameNames( names, i->fNames))
+		{
+			return false;
+		}
+
+		for( size_t j = 0 ; j < i->fNames.size() ; ++j)
+		{
+			if (i->fChecked[j])
+			{
+				VJSException exception;
+				VJSValue value( object.GetProperty( i->fNames[j], exception));
+				if (!exception.IsEmpty() || !_IsSameValue( value, inInfo.fKeptValues->GetValueAt( i->fFirstValueIndex + j)))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+bool VJSContextPool::_ResetContext( VJSGlobalContext *inContext, const SContextInfo& inInfo)
+{
+	VJSContext context( inContext);
+
+	if (context.GetGlobalObjectPrivateInstance()->IsIncludedFilesHaveBeenChanged())
+		return false;
+
+	// a modified built-in or initial global would be seen by the next users
+	std::vector<VString> names;
+	if (!_CheckSnapshot( inInfo, names))
+		return false;
+
+	VJSObject globalObject( context.GetGlobalObject());
+
+	bool ok = true;
+	for( std::vector<VString>::const_iterator i = names.begin() ; (i != names.end()) && ok ; ++i)
+	{
+		VJSException exception;
+		if (!globalObject.DeleteProperty( *i, exception) || !exception.IsEmpty())
+		{
+			// Top-level var and function declarations can't be deleted, their value is dropped instead.
+			// The name stays defined, as if the next script had declared it. A read only one can't be reset.
+			VJSValue undefinedValue( context);
+			undefinedValue.SetUndefined();
+
+			VJSException setException;
+			globalObject.SetProperty( *i, undefinedValue, JS4D::PropertyAttributeNone, &setException);
+			ok = setException.IsEmpty() && globalObject.GetProperty( *i).IsUndefined();
+		}
+	}
+
+	// a terminated worker is reopened, as when the host reuses a context
+	if (ok)
+		VJSWorker::RecycleWorker( context);
+
+	return ok;
+}
+
+
+// under fMutex
+void VJSContextPool::_CollectExpiredContexts( VectorOfDisposedContext& outContexts)
+{
+	// the oldest idle contexts are at the front
+	uLONG now = VSystem::GetCurrentTime();
+	sLONG count = 0;
+	while ( (count < (sLONG) fIdleContexts.size() - fMinimumIdleCount)
+		&& (now - fContexts[fIdleContexts[count]].fIdleSince > kIdleTimeout) )
+	{
+		outContexts.push_back( DisposedContext( fIdleContexts[count], fContexts[fIdleContexts[count]].fKeptValues));
+		fContexts.erase( fIdleContexts[count]);
+		++count;
+	}
+
+	if (count > 0)
+	{
+		fIdleContexts.erase( fIdleContexts.begin(), fIdleContexts.begin() + count);
+		fStatistics.fDiscardedCount += count;
+		fStatistics.fIdleCount = (sLONG) fIdleContexts.size();
+	}
+}
+
+
+void VJSContextPool::_DisposeContexts( VectorOfDisposedContext& ioContexts)
+{
+	for( VectorOfDisposedContext::iterator i = ioContexts.begin() ; i != ioContexts.end() ; ++i)
+	{
+		if (i->second != NULL)
+		{
+			VJSContext context( i->first);
+			i->second->Unprotect();
+			delete i->second;
+		}
+		i->first->Release();
+	}
+	ioContexts.clear();
+}
+
+
+END_TOOLBOX_NAMESPACE
@@ -0,0 +1,143 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VJS_CONTEXT_POOL__
+#define __VJS_CONTEXT_POOL__
+
+#include "VJSContext.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+class IJSRuntimeDelegate;
+class VJSArray;
+
+typedef struct VJSContextPoolStatistics
+{
+	uLONG8		fAcquireCount;
+	uLONG8		fReuseCount;			// acquisitions served by an idle context
+	uLONG8		fCreatedCount;
+	uLONG8		fDiscardedCount;		// contexts that could not be reset or were idle for too long
+	uLONG8		fTotalAcquireDuration;	// microseconds
+	uLONG8		fMaxAcquireDuration;
+	sLONG		fIdleCount;
+	sLONG		fInUseCount;
+} VJSContextPoolStatistics;
+
+
+/*!
+	@class	VJSContextPool
+	@abstract	Keeps initialized VJSGlobalContext of one runtime delegate ready to be used.
+	@discussion
+		RetainContext returns an idle context if any, or creates a new one. ReleaseContext gives it back.
+		Creating a context instantiates the global class, the prototypes and the require() function,
+		so a request handler should rather borrow one from the pool.
+
+		Between two uses, a context is reset: global properties added by the previous user, enumerable or not,
+		are deleted and its worker is recycled. Top-level var and function declarations can't be deleted,
+		they are set to undefined instead, so a request handler script such as
+		"var result = handle( request); function handle( r) { ... }" runs again in the same context.
+
+		A context is destroyed instead if the previous user changed anything else the next one would see:
+		an initial global deleted or replaced (JSON, Date, require...), a property added, removed or replaced
+		in the objects they refer to (JSON.parse) or in their prototypes (Array.prototype.push).
+		It's also destroyed if an added global can't be reset (read only), if one of its included files has changed
+		or after inMaximumUseCount uses, which also bounds the life of changes made deeper in the built-ins.
+
+		The pool grows with the load up to the number of contexts used at the same time and keeps at most
+		inMaximumIdleCount idle contexts. Idle contexts above inMinimumIdleCount are destroyed after kIdleTimeout.
+
+		Thread safe. A context must be used by one task at a time, as any VJSGlobalContext.
+*/
+class XTOOLBOX_API VJSContextPool : public VObject, public IRefCountable
+{
+public:
+	enum { kIdleTimeout = 30000 };	// milliseconds
+
+										VJSContextPool( IJSRuntimeDelegate *inRuntimeDelegate, sLONG inMinimumIdleCount = 2, sLONG inMaximumIdleCount = 32, sLONG inMaximumUseCount = 100);
+
+	// The pool of the runtime delegate, created and pre-warmed on first call.
+	// It's stored with IJSRuntimeDelegate::SetRuntimeSpecific so it's released with the runtime delegate.
+	static	VJSContextPool*				RetainPool( IJSRuntimeDelegate *inRuntimeDelegate);
+
+	// Returns a retained context or NULL if the creation failed. The pool must stay retained until ReleaseContext is called.
+			VJSGlobalContext*			RetainContext();
+
+	// Resets the context and makes it available again. Releases the reference given by RetainContext.
+			void						ReleaseContext( VJSGlobalContext *inContext);
+
+	// Creates contexts until there are inMinimumIdleCount idle ones.
+			void						PreWarm();
+
+	// Destroys all idle contexts.
+			void						Purge();
+
+			IJSRuntimeDelegate*			GetRuntimeDelegate() const		{ return fRuntimeDelegate;}
+
+			void						GetStatistics( VJSContextPoolStatistics& outStatistics) const;
+
+protected:
+	virtual								~VJSContextPool();
+
+private:
+	// Own properties of an object after the context creation.
+	typedef struct SObjectSnapshot
+	{
+		size_t					fObjectIndex;		// index of the object in SContextInfo::fKeptValues
+		size_t					fFirstValueIndex;	// index of the value of fNames[0] in SContextInfo::fKeptValues, the others follow
+		std::vector<VString>	fNames;				// sorted, enumerable or not
+		std::vector<bool>		fChecked;			// false for values that can't be read or change at each read
+	} SObjectSnapshot;
+
+	typedef struct SContextInfo
+	{
+		std::vector<SObjectSnapshot>	fSnapshots;		// the global object first
+		VJSArray*				fKeptValues;		// protected, Object.getOwnPropertyNames() at 0 then the objects and values of fSnapshots
+		sLONG					fUseCount;
+		uLONG					fIdleSince;			// VSystem::GetCurrentTime()
+	} SContextInfo;
+
+	typedef std::map<VJSGlobalContext*,SContextInfo>	MapOfContext;
+	typedef std::pair<VJSGlobalContext*,VJSArray*>		DisposedContext;
+	typedef std::vector<DisposedContext>				VectorOfDisposedContext;
+
+										VJSContextPool( const VJSContextPool&);	// no copy
+			VJSContextPool&				operator=( const VJSContextPool&);
+
+			VJSGlobalContext*			_CreateContext( SContextInfo& outInfo);
+			bool						_ResetContext( VJSGlobalContext *inContext, const SContextInfo& inInfo);
+			void						_CollectExpiredContexts( VectorOfDisposedContext& outContexts);
+
+	static	bool						_TakeSnapshot( const VJSContext& inContext, SContextInfo& outInfo);
+	static	bool						_CheckSnapshot( const SContextInfo& inInfo, std::vector<VString>& outAddedGlobalNames);
+
+	// Releases the pool references, after unprotecting the kept values.
+	static	void						_DisposeContexts( VectorOfDisposedContext& ioContexts);
+
+	static	VCriticalSection			sPoolsMutex;
+
+	mutable	VCriticalSection			fMutex;
+			IJSRuntimeDelegate*			fRuntimeDelegate;	// not retained (our owner)
+			sLONG						fMinimumIdleCount;
+			sLONG						fMaximumIdleCount;
+			sLONG						fMaximumUseCount;
+			MapOfContext				fContexts;			// idle or in use, one reference each
+			std::vector<VJSGlobalContext*>	fIdleContexts;	// most recently used at the end
+			VJSContextPoolStatistics	fStatistics;
+};
+
+
+END_TOOLBOX_NAMESPACE
+
+#endif
@@ -389,6 +389,8 @@ VJSTimerEvent *VJSTimerEvent::Create (VJSTimer *inTimer, XBOX::VTime &inTriggerT
 	timerEvent->fTimer = inTimer;
 	timerEvent->fArguments = inArguments;
 
+	inTimer->fEvent = timerEvent;
+
 	return timerEvent;
 }
 
@@ -424,25 +426,210 @@ void VJSTimerEvent::Process (XBOX::VJSContext inContext, VJSWorker *inWorker)
 
 void VJSTimerEvent::Discard ()
 {
+	xbox_assert(fQueueIndex < 0);
+
+	fTimer->fEvent = NULL;
 	fTimer->_ReleaseIfCleared();
 	delete fArguments;
 	Release();
 }
 
-void VJSTimerEvent::RemoveTimerEvent (std::list<IJSEvent *> *ioEventQueue, VJSTimer *inTimer)
+VJSEventQueue::VJSEventQueue ()
 {
-	std::list<IJSEvent *>::iterator	i;
+	fSequence = 0;
+}
 
-	for (i = ioEventQueue->begin(); i != ioEventQueue->end(); i++)
+VJSEventQueue::~VJSEventQueue ()
+{
+	xbox_assert(IsEmpty());
+}
 
-		if ((*i)->GetType() == eTYPE_TIMER 
-		&& ((VJSTimerEvent *) (*i))->fTimer == inTimer) {
+void VJSEventQueue::Push (IJSEvent *inEvent)
+{
+	xbox_assert(inEvent != NULL);
+
+	if (inEvent->GetType() != IJSEvent::eTYPE_TIMER) {
+
+		SImmediateEntry	entry;
+
+		entry.fTriggerStamp = inEvent->GetTriggerTime().GetStamp();
+		entry.fSequence = fSequence++;
+		entry.fEvent = inEvent;
+
+		fImmediateEvents.push_back(entry);
+		return;
+
+	}
+
+	VJSTimerEvent	*timerEvent	= (VJSTimerEvent *) inEvent;
+	STimerEntry		entry;
+
+	xbox_assert(timerEvent->fQueueIndex < 0);
+
+	entry.fTriggerStamp = timerEvent->GetTriggerTime().GetStamp();
+	entry.fSequence = fSequence++;
+	entry.fEvent = timerEvent;
+
+	fTimerEvents.push_back(entry);
+	timerEvent->fQueueIndex = (sLONG) fTimerEvents.size() - 1;
+	_SiftUp(fTimerEvents.size() - 1);
+}
+
+IJSEvent *VJSEventQueue::GetFront () const
+{
+	if (_IsTimerEventFirst())
+
+		return fTimerEvents.front().fEvent;
+
+	else
+
+		return fImmediateEvents.empty() ? NULL : fImmediateEvents.front().fEvent;
+}
+
+IJSEvent *VJSEventQueue::PopFront ()
+{
+	IJSEvent	*event;
+
+	if (_IsTimerEventFirst()) 
+
+		event = _RemoveTimerEvent(0);
+
+	else if (!fImmediateEvents.empty()) {
+
+		event = fImmediateEvents.front().fEvent;
+		fImmediateEvents.pop_front();
+
+	} else
+
+		event = NULL;
+
+	return event;
+}
+
+void VJSEventQueue::RemoveTimerEvent (VJSTimer *inTimer)
+{
+	xbox_assert(inTimer != NULL);
+
+	// If the timer event is executing, it is not queued and there is nothing to do.
+
+	VJSTimerEvent	*timerEvent	= inTimer->fEvent;
+
+	if (timerEvent != NULL && timerEvent->fQueueIndex >= 0) {
+
+		xbox_assert(fTimerEvents[timerEvent->fQueueIndex].fEvent == timerEvent);
+
+		_RemoveTimerEvent(timerEvent->fQueueIndex);
+		timerEvent->Discard();
+
+	}
+}
+
+void VJSEventQueue::DiscardAll ()
+{
+	while (!IsEmpty())
+
+		PopFront()->Discard();
+}
+
+bool VJSEventQueue::_IsTimerEventFirst () const
+{
+	if (fTimerEvents.empty())
+
+		return false;
+
+	else if (fImmediateEvents.empty())
+
+		return true;
+
+	// With identical trigger times, the event queued first goes first.
+
+	const STimerEntry		&timer		= fTimerEvents.front();
+	const SImmediateEntry	&immediate	= fImmediateEvents.front();
+
+	return timer.fTriggerStamp < immediate.fTriggerStamp
+		|| (timer.fTriggerStamp == immediate.fTriggerStamp && timer.fSequence < immediate.fSequence);
+}
+
+void VJSEventQueue::_SetEntry (size_t inIndex, const STimerEntry &inEntry)
+{
+	fTimerEvents[inIndex] = inEntry;
+	inEntry.fEvent->fQueueIndex = (sLONG) inIndex;
+}
+
+void VJSEventQueue::_SiftUp (size_t inIndex)
+{
+	STimerEntry	entry	= fTimerEvents[inIndex];
+
+	while (inIndex > 0) {
+
+		size_t	parent	= (inIndex - 1) / 2;
+
+		if (!_IsBefore(entry, fTimerEvents[parent]))
 
-			(*i)->Discard();
-			ioEventQueue->erase(i);
 			break;
 
-		}
+		_SetEntry(inIndex, fTimerEvents[parent]);
+		inIndex = parent;
+
+	}
+	_SetEntry(inIndex, entry);
+}
+
+void VJSEventQueue::_SiftDown (size_t inIndex)
+{
+	STimerEntry	entry	= fTimerEvents[inIndex];
+	size_t		count	= fTimerEvents.size();
+
+	for ( ; ; ) {
+
+		size_t	child	= 2 * inIndex + 1;
+
+		if (child >= count)
+
+			break;
+
+		if (child + 1 < count && _IsBefore(fTimerEvents[child + 1], fTimerEvents[child]))
+
+			child++;
+
+		if (!_IsBefore(fTimerEvents[child], entry))
+
+			break;
+
+		_SetEntry(inIndex, fTimerEvents[child]);
+		inIndex = child;
+
+	}
+	_SetEntry(inIndex, entry);
+}
+
+VJSTimerEvent *VJSEventQueue::_RemoveTimerEvent (size_t inIndex)
+{
+	xbox_assert(inIndex < fTimerEvents.size());
+
+	VJSTimerEvent	*timerEvent	= fTimerEvents[inIndex].fEvent;
+	size_t			last		= fTimerEvents.size() - 1;
+
+	timerEvent->fQueueIndex = -1;
+	if (inIndex != last) {
+
+		// Move last entry to the hole, it may have to go either up or down.
+
+		_SetEntry(inIndex, fTimerEvents[last]);
+		fTimerEvents.pop_back();
+		if (inIndex > 0 && _IsBefore(fTimerEvents[inIndex], fTimerEvents[(inIndex - 1) / 2]))
+
+			_SiftUp(inIndex);
+
+		else
+
+			_SiftDown(inIndex);
+
+	} else
+
+		fTimerEvents.pop_back();
+
+	return timerEvent;
 }
 
 VJSSystemWorkerEvent *VJSSystemWorkerEvent::Create (VJSSystemWorker *inSystemWorker, sLONG inType, XBOX::VJSObject &inObjectRef, uBYTE *inData, sLONG inSize)
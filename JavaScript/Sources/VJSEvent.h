@@ -16,6 +16,8 @@
 #ifndef __VJS_EVENT__
 #define __VJS_EVENT__
 
+#include <deque>
+
 #include "VJSClass.h"
 #include "VJSValue.h"
 
@@ -227,19 +229,87 @@ public:
 	void						Process (XBOX::VJSContext inContext, VJSWorker *inWorker);
 	void						Discard ();
 
-	// Remove a timer event from an event queue.
-
-	static void					RemoveTimerEvent (std::list<IJSEvent *> *ioEventQueue, VJSTimer *inTimer);
-
 private:
 
+friend class VJSEventQueue;
+
 	VJSTimer					*fTimer;
 	std::vector<XBOX::VJSValue>	*fArguments;
+	sLONG						fQueueIndex;	// Position in the timer heap of VJSEventQueue, -1 if not queued.
 
-								VJSTimerEvent ()	{}
+								VJSTimerEvent ()	{	fQueueIndex = -1;	}
 	virtual						~VJSTimerEvent ()	{}
 };
 
+// Event queue of a worker.
+//
+// Timer events are kept in a binary min-heap ordered by trigger time, then by queuing order. Each VJSTimerEvent 
+// knows its position in the heap, so clearTimeout() and clearInterval() are O(log n) instead of a scan of the queue.
+// All other events are triggered as soon as possible, they are kept in a FIFO.
+// Events with identical trigger times are processed in the order they have been queued. 
+// Not thread-safe, VJSWorker locks its mutex.
+
+class XTOOLBOX_API VJSEventQueue : public XBOX::VObject
+{
+public:
+
+						VJSEventQueue ();
+	virtual				~VJSEventQueue ();
+
+	bool				IsEmpty () const	{	return fImmediateEvents.empty() && fTimerEvents.empty();	}
+	size_t				GetCount () const	{	return fImmediateEvents.size() + fTimerEvents.size();		}
+
+	void				Push (IJSEvent *inEvent);
+
+	// Return event with earliest trigger time, NULL if queue is empty.
+
+	IJSEvent			*GetFront () const;
+	IJSEvent			*PopFront ();
+
+	// If the timer has a queued event, remove and discard it.
+
+	void				RemoveTimerEvent (VJSTimer *inTimer);
+
+	// Discard all events.
+
+	void				DiscardAll ();
+
+private:
+
+	struct STimerEntry {
+
+		uLONG8			fTriggerStamp;
+		uLONG8			fSequence;
+		VJSTimerEvent	*fEvent;
+
+	};
+
+	struct SImmediateEntry {
+
+		uLONG8			fTriggerStamp;
+		uLONG8			fSequence;
+		IJSEvent		*fEvent;
+
+	};
+
+	// Both kinds of events share the sequence counter, so that ties between them are broken by queuing order.
+
+	std::deque<SImmediateEntry>	fImmediateEvents;
+	std::vector<STimerEntry>	fTimerEvents;
+	uLONG8						fSequence;
+
+	static bool			_IsBefore (const STimerEntry &inA, const STimerEntry &inB)
+	{
+		return inA.fTriggerStamp < inB.fTriggerStamp || (inA.fTriggerStamp == inB.fTriggerStamp && inA.fSequence < inB.fSequence);
+	}
+
+	bool				_IsTimerEventFirst () const;
+	void				_SetEntry (size_t inIndex, const STimerEntry &inEntry);
+	void				_SiftUp (size_t inIndex);
+	void				_SiftDown (size_t inIndex);
+	VJSTimerEvent		*_RemoveTimerEvent (size_t inIndex);
+};
+
 // System worker events.
 
 class XTOOLBOX_API VJSSystemWorkerEvent : public XBOX::IJSEvent
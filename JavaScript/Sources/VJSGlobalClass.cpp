@@ -55,6 +55,7 @@
 #include "VJSTLS.h"
 #include "VJSW3CFileSystem.h"
 #include "VJSBuffer.h"
+#include "VJSScriptCache.h"
 #include "VJSNet.h"
 #include "VJSCrypto.h"
 #include "VJSModule.h"
@@ -1418,18 +1419,10 @@ void VJSGlobalClass::do_ImportScripts (VJSParms_callStaticFunction &ioParms, VJS
 				
 		if (url.GetFilePath(path)) {
 
-			XBOX::VFile			file(path);			
-			XBOX::VFileStream	stream(&file);
-			XBOX::VError		error;
-		
-			if ((error = stream.OpenReading()) == XBOX::VE_OK
-			&& (error = stream.GuessCharSetFromLeadingBytes(XBOX::VTC_DefaultTextExport)) == XBOX::VE_OK) {
-
-				stream.SetCarriageReturnMode(XBOX::eCRM_NATIVE);
-				error = stream.GetText(script);
+			XBOX::VFile		file(path);
+			XBOX::VError	error;
 
-			}
-			stream.CloseReading();
+			error = XBOX::VJSScriptCache::Get()->LoadScript(file, script);
 
 			isOk = error == XBOX::VE_OK;
 
@@ -1574,18 +1567,10 @@ void VJSGlobalClass::do_RequireFile (VJSParms_callStaticFunction &ioParms, VJSGl
 				
 	if (url.GetFilePath(path)) {
 
-		XBOX::VFile			file(path);			
-		XBOX::VFileStream	stream(&file);
-		XBOX::VError		error;
-		
-		if ((error = stream.OpenReading()) == XBOX::VE_OK
-		&& (error = stream.GuessCharSetFromLeadingBytes(XBOX::VTC_DefaultTextExport)) == XBOX::VE_OK) {
-
-			stream.SetCarriageReturnMode(XBOX::eCRM_NATIVE);
-			error = stream.GetText(script);
+		XBOX::VFile		file(path);
+		XBOX::VError	error;
 
-		}
-		stream.CloseReading();
+		error = XBOX::VJSScriptCache::Get()->LoadScript(file, script);
 
 		isOk = error == XBOX::VE_OK;
 
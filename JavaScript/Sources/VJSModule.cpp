@@ -31,6 +31,7 @@
 
 #include "VJSContext.h"
 #include "VJSGlobalClass.h"
+#include "VJSScriptCache.h"
 
 USING_TOOLBOX_NAMESPACE
 
@@ -157,17 +158,9 @@ XBOX::VError VJSModuleState::LoadScript (const XBOX::VString &inFullPath, XBOX::
 					
 	if (outURL->GetFilePath(path) && path.IsFile()) {
 
-		XBOX::VFile			file(path);			
-		XBOX::VFileStream	stream(&file);
-						
-		if ((error = stream.OpenReading()) == XBOX::VE_OK
-		&& (error = stream.GuessCharSetFromLeadingBytes(XBOX::VTC_DefaultTextExport)) == XBOX::VE_OK) {
-
-			stream.SetCarriageReturnMode(XBOX::eCRM_NATIVE);
-			error = stream.GetText(*outScript);
+		XBOX::VFile	file(path);
 
-		}
-		stream.CloseReading();	// Ignore closing error, if any.
+		error = XBOX::VJSScriptCache::Get()->LoadScript(file, *outScript);
 
 		if (error == XBOX::VE_STREAM_EOF)
 
@@ -0,0 +1,326 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VJavaScriptPrecompiled.h"
+
+#include "KernelIPC/VKernelIPC.h"
+
+#include "VJSScriptCache.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+
+// Latency given to VFileSystemNotifier, in milliseconds.
+static const sLONG	kWatchLatency	= 100;
+
+// Some file systems only store the modification time to the second (two seconds for FAT):
+// a file rewritten with the same size in the same interval would keep its attributes.
+static const sLONG8	kModificationTimePrecision	= 2000;
+
+
+static uLONG8 _GetMicroseconds( sLONG8 inStartCounter)
+{
+	sLONG8 now;
+	VSystem::GetProfilingCounter( now);
+
+	return (uLONG8) (((Real) (now - inStartCounter) * 1000000.0) / (Real) VSystem::GetProfilingFrequency());
+}
+
+
+// True if inPath is inFolderPath or a path inside it (case sensitive, as the cache keys).
+static bool _IsInFolder( const VString& inPath, const VString& inFolderPath)
+{
+	VIndex length = inFolderPath.GetLength();
+
+	return (inPath.GetLength() >= length) && (::memcmp( inPath.GetCPointer(), inFolderPath.GetCPointer(), length * sizeof( UniChar)) == 0);
+}
+
+
+//=========================================================================================================
+
+
+class VJSScriptCacheEventHandler : public VObject, public VFileSystemNotifier::IEventHandler
+{
+public:
+								VJSScriptCacheEventHandler( VJSScriptCache *inCache) : fCache( inCache)	{;}
+
+	// Any kind of event: an added file may be a new version renamed over a cached one.
+	virtual	void				FileSystemEventHandler( const std::vector<VFilePath>& inFilePaths, VFileSystemNotifier::EventKind inKind)
+	{
+		for( std::vector<VFilePath>::const_iterator i = inFilePaths.begin() ; i != inFilePaths.end() ; ++i)
+			fCache->Invalidate( *i);
+	}
+
+private:
+			VJSScriptCache*		fCache;
+};
+
+
+// Posted to the main task: VFileSystemNotifier sends its events to the task that started watching.
+class VJSScriptCacheWatchMessage : public VMessage
+{
+public:
+								VJSScriptCacheWatchMessage( VJSScriptCache *inCache, VFolder *inFolder) : fCache( inCache), fFolder( inFolder)	{;}
+
+protected:
+	virtual	void				DoExecute()
+	{
+		fCache->_StartWatching( fFolder.Get());
+	}
+
+private:
+			VJSScriptCache*		fCache;
+			VRefPtr<VFolder>	fFolder;
+};
+
+
+//=========================================================================================================
+
+
+VJSScriptCache*		VJSScriptCache::sInstance = NULL;
+VCriticalSection	VJSScriptCache::sInstanceMutex;
+
+
+VJSScriptCache::VJSScriptCache()
+: fMaximumSize( kDefaultMaximumSize)
+{
+	::memset( &fStatistics, 0, sizeof( fStatistics));
+	fEventHandler = new VJSScriptCacheEventHandler( this);
+}
+
+
+VJSScriptCache::~VJSScriptCache()
+{
+	// never called: the cache lives as long as the process and the watched folders
+	delete fEventHandler;
+}
+
+
+VJSScriptCache *VJSScriptCache::Get()
+{
+	if (sInstance == NULL)
+	{
+		StLocker<VCriticalSection> lock( &sInstanceMutex);
+		if (sInstance == NULL)
+			sInstance = new VJSScriptCache;
+	}
+	return sInstance;
+}
+
+
+VError VJSScriptCache::LoadScript( const VFile& inFile, VString& outScript)
+{
+	const VString& key = inFile.GetPath().GetPath();
+
+	// The file attributes are read before the file itself so that a change while reading makes the entry stale.
+	VTime modificationTime;
+	sLONG8 fileSize = 0;
+	bool gotAttributes;
+	{
+		StErrorCapture errorCapture;	// a missing file is reported by _ReadScript
+		gotAttributes = (inFile.GetTimeAttributes( &modificationTime) == VE_OK) && (inFile.GetSize( &fileSize) == VE_OK);
+	}
+
+	// A file modified too recently may still be rewritten without any change to its attributes, it's not cached.
+	// Once cached, any later write gives it a modification time after the one of the entry.
+	bool isSettled = false;
+	if (gotAttributes)
+	{
+		VTime now;
+		VTime::Now( now);
+		isSettled = (now.GetMilliseconds() - modificationTime.GetMilliseconds() >= kModificationTimePrecision);
+	}
+
+	if (gotAttributes)
+	{
+		StLocker<VCriticalSection> lock( &fMutex);
+
+		MapOfEntry::iterator i = fEntries.find( key);
+		if (i != fEntries.end())
+		{
+			if ( (i->second.fModificationTime == modificationTime) && (i->second.fFileSize == fileSize) )
+			{
+				++fStatistics.fHitCount;
+				fStatistics.fSavedLoadDuration += i->second.fLoadDuration;
+				outScript = i->second.fScript;
+				return VE_OK;
+			}
+
+			++fStatistics.fInvalidatedCount;
+			_Remove( i);
+		}
+	}
+
+	sLONG8 startCounter;
+	VSystem::GetProfilingCounter( startCounter);
+
+	VError err = _ReadScript( inFile, outScript);
+
+	uLONG8 duration = _GetMicroseconds( startCounter);
+
+	bool watch = false;
+	{
+		StLocker<VCriticalSection> lock( &fMutex);
+
+		++fStatistics.fMissCount;
+		fStatistics.fLoadDuration += duration;
+
+		VSize size = outScript.GetLength() * sizeof( UniChar);
+		if ( (err == VE_OK) && isSettled && (fStatistics.fCachedSize + size <= fMaximumSize) )
+		{
+			// another task may have loaded the same file meanwhile
+			std::pair<MapOfEntry::iterator,bool> inserted = fEntries.insert( MapOfEntry::value_type( key, SEntry()));
+			if (inserted.second)
+			{
+				SEntry& entry = inserted.first->second;
+				entry.fModificationTime = modificationTime;
+				entry.fFileSize = fileSize;
+				entry.fLoadDuration = duration;
+				entry.fScript = outScript;
+
+				++fStatistics.fEntryCount;
+				fStatistics.fCachedSize += size;
+				watch = true;
+			}
+		}
+	}
+
+	if (watch)
+		_WatchFolderOf( inFile);
+
+	return err;
+}
+
+
+void VJSScriptCache::SetMaximumSize( VSize inMaximumSize)
+{
+	StLocker<VCriticalSection> lock( &fMutex);
+
+	fMaximumSize = inMaximumSize;
+}
+
+
+void VJSScriptCache::Invalidate( const VFilePath& inPath)
+{
+	StLocker<VCriticalSection> lock( &fMutex);
+
+	if (inPath.IsFolder())
+	{
+		// a deleted or renamed folder is notified only once
+		for( MapOfEntry::iterator i = fEntries.begin() ; i != fEntries.end() ; )
+		{
+			MapOfEntry::iterator current = i++;
+			if (_IsInFolder( current->first, inPath.GetPath()))
+			{
+				++fStatistics.fInvalidatedCount;
+				_Remove( current);
+			}
+		}
+	}
+	else
+	{
+		MapOfEntry::iterator i = fEntries.find( inPath.GetPath());
+		if (i != fEntries.end())
+		{
+			++fStatistics.fInvalidatedCount;
+			_Remove( i);
+		}
+	}
+}
+
+
+void VJSScriptCache::Clear()
+{
+	StLocker<VCriticalSection> lock( &fMutex);
+
+	fEntries.clear();
+	fStatistics.fEntryCount = 0;
+	fStatistics.fCachedSize = 0;
+}
+
+
+void VJSScriptCache::GetStatistics( VJSScriptCacheStatistics& outStatistics) const
+{
+	StLocker<VCriticalSection> lock( &fMutex);
+
+	outStatistics = fStatistics;
+}
+
+
+VError VJSScriptCache::_ReadScript( const VFile& inFile, VString& outScript)
+{
+	VFileStream stream( &inFile);
+	VError err = stream.OpenReading();
+	if (err == VE_OK)
+	{
+		err = stream.GuessCharSetFromLeadingBytes( VTC_DefaultTextExport);		// sc 18/03/2011 instead of VTC_UTF_8
+		stream.SetCarriageReturnMode( eCRM_NATIVE);
+		if (err == VE_OK)
+			err = stream.GetText( outScript);
+	}
+	stream.CloseReading();	// Ignore closing error, if any.
+
+	return err;
+}
+
+
+// under fMutex
+void VJSScriptCache::_Remove( MapOfEntry::iterator inIterator)
+{
+	--fStatistics.fEntryCount;
+	fStatistics.fCachedSize -= inIterator->second.fScript.GetLength() * sizeof( UniChar);
+	fEntries.erase( inIterator);
+}
+
+
+void VJSScriptCache::_WatchFolderOf( const VFile& inFile)
+{
+	if (VProcessIPC::Get() == NULL)
+		return;		// no file system notifier in this process, file attributes are enough
+
+	VFolder *folder = inFile.RetainParentFolder();
+	if (folder == NULL)
+		return;
+
+	bool isNew;
+	{
+		StLocker<VCriticalSection> lock( &fMutex);
+		isNew = fWatchedFolders.insert( MapOfFolder::value_type( folder->GetPath().GetPath(), VRefPtr<VFolder>( folder))).second;
+	}
+
+	if (isNew)
+	{
+		VJSScriptCacheWatchMessage *msg = new VJSScriptCacheWatchMessage( this, folder);
+		if (msg != NULL)
+			msg->PostTo( VTask::GetMain());
+		ReleaseRefCountable( &msg);
+	}
+
+	folder->Release();
+}
+
+
+// on the main task
+void VJSScriptCache::_StartWatching( VFolder *inFolder)
+{
+	// Not being notified only delays the eviction of changed files: the file attributes are always checked.
+	StErrorContextInstaller errorContext( false);
+
+	if (VProcessIPC::Get() != NULL)
+		VFileSystemNotifier::Instance()->StartWatchingForChanges( *inFolder, VFileSystemNotifier::kAll, fEventHandler, kWatchLatency);
+}
+
+
+END_TOOLBOX_NAMESPACE
@@ -0,0 +1,110 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VJS_SCRIPT_CACHE__
+#define __VJS_SCRIPT_CACHE__
+
+BEGIN_TOOLBOX_NAMESPACE
+
+class VJSScriptCacheEventHandler;
+
+typedef struct VJSScriptCacheStatistics
+{
+	uLONG8		fHitCount;
+	uLONG8		fMissCount;
+	uLONG8		fInvalidatedCount;		// entries dropped because the file changed
+	uLONG8		fLoadDuration;			// microseconds spent reading and decoding files
+	uLONG8		fSavedLoadDuration;		// microseconds the hits would have spent doing the same
+	sLONG		fEntryCount;
+	VSize		fCachedSize;			// bytes of cached source
+} VJSScriptCacheStatistics;
+
+
+/*!
+	@class	VJSScriptCache
+	@abstract	Process wide cache of the decoded source of script files.
+	@discussion
+		require(), importScripts(), workers and VJSContext::EvaluateScript( VFile*) all read their scripts
+		through this cache, so that every new context doesn't read the same files and guess their charset again.
+
+		An entry is keyed by its full path and is only used if the file still has the same
+		last modification time and size. Files modified in the last two seconds are not cached,
+		because a modification time stored to the second can't tell two versions apart.
+		The folders of cached files are also watched with VFileSystemNotifier (from the main task)
+		so that changed or deleted files are dropped early.
+
+		JavaScriptCore gives no way to share compiled code between context groups,
+		so only the source is shared: each context still parses it.
+*/
+class XTOOLBOX_API VJSScriptCache : public VObject
+{
+public:
+	enum { kDefaultMaximumSize = 64 * 1024 * 1024 };
+
+	static	VJSScriptCache*				Get();
+
+	// Same behavior as reading the file with a VFileStream, GuessCharSetFromLeadingBytes( VTC_DefaultTextExport) and GetText().
+	// An empty file returns VE_STREAM_EOF.
+			VError						LoadScript( const VFile& inFile, VString& outScript);
+
+	// Files are no longer cached once the cached source takes more than inMaximumSize bytes.
+			void						SetMaximumSize( VSize inMaximumSize);
+
+			void						Invalidate( const VFilePath& inPath);
+			void						Clear();
+
+			void						GetStatistics( VJSScriptCacheStatistics& outStatistics) const;
+
+private:
+	friend class VJSScriptCacheEventHandler;
+	friend class VJSScriptCacheWatchMessage;
+
+	typedef struct SEntry
+	{
+		VTime		fModificationTime;
+		sLONG8		fFileSize;
+		uLONG8		fLoadDuration;
+		VString		fScript;
+	} SEntry;
+
+	typedef unordered_map_VString<SEntry>				MapOfEntry;
+	typedef unordered_map_VString<VRefPtr<VFolder> >	MapOfFolder;
+
+										VJSScriptCache();
+	virtual								~VJSScriptCache();
+
+										VJSScriptCache( const VJSScriptCache&);	// no copy
+			VJSScriptCache&				operator=( const VJSScriptCache&);
+
+	static	VError						_ReadScript( const VFile& inFile, VString& outScript);
+			void						_Remove( MapOfEntry::iterator inIterator);
+			void						_WatchFolderOf( const VFile& inFile);
+			void						_StartWatching( VFolder *inFolder);
+
+	static	VJSScriptCache*				sInstance;
+	static	VCriticalSection			sInstanceMutex;
+
+	mutable	VCriticalSection			fMutex;
+			MapOfEntry					fEntries;
+			MapOfFolder					fWatchedFolders;
+			VSize						fMaximumSize;
+			VJSScriptCacheStatistics	fStatistics;
+			VJSScriptCacheEventHandler*	fEventHandler;
+};
+
+
+END_TOOLBOX_NAMESPACE
+
+#endif
@@ -71,7 +71,7 @@ bool VJSSystemWorker::IsRunning (bool inWaitForStartup)
 
 			if (inWaitForStartup) 
 	
-				XBOX::VTask::Sleep(kPollingInterval);
+				XBOX::VTask::Sleep(kStartupPollingInterval);
 
 			else {
 
@@ -101,6 +101,7 @@ void VJSSystemWorker::Kill (bool inPanicTermination)
 		fForcedTermination = fIsTerminated = true;	// _DoRun() will quit.
 		
 	}
+	fProcessLauncher.InterruptWait();
 }
 
 void VJSSystemWorker::KillAll ()
@@ -443,8 +444,10 @@ void VJSSystemWorker::_DoRun ()
 		XBOX::VInterlocked::Increment((sLONG *) &VJSSystemWorker::sNumberRunning);
 
 		uBYTE	*readBuffer;
+		sLONG	bufferSize;
 
-		readBuffer = (uBYTE *) ::malloc(kBufferSize);
+		bufferSize = kBufferSize;
+		readBuffer = (uBYTE *) ::malloc(bufferSize);
 		xbox_assert(readBuffer != NULL);
 
 		while (!fIsTerminated) {
@@ -459,7 +462,7 @@ void VJSSystemWorker::_DoRun ()
 			// Data on stdout?
 			
 			if (!fPanicTermination 
-			&& (size = fProcessLauncher.ReadFromChild((char *) readBuffer, kBufferSize - 1)) > 0) {
+			&& (size = fProcessLauncher.ReadFromChild((char *) readBuffer, bufferSize - 1)) > 0) {
 
 				fCriticalSection.Unlock();
 
@@ -471,10 +474,11 @@ void VJSSystemWorker::_DoRun ()
 
 #endif
 
+				_TrimReadBuffer(&readBuffer, size, bufferSize);
 				fWorker->QueueEvent(VJSSystemWorkerEvent::Create(this, VJSSystemWorkerEvent::eTYPE_STDOUT_DATA, fThis, readBuffer, size));
 				hasProducedData = true;
 
-				readBuffer = (uBYTE *) ::malloc(kBufferSize);
+				readBuffer = _AllocateReadBuffer(size, &bufferSize);
 				xbox_assert(readBuffer != NULL);
 				
 				fCriticalSection.Lock();
@@ -484,7 +488,7 @@ void VJSSystemWorker::_DoRun ()
 			// Data on stderr?
 
 			if (!fPanicTermination 
-			&& (size = fProcessLauncher.ReadErrorFromChild((char *) readBuffer, kBufferSize - 1)) > 0) {
+			&& (size = fProcessLauncher.ReadErrorFromChild((char *) readBuffer, bufferSize - 1)) > 0) {
 
 				fCriticalSection.Unlock();
 				
@@ -496,10 +500,11 @@ void VJSSystemWorker::_DoRun ()
 
 #endif
 
+				_TrimReadBuffer(&readBuffer, size, bufferSize);
 				fWorker->QueueEvent(VJSSystemWorkerEvent::Create(this, VJSSystemWorkerEvent::eTYPE_STDERR_DATA, fThis, readBuffer, size));
 				hasProducedData = true;
 
-				readBuffer = (uBYTE *) ::malloc(kBufferSize);
+				readBuffer = _AllocateReadBuffer(size, &bufferSize);
 				xbox_assert(readBuffer != NULL);
 				
 				fCriticalSection.Lock();
@@ -534,10 +539,10 @@ void VJSSystemWorker::_DoRun ()
 
 				} else {
 				
-					// No data, sleep then poll later.
+					// No data, wait for some, for termination, or for a termination request.
 				
 					fCriticalSection.Unlock();
-					XBOX::VTask::Sleep(kPollingInterval);
+					fProcessLauncher.WaitForData(kMaximumWaitDuration);
 				
 				}
 			
@@ -625,6 +630,40 @@ void VJSSystemWorker::_DoRun ()
 	Release();
 }
 
+uBYTE *VJSSystemWorker::_AllocateReadBuffer (sLONG inReadSize, sLONG *ioBufferSize)
+{
+	xbox_assert(ioBufferSize != NULL);
+
+	// One byte is kept for a terminating zero.
+
+	if (inReadSize >= *ioBufferSize - 1) {
+
+		if (*ioBufferSize < kMaximumBufferSize)
+
+			*ioBufferSize *= 2;
+
+	} else if (inReadSize < *ioBufferSize / 4 && *ioBufferSize > kBufferSize)
+
+		*ioBufferSize /= 2;
+
+	return (uBYTE *) ::malloc(*ioBufferSize);
+}
+
+void VJSSystemWorker::_TrimReadBuffer (uBYTE **ioBuffer, sLONG inReadSize, sLONG inBufferSize)
+{
+	// Event keeps the buffer until processed, don't waste a big one for a small read.
+
+	if (inBufferSize > kBufferSize && inReadSize + 1 < inBufferSize / 2) {
+
+		uBYTE	*buffer;
+
+		if ((buffer = (uBYTE *) ::realloc(*ioBuffer, inReadSize + 1)) != NULL)
+
+			*ioBuffer = buffer;
+
+	}
+}
+
 sLONG VJSSystemWorker::_RunProc (XBOX::VTask *inVTask)
 {
 	((VJSSystemWorker *) inVTask->GetKindData())->_DoRun();	
@@ -1419,6 +1458,7 @@ void VJSSystemWorkerClass::_terminate (XBOX::VJSParms_callStaticFunction &ioParm
 
 	inSystemWorker->fProcessLauncher.CloseStandardInput();
 	inSystemWorker->fTerminationRequested = true;
+	inSystemWorker->fProcessLauncher.InterruptWait();
 
 	if (doWait && !inSystemWorker->fWorker->IsInsideWaitFor()) {
 
@@ -1823,7 +1863,7 @@ void VJSSystemWorkerClass::_Exec (XBOX::VJSParms_callStaticFunction &ioParms, vo
 
 			} else 
 
-				XBOX::VTask::Sleep(VJSSystemWorker::kPollingInterval);
+				processLauncher->WaitForData(VJSSystemWorker::kPollingInterval);
 
 		}
 		
@@ -76,14 +76,21 @@ private:
 friend class VJSSystemWorkerClass;
 friend class VJSSystemWorkerEvent;
 
-	// Events (data available on stdout or stderr, process termination) are polled at regular interval. 
-	// Default is 100ms. Use a smaller interval to reduce latency.
+	// Events (data available on stdout or stderr, process termination) are waited for with VProcessLauncher::WaitForData()
+	// and delivered as soon as they happen. Waits are bounded so that a dying task is noticed, termination requests interrupt them. 
+	// exec() checks for panic termination at kPollingInterval.
 
+	static const sLONG		kMaximumWaitDuration		= 1000;
 	static const sLONG		kPollingInterval			= 100;
 
-	// Buffer size.
+	// Wait for the launch of the external process.
+
+	static const sLONG		kStartupPollingInterval		= 5;
+
+	// Read buffer size adapts to the output rate: it doubles when a read fills it and halves when reads use less than a quarter.
 
 	static const sLONG		kBufferSize					= 4096;
+	static const sLONG		kMaximumBufferSize			= 1 << 20;
 
 	// If a SystemWorker object is to be destroyed, termination is automatically requested. 
 	// Wait for a limited delay only, so program will not be stuck. 
@@ -133,10 +140,15 @@ friend class VJSSystemWorkerEvent;
 
 	void			AddArgument (const XBOX::VString &inArgument);
 	
-	// Will poll the external process for data.
+	// Will wait for data from the external process and its termination.
 
 	void			_DoRun();
 
+	// Allocate the buffer for next read, after a read of inReadSize bytes in a buffer of ioBufferSize bytes.
+
+	static uBYTE	*_AllocateReadBuffer (sLONG inReadSize, sLONG *ioBufferSize);
+	static void		_TrimReadBuffer (uBYTE **ioBuffer, sLONG inReadSize, sLONG inBufferSize);
+
 	// Will call _DoRun().
 
 	static sLONG	_RunProc (XBOX::VTask *inVTask);	
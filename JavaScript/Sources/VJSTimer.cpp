@@ -155,6 +155,7 @@ VJSTimer::VJSTimer (XBOX::VJSObject &inFunctionObject, sLONG inInterval)
 	fTimerContext = NULL;
 	fID = -1;
 	fInterval = inInterval;
+	fEvent = NULL;
 	//fFunctionObject = new VJSObject(inFunctionObject);	
 }
 
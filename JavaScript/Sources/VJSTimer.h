@@ -28,6 +28,7 @@ class VJSGlobalObject;
 class VJSWorker;
 
 class VJSTimer;
+class VJSTimerEvent;
 
 // All timers (context) of a JavaScript execution.
 
@@ -85,6 +86,7 @@ private:
 
 friend class VJSTimerContext;
 friend class VJSTimerEvent;
+friend class VJSEventQueue;
 
 	// Interval is in milliseconds, negative values are special constants. 
 	// For timeouts, actual delay is set in the trigger time of timer event.
@@ -98,6 +100,7 @@ friend class VJSTimerEvent;
 	sLONG					fID;
 	sLONG					fInterval;
 	XBOX::VJSObject			fFunctionObject;	
+	VJSTimerEvent			*fEvent;			// Event of the timer, NULL once discarded.
 				
 				VJSTimer ();
 				VJSTimer (XBOX::VJSObject &inFunctionObject, sLONG inInterval);
@@ -1292,7 +1292,7 @@ bool VJSObject::HasProperty( const VString& inPropertyName) const
     Local<Object>			obj = fObject->ToObject();
 	ok = obj->Has(v8::String::NewFromTwoByte(fContext,inPropertyName.GetCPointer(), v8::String::kNormalString, inPropertyName.GetLength()));
 #else
-	JSStringRef jsName = JS4D::VStringToString( inPropertyName);
+	JSStringRef jsName = JS4D::VStringToPropertyName( inPropertyName);
 	ok = JSObjectHasProperty( fContext, fObject, jsName);
 	JSStringRelease( jsName);
 #endif
@@ -1316,7 +1316,7 @@ void VJSObject::SetProperty( const VString& inPropertyName, const VJSValue& inVa
 		obj->Set(propStr, propVal);
     }
 #else
-	JSStringRef jsName = JS4D::VStringToString( inPropertyName);
+	JSStringRef jsName = JS4D::VStringToPropertyName( inPropertyName);
 	JSObjectSetProperty( fContext, fObject, jsName, inValue, inAttributes, VJSException::GetExceptionRefIfNotNull(outException));
 	JSStringRelease( jsName);
 #endif
@@ -1345,7 +1345,7 @@ void VJSObject::SetProperty( const XBOX::VString& inPropertyName, const VJSObjec
 		v8PersContext->Reset(fContext, context);
 	}
 #else
-	JSStringRef jsName = JS4D::VStringToString( inPropertyName);
+	JSStringRef jsName = JS4D::VStringToPropertyName( inPropertyName);
 	JSObjectSetProperty( fContext, fObject, jsName, inObject.GetObjectRef(), inAttributes, VJSException::GetExceptionRefIfNotNull(outException));
 	JSStringRelease( jsName);
 #endif
@@ -1363,7 +1363,7 @@ void VJSObject::SetProperty( const XBOX::VString& inPropertyName, const VJSArray
 		SetProperty(inPropertyName, tmpObj, inAttributes, outException);
 	}
 #else
-	JSStringRef jsName = JS4D::VStringToString( inPropertyName);
+	JSStringRef jsName = JS4D::VStringToPropertyName( inPropertyName);
 	JSObjectSetProperty(fContext, fObject, jsName, inArray.fObject, inAttributes, VJSException::GetExceptionRefIfNotNull(outException));
 	JSStringRelease( jsName);
 #endif
@@ -1383,7 +1383,7 @@ void VJSObject::SetProperty( const VString& inPropertyName, bool inBoolean, JS4D
 
     obj->Set(String::NewSymbol(bufferTmp.GetCPointer()),propVal);
 #else
-	JSStringRef jsName = JS4D::VStringToString(inPropertyName);
+	JSStringRef jsName = JS4D::VStringToPropertyName( inPropertyName);
 	JSObjectSetProperty(
 		fContext, 
 		fObject, 
@@ -1411,7 +1411,7 @@ VJSValue VJSObject::GetProperty( const VString& inPropertyName, JS4D::ExceptionR
 	return VJSValue(fContext);
 
 #else
-	JSStringRef jsName = JS4D::VStringToString( inPropertyName);
+	JSStringRef jsName = JS4D::VStringToPropertyName( inPropertyName);
 	JSValueRef valueRef = JSObjectGetProperty( fContext, fObject, jsName, outException);
 	JSStringRelease( jsName);
 	return VJSValue( fContext, valueRef);
@@ -1448,7 +1448,7 @@ VJSObject VJSObject::GetPropertyAsObject( const VString& inPropertyName, JS4D::E
 	return VJSObject(fContext);
 
 #else
-	JSStringRef jsName = JS4D::VStringToString( inPropertyName);
+	JSStringRef jsName = JS4D::VStringToPropertyName( inPropertyName);
 	JSValueRef value = JSObjectGetProperty( fContext, fObject, jsName, outException);
 	JSObjectRef objectRef = ((value != NULL) && JSValueIsObject( fContext, value)) ? JSValueToObject( fContext, value, outException) : NULL;
 	JSStringRelease( jsName);
@@ -1575,7 +1575,7 @@ bool VJSObject::DeleteProperty( const VString& inPropertyName, JS4D::ExceptionRe
 #if USE_V8_ENGINE
 	DebugMsg("VJSObject::DeleteProperty called\n");
 #else
-	JSStringRef jsName = JS4D::VStringToString( inPropertyName);
+	JSStringRef jsName = JS4D::VStringToPropertyName( inPropertyName);
 	ok = JSObjectDeleteProperty( fContext, fObject, jsName, outException);
 	JSStringRelease( jsName);
 #endif
@@ -2426,9 +2426,7 @@ size_t VJSArray::GetLength() const
 		length = tmpArray->Length();
 	}
 #else
-	JSStringRef jsString = JSStringCreateWithUTF8CString( "length");
-	JSValueRef result = JSObjectGetProperty( fContext, fObject, jsString, NULL);
-	JSStringRelease( jsString);
+	JSValueRef result = JSObjectGetProperty( fContext, fObject, JS4D::GetPropertyName( JS4D::ePropertyName_length), NULL);
 	if (testAssert( result != NULL))
 	{
 		double r = JSValueToNumber( fContext, result, NULL);
@@ -2565,10 +2563,8 @@ void VJSArray::_Splice( size_t inWhere, size_t inCount, const std::vector<VJSVal
 	DebugMsg("VJSArray::_Splice called\n");
 #else
 	JS4D::ExceptionRef*		jsException = VJSException::GetExceptionRefIfNotNull(outException);
-	JSStringRef jsString = JSStringCreateWithUTF8CString( "splice");
-	JSValueRef splice = JSObjectGetProperty( fContext, fObject, jsString, jsException);
+	JSValueRef splice = JSObjectGetProperty( fContext, fObject, JS4D::GetPropertyName( JS4D::ePropertyName_splice), jsException);
 	JSObjectRef spliceFunction = JSValueToObject( fContext, splice, jsException);
-    JSStringRelease( jsString);
 
 	JSValueRef *values = new JSValueRef[2 + ((inValues != NULL) ? inValues->size() : 0)];
 	if (values != NULL)
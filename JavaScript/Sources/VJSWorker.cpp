@@ -29,6 +29,7 @@
 #include "VJSProcess.h"
 #include "VJSWebSocket.h"
 #include "VJSSystemWorker.h"
+#include "VJSScriptCache.h"
 
 USING_TOOLBOX_NAMESPACE
 
@@ -345,12 +346,11 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 		
 		// If there is an event to be triggered, process it.
 		
-		if (!fEventQueue.empty() && currentTime >= fEventQueue.front()->GetTriggerTime()) {
+		if (!fEventQueue.IsEmpty() && currentTime >= fEventQueue.GetFront()->GetTriggerTime()) {
 
 			IJSEvent	*event;
 
-			event = fEventQueue.front();
-			fEventQueue.pop_front();
+			event = fEventQueue.PopFront();
 
 			// If an event generator and event type has been specified, check if the event to process is matching.
 
@@ -409,7 +409,7 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 		uLONG			waitDuration;
 						
 		isTimedOutWait = true;
-		if (fEventQueue.empty()) {
+		if (fEventQueue.IsEmpty()) {
 
 			if (inWaitingDuration > 0) {
 
@@ -430,7 +430,7 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 
 			XBOX::VTime	minimum;
 
-			minimum = fEventQueue.front()->GetTriggerTime();
+			minimum = fEventQueue.GetFront()->GetTriggerTime();
 			if (inWaitingDuration > 0 && minimum > endTime)
 
 				minimum = endTime;
@@ -619,17 +619,9 @@ void VJSWorker::QueueEvent (IJSEvent *inEvent)
 
 	}
 
-	std::list<IJSEvent *>::iterator	i;
-	
-	for (i = fEventQueue.begin(); i != fEventQueue.end(); i++) 
-
-		// If two events have identical trigger time, first queued will be processed first.
-		
-		if ((*i)->GetTriggerTime() > inEvent->GetTriggerTime())
+	// If two events have identical trigger time, first queued will be processed first.
 
-			break;
-
-	fEventQueue.insert(i, inEvent);	
+	fEventQueue.Push(inEvent);
 
 	// Send a VMessage to running VTask, only in studio and for SystemWorker events.
 
@@ -660,7 +652,7 @@ void VJSWorker::UnscheduleTimer (VJSTimer *inTimer)
 
 	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
 
-	VJSTimerEvent::RemoveTimerEvent(&fEventQueue, inTimer);	
+	fEventQueue.RemoveTimerEvent(inTimer);
 }
 
 void VJSWorker::AddMessagePort (VJSMessagePort *inMessagePort)
@@ -803,7 +795,7 @@ void VJSWorker::ExecuteHasEventMessage (VJSHasEventMessage *inMessage)
 {
 	if (fWaitForMutex.TryToLock()) {
 	
-		if (!fInsideWaitCount && fEventQueue.size()) {
+		if (!fInsideWaitCount && !fEventQueue.IsEmpty()) {
 
 			XBOX::VJSContext		context((XBOX::JS4D::ContextRef) fRootGlobalContext);
 			XBOX::VJSGlobalObject	*globalObject	= context.GetGlobalObjectPrivateInstance();
@@ -912,7 +904,7 @@ VJSWorker::~VJSWorker ()
 
 	// All references should have been released.
 	
-	xbox_assert(fEventQueue.empty());
+	xbox_assert(fEventQueue.IsEmpty());
 
 	// Free VTask and remove worker from dedicated, shared, or root worker list.
 
@@ -1102,18 +1094,10 @@ bool VJSWorker::_LoadAndCheckScript (XBOX::VError *outError, XBOX::VString *outE
 
 	}
 
-	XBOX::VFile			file(fullPath, XBOX::FPS_POSIX);
-	XBOX::VFileStream	stream(&file);
-	XBOX::VError		error;
-	
-	if ((error = stream.OpenReading()) == XBOX::VE_OK
-	&& (error = stream.GuessCharSetFromLeadingBytes(XBOX::VTC_DefaultTextExport)) == XBOX::VE_OK) {
-
-		stream.SetCarriageReturnMode(XBOX::eCRM_NATIVE);
-		error = stream.GetText(fScript);
+	XBOX::VFile		file(fullPath, XBOX::FPS_POSIX);
+	XBOX::VError	error;
 
-	}
-	stream.CloseReading();
+	error = XBOX::VJSScriptCache::Get()->LoadScript(file, fScript);
 	
 	if (error != XBOX::VE_OK) {
 
@@ -1423,12 +1407,7 @@ void VJSWorker::_ReleaseAllReferences ()
 
 	// Discard all events.
 
-	while (!fEventQueue.empty()) {
-
-		fEventQueue.front()->Discard();
-		fEventQueue.pop_front();
-
-	}
+	fEventQueue.DiscardAll();
 	
 	// Release all error ports, requesting termination of "child" dedicated workers if needed.
 
@@ -22,6 +22,7 @@
 #include "VJSClass.h"
 #include "VJSValue.h"
 #include "VJSTimer.h"
+#include "VJSEvent.h"
 
 #define VJSWORKER_WITH_PROJECT_INFO_RETAIN_JS	0
 
@@ -240,7 +241,7 @@ private:
 	bool									fHasReleasedAll, fClosingFlag, fExitWaitFlag;
 	XBOX::VSyncEvent						fSyncEvent;
 	bool									fIsLockedWaiting;			// True if locked waiting on fSyncEvent.
-	std::list<IJSEvent *>					fEventQueue;		
+	VJSEventQueue							fEventQueue;		
 	std::list< VRefPtr<VJSMessagePort> >	fMessagePorts;				// List of all message ports (any type), they may be "duplicated" elsewhere.
 	VJSTimerContext							fTimerContext;				// All timers.
 	
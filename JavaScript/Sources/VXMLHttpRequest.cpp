@@ -977,7 +977,7 @@ void VJSXMLHttpRequest::_GetReadyState(VJSParms_getProperty& ioParms, VXMLHttpRe
 
 void VJSXMLHttpRequest::_GetStatus(VJSParms_getProperty& ioParms, VXMLHttpRequest* inXhr)
 {
-    StErrorContextInstaller ctx(false /*we drop errors*/, true /*from now on, popups are forbidden*/);
+    StErrorCapture ctx;	// errors are dropped and silent
     
 	VLong value(0);
 	VError res=inXhr->GetStatus(&value);
@@ -991,7 +991,7 @@ void VJSXMLHttpRequest::_GetStatus(VJSParms_getProperty& ioParms, VXMLHttpReques
 
 void VJSXMLHttpRequest::_GetStatusText(VJSParms_getProperty& ioParms, VXMLHttpRequest* inXhr)
 {
-    StErrorContextInstaller ctx(false /*we drop errors*/, true /*from now on, popups are forbidden*/);
+    StErrorCapture ctx;	// errors are dropped and silent
 
     VString value;
     VError res=inXhr->GetStatusText(&value);
@@ -1011,7 +1011,7 @@ void VJSXMLHttpRequest::_GetResponseHeader(VJSParms_callStaticFunction& ioParms,
 
     if(resHeader!=NULL)
     {
-        StErrorContextInstaller ctx(false /*we drop errors*/, true /*from now on, popups are forbidden*/);
+        StErrorCapture ctx;	// errors are dropped and silent
 
         VString value;
         VError res;
@@ -1030,7 +1030,7 @@ void VJSXMLHttpRequest::_GetResponseHeader(VJSParms_callStaticFunction& ioParms,
 
 void VJSXMLHttpRequest::_GetAllResponseHeaders(VJSParms_callStaticFunction& ioParms, VXMLHttpRequest* inXhr)
 {
-    StErrorContextInstaller ctx(false /*we drop errors*/, true /*from now on, popups are forbidden*/);
+    StErrorCapture ctx;	// errors are dropped and silent
 
     VString value;
     VError res=inXhr->GetAllResponseHeaders(&value);
@@ -1044,7 +1044,7 @@ void VJSXMLHttpRequest::_GetAllResponseHeaders(VJSParms_callStaticFunction& ioPa
 
 void VJSXMLHttpRequest::_GetResponseText(VJSParms_getProperty& ioParms, VXMLHttpRequest* inXhr)
 {
-    StErrorContextInstaller ctx(false /*we drop errors*/, true /*from now on, popups are forbidden*/);
+    StErrorCapture ctx;	// errors are dropped and silent
 
     VString value;
     VError res=inXhr->GetResponseText(&value);
@@ -1081,7 +1081,7 @@ bool VJSXMLHttpRequest::_SetResponseType(VJSParms_setProperty& ioParms, VXMLHttp
 
 void VJSXMLHttpRequest::_GetResponseType(VJSParms_getProperty& ioParms, VXMLHttpRequest* inXhr)
 {
-    StErrorContextInstaller ctx(false /*we drop errors*/, true /*from now on, popups are forbidden*/);
+    StErrorCapture ctx;	// errors are dropped and silent
 
 	VString value;
 	VError res=inXhr->GetResponseType(&value);
@@ -1095,7 +1095,7 @@ void VJSXMLHttpRequest::_GetResponseType(VJSParms_getProperty& ioParms, VXMLHttp
 
 void VJSXMLHttpRequest::_GetResponse(VJSParms_getProperty& ioParms, VXMLHttpRequest* inXhr)
 {
-    StErrorContextInstaller ctx(false /*we drop errors*/, true /*from now on, popups are forbidden*/);
+    StErrorCapture ctx;	// errors are dropped and silent
 
 	VJSValue value(ioParms.GetContext());
 	VError res=inXhr->GetResponse(value);
@@ -38,6 +38,7 @@
 #include "Sources/VJSRuntime_Atomic.h"
 #include "Sources/VJSRuntime_blob.h"
 #include "Sources/VJSGlobalClass.h"
+#include "Sources/VJSContextPool.h"
 #if WITH_NATIVE_HTTP_BACKEND
 #include "Sources/VXMLHttpRequest.h"
 #endif
@@ -35,9 +35,27 @@
 
 #include "VKernelPrecompiled.h"
 #include "VError.h"
+#include "VErrorContext.h"
+#include "VMemory.h"
 #include "Base64Coder.h"
 
-static const size_t	B64CODER_BASELENGTH	= 255;
+// x86 extensions are compiled per function and selected at runtime
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#include <cpuid.h>
+	#include <immintrin.h>
+	#define BASE64_WITH_X86				1
+	#define BASE64_TARGET(_features_)	__attribute__((target(_features_)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+	#include <immintrin.h>
+	#define BASE64_WITH_X86				1
+	#define BASE64_TARGET(_features_)
+#else
+	#define BASE64_WITH_X86				0
+#endif
+
+// 256 so that any octet can index the inverse table
+static const size_t	B64CODER_BASELENGTH	= 256;
 static const size_t	B64CODER_FOURBYTE	= 4;
 static const uBYTE	BASE64_PADDING		= 0x3D;
 
@@ -102,6 +120,226 @@ inline void split3rdOctet(const uBYTE& ch, uBYTE& b3, uBYTE& b4)
     b4 = ( ch & 0x3f );
 }
 
+
+// -----------------------------------------------------------------------
+//  Vector kernels
+// -----------------------------------------------------------------------
+enum
+{
+	kBase64_Scalar	= 1,
+	kBase64_SSSE3	= 2,
+	kBase64_AVX2	= 3
+};
+
+static sLONG sBase64Kernel = 0;
+
+#if BASE64_WITH_X86
+static uLONG8 _GetXCR0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv( 0);
+#else
+	uLONG eax, edx;
+	__asm__ __volatile__ ( "xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return ((uLONG8) edx << 32) | eax;
+#endif
+}
+#endif
+
+static sLONG _GetBase64Kernel()
+{
+	sLONG kernel = sBase64Kernel;
+	if (kernel == 0)
+	{
+		// every task computes the same value so there's no need to synchronize
+		kernel = kBase64_Scalar;
+	#if BASE64_WITH_X86
+		uLONG regs1[4] = { 0, 0, 0, 0};	// eax, ebx, ecx, edx
+		uLONG regs7[4] = { 0, 0, 0, 0};
+		#if defined(_MSC_VER)
+		int info[4];
+		__cpuid( info, 0);
+		uLONG maxLeaf = (uLONG) info[0];
+		__cpuid( info, 1);
+		for( int i = 0 ; i < 4 ; ++i)
+			regs1[i] = (uLONG) info[i];
+		if (maxLeaf >= 7)
+		{
+			__cpuidex( info, 7, 0);
+			for( int i = 0 ; i < 4 ; ++i)
+				regs7[i] = (uLONG) info[i];
+		}
+		#else
+		uLONG maxLeaf = __get_cpuid_max( 0, NULL);
+		if (maxLeaf >= 1)
+			__cpuid( 1, regs1[0], regs1[1], regs1[2], regs1[3]);
+		if (maxLeaf >= 7)
+			__cpuid_count( 7, 0, regs7[0], regs7[1], regs7[2], regs7[3]);
+		#endif
+		if (regs1[2] & (1 << 9))
+			kernel = kBase64_SSSE3;
+
+		// AVX2 also needs the OS to save the ymm registers (OSXSAVE, AVX, then XCR0)
+		if ( (regs1[2] & (1 << 27)) && (regs1[2] & (1 << 28)) && (regs7[1] & (1 << 5)) && ((_GetXCR0() & 6) == 6) )
+			kernel = kBase64_AVX2;
+	#endif
+		sBase64Kernel = kernel;
+	}
+	return kernel;
+}
+
+
+#if BASE64_WITH_X86
+
+/*
+	Encoding spreads 3 bytes on 4 bytes then moves each group of 6 bits with multiplications,
+	the resulting indices are turned into characters by adding an offset chosen with a lookup in a 16 bytes table.
+	Decoding checks each character with two nibble lookups, adds the reverse offset and packs 4 values of 6 bits with multiply-adds.
+	The AVX2 versions do the same on two 128 bits lanes.
+*/
+
+BASE64_TARGET("ssse3")
+static size_t _EncodeTriplets_SSSE3( const uBYTE *inData, size_t inCount, uBYTE *outData)
+{
+	const __m128i spread = _mm_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	const __m128i offsets = _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+	size_t done = 0;
+
+	// 16 bytes are loaded for 12 encoded ones so that at least 2 triplets must remain after the block
+	for( ; done + 6 <= inCount ; done += 4)
+	{
+		__m128i bytes = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*) (inData + done * 3)), spread);
+		__m128i t0 = _mm_mulhi_epu16( _mm_and_si128( bytes, _mm_set1_epi32( 0x0FC0FC00)), _mm_set1_epi32( 0x04000040));
+		__m128i t1 = _mm_mullo_epi16( _mm_and_si128( bytes, _mm_set1_epi32( 0x003F03F0)), _mm_set1_epi32( 0x01000010));
+		__m128i indices = _mm_or_si128( t0, t1);
+
+		// 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+		__m128i ranges = _mm_subs_epu8( indices, _mm_set1_epi8( 51));
+		ranges = _mm_or_si128( ranges, _mm_and_si128( _mm_cmpgt_epi8( _mm_set1_epi8( 26), indices), _mm_set1_epi8( 13)));
+
+		_mm_storeu_si128( (__m128i*) (outData + done * 4), _mm_add_epi8( indices, _mm_shuffle_epi8( offsets, ranges)));
+	}
+
+	return done;
+}
+
+
+BASE64_TARGET("avx2")
+static size_t _EncodeTriplets_AVX2( const uBYTE *inData, size_t inCount, uBYTE *outData)
+{
+	const __m256i spread = _mm256_broadcastsi128_si256( _mm_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+	const __m256i offsets = _mm256_broadcastsi128_si256( _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+
+	size_t done = 0;
+
+	// each lane loads 16 bytes for 12 encoded ones so that at least 2 triplets must remain after the block
+	for( ; done + 10 <= inCount ; done += 8)
+	{
+		const uBYTE *input = inData + done * 3;
+		__m256i bytes = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*) input)), _mm_loadu_si128( (const __m128i*) (input + 12)), 1);
+		bytes = _mm256_shuffle_epi8( bytes, spread);
+		__m256i t0 = _mm256_mulhi_epu16( _mm256_and_si256( bytes, _mm256_set1_epi32( 0x0FC0FC00)), _mm256_set1_epi32( 0x04000040));
+		__m256i t1 = _mm256_mullo_epi16( _mm256_and_si256( bytes, _mm256_set1_epi32( 0x003F03F0)), _mm256_set1_epi32( 0x01000010));
+		__m256i indices = _mm256_or_si256( t0, t1);
+
+		__m256i ranges = _mm256_subs_epu8( indices, _mm256_set1_epi8( 51));
+		ranges = _mm256_or_si256( ranges, _mm256_and_si256( _mm256_cmpgt_epi8( _mm256_set1_epi8( 26), indices), _mm256_set1_epi8( 13)));
+
+		_mm256_storeu_si256( (__m256i*) (outData + done * 4), _mm256_add_epi8( indices, _mm256_shuffle_epi8( offsets, ranges)));
+	}
+
+	return done;
+}
+
+
+// Returns the count of decoded quadruplets, it stops before the first block holding an invalid character.
+BASE64_TARGET("ssse3")
+static size_t _DecodeQuadruplets_SSSE3( const uBYTE *inData, size_t inCount, uBYTE *outData)
+{
+	// offsets per high nibble, '/' is handled apart
+	const __m128i offsets = _mm_setr_epi8( 0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	// for each low nibble, one bit per valid high nibble
+	const __m128i validHigh = _mm_setr_epi8( (char) 0xA8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF0, 0x54, 0x50, 0x50, 0x50, 0x54);
+	const __m128i highBit = _mm_setr_epi8( 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char) 0x80, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i pack = _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m128i nibble = _mm_set1_epi8( 0x0F);
+
+	size_t done = 0;
+
+	// 16 bytes are stored for 12 decoded ones so that at least 2 quadruplets must remain after the block
+	for( ; done + 6 <= inCount ; done += 4)
+	{
+		__m128i chars = _mm_loadu_si128( (const __m128i*) (inData + done * 4));
+		__m128i high = _mm_and_si128( _mm_srli_epi32( chars, 4), nibble);
+		__m128i valid = _mm_and_si128( _mm_shuffle_epi8( validHigh, _mm_and_si128( chars, nibble)), _mm_shuffle_epi8( highBit, high));
+		if (_mm_movemask_epi8( _mm_cmpeq_epi8( valid, _mm_setzero_si128())) != 0)
+			break;
+
+		__m128i isSlash = _mm_cmpeq_epi8( chars, _mm_set1_epi8( '/'));
+		__m128i offset = _mm_or_si128( _mm_andnot_si128( isSlash, _mm_shuffle_epi8( offsets, high)), _mm_and_si128( isSlash, _mm_set1_epi8( 63 - '/')));
+		__m128i values = _mm_add_epi8( chars, offset);
+
+		// 00aaaaaa 00bbbbbb 00cccccc 00dddddd -> aaaaaabb bbbbcccc ccdddddd
+		__m128i merged = _mm_madd_epi16( _mm_maddubs_epi16( values, _mm_set1_epi32( 0x01400140)), _mm_set1_epi32( 0x00011000));
+		_mm_storeu_si128( (__m128i*) (outData + done * 3), _mm_shuffle_epi8( merged, pack));
+	}
+
+	return done;
+}
+
+
+BASE64_TARGET("avx2")
+static size_t _DecodeQuadruplets_AVX2( const uBYTE *inData, size_t inCount, uBYTE *outData)
+{
+	const __m256i offsets = _mm256_broadcastsi128_si256( _mm_setr_epi8( 0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+	const __m256i validHigh = _mm256_broadcastsi128_si256( _mm_setr_epi8( (char) 0xA8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF8, (char) 0xF0, 0x54, 0x50, 0x50, 0x50, 0x54));
+	const __m256i highBit = _mm256_broadcastsi128_si256( _mm_setr_epi8( 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char) 0x80, 0, 0, 0, 0, 0, 0, 0, 0));
+	const __m256i pack = _mm256_broadcastsi128_si256( _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	const __m256i nibble = _mm256_set1_epi8( 0x0F);
+
+	size_t done = 0;
+
+	// each lane stores 16 bytes for 12 decoded ones so that at least 2 quadruplets must remain after the block
+	for( ; done + 10 <= inCount ; done += 8)
+	{
+		__m256i chars = _mm256_loadu_si256( (const __m256i*) (inData + done * 4));
+		__m256i high = _mm256_and_si256( _mm256_srli_epi32( chars, 4), nibble);
+		__m256i valid = _mm256_and_si256( _mm256_shuffle_epi8( validHigh, _mm256_and_si256( chars, nibble)), _mm256_shuffle_epi8( highBit, high));
+		if (_mm256_movemask_epi8( _mm256_cmpeq_epi8( valid, _mm256_setzero_si256())) != 0)
+			break;
+
+		__m256i isSlash = _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '/'));
+		__m256i offset = _mm256_or_si256( _mm256_andnot_si256( isSlash, _mm256_shuffle_epi8( offsets, high)), _mm256_and_si256( isSlash, _mm256_set1_epi8( 63 - '/')));
+		__m256i values = _mm256_add_epi8( chars, offset);
+
+		__m256i merged = _mm256_madd_epi16( _mm256_maddubs_epi16( values, _mm256_set1_epi32( 0x01400140)), _mm256_set1_epi32( 0x00011000));
+		merged = _mm256_shuffle_epi8( merged, pack);
+
+		uBYTE *output = outData + done * 3;
+		_mm_storeu_si128( (__m128i*) output, _mm256_castsi256_si128( merged));
+		_mm_storeu_si128( (__m128i*) (output + 12), _mm256_extracti128_si256( merged, 1));
+	}
+
+	return done;
+}
+
+#endif	// BASE64_WITH_X86
+
+
+// Removes RFC2045 white spaces in place and returns the new size.
+static size_t _RemoveWhiteSpaces( uBYTE *ioData, size_t inSize)
+{
+	uBYTE *destination = ioData;
+	for( const uBYTE *p = ioData, *end = ioData + inSize ; p != end ; ++p)
+	{
+		if ( (*p != 0x20) && (*p != 0x09) && (*p != 0x0D) && (*p != 0x0A) )
+			*destination++ = *p;
+	}
+	return destination - ioData;
+}
+
+
 bool Base64Coder::Encode( const void *inInputData, size_t inInputSize, VMemoryBuffer<>&	outResult, sLONG inQuadsPerLine)
 {
 	xbox_assert(inQuadsPerLine > 0);
@@ -125,11 +363,6 @@ bool Base64Coder::Encode( const void *inInputData, size_t inInputSize, VMemoryBu
 	if (!outResult.SetSize( quadrupletCount*B64CODER_FOURBYTE + lineCount * 2))
 		return false;
 
-    //
-    // convert the triplet(s) to quadruplet(s)
-    //
-    uBYTE  b1, b2, b3, b4;  // base64 binary codes ( 0..63 )
-
 	size_t inputIndex = 0;
 	size_t outputIndex = 0;
 
@@ -137,21 +370,17 @@ bool Base64Coder::Encode( const void *inInputData, size_t inInputSize, VMemoryBu
 	const uBYTE *inputData = (const uBYTE *) inInputData;
 
 	//
-	// Process all quadruplet(s) except the last
+	// Process all quadruplet(s) except the last, one line at a time
 	//
-	size_t quad = 1;
-	for (; quad <= quadrupletCount-1; quad++ )
+	size_t fullCount = quadrupletCount - 1;
+	size_t quad = 0;
+	while (quad < fullCount)
 	{
-		// read triplet from the input stream
-		split1stOctet( inputData[ inputIndex++ ], b1, b2 );
-		split2ndOctet( inputData[ inputIndex++ ], b2, b3 );
-		split3rdOctet( inputData[ inputIndex++ ], b3, b4 );
-
-		// write quadruplet to the output stream
-		encodedData[ outputIndex++ ] = sBase64Alphabet[ b1 ];
-		encodedData[ outputIndex++ ] = sBase64Alphabet[ b2 ];
-		encodedData[ outputIndex++ ] = sBase64Alphabet[ b3 ];
-		encodedData[ outputIndex++ ] = sBase64Alphabet[ b4 ];
+		size_t count = Min( (size_t) inQuadsPerLine - (quad % inQuadsPerLine), fullCount - quad);
+		EncodeTriplets( inputData + inputIndex, count, encodedData + outputIndex);
+		inputIndex += count * 3;
+		outputIndex += count * B64CODER_FOURBYTE;
+		quad += count;
 
 		// Use CRLF for line breaks.
 
@@ -166,51 +395,90 @@ bool Base64Coder::Encode( const void *inInputData, size_t inInputSize, VMemoryBu
 	//
 	// process the last Quadruplet
 	//
+	EncodeLastBytes( inputData + inputIndex, inInputSize - inputIndex, encodedData + outputIndex);
+	outputIndex += B64CODER_FOURBYTE;
+
+	xbox_assert(outResult.GetDataSize() == outputIndex);
+
+	outResult.ShrinkSizeNoReallocate( outputIndex);
+
+	return true;
+}
+
+
+void Base64Coder::EncodeTriplets( const void *inData, size_t inTripletCount, void *outResult)
+{
+	Init();
+
+	const uBYTE *inputData = (const uBYTE*) inData;
+	uBYTE *encodedData = (uBYTE*) outResult;
+	size_t done = 0;
+
+#if BASE64_WITH_X86
+	sLONG kernel = _GetBase64Kernel();
+	if (kernel == kBase64_AVX2)
+		done = _EncodeTriplets_AVX2( inputData, inTripletCount, encodedData);
+	if (kernel >= kBase64_SSSE3)
+		done += _EncodeTriplets_SSSE3( inputData + done * 3, inTripletCount - done, encodedData + done * B64CODER_FOURBYTE);
+#endif
+
+	inputData += done * 3;
+	encodedData += done * B64CODER_FOURBYTE;
+	for( ; done < inTripletCount ; ++done, inputData += 3, encodedData += B64CODER_FOURBYTE)
+	{
+		uLONG triplet = ((uLONG) inputData[0] << 16) | ((uLONG) inputData[1] << 8) | inputData[2];
+		encodedData[0] = sBase64Alphabet[ triplet >> 18 ];
+		encodedData[1] = sBase64Alphabet[ (triplet >> 12) & 0x3f ];
+		encodedData[2] = sBase64Alphabet[ (triplet >> 6) & 0x3f ];
+		encodedData[3] = sBase64Alphabet[ triplet & 0x3f ];
+	}
+}
+
+
+void Base64Coder::EncodeLastBytes( const void *inData, size_t inDataSize, void *outResult)
+{
+	xbox_assert( (inDataSize >= 1) && (inDataSize <= 3));
+
+	Init();
+
+    uBYTE  b1, b2, b3, b4;  // base64 binary codes ( 0..63 )
+	const uBYTE *inputData = (const uBYTE*) inData;
+	uBYTE *encodedData = (uBYTE*) outResult;
+
 	// first octet is present always, process it
-	split1stOctet( inputData[ inputIndex++ ], b1, b2 );
-	encodedData[ outputIndex++ ] = sBase64Alphabet[ b1 ];
+	split1stOctet( inputData[0], b1, b2 );
+	encodedData[0] = sBase64Alphabet[ b1 ];
 
-	if( inputIndex < inInputSize)
+	if (inDataSize > 1)
 	{
 		// second octet is present, process it
-		split2ndOctet( inputData[ inputIndex++ ], b2, b3 );
-		encodedData[ outputIndex++ ] = sBase64Alphabet[ b2 ];
+		split2ndOctet( inputData[1], b2, b3 );
+		encodedData[1] = sBase64Alphabet[ b2 ];
 
-		if( inputIndex < inInputSize )
+		if (inDataSize > 2)
 		{
 			// third octet present, process it
 			// no PAD e.g. 3cQl
-			split3rdOctet( inputData[ inputIndex++ ], b3, b4 );
-			encodedData[ outputIndex++ ] = sBase64Alphabet[ b3 ];
-			encodedData[ outputIndex++ ] = sBase64Alphabet[ b4 ];
+			split3rdOctet( inputData[2], b3, b4 );
+			encodedData[2] = sBase64Alphabet[ b3 ];
+			encodedData[3] = sBase64Alphabet[ b4 ];
 		}
 		else
 		{
 			// third octet not present
 			// one PAD e.g. 3cQ=
-			encodedData[ outputIndex++ ] = sBase64Alphabet[ b3 ];
-			encodedData[ outputIndex++ ] = BASE64_PADDING;
+			encodedData[2] = sBase64Alphabet[ b3 ];
+			encodedData[3] = BASE64_PADDING;
 		}
 	}
 	else
 	{
 		// second octet not present
 		// two PADs e.g. 3c==
-		encodedData[ outputIndex++ ] = sBase64Alphabet[ b2 ];
-		encodedData[ outputIndex++ ] = BASE64_PADDING;
-		encodedData[ outputIndex++ ] = BASE64_PADDING;
+		encodedData[1] = sBase64Alphabet[ b2 ];
+		encodedData[2] = BASE64_PADDING;
+		encodedData[3] = BASE64_PADDING;
 	}
-
-	xbox_assert(outResult.GetDataSize() == outputIndex);
-
-	// write out end of the last line
-	//encodedData[ outputIndex++ ] = 0x0A;
-	// write out end of string
-	// encodedData[ outputIndex ] = 0;
-
-	outResult.ShrinkSizeNoReallocate( outputIndex);
-
-	return true;
 }
 
 
@@ -253,7 +521,6 @@ bool Base64Coder::Decode ( const void *inInputData, size_t inInputSize, VMemoryB
 	VMemoryBuffer<> rawInputBuffer;
 
 	const uBYTE *inputData = (const uBYTE*) inInputData;
-	size_t inputIndex = 0;
 	const uBYTE *rawInputData = inputData;
 	size_t rawInputLength = inInputSize;
 
@@ -267,22 +534,14 @@ bool Base64Coder::Decode ( const void *inInputData, size_t inInputSize, VMemoryB
 					if (rawInputBuffer.SetSize( inInputSize))
 					{
 						rawInputData = (const uBYTE*) rawInputBuffer.GetDataPtr();
-						rawInputLength = 0;
-						while ( inputIndex < inInputSize )
-						{
-							//if (!XMLChar1_0::isWhitespace(inputData[inputIndex]))
-							if (std::find( whites, whites+sizeof(whites), inputData[inputIndex]) == whites+sizeof(whites))
-							{
-								const_cast<uBYTE*>(rawInputData)[ rawInputLength++ ] = inputData[ inputIndex ];
-							}
-							// RFC2045 does not explicitly forbid more than ONE whitespace 
-							// before, in between, or after base64 octects.
-							// Besides, S? allows more than ONE whitespace as specified in the production 
-							// [3]   S   ::=   (#x20 | #x9 | #xD | #xA)+
-							// therefore we do not detect multiple ws
-
-							inputIndex++;
-						}
+						::memcpy( rawInputBuffer.GetDataPtr(), inputData, inInputSize);
+
+						// RFC2045 does not explicitly forbid more than ONE whitespace 
+						// before, in between, or after base64 octects.
+						// Besides, S? allows more than ONE whitespace as specified in the production 
+						// [3]   S   ::=   (#x20 | #x9 | #xD | #xA)+
+						// therefore we do not detect multiple ws
+						rawInputLength = _RemoveWhiteSpaces( (uBYTE*) rawInputBuffer.GetDataPtr(), inInputSize);
 					}
 					else
 					{
@@ -345,61 +604,93 @@ bool Base64Coder::Decode ( const void *inInputData, size_t inInputSize, VMemoryB
 	if (!outResult.SetSize( quadrupletCount*3 + 1))
 		return false;
 
-    //
-    // convert the quadruplet(s) to triplet(s)
-    //
-    uBYTE d1, d2, d3, d4;  // base64 characters
-    uBYTE b1, b2, b3, b4;  // base64 binary codes ( 0..64 )
-
-    size_t rawInputIndex  = 0;
-    size_t outputIndex    = 0;
-	
     uBYTE *decodedData = (uBYTE *) outResult.GetDataPtr();
 
     //
     // Process all quadruplet(s) except the last
     //
-    size_t quad = 1;
-    for (; quad <= quadrupletCount-1; quad++ )
-    {
-        // read quadruplet from the input stream
-        if (!isData( (d1 = rawInputData[ rawInputIndex++ ]) ) ||
-            !isData( (d2 = rawInputData[ rawInputIndex++ ]) ) ||
-            !isData( (d3 = rawInputData[ rawInputIndex++ ]) ) ||
-            !isData( (d4 = rawInputData[ rawInputIndex++ ]) ))
-        {
-            // if found "no data" just return NULL
-            return false;
-        }
+    if (!DecodeQuadruplets( rawInputData, quadrupletCount - 1, decodedData))
+        return false;	// if found "no data" just return NULL
 
-        b1 = sBase64Inverse[ d1 ];
-        b2 = sBase64Inverse[ d2 ];
-        b3 = sBase64Inverse[ d3 ];
-        b4 = sBase64Inverse[ d4 ];
-
-        // write triplet to the output stream
-        decodedData[ outputIndex++ ] = set1stOctet(b1, b2);
-        decodedData[ outputIndex++ ] = set2ndOctet(b2, b3);
-        decodedData[ outputIndex++ ] = set3rdOctet(b3, b4);
-    }
+    size_t outputIndex = (quadrupletCount - 1) * 3;
 
     //
     // process the last Quadruplet
     //
+    size_t lastCount = DecodeLastQuadruplet( rawInputData + (quadrupletCount - 1) * B64CODER_FOURBYTE, decodedData + outputIndex);
+    if (lastCount == 0)
+        return false;
+
+    outputIndex += lastCount;
+
+    // write out the end of string
+    outResult.ShrinkSizeNoReallocate( outputIndex);
+
+	return true;
+}
+
+
+bool Base64Coder::DecodeQuadruplets( const void *inData, size_t inQuadrupletCount, void *outResult)
+{
+	Init();
+
+	const uBYTE *rawInputData = (const uBYTE*) inData;
+	uBYTE *decodedData = (uBYTE*) outResult;
+	size_t done = 0;
+
+#if BASE64_WITH_X86
+	sLONG kernel = _GetBase64Kernel();
+	if (kernel == kBase64_AVX2)
+		done = _DecodeQuadruplets_AVX2( rawInputData, inQuadrupletCount, decodedData);
+	if (kernel >= kBase64_SSSE3)
+		done += _DecodeQuadruplets_SSSE3( rawInputData + done * B64CODER_FOURBYTE, inQuadrupletCount - done, decodedData + done * 3);
+#endif
+
+	// the vector kernels stop before an invalid character, the scalar loop finds it
+	rawInputData += done * B64CODER_FOURBYTE;
+	decodedData += done * 3;
+	for( ; done < inQuadrupletCount ; ++done, rawInputData += B64CODER_FOURBYTE, decodedData += 3)
+	{
+		uLONG b1 = sBase64Inverse[ rawInputData[0] ];
+		uLONG b2 = sBase64Inverse[ rawInputData[1] ];
+		uLONG b3 = sBase64Inverse[ rawInputData[2] ];
+		uLONG b4 = sBase64Inverse[ rawInputData[3] ];
+		if ((b1 | b2 | b3 | b4) & 0x80)
+			return false;
+
+		uLONG triplet = (b1 << 18) | (b2 << 12) | (b3 << 6) | b4;
+		decodedData[0] = (uBYTE) (triplet >> 16);
+		decodedData[1] = (uBYTE) (triplet >> 8);
+		decodedData[2] = (uBYTE) triplet;
+	}
+
+	return true;
+}
+
+
+size_t Base64Coder::DecodeLastQuadruplet( const void *inData, void *outResult)
+{
+	Init();
+
+    uBYTE d1, d2, d3, d4;  // base64 characters
+    uBYTE b1, b2, b3, b4;  // base64 binary codes ( 0..64 )
+
+	const uBYTE *rawInputData = (const uBYTE*) inData;
+	uBYTE *decodedData = (uBYTE*) outResult;
+
     // first two octets are present always, process them
-    if (!isData( (d1 = rawInputData[ rawInputIndex++ ]) ) ||
-        !isData( (d2 = rawInputData[ rawInputIndex++ ]) ))
+    if (!isData( (d1 = rawInputData[0]) ) ||
+        !isData( (d2 = rawInputData[1]) ))
     {
-        // if found "no data" just return NULL
-        return false;
+        return 0;
     }
 
     b1 = sBase64Inverse[ d1 ];
     b2 = sBase64Inverse[ d2 ];
 
     // try to process last two octets
-    d3 = rawInputData[ rawInputIndex++ ];
-    d4 = rawInputData[ rawInputIndex++ ];
+    d3 = rawInputData[2];
+    d4 = rawInputData[3];
 
     if (!isData( d3 ) || !isData( d4 ))
     {
@@ -409,10 +700,11 @@ bool Base64Coder::Decode ( const void *inInputData, size_t inInputSize, VMemoryB
             // two PAD e.g. 3c==
             if ((b2 & 0xf) != 0) // last 4 bits should be zero
             {
-                return false;
+                return 0;
             }
 
-            decodedData[ outputIndex++ ] = set1stOctet(b1, b2);
+            decodedData[0] = set1stOctet(b1, b2);
+            return 1;
         }
         else if (!isPad( d3 ) && isPad( d4 ))
         {
@@ -420,34 +712,398 @@ bool Base64Coder::Decode ( const void *inInputData, size_t inInputSize, VMemoryB
             b3 = sBase64Inverse[ d3 ];
             if (( b3 & 0x3 ) != 0 ) // last 2 bits should be zero
             {
-                return false;
+                return 0;
             }
 
-            decodedData[ outputIndex++ ] = set1stOctet( b1, b2 );
-            decodedData[ outputIndex++ ] = set2ndOctet( b2, b3 );
+            decodedData[0] = set1stOctet( b1, b2 );
+            decodedData[1] = set2ndOctet( b2, b3 );
+            return 2;
         }
         else
         {
             // an error like "3c[Pad]r", "3cdX", "3cXd", "3cXX" where X is non data
-            return false;
+            return 0;
         }
     }
-    else
-    {
-        // no PAD e.g 3cQl
-        b3 = sBase64Inverse[ d3 ];
-        b4 = sBase64Inverse[ d4 ];
-        decodedData[ outputIndex++ ] = set1stOctet( b1, b2 );
-        decodedData[ outputIndex++ ] = set2ndOctet( b2, b3 );
-        decodedData[ outputIndex++ ] = set3rdOctet( b3, b4 );
-    }
 
-    // write out the end of string
-    outResult.ShrinkSizeNoReallocate( outputIndex);
+    // no PAD e.g 3cQl
+    b3 = sBase64Inverse[ d3 ];
+    b4 = sBase64Inverse[ d4 ];
+    decodedData[0] = set1stOctet( b1, b2 );
+    decodedData[1] = set2ndOctet( b2, b3 );
+    decodedData[2] = set3rdOctet( b3, b4 );
+    return 3;
+}
 
-	return true;
+
+// -----------------------------------------------------------------------
+//  VBase64EncoderStream
+// -----------------------------------------------------------------------
+
+VBase64EncoderStream::VBase64EncoderStream( VStream *inDestination, sLONG inQuadsPerLine)
+: fDestination( inDestination)
+, fQuadsPerLine( inQuadsPerLine)
+, fLineQuads( 0)
+, fInput( NULL)
+, fInputSize( 0)
+, fOutput( NULL)
+{
+	xbox_assert( (inDestination != NULL) && (inQuadsPerLine > 0));
+	SetWriteOnly( true);
+}
+
+
+VBase64EncoderStream::~VBase64EncoderStream()
+{
+	_ReleaseBuffers();
+}
+
+
+void VBase64EncoderStream::_ReleaseBuffers()
+{
+	if (fInput != NULL)
+	{
+		VMemory::DisposePtr( fInput);
+		fInput = NULL;
+	}
+	if (fOutput != NULL)
+	{
+		VMemory::DisposePtr( fOutput);
+		fOutput = NULL;
+	}
+	fInputSize = 0;
+}
+
+
+VError VBase64EncoderStream::DoOpenWriting()
+{
+	_ReleaseBuffers();
+	fLineQuads = 0;
+
+	// at most one line break per quadruplet
+	fInput = (uBYTE*) VMemory::NewPtr( kChunkSize, 'b64e');
+	fOutput = (uBYTE*) VMemory::NewPtr( (kChunkSize / 3) * (B64CODER_FOURBYTE + 2), 'b64e');
+	if ( (fInput == NULL) || (fOutput == NULL) )
+	{
+		_ReleaseBuffers();
+		return vThrowError( VE_MEMORY_FULL);
+	}
+	return VE_OK;
+}
+
+
+VError VBase64EncoderStream::DoCloseWriting( Boolean /*inSetSize*/)
+{
+	// DoFlush() has encoded all full triplets, only the padded last quadruplet remains
+	VError err = VE_OK;
+	if ( (GetLastError() == VE_OK) && (fInputSize > 0) )
+	{
+		uBYTE *encodedData = fOutput;
+		if (fLineQuads == fQuadsPerLine)
+		{
+			*encodedData++ = 0x0D;
+			*encodedData++ = 0x0A;
+		}
+		Base64Coder::EncodeLastBytes( fInput, fInputSize, encodedData);
+		encodedData += B64CODER_FOURBYTE;
+		err = fDestination->PutData( fOutput, encodedData - fOutput);
+
+		// VStream::CloseWriting ignores what DoCloseWriting returns but reports the stream error
+		if (err != VE_OK)
+			SetError( err);
+	}
+	_ReleaseBuffers();
+	return err;
+}
+
+
+VError VBase64EncoderStream::_EncodeTriplets( const uBYTE *inData, size_t inTripletCount)
+{
+	xbox_assert( inTripletCount <= kChunkSize / 3);
+
+	// line breaks are written before the next quadruplet so that there's none after the last one
+	uBYTE *encodedData = fOutput;
+	while (inTripletCount > 0)
+	{
+		if (fLineQuads == fQuadsPerLine)
+		{
+			*encodedData++ = 0x0D;
+			*encodedData++ = 0x0A;
+			fLineQuads = 0;
+		}
+		size_t count = Min( inTripletCount, (size_t) (fQuadsPerLine - fLineQuads));
+		Base64Coder::EncodeTriplets( inData, count, encodedData);
+		inData += count * 3;
+		encodedData += count * B64CODER_FOURBYTE;
+		inTripletCount -= count;
+		fLineQuads += (sLONG) count;
+	}
+	return fDestination->PutData( fOutput, encodedData - fOutput);
+}
+
+
+VError VBase64EncoderStream::DoPutData( const void* inBuffer, VSize inNbBytes)
+{
+	const uBYTE *inputData = (const uBYTE*) inBuffer;
+	VError err = VE_OK;
+	while ( (inNbBytes > 0) && (err == VE_OK) )
+	{
+		if ( (fInputSize == 0) && (inNbBytes >= kChunkSize) )
+		{
+			// big writes are encoded without copy
+			err = _EncodeTriplets( inputData, kChunkSize / 3);
+			inputData += kChunkSize;
+			inNbBytes -= kChunkSize;
+		}
+		else
+		{
+			size_t count = Min( (size_t) inNbBytes, kChunkSize - fInputSize);
+			::memcpy( fInput + fInputSize, inputData, count);
+			fInputSize += count;
+			inputData += count;
+			inNbBytes -= count;
+			if (fInputSize == kChunkSize)
+			{
+				err = _EncodeTriplets( fInput, kChunkSize / 3);
+				fInputSize = 0;
+			}
+		}
+	}
+	return err;
+}
+
+
+VError VBase64EncoderStream::DoFlush()
+{
+	VError err = VE_OK;
+	size_t count = fInputSize / 3;
+	if (count > 0)
+	{
+		err = _EncodeTriplets( fInput, count);
+
+		// keep the last 1 or 2 bytes for the next triplet
+		::memmove( fInput, fInput + count * 3, fInputSize - count * 3);
+		fInputSize -= count * 3;
+	}
+	return err;
+}
+
+
+VError VBase64EncoderStream::DoGetData( void* /*inBuffer*/, VSize* ioCount)
+{
+	*ioCount = 0;
+	return vThrowError( VE_STREAM_CANNOT_READ);
+}
+
+
+VError VBase64EncoderStream::DoSetPos( sLONG8 inNewPos)
+{
+	if (inNewPos != GetPos())
+		return vThrowError( VE_STREAM_CANNOT_SET_POS);
+	return VE_OK;
+}
+
+
+sLONG8 VBase64EncoderStream::DoGetSize()
+{
+	return GetPos();
+}
+
+
+VError VBase64EncoderStream::DoSetSize( sLONG8 /*inNewSize*/)
+{
+	return vThrowError( VE_STREAM_CANNOT_SET_SIZE);
 }
 
 
+// -----------------------------------------------------------------------
+//  VBase64DecoderStream
+// -----------------------------------------------------------------------
+
+VBase64DecoderStream::VBase64DecoderStream( VStream *inSource, Base64Coder::Conformance inConform)
+: fSource( inSource)
+, fConformance( inConform)
+, fInput( NULL)
+, fInputSize( 0)
+, fOutput( NULL)
+, fOutputPos( 0)
+, fOutputSize( 0)
+, fSourceEOF( false)
+, fEnded( false)
+{
+	xbox_assert( inSource != NULL);
+	SetReadOnly( true);
+}
 
 
+VBase64DecoderStream::~VBase64DecoderStream()
+{
+	_ReleaseBuffers();
+}
+
+
+void VBase64DecoderStream::_ReleaseBuffers()
+{
+	if (fInput != NULL)
+	{
+		VMemory::DisposePtr( fInput);
+		fInput = NULL;
+	}
+	if (fOutput != NULL)
+	{
+		VMemory::DisposePtr( fOutput);
+		fOutput = NULL;
+	}
+	fInputSize = 0;
+	fOutputPos = 0;
+	fOutputSize = 0;
+}
+
+
+VError VBase64DecoderStream::DoOpenReading()
+{
+	_ReleaseBuffers();
+	fSourceEOF = false;
+	fEnded = false;
+
+	fInput = (uBYTE*) VMemory::NewPtr( kChunkSize, 'b64d');
+	fOutput = (uBYTE*) VMemory::NewPtr( (kChunkSize / B64CODER_FOURBYTE) * 3, 'b64d');
+	if ( (fInput == NULL) || (fOutput == NULL) )
+	{
+		_ReleaseBuffers();
+		return vThrowError( VE_MEMORY_FULL);
+	}
+	return VE_OK;
+}
+
+
+VError VBase64DecoderStream::DoCloseReading()
+{
+	_ReleaseBuffers();
+	return VE_OK;
+}
+
+
+VError VBase64DecoderStream::_FillOutput()
+{
+	fOutputPos = 0;
+	fOutputSize = 0;
+
+	if (!fSourceEOF)
+	{
+		VSize count = 0;
+		VError err;
+		{
+			StErrorContextInstaller filter( VE_STREAM_EOF, VE_OK);
+			err = fSource->GetData( fInput + fInputSize, kChunkSize - fInputSize, &count);
+		}
+		if (err == VE_STREAM_EOF)
+		{
+			fSourceEOF = true;
+			err = VE_OK;
+		}
+		if (err != VE_OK)
+			return err;
+
+		if (fConformance == Base64Coder::Conf_RFC2045)
+			count = _RemoveWhiteSpaces( fInput + fInputSize, count);
+		fInputSize += count;
+	}
+
+	size_t quadrupletCount = fInputSize / B64CODER_FOURBYTE;
+	if (fSourceEOF)
+	{
+		fEnded = true;
+		if ((fInputSize % B64CODER_FOURBYTE) != 0)
+			return vThrowError( VE_STREAM_CANNOT_GET_DATA);
+
+		if (quadrupletCount > 0)
+		{
+			if (!Base64Coder::DecodeQuadruplets( fInput, quadrupletCount - 1, fOutput))
+				return vThrowError( VE_STREAM_CANNOT_GET_DATA);
+
+			size_t lastCount = Base64Coder::DecodeLastQuadruplet( fInput + (quadrupletCount - 1) * B64CODER_FOURBYTE, fOutput + (quadrupletCount - 1) * 3);
+			if (lastCount == 0)
+				return vThrowError( VE_STREAM_CANNOT_GET_DATA);
+
+			fOutputSize = (quadrupletCount - 1) * 3 + lastCount;
+		}
+		fInputSize = 0;
+	}
+	else if (quadrupletCount > 1)
+	{
+		// the last quadruplet is kept because it may be padded if the source ends right after it
+		--quadrupletCount;
+		if (!Base64Coder::DecodeQuadruplets( fInput, quadrupletCount, fOutput))
+		{
+			fEnded = true;
+			return vThrowError( VE_STREAM_CANNOT_GET_DATA);
+		}
+
+		fOutputSize = quadrupletCount * 3;
+		fInputSize -= quadrupletCount * B64CODER_FOURBYTE;
+		::memmove( fInput, fInput + quadrupletCount * B64CODER_FOURBYTE, fInputSize);
+	}
+
+	return VE_OK;
+}
+
+
+VError VBase64DecoderStream::DoGetData( void* inBuffer, VSize* ioCount)
+{
+	uBYTE *outputData = (uBYTE*) inBuffer;
+	VSize wanted = *ioCount;
+	VSize copied = 0;
+	VError err = VE_OK;
+	while ( (copied < wanted) && (err == VE_OK) )
+	{
+		if (fOutputPos < fOutputSize)
+		{
+			size_t count = Min( (size_t) (wanted - copied), fOutputSize - fOutputPos);
+			::memcpy( outputData + copied, fOutput + fOutputPos, count);
+			fOutputPos += count;
+			copied += count;
+		}
+		else if (fEnded)
+		{
+			break;
+		}
+		else
+		{
+			err = _FillOutput();
+		}
+	}
+
+	*ioCount = copied;
+	if ( (err == VE_OK) && (copied < wanted) )
+		err = vThrowError( VE_STREAM_EOF);
+	return err;
+}
+
+
+VError VBase64DecoderStream::DoPutData( const void* /*inBuffer*/, VSize /*inNbBytes*/)
+{
+	return vThrowError( VE_STREAM_CANNOT_WRITE);
+}
+
+
+VError VBase64DecoderStream::DoSetPos( sLONG8 inNewPos)
+{
+	if (inNewPos != GetPos())
+		return vThrowError( VE_STREAM_CANNOT_SET_POS);
+	return VE_OK;
+}
+
+
+sLONG8 VBase64DecoderStream::DoGetSize()
+{
+	// not known before the source has been read
+	return GetPos() + (sLONG8) (fOutputSize - fOutputPos);
+}
+
+
+VError VBase64DecoderStream::DoSetSize( sLONG8 /*inNewSize*/)
+{
+	return vThrowError( VE_STREAM_CANNOT_SET_SIZE);
+}
+
@@ -17,6 +17,7 @@
 #define __BASE_64_CODER__
 
 #include "VMemoryBuffer.h"
+#include "VStream.h"
 
 BEGIN_TOOLBOX_NAMESPACE
 
@@ -37,7 +38,24 @@ public:
 	static	bool	Encode( const void *inData, size_t inDataSize, VMemoryBuffer<>& outResult, sLONG inQuadsPerLine = BASE64_QUADSPERLINE);
 
 	static	bool	Decode( const void *inData, size_t inDataSize, VMemoryBuffer<>& outResult, Conformance inConform = Conf_RFC2045 );
-	
+
+	// Low level routines used for chunked coding: no line breaks, no white spaces.
+	// They use SSSE3 or AVX2 when the processor supports them.
+
+	// Encodes inTripletCount groups of 3 bytes into inTripletCount * 4 characters.
+	static	void	EncodeTriplets( const void *inData, size_t inTripletCount, void *outResult);
+
+	// Encodes the last 1, 2 or 3 bytes into 4 characters, with padding if needed.
+	static	void	EncodeLastBytes( const void *inData, size_t inDataSize, void *outResult);
+
+	// Decodes inQuadrupletCount groups of 4 characters that can't be padded into inQuadrupletCount * 3 bytes.
+	// Returns false if a character is not part of the base64 alphabet.
+	static	bool	DecodeQuadruplets( const void *inData, size_t inQuadrupletCount, void *outResult);
+
+	// Decodes the last group of 4 characters that may be padded.
+	// Returns the count of decoded bytes (1 to 3) or 0 if the group is invalid.
+	static	size_t	DecodeLastQuadruplet( const void *inData, void *outResult);
+
 private:
     Base64Coder();
     Base64Coder(const Base64Coder&);
@@ -50,6 +68,85 @@ private:
 };
 
 
+
+/*
+	Write-only stream that base64 encodes the data put into it and writes the characters into a destination stream.
+	The destination must be opened for writing and is left opened.
+	Data is encoded by chunks of kChunkSize bytes so memory usage does not depend on the data size.
+	The padding is written when the stream is closed.
+*/
+class XTOOLBOX_API VBase64EncoderStream : public VStream
+{
+public:
+	enum { kChunkSize = 3 * 16384 };
+
+							VBase64EncoderStream( VStream *inDestination, sLONG inQuadsPerLine = Base64Coder::BASE64_QUADSPERLINE);
+	virtual					~VBase64EncoderStream();
+
+protected:
+	// Inherited from VStream
+	virtual VError			DoOpenWriting();
+	virtual VError			DoCloseWriting( Boolean inSetSize);
+	virtual VError			DoPutData( const void* inBuffer, VSize inNbBytes);
+	virtual VError			DoGetData( void* inBuffer, VSize* ioCount);
+	virtual VError			DoFlush();
+	virtual VError			DoSetPos( sLONG8 inNewPos);
+	virtual sLONG8			DoGetSize();
+	virtual VError			DoSetSize( sLONG8 inNewSize);
+
+private:
+			VError			_EncodeTriplets( const uBYTE *inData, size_t inTripletCount);
+			void			_ReleaseBuffers();
+
+			VStream*		fDestination;
+			sLONG			fQuadsPerLine;
+			sLONG			fLineQuads;		// quadruplets already written on current line
+			uBYTE*			fInput;			// bytes not encoded yet
+			size_t			fInputSize;
+			uBYTE*			fOutput;
+};
+
+
+/*
+	Read-only stream that reads base64 characters from a source stream and returns the decoded data.
+	The source must be opened for reading and is left opened.
+	Characters are decoded by chunks of kChunkSize bytes so memory usage does not depend on the data size.
+	Invalid characters or padding make GetData() fail with VE_STREAM_CANNOT_GET_DATA.
+*/
+class XTOOLBOX_API VBase64DecoderStream : public VStream
+{
+public:
+	enum { kChunkSize = 65536 };
+
+							VBase64DecoderStream( VStream *inSource, Base64Coder::Conformance inConform = Base64Coder::Conf_RFC2045);
+	virtual					~VBase64DecoderStream();
+
+protected:
+	// Inherited from VStream
+	virtual VError			DoOpenReading();
+	virtual VError			DoCloseReading();
+	virtual VError			DoPutData( const void* inBuffer, VSize inNbBytes);
+	virtual VError			DoGetData( void* inBuffer, VSize* ioCount);
+	virtual VError			DoSetPos( sLONG8 inNewPos);
+	virtual sLONG8			DoGetSize();
+	virtual VError			DoSetSize( sLONG8 inNewSize);
+
+private:
+			VError			_FillOutput();
+			void			_ReleaseBuffers();
+
+			VStream*		fSource;
+			Base64Coder::Conformance	fConformance;
+			uBYTE*			fInput;			// characters not decoded yet, without white spaces
+			size_t			fInputSize;
+			uBYTE*			fOutput;		// decoded bytes not returned yet
+			size_t			fOutputPos;
+			size_t			fOutputSize;
+			bool			fSourceEOF;
+			bool			fEnded;
+};
+
+
 END_TOOLBOX_NAMESPACE
 
 #endif /* __BASE_64_CODER__ */
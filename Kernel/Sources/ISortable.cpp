@@ -16,6 +16,7 @@
 #include "VKernelPrecompiled.h"
 #include "ISortable.h"
 #include "VMemoryCpp.h"
+#include <algorithm>
 
 
 ISortable::ISortable()
@@ -69,18 +70,35 @@ CompareResult ISortable::MultiCriteriaCompare(ISortable** inArrays, uBYTE** inDa
 }
 
 
+BEGIN_TOOLBOX_NAMESPACE
+
+class VMultiCriteriaLess
+{
+public:
+	VMultiCriteriaLess(ISortable** inArrays, uBYTE** inDatas, Boolean* inInvert, sLONG inMultiCriteriaLevel)
+		: fArrays(inArrays), fDatas(inDatas), fInvert(inInvert), fMultiCriteriaLevel(inMultiCriteriaLevel) {}
+
+	bool operator()(sLONG inA, sLONG inB) const
+	{
+		return ISortable::MultiCriteriaCompare(fArrays, fDatas, fInvert, fMultiCriteriaLevel, inA, inB) == CR_SMALLER;
+	}
+
+private:
+	ISortable**	fArrays;
+	uBYTE**		fDatas;
+	Boolean*	fInvert;
+	sLONG		fMultiCriteriaLevel;
+};
+
+END_TOOLBOX_NAMESPACE
+
+
 void ISortable::MultiCriteriaQSort(ISortable** inArrays, Boolean* inInvert, sLONG inMultiCriteriaLevel, sLONG inFrom, sLONG inTo)
 {
-    sLONG lo, hi;					/* ends of sub-array currently sorting */
-    sLONG mid;						/* points to middle of subarray */
-    sLONG loguy, higuy;				/* traveling pointers for partition step */
-    sLONG size;						/* size of the sub-array */
-    sLONG lostk[30], histk[30];
-    sLONG stkptr;					/* stack for saving sub-array to be processed */
 	uBYTE** datas;
 	sLONG i;
 
-    if (inTo - inFrom < 2)
+    if (inTo - inFrom < 1)
         return;					/* nothing to do */
 
 	// compute number of arrays;
@@ -98,7 +116,72 @@ void ISortable::MultiCriteriaQSort(ISortable** inArrays, Boolean* inInvert, sLON
 	// lock all the used arrays
 	for (i = 0; i < nb; i++)
 		datas[i] = inArrays[i]->LockAndGetData();
-	
+
+	// sort indexes instead of swapping all the arrays at each step.
+	// stable_sort never reads out of range even if CompareElements is not a strict weak ordering (NaN reals).
+	sLONG count = inTo - inFrom + 1;
+	std::vector<sLONG> order;
+	std::vector<bool> placed;
+	bool withIndex;
+	try
+	{
+		order.resize( count);
+		placed.resize( count);
+		for (i = 0; i < count; i++)
+			order[i] = inFrom + i;
+		std::stable_sort( order.begin(), order.end(), VMultiCriteriaLess( inArrays, datas, inInvert, inMultiCriteriaLevel));
+		withIndex = true;
+	}
+	catch(...)
+	{
+		withIndex = false;
+	}
+
+	if (withIndex)
+	{
+		// element i must receive element order[i]: follow each cycle of the permutation with one swap per element
+		for (sLONG array = 0; array < nb; array++)
+		{
+			std::fill( placed.begin(), placed.end(), false);
+			for (sLONG start = 0; start < count; start++)
+			{
+				if (placed[start])
+					continue;
+
+				sLONG cur = start;
+				for (;;)
+				{
+					placed[cur] = true;
+					sLONG next = order[cur] - inFrom;
+					if (next == start)
+						break;
+					inArrays[array]->SwapElements(datas[array], inFrom + cur, inFrom + next);
+					cur = next;
+				}
+			}
+		}
+	}
+	else
+	{
+		_MultiCriteriaQSortInPlace(inArrays, datas, inInvert, inMultiCriteriaLevel, inFrom, inTo);
+	}
+
+	for (i = 0; i < nb; i++)
+		inArrays[i]->UnlockData();
+
+	vFree(datas);
+}
+
+
+void ISortable::_MultiCriteriaQSortInPlace(ISortable** inArrays, uBYTE** datas, Boolean* inInvert, sLONG inMultiCriteriaLevel, sLONG inFrom, sLONG inTo)
+{
+    sLONG lo, hi;					/* ends of sub-array currently sorting */
+    sLONG mid;						/* points to middle of subarray */
+    sLONG loguy, higuy;				/* traveling pointers for partition step */
+    sLONG size;						/* size of the sub-array */
+    sLONG lostk[30], histk[30];
+    sLONG stkptr;					/* stack for saving sub-array to be processed */
+
 	stkptr = 0;						/* initialize stack */
 
     lo = inFrom;
@@ -121,7 +204,7 @@ void ISortable::MultiCriteriaQSort(ISortable** inArrays, Boolean* inInvert, sLON
 
 			hi--;
 		}
-		goto done;
+		return;
     }
     else
 	{
@@ -196,12 +279,4 @@ recurse:
         goto recurse;			/* pop subarray from stack */
     }
 
-done:
-
-	for (i = 0; i < nb; i++)
-		inArrays[i]->UnlockData();
-
-	vFree(datas);
 }
-
-
@@ -26,9 +26,13 @@ public:
 			ISortable ();
 	virtual ~ISortable ();
 
+	// Sorts elements inFrom to inTo (included) of the NULL terminated list of arrays.
+	// A permutation index is sorted first and then applied once to each array.
 	static void	MultiCriteriaQSort (ISortable** inArrays, Boolean* inInvert, sLONG inMultiCriteriaLevel, sLONG inFrom, sLONG inTo);
 
 protected:
+	friend class VMultiCriteriaLess;
+
 	virtual uBYTE*	LockAndGetData () const { return NULL; };
 	virtual void	UnlockData () const {};
 	
@@ -37,6 +41,10 @@ protected:
 
 	static CompareResult	MultiCriteriaCompare (ISortable** inArrays, uBYTE** inDatas, Boolean* inInvert, sLONG inMultiCriteriaLevel, sLONG inIndexA, sLONG inIndexB);
 	static void	MultiCriteriaSwap (ISortable** inArrays, uBYTE** inDatas, sLONG inIndexA, sLONG inIndexB);
+
+private:
+	// in place quicksort, used if the permutation index can't be allocated
+	static void	_MultiCriteriaQSortInPlace (ISortable** inArrays, uBYTE** inDatas, Boolean* inInvert, sLONG inMultiCriteriaLevel, sLONG inFrom, sLONG inTo);
 };
 
 
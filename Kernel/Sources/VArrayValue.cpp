@@ -19,6 +19,9 @@
 #include "VStream.h"
 #include "VFloat.h"
 #include "VTime.h"
+#include "VIntlMgr.h"
+#include "VCollator.h"
+#include "VParallelSort.h"
 
 
 // Class constants
@@ -1109,7 +1112,7 @@ void VArrayByte::Sort(sLONG inFrom, sLONG inTo, Boolean inDescending)
 	inFrom--;
 
 	sBYTE* data = (sBYTE*) LockAndGetData();
-	QSort<sBYTE>(data + inFrom, inTo - inFrom, inDescending);
+	ParallelRadixSort<sBYTE>(data + inFrom, inTo - inFrom, inDescending != 0);
 	UnlockData();
 }
 
@@ -1483,7 +1486,7 @@ void VArrayWord::Sort(sLONG inFrom, sLONG inTo, Boolean inDescending)
 	inFrom--;
 
 	sWORD* data = (sWORD*) LockAndGetData();
-	QSort<sWORD>(data + inFrom, inTo - inFrom, inDescending);
+	ParallelRadixSort<sWORD>(data + inFrom, inTo - inFrom, inDescending != 0);
 	UnlockData();
 }
 
@@ -1885,7 +1888,7 @@ void VArrayLong::Sort(sLONG inFrom, sLONG inTo, Boolean inDescending)
 	inFrom--;
 
 	sLONG* data = (sLONG*) LockAndGetData();
-	QSort<sLONG>(data + inFrom, inTo - inFrom, inDescending);
+	ParallelRadixSort<sLONG>(data + inFrom, inTo - inFrom, inDescending != 0);
 	UnlockData();
 }
 
@@ -2212,7 +2215,7 @@ void VArrayLong8::Sort(sLONG inFrom, sLONG inTo, Boolean inDescending)
 	inFrom--;
 
 	sLONG8* data = (sLONG8*) LockAndGetData();
-	QSort<sLONG8>(data + inFrom, inTo - inFrom, inDescending);
+	ParallelRadixSort<sLONG8>(data + inFrom, inTo - inFrom, inDescending != 0);
 	UnlockData();
 }
 
@@ -2598,7 +2601,7 @@ void VArrayReal::Sort(sLONG inFrom, sLONG inTo, Boolean inDescending)
 	inFrom--;
 
 	Real* data = (Real*) LockAndGetData();
-	QSort<Real>(data + inFrom, inTo - inFrom, inDescending);
+	ParallelRadixSort<Real>(data + inFrom, inTo - inFrom, inDescending != 0);
 	UnlockData();
 }
 
@@ -3350,6 +3353,108 @@ CompareResult VArrayString::CompareElements(uBYTE* inData, sLONG inA, sLONG inB)
 }
 
 
+BEGIN_TOOLBOX_NAMESPACE
+
+class VStringSortEntry
+{
+public:
+	const uBYTE*	fKey;
+	sLONG			fKeyLength;
+	VString*		fString;
+};
+
+
+// same order as VArrayString::CompareElements: NULL strings first, then collator keys
+class VStringSortEntryLess
+{
+public:
+	VStringSortEntryLess(bool inDescending) : fDescending(inDescending) {}
+
+	bool operator()(const VStringSortEntry& inA, const VStringSortEntry& inB) const
+	{
+		return fDescending ? (_Compare(inB, inA) < 0) : (_Compare(inA, inB) < 0);
+	}
+
+private:
+	static sLONG _Compare(const VStringSortEntry& inA, const VStringSortEntry& inB)
+	{
+		if (inA.fString == NULL)
+			return (inB.fString == NULL) ? 0 : -1;
+		if (inB.fString == NULL)
+			return 1;
+
+		return VCollator::CompareSortKeys(inA.fKey, inA.fKeyLength, inB.fKey, inB.fKeyLength);
+	}
+
+	bool	fDescending;
+};
+
+END_TOOLBOX_NAMESPACE
+
+
+void VArrayString::Sort(sLONG inFrom, sLONG inTo, Boolean inDescending)
+{
+	// same bounds as VArrayValue::Sort (first and last indexes)
+	if (inFrom < 0 || inTo >= fCount || inTo <= inFrom)
+		return;
+
+	// collator keys are computed once per string so that the sort itself only compares bytes
+	VIntlMgr* intlMgr = VIntlMgr::GetDefaultMgr();
+	VCollator* collator = (intlMgr != NULL) ? intlMgr->GetCollator() : NULL;
+
+	sLONG count = inTo - inFrom + 1;
+	std::vector<VStringSortEntry> entries;
+	std::vector<uBYTE> keys;
+	std::vector<sLONG> offsets;
+	std::vector<uBYTE> key;
+	bool withKeys = (collator != NULL);
+
+	VString** data = (VString**) LockAndGetData();
+
+	if (withKeys)
+	{
+		try
+		{
+			entries.resize(count);
+			offsets.resize(count);
+			for (sLONG i = 0; withKeys && (i < count); i++)
+			{
+				VString* str = data[inFrom + i];
+				entries[i].fString = str;
+				entries[i].fKeyLength = 0;
+				offsets[i] = (sLONG) keys.size();
+				if (str != NULL)
+				{
+					withKeys = collator->GetSortKey(str->GetCPointer(), str->GetLength(), true, key);
+					entries[i].fKeyLength = (sLONG) key.size();
+					keys.insert(keys.end(), key.begin(), key.end());
+				}
+			}
+		}
+		catch(...)
+		{
+			withKeys = false;
+		}
+	}
+
+	if (withKeys)
+	{
+		for (sLONG i = 0; i < count; i++)
+			entries[i].fKey = keys.empty() ? NULL : keys.data() + offsets[i];	// offsets[i] may be keys.size() for trailing empty strings
+
+		ParallelSort(&entries[0], count, VStringSortEntryLess(inDescending != 0));
+
+		for (sLONG i = 0; i < count; i++)
+			data[inFrom + i] = entries[i].fString;
+	}
+
+	UnlockData();
+
+	if (!withKeys)
+		VArrayValue::Sort(inFrom, inTo, inDescending);
+}
+
+
 sLONG VArrayString::QuickFind(const VString& inValue) const
 {
 	sLONG low, high, test, result;
@@ -521,6 +521,9 @@ public:
 
 	virtual CompareResult	CompareTo (const VValueSingle& inValue, Boolean inDiacritic, sLONG inElement) const;
 
+	// Sorts on collator keys computed once per string, in parallel for big arrays.
+	virtual void	Sort (sLONG inFrom, sLONG inTo, Boolean inDescending = false);
+
 	virtual VError	ReadFromStream (VStream* inStream, sLONG inParam = 0);
 	virtual VError	WriteToStream (VStream* inStream, sLONG inParam = 0) const;
 	
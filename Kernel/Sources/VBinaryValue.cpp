@@ -0,0 +1,1050 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VKernelPrecompiled.h"
+#include "VBinaryValue.h"
+#include "VFile.h"
+#include "VTime.h"
+#include "VString.h"
+#include "VStream.h"
+
+
+const uLONG	kBinaryValueVersion		= 1;
+const uLONG	kBinaryValueHeaderSize	= 24;
+const sLONG	kBinaryValueMaxDepth	= 512;
+
+
+static void _WriteLong( uBYTE *outBytes, uLONG inValue)
+{
+	outBytes[0] = (uBYTE) inValue;
+	outBytes[1] = (uBYTE) (inValue >> 8);
+	outBytes[2] = (uBYTE) (inValue >> 16);
+	outBytes[3] = (uBYTE) (inValue >> 24);
+}
+
+
+static uLONG _ReadLong( const uBYTE *inBytes)
+{
+	return (uLONG) inBytes[0] | ((uLONG) inBytes[1] << 8) | ((uLONG) inBytes[2] << 16) | ((uLONG) inBytes[3] << 24);
+}
+
+
+// lexicographic order of utf-8 bytes, used by the sorted index of member tables.
+static sLONG _CompareNames( const char *inName1, uLONG inLength1, const char *inName2, uLONG inLength2)
+{
+	int result = ::memcmp( inName1, inName2, (inLength1 < inLength2) ? inLength1 : inLength2);
+	if (result != 0)
+		return (result < 0) ? -1 : 1;
+	return (inLength1 == inLength2) ? 0 : ((inLength1 < inLength2) ? -1 : 1);
+}
+
+
+// orders member indexes by their name
+class VBinaryMemberNameLess
+{
+public:
+			VBinaryMemberNameLess( const std::vector<std::pair<uLONG,uLONG> >& inMembers, const std::vector<char>& inStringBytes, const std::vector<uLONG>& inStringStarts, const std::vector<uLONG>& inStringLengths)
+				: fMembers( inMembers), fStringBytes( inStringBytes), fStringStarts( inStringStarts), fStringLengths( inStringLengths)	{;}
+
+			bool	operator()( uLONG inIndex1, uLONG inIndex2) const
+			{
+				uLONG name1 = fMembers[inIndex1].first;
+				uLONG name2 = fMembers[inIndex2].first;
+				if (name1 == name2)
+					return inIndex1 < inIndex2;
+				return _CompareNames( &fStringBytes[fStringStarts[name1]], fStringLengths[name1], &fStringBytes[fStringStarts[name2]], fStringLengths[name2]) < 0;
+			}
+
+private:
+	const	std::vector<std::pair<uLONG,uLONG> >&	fMembers;
+	const	std::vector<char>&						fStringBytes;
+	const	std::vector<uLONG>&						fStringStarts;
+	const	std::vector<uLONG>&						fStringLengths;
+};
+
+
+//================================================================================================================
+
+
+EBinaryValueType VBinaryValueView::GetType() const
+{
+	uBYTE type;
+	if ( (fReader == NULL) || !fReader->_GetByte( fOffset, &type) || (type > eBinaryValue_Bag) )
+		return eBinaryValue_Undefined;
+	return (EBinaryValueType) type;
+}
+
+
+bool VBinaryValueView::GetBool() const
+{
+	switch( GetType())
+	{
+		case eBinaryValue_True:		return true;
+		case eBinaryValue_Long:		return GetLong8() != 0;
+		case eBinaryValue_Real:		return GetReal() != 0;
+		default:					return false;
+	}
+}
+
+
+sLONG8 VBinaryValueView::GetLong8() const
+{
+	uLONG8 bits;
+	switch( GetType())
+	{
+		case eBinaryValue_True:
+			return 1;
+
+		case eBinaryValue_Long:
+			return fReader->_GetLong8( fOffset + 1, &bits) ? (sLONG8) bits : 0;
+
+		case eBinaryValue_Real:
+			return (sLONG8) GetReal();
+
+		default:
+			return 0;
+	}
+}
+
+
+Real VBinaryValueView::GetReal() const
+{
+	uLONG8 bits;
+	switch( GetType())
+	{
+		case eBinaryValue_True:
+			return 1;
+
+		case eBinaryValue_Long:
+			return (Real) GetLong8();
+
+		case eBinaryValue_Real:
+			if (fReader->_GetLong8( fOffset + 1, &bits))
+			{
+				Real value;
+				::memcpy( &value, &bits, sizeof( value));
+				return value;
+			}
+			return 0;
+
+		default:
+			return 0;
+	}
+}
+
+
+bool VBinaryValueView::GetTime( VTime& outTime) const
+{
+	uLONG8 stamp;
+	if ( (GetType() != eBinaryValue_Time) || !fReader->_GetLong8( fOffset + 1, &stamp) )
+	{
+		outTime.SetNull( true);
+		return false;
+	}
+	outTime.FromStamp( stamp);
+	return true;
+}
+
+
+bool VBinaryValueView::GetUTF8( const char **outString, size_t *outLength) const
+{
+	uLONG index, length;
+	const char *p;
+	if ( (GetType() != eBinaryValue_String) || !fReader->_GetLong( fOffset + 1, &index) || !fReader->_GetString( index, &p, &length) )
+	{
+		*outString = NULL;
+		*outLength = 0;
+		return false;
+	}
+	*outString = p;
+	*outLength = length;
+	return true;
+}
+
+
+bool VBinaryValueView::GetString( VString& outString) const
+{
+	bool ok = true;
+	switch( GetType())
+	{
+		case eBinaryValue_String:
+			{
+				const char *p;
+				size_t length;
+				ok = GetUTF8( &p, &length);
+				if (ok)
+					outString.FromBlock( p, length, VTC_UTF_8);
+				else
+					outString.Clear();
+				break;
+			}
+
+		case eBinaryValue_False:	outString = CVSTR( "false"); break;
+		case eBinaryValue_True:		outString = CVSTR( "true"); break;
+		case eBinaryValue_Long:		outString.FromLong8( GetLong8()); break;
+		case eBinaryValue_Real:		outString.FromReal( GetReal()); break;
+
+		default:
+			outString.Clear();
+			ok = false;
+			break;
+	}
+	return ok;
+}
+
+
+sLONG VBinaryValueView::GetCount() const
+{
+	uLONG count = 0;
+	switch( GetType())
+	{
+		case eBinaryValue_Array:
+		case eBinaryValue_Object:
+		case eBinaryValue_Bag:
+			if (!fReader->_GetLong( fOffset + 1, &count) || (count > (uLONG) kMAX_sLONG))
+				count = 0;
+			break;
+
+		default:
+			break;
+	}
+	return (sLONG) count;
+}
+
+
+VBinaryValueView VBinaryValueView::GetNth( sLONG inIndex) const
+{
+	uLONG count, offset;
+	if ( (GetType() != eBinaryValue_Array) || !fReader->_GetLong( fOffset + 1, &count) || (count >= fReader->fSize / 4) || (inIndex < 0) || ((uLONG) inIndex >= count) )
+		return VBinaryValueView();
+
+	// children are always written before their parent, which also protects from cycles
+	if (!fReader->_GetLong( fOffset + 5 + 4 * (uLONG) inIndex, &offset) || (offset >= fOffset) )
+		return VBinaryValueView();
+
+	return VBinaryValueView( fReader, offset);
+}
+
+
+uLONG VBinaryValueView::_GetMembersOffset( bool inElements) const
+{
+	switch( GetType())
+	{
+		case eBinaryValue_Object:
+			return inElements ? 0 : fOffset + 1;
+
+		case eBinaryValue_Bag:
+			{
+				if (!inElements)
+					return fOffset + 1;
+				uLONG count;
+				if (!fReader->_GetLong( fOffset + 1, &count) || (count >= fReader->fSize / 12) )
+					return 0;
+				return fOffset + 5 + 12 * count;
+			}
+
+		default:
+			return 0;
+	}
+}
+
+
+VBinaryValueView VBinaryValueView::_GetNthMember( uLONG inTableOffset, sLONG inIndex, VString *outName) const
+{
+	uLONG count, nameIndex, offset;
+	const char *name;
+	uLONG nameLength;
+	if ( (inTableOffset != 0)
+		&& fReader->_GetLong( inTableOffset, &count)
+		&& (count < fReader->fSize / 8)
+		&& (inIndex >= 0) && ((uLONG) inIndex < count)
+		&& fReader->_GetLong( inTableOffset + 4 + 8 * (uLONG) inIndex, &nameIndex)
+		&& fReader->_GetLong( inTableOffset + 8 + 8 * (uLONG) inIndex, &offset)
+		&& (offset < fOffset)
+		&& fReader->_GetString( nameIndex, &name, &nameLength) )
+	{
+		if (outName != NULL)
+			outName->FromBlock( name, nameLength, VTC_UTF_8);
+		return VBinaryValueView( fReader, offset);
+	}
+
+	if (outName != NULL)
+		outName->Clear();
+	return VBinaryValueView();
+}
+
+
+VBinaryValueView VBinaryValueView::_FindMember( uLONG inTableOffset, const StPackedDictionaryKey& inName) const
+{
+	uLONG count;
+	if ( (inTableOffset == 0) || !fReader->_GetLong( inTableOffset, &count) || (count >= fReader->fSize / 12) )
+		return VBinaryValueView();
+
+	uLONG sortedOffset = inTableOffset + 4 + 8 * count;
+	uLONG low = 0;
+	uLONG high = count;
+	while( low < high)
+	{
+		uLONG middle = low + (high - low) / 2;
+		uLONG index, nameIndex, nameLength;
+		const char *name;
+		if ( !fReader->_GetLong( sortedOffset + 4 * middle, &index)
+			|| (index >= count)
+			|| !fReader->_GetLong( inTableOffset + 4 + 8 * index, &nameIndex)
+			|| !fReader->_GetString( nameIndex, &name, &nameLength) )
+			break;
+
+		sLONG result = _CompareNames( inName.GetKeyAdress(), (uLONG) inName.GetKeyLength(), name, nameLength);
+		if (result == 0)
+			return _GetNthMember( inTableOffset, (sLONG) index, NULL);
+		if (result < 0)
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	return VBinaryValueView();
+}
+
+
+VBinaryValueView VBinaryValueView::GetNthProperty( sLONG inIndex, VString *outName) const
+{
+	return _GetNthMember( _GetMembersOffset( false), inIndex, outName);
+}
+
+
+VBinaryValueView VBinaryValueView::GetProperty( const StPackedDictionaryKey& inName) const
+{
+	return _FindMember( _GetMembersOffset( false), inName);
+}
+
+
+sLONG VBinaryValueView::GetElementNamesCount() const
+{
+	uLONG tableOffset = _GetMembersOffset( true);
+	uLONG count;
+	if ( (tableOffset == 0) || !fReader->_GetLong( tableOffset, &count) || (count > (uLONG) kMAX_sLONG) )
+		return 0;
+	return (sLONG) count;
+}
+
+
+VBinaryValueView VBinaryValueView::GetNthElementName( sLONG inIndex, VString *outName) const
+{
+	return _GetNthMember( _GetMembersOffset( true), inIndex, outName);
+}
+
+
+VBinaryValueView VBinaryValueView::GetElements( const StPackedDictionaryKey& inName) const
+{
+	return _FindMember( _GetMembersOffset( true), inName);
+}
+
+
+VValueSingle* VBinaryValueView::CreateVValue() const
+{
+	VValueSingle *value = NULL;
+	switch( GetType())
+	{
+		case eBinaryValue_Null:
+			value = new VString;
+			if (value != NULL)
+				value->SetNull( true);
+			break;
+
+		case eBinaryValue_False:
+		case eBinaryValue_True:
+			value = new VBoolean( GetType() == eBinaryValue_True);
+			break;
+
+		case eBinaryValue_Long:
+			{
+				sLONG8 number = GetLong8();
+				if ( (number >= kMIN_sLONG) && (number <= kMAX_sLONG) )
+					value = new VLong( (sLONG) number);
+				else
+					value = new VLong8( number);
+				break;
+			}
+
+		case eBinaryValue_Real:
+			value = new VReal( GetReal());
+			break;
+
+		case eBinaryValue_String:
+			{
+				VString *s = new VString;
+				if (s != NULL)
+					GetString( *s);
+				value = s;
+				break;
+			}
+
+		case eBinaryValue_Time:
+			{
+				VTime *time = new VTime;
+				if (time != NULL)
+					GetTime( *time);
+				value = time;
+				break;
+			}
+
+		default:
+			break;
+	}
+	return value;
+}
+
+
+VError VBinaryValueView::ToJSON( VJSONValue& outValue) const
+{
+	// Values may point to the same child, the depth limit alone doesn't protect from an exponential expansion.
+	// Each value takes at least one byte and the writer never shares them: a genuine document has less values than bytes.
+	uLONG nodeBudget = (fReader != NULL) ? fReader->fSize : 1;
+	return _ToJSON( outValue, 0, nodeBudget);
+}
+
+
+VError VBinaryValueView::_ToJSON( VJSONValue& outValue, sLONG inDepth, uLONG& ioNodeBudget) const
+{
+	if ( (inDepth > kBinaryValueMaxDepth) || (ioNodeBudget == 0) )
+		return vThrowError( VE_STREAM_CANNOT_READ);
+	--ioNodeBudget;
+
+	VError err = VE_OK;
+	switch( GetType())
+	{
+		case eBinaryValue_Undefined:	outValue.SetUndefined(); break;
+		case eBinaryValue_Null:			outValue.SetNull(); break;
+		case eBinaryValue_False:		outValue.SetBool( false); break;
+		case eBinaryValue_True:			outValue.SetBool( true); break;
+		case eBinaryValue_Long:
+		case eBinaryValue_Real:			outValue.SetNumber( GetReal()); break;
+
+		case eBinaryValue_String:
+			{
+				VString s;
+				GetString( s);
+				outValue.SetString( s);
+				break;
+			}
+
+		case eBinaryValue_Time:
+			{
+				VTime time;
+				GetTime( time);
+				outValue.SetTime( time);
+				break;
+			}
+
+		case eBinaryValue_Array:
+			{
+				VJSONArray *array = new VJSONArray;
+				sLONG count = GetCount();
+				for( sLONG i = 0 ; (i < count) && (err == VE_OK) ; ++i)
+				{
+					VJSONValue item;
+					err = GetNth( i)._ToJSON( item, inDepth + 1, ioNodeBudget);
+					if ( (err == VE_OK) && !array->Push( item) )
+						err = vThrowError( VE_MEMORY_FULL);
+				}
+				outValue.SetArray( array);
+				ReleaseRefCountable( &array);
+				break;
+			}
+
+		// bags become objects whose elements are arrays of objects
+		case eBinaryValue_Object:
+		case eBinaryValue_Bag:
+			{
+				VJSONObject *object = new VJSONObject;
+				VString name;
+				sLONG count = GetCount();
+				for( sLONG i = 0 ; (i < count) && (err == VE_OK) ; ++i)
+				{
+					VJSONValue property;
+					err = GetNthProperty( i, &name)._ToJSON( property, inDepth + 1, ioNodeBudget);
+					if (err == VE_OK)
+						object->SetProperty( name, property);
+				}
+				count = GetElementNamesCount();
+				for( sLONG i = 0 ; (i < count) && (err == VE_OK) ; ++i)
+				{
+					VJSONValue elements;
+					err = GetNthElementName( i, &name)._ToJSON( elements, inDepth + 1, ioNodeBudget);
+					if (err == VE_OK)
+						object->SetProperty( name, elements);
+				}
+				outValue.SetObject( object);
+				ReleaseRefCountable( &object);
+				break;
+			}
+	}
+	return err;
+}
+
+
+VError VBinaryValueView::ToBag( VValueBag& ioBag) const
+{
+	// see ToJSON
+	uLONG nodeBudget = (fReader != NULL) ? fReader->fSize : 1;
+	return _ToBag( ioBag, 0, nodeBudget);
+}
+
+
+VError VBinaryValueView::_ToBag( VValueBag& ioBag, sLONG inDepth, uLONG& ioNodeBudget) const
+{
+	if ( (inDepth > kBinaryValueMaxDepth) || (ioNodeBudget == 0) )
+		return vThrowError( VE_STREAM_CANNOT_READ);
+	--ioNodeBudget;
+
+	if (GetType() != eBinaryValue_Bag)
+		return vThrowError( VE_INVALID_PARAMETER);
+
+	VError err = VE_OK;
+	VString name;
+	sLONG count = GetCount();
+	for( sLONG i = 0 ; (i < count) && (err == VE_OK) ; ++i)
+	{
+		if (ioNodeBudget == 0)
+		{
+			err = vThrowError( VE_STREAM_CANNOT_READ);
+			break;
+		}
+		--ioNodeBudget;
+
+		VValueSingle *value = GetNthProperty( i, &name).CreateVValue();
+		if ( (value != NULL) && !name.IsEmpty() )
+			ioBag.SetAttribute( name, value);
+		else
+			delete value;
+	}
+
+	count = GetElementNamesCount();
+	for( sLONG i = 0 ; (i < count) && (err == VE_OK) ; ++i)
+	{
+		// the elements array counts as a value, shared or not
+		if (ioNodeBudget == 0)
+		{
+			err = vThrowError( VE_STREAM_CANNOT_READ);
+			break;
+		}
+		--ioNodeBudget;
+
+		VBinaryValueView elements = GetNthElementName( i, &name);
+		if (name.IsEmpty())
+			continue;
+		sLONG elementsCount = elements.GetCount();
+		for( sLONG j = 0 ; (j < elementsCount) && (err == VE_OK) ; ++j)
+		{
+			VBinaryValueView element = elements.GetNth( j);
+			if (!element.IsBag())
+			{
+				if (ioNodeBudget == 0)
+					err = vThrowError( VE_STREAM_CANNOT_READ);
+				else
+					--ioNodeBudget;
+			}
+			else
+			{
+				VValueBag *bag = new VValueBag;
+				err = element._ToBag( *bag, inDepth + 1, ioNodeBudget);
+				ioBag.AddElement( name, bag);
+				ReleaseRefCountable( &bag);
+			}
+		}
+	}
+	return err;
+}
+
+
+//================================================================================================================
+
+
+VBinaryValueReader::VBinaryValueReader()
+: fData( NULL)
+, fSize( 0)
+, fStringTableOffset( 0)
+, fStringCount( 0)
+, fRootOffset( 0)
+, fMapping( NULL)
+{
+}
+
+
+VBinaryValueReader::~VBinaryValueReader()
+{
+	ReleaseRefCountable( &fMapping);
+}
+
+
+VError VBinaryValueReader::Init( const void *inData, VSize inSize)
+{
+	fData = NULL;
+	fSize = 0;
+	fStringTableOffset = fStringCount = fRootOffset = 0;
+	ReleaseRefCountable( &fMapping);
+
+	const uBYTE *data = (const uBYTE*) inData;
+	if ( (data == NULL) || (inSize < kBinaryValueHeaderSize) || (data[0] != 'V') || (data[1] != 'B') || (data[2] != 'I') || (data[3] != 'N') )
+		return vThrowError( VE_STREAM_BAD_SIGNATURE);
+
+	if (_ReadLong( data + 4) != kBinaryValueVersion)
+		return vThrowError( VE_STREAM_BAD_VERSION);
+
+	uLONG size = _ReadLong( data + 8);
+	uLONG stringTableOffset = _ReadLong( data + 12);
+	uLONG stringCount = _ReadLong( data + 16);
+	uLONG rootOffset = _ReadLong( data + 20);
+	if ( (size < kBinaryValueHeaderSize) || (size > inSize)
+		|| (stringTableOffset < kBinaryValueHeaderSize) || ((uLONG8) stringTableOffset + 4 * (uLONG8) stringCount > size)
+		|| (rootOffset < kBinaryValueHeaderSize) || (rootOffset >= stringTableOffset) )
+		return vThrowError( VE_STREAM_CANNOT_READ);
+
+	fData = data;
+	fSize = size;
+	fStringTableOffset = stringTableOffset;
+	fStringCount = stringCount;
+	fRootOffset = rootOffset;
+	return VE_OK;
+}
+
+
+VError VBinaryValueReader::Init( VFileMapping *inMapping)
+{
+	if (inMapping == NULL)
+		return Init( NULL, 0);
+
+	// retain first in case inMapping is already ours
+	inMapping->Retain();
+	VError err = Init( inMapping->GetDataPtr(), inMapping->GetDataSize());
+	if (err == VE_OK)
+		fMapping = inMapping;
+	else
+		inMapping->Release();
+	return err;
+}
+
+
+bool VBinaryValueReader::_GetByte( uLONG inOffset, uBYTE *outValue) const
+{
+	if (inOffset >= fSize)
+		return false;
+	*outValue = fData[inOffset];
+	return true;
+}
+
+
+bool VBinaryValueReader::_GetLong( uLONG inOffset, uLONG *outValue) const
+{
+	if ( (fSize < 4) || (inOffset > fSize - 4) )
+		return false;
+	*outValue = _ReadLong( fData + inOffset);
+	return true;
+}
+
+
+bool VBinaryValueReader::_GetLong8( uLONG inOffset, uLONG8 *outValue) const
+{
+	if ( (fSize < 8) || (inOffset > fSize - 8) )
+		return false;
+	*outValue = (uLONG8) _ReadLong( fData + inOffset) | ((uLONG8) _ReadLong( fData + inOffset + 4) << 32);
+	return true;
+}
+
+
+bool VBinaryValueReader::_GetString( uLONG inIndex, const char **outString, uLONG *outLength) const
+{
+	uLONG offset, length;
+	if ( (inIndex >= fStringCount) || !_GetLong( fStringTableOffset + 4 * inIndex, &offset) || !_GetLong( offset, &length) )
+		return false;
+
+	// room for the bytes and the trailing zero
+	if ((uLONG8) offset + 4 + length >= fSize)
+		return false;
+
+	*outString = (const char*) fData + offset + 4;
+	*outLength = length;
+	return true;
+}
+
+
+//================================================================================================================
+
+
+VBinaryValueWriter::VBinaryValueWriter()
+: fFailed( false)
+{
+}
+
+
+VBinaryValueWriter::~VBinaryValueWriter()
+{
+}
+
+
+VError VBinaryValueWriter::WriteBag( const VValueBag& inBag)
+{
+	VError err;
+	try
+	{
+		_Begin();
+		err = _Finish( _WriteBag( inBag, 0));
+	}
+	catch(...)
+	{
+		fData.clear();
+		err = vThrowError( VE_MEMORY_FULL);
+	}
+	return err;
+}
+
+
+VError VBinaryValueWriter::WriteJSON( const VJSONValue& inValue)
+{
+	VError err;
+	try
+	{
+		_Begin();
+		err = _Finish( _WriteJSON( inValue, 0));
+	}
+	catch(...)
+	{
+		fData.clear();
+		err = vThrowError( VE_MEMORY_FULL);
+	}
+	return err;
+}
+
+
+VError VBinaryValueWriter::WriteToStream( VStream *ioStream) const
+{
+	if (fData.empty())
+		return vThrowError( VE_INVALID_PARAMETER);
+	return ioStream->PutData( &fData.front(), fData.size());
+}
+
+
+void VBinaryValueWriter::_Begin()
+{
+	fData.clear();
+	fStringIndexes.clear();
+	fStringBytes.clear();
+	fStringStarts.clear();
+	fStringLengths.clear();
+	fFailed = false;
+
+	fData.resize( kBinaryValueHeaderSize, 0);
+}
+
+
+VError VBinaryValueWriter::_Finish( uLONG inRootOffset)
+{
+	uLONG stringCount = (uLONG) fStringStarts.size();
+	uLONG8 totalSize = (uLONG8) fData.size() + 4 * (uLONG8) stringCount + 4 * (uLONG8) stringCount + fStringBytes.size();
+	if (fFailed || (totalSize > kMAX_uLONG))
+	{
+		fData.clear();
+		return vThrowError( VE_INVALID_PARAMETER);
+	}
+
+	fData.reserve( (size_t) totalSize);
+
+	// string offsets then strings
+	uLONG stringTableOffset = _GetPos();
+	uLONG offset = stringTableOffset + 4 * stringCount;
+	for( uLONG i = 0 ; i < stringCount ; ++i)
+	{
+		_PutLong( offset);
+		offset += 4 + fStringLengths[i] + 1;
+	}
+	for( uLONG i = 0 ; i < stringCount ; ++i)
+	{
+		_PutLong( fStringLengths[i]);
+		const char *p = &fStringBytes[fStringStarts[i]];
+		fData.insert( fData.end(), p, p + fStringLengths[i] + 1);
+	}
+
+	uBYTE *header = &fData.front();
+	header[0] = 'V';
+	header[1] = 'B';
+	header[2] = 'I';
+	header[3] = 'N';
+	_WriteLong( header + 4, kBinaryValueVersion);
+	_WriteLong( header + 8, _GetPos());
+	_WriteLong( header + 12, stringTableOffset);
+	_WriteLong( header + 16, stringCount);
+	_WriteLong( header + 20, inRootOffset);
+
+	fStringIndexes.clear();
+	fStringBytes.clear();
+	fStringStarts.clear();
+	fStringLengths.clear();
+
+	return VE_OK;
+}
+
+
+uLONG VBinaryValueWriter::_InternString( const VString& inString)
+{
+	unordered_map_VString<uLONG>::const_iterator i = fStringIndexes.find( inString);
+	if (i != fStringIndexes.end())
+		return i->second;
+
+	VStringConvertBuffer buffer( inString, VTC_UTF_8);
+	uLONG index = (uLONG) fStringStarts.size();
+	fStringStarts.push_back( (uLONG) fStringBytes.size());
+	fStringLengths.push_back( (uLONG) buffer.GetSize());
+	fStringBytes.insert( fStringBytes.end(), buffer.GetCPointer(), buffer.GetCPointer() + buffer.GetSize());
+	fStringBytes.push_back( 0);
+	fStringIndexes.insert( unordered_map_VString<uLONG>::value_type( inString, index));
+	return index;
+}
+
+
+void VBinaryValueWriter::_PutLong( uLONG inValue)
+{
+	uBYTE bytes[4];
+	_WriteLong( bytes, inValue);
+	fData.insert( fData.end(), bytes, bytes + 4);
+}
+
+
+void VBinaryValueWriter::_PutLong8( uLONG8 inValue)
+{
+	_PutLong( (uLONG) inValue);
+	_PutLong( (uLONG) (inValue >> 32));
+}
+
+
+void VBinaryValueWriter::_WriteMembers( const VectorOfMember& inMembers)
+{
+	_PutLong( (uLONG) inMembers.size());
+	for( VectorOfMember::const_iterator i = inMembers.begin() ; i != inMembers.end() ; ++i)
+	{
+		_PutLong( i->first);
+		_PutLong( i->second);
+	}
+
+	std::vector<uLONG> sorted( inMembers.size());
+	for( uLONG i = 0 ; i < (uLONG) sorted.size() ; ++i)
+		sorted[i] = i;
+	std::sort( sorted.begin(), sorted.end(), VBinaryMemberNameLess( inMembers, fStringBytes, fStringStarts, fStringLengths));
+	for( std::vector<uLONG>::const_iterator i = sorted.begin() ; i != sorted.end() ; ++i)
+		_PutLong( *i);
+}
+
+
+uLONG VBinaryValueWriter::_WriteSingle( const VValueSingle& inValue)
+{
+	uLONG offset = _GetPos();
+	if (inValue.IsNull())
+	{
+		_PutByte( eBinaryValue_Null);
+		return offset;
+	}
+
+	switch( inValue.GetValueKind())
+	{
+		case VK_BOOLEAN:
+			_PutByte( inValue.GetBoolean() ? eBinaryValue_True : eBinaryValue_False);
+			break;
+
+		case VK_BYTE:
+		case VK_WORD:
+		case VK_LONG:
+		case VK_LONG8:
+			_PutByte( eBinaryValue_Long);
+			_PutLong8( (uLONG8) inValue.GetLong8());
+			break;
+
+		case VK_REAL:
+		case VK_FLOAT:
+			{
+				Real value = inValue.GetReal();
+				uLONG8 bits;
+				::memcpy( &bits, &value, sizeof( bits));
+				_PutByte( eBinaryValue_Real);
+				_PutLong8( bits);
+				break;
+			}
+
+		case VK_TIME:
+			_PutByte( eBinaryValue_Time);
+			_PutLong8( static_cast<const VTime&>( inValue).GetStamp());
+			break;
+
+		default:
+			{
+				VString s;
+				inValue.GetString( s);
+				uLONG index = _InternString( s);
+				_PutByte( eBinaryValue_String);
+				_PutLong( index);
+				break;
+			}
+	}
+	return offset;
+}
+
+
+uLONG VBinaryValueWriter::_WriteBag( const VValueBag& inBag, sLONG inDepth)
+{
+	if (inDepth > kBinaryValueMaxDepth)
+	{
+		fFailed = true;
+		return 0;
+	}
+
+	VString name;
+	VectorOfMember attributes;
+	VIndex count = inBag.GetAttributesCount();
+	attributes.reserve( count);
+	for( VIndex i = 1 ; i <= count ; ++i)
+	{
+		const VValueSingle *value = inBag.GetNthAttribute( i, &name);
+		if (value != NULL)
+		{
+			uLONG nameIndex = _InternString( name);
+			attributes.push_back( Member( nameIndex, _WriteSingle( *value)));
+		}
+	}
+
+	VectorOfMember elements;
+	std::vector<uLONG> offsets;
+	count = inBag.GetElementNamesCount();
+	elements.reserve( count);
+	for( VIndex i = 1 ; (i <= count) && !fFailed ; ++i)
+	{
+		const VBagArray *bags = inBag.GetNthElementName( i, &name);
+		if (bags == NULL)
+			continue;
+
+		offsets.clear();
+		VIndex bagsCount = bags->GetCount();
+		for( VIndex j = 1 ; (j <= bagsCount) && !fFailed ; ++j)
+		{
+			const VValueBag *bag = bags->GetNth( j);
+			if (bag != NULL)
+				offsets.push_back( _WriteBag( *bag, inDepth + 1));
+		}
+
+		uLONG nameIndex = _InternString( name);
+		uLONG arrayOffset = _GetPos();
+		_PutByte( eBinaryValue_Array);
+		_PutLong( (uLONG) offsets.size());
+		for( std::vector<uLONG>::const_iterator k = offsets.begin() ; k != offsets.end() ; ++k)
+			_PutLong( *k);
+		elements.push_back( Member( nameIndex, arrayOffset));
+	}
+
+	uLONG offset = _GetPos();
+	_PutByte( eBinaryValue_Bag);
+	_WriteMembers( attributes);
+	_WriteMembers( elements);
+	return offset;
+}
+
+
+uLONG VBinaryValueWriter::_WriteJSON( const VJSONValue& inValue, sLONG inDepth)
+{
+	if (inDepth > kBinaryValueMaxDepth)
+	{
+		fFailed = true;
+		return 0;
+	}
+
+	uLONG offset;
+	switch( inValue.GetType())
+	{
+		case JSON_null:
+			offset = _GetPos();
+			_PutByte( eBinaryValue_Null);
+			break;
+
+		case JSON_true:
+		case JSON_false:
+			offset = _GetPos();
+			_PutByte( inValue.GetBool() ? eBinaryValue_True : eBinaryValue_False);
+			break;
+
+		case JSON_number:
+			{
+				Real value = inValue.GetNumber();
+				uLONG8 bits;
+				::memcpy( &bits, &value, sizeof( bits));
+				offset = _GetPos();
+				_PutByte( eBinaryValue_Real);
+				_PutLong8( bits);
+				break;
+			}
+
+		case JSON_string:
+			{
+				VString s;
+				inValue.GetString( s);
+				uLONG index = _InternString( s);
+				offset = _GetPos();
+				_PutByte( eBinaryValue_String);
+				_PutLong( index);
+				break;
+			}
+
+		case JSON_date:
+			{
+				VTime time;
+				inValue.GetTime( time);
+				offset = _GetPos();
+				_PutByte( eBinaryValue_Time);
+				_PutLong8( time.GetStamp());
+				break;
+			}
+
+		case JSON_array:
+			{
+				const VJSONArray *array = inValue.GetArray();
+				std::vector<uLONG> offsets( array->GetCount());
+				for( size_t i = 0 ; (i < offsets.size()) && !fFailed ; ++i)
+					offsets[i] = _WriteJSON( (*array)[i], inDepth + 1);
+
+				offset = _GetPos();
+				_PutByte( eBinaryValue_Array);
+				_PutLong( (uLONG) offsets.size());
+				for( std::vector<uLONG>::const_iterator i = offsets.begin() ; i != offsets.end() ; ++i)
+					_PutLong( *i);
+				break;
+			}
+
+		case JSON_object:
+			{
+				VectorOfMember members;
+				for( VJSONPropertyConstOrderedIterator i( inValue.GetObject()) ; i.IsValid() && !fFailed ; ++i)
+				{
+					uLONG nameIndex = _InternString( i.GetName());
+					members.push_back( Member( nameIndex, _WriteJSON( i.GetValue(), inDepth + 1)));
+				}
+
+				offset = _GetPos();
+				_PutByte( eBinaryValue_Object);
+				_WriteMembers( members);
+				break;
+			}
+
+		default:
+			offset = _GetPos();
+			_PutByte( eBinaryValue_Undefined);
+			break;
+	}
+	return offset;
+}
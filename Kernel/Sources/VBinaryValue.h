@@ -0,0 +1,249 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VBinaryValue__
+#define __VBinaryValue__
+
+#include "Kernel/Sources/VJSONValue.h"
+#include "Kernel/Sources/VValueBag.h"
+#include "Kernel/Sources/VPackedDictionary.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+class VFileMapping;
+class VBinaryValueReader;
+
+
+/*
+	Compact binary format for VValueBag and VJSONValue documents.
+
+	All integers are little endian and all offsets are absolute from the document start.
+
+	header (24 bytes):
+		'VBIN'					signature
+		uLONG					version (1)
+		uLONG					document size
+		uLONG					string table offset
+		uLONG					string count
+		uLONG					root value offset
+
+	string table:
+		uLONG					offsets of each string
+		each string is a uLONG byte count followed by the utf-8 bytes and a trailing zero.
+		Keys and string values are stored only once.
+
+	value: a type byte (EBinaryValueType) followed by:
+		undefined, null, false, true	nothing
+		long					sLONG8
+		real					IEEE 754 double
+		string					uLONG string index
+		time					sLONG8 VTime stamp
+		array					uLONG count, uLONG value offsets[count]
+		object					member table
+		bag						attributes member table, then elements member table (values are arrays of bags)
+
+	member table:
+		uLONG					count
+		{ uLONG name string index, uLONG value offset } [count] in insertion order
+		uLONG					member indexes sorted by name bytes [count], for binary search
+
+	Children are written before their parent so that a document is produced in one pass.
+	Bag attributes of kinds other than boolean, numbers, string and time are stored as strings, as in XML.
+*/
+
+typedef enum
+{
+	eBinaryValue_Undefined	= 0,
+	eBinaryValue_Null		= 1,
+	eBinaryValue_False		= 2,
+	eBinaryValue_True		= 3,
+	eBinaryValue_Long		= 4,
+	eBinaryValue_Real		= 5,
+	eBinaryValue_String		= 6,
+	eBinaryValue_Time		= 7,
+	eBinaryValue_Array		= 8,
+	eBinaryValue_Object		= 9,
+	eBinaryValue_Bag		= 10
+} EBinaryValueType;
+
+
+/*!
+	@class	VBinaryValueView
+	@abstract	Read access to a value of a binary document without building any VValueBag or VJSONValue.
+	@discussion
+		A view is a small value type (a reader and an offset). It is valid as long as its VBinaryValueReader lives.
+		All accesses are bounds checked: a corrupted or missing value reads as undefined.
+		Strings can be read in place as utf-8 with GetUTF8.
+*/
+class XTOOLBOX_API VBinaryValueView
+{
+public:
+										VBinaryValueView() : fReader( NULL), fOffset( 0)	{;}
+
+			EBinaryValueType			GetType() const;
+
+			bool						IsUndefined() const			{ return GetType() == eBinaryValue_Undefined;}
+			bool						IsNull() const				{ return GetType() == eBinaryValue_Null;}
+			bool						IsBool() const				{ EBinaryValueType type = GetType(); return (type == eBinaryValue_False) || (type == eBinaryValue_True);}
+			bool						IsNumber() const			{ EBinaryValueType type = GetType(); return (type == eBinaryValue_Long) || (type == eBinaryValue_Real);}
+			bool						IsString() const			{ return GetType() == eBinaryValue_String;}
+			bool						IsTime() const				{ return GetType() == eBinaryValue_Time;}
+			bool						IsArray() const				{ return GetType() == eBinaryValue_Array;}
+			bool						IsObject() const			{ return GetType() == eBinaryValue_Object;}
+			bool						IsBag() const				{ return GetType() == eBinaryValue_Bag;}
+
+	// scalars. Numbers and booleans are coerced into each other.
+			bool						GetBool() const;
+			sLONG8						GetLong8() const;
+			Real						GetReal() const;
+			bool						GetTime( VTime& outTime) const;
+
+	// strings, numbers and booleans are converted. Returns false for other types.
+			bool						GetString( VString& outString) const;
+
+	// strings only: returns a pointer to the zero terminated utf-8 bytes inside the document.
+			bool						GetUTF8( const char **outString, size_t *outLength) const;
+
+	// count of array items, of object properties or of bag attributes
+			sLONG						GetCount() const;
+
+	// array item (0 based)
+			VBinaryValueView			GetNth( sLONG inIndex) const;
+
+	// object property or bag attribute (0 based, insertion order)
+			VBinaryValueView			GetNthProperty( sLONG inIndex, VString *outName) const;
+
+	// object property or bag attribute by name (binary search)
+			VBinaryValueView			GetProperty( const StPackedDictionaryKey& inName) const;
+
+	// bag elements. Values are arrays of bags.
+			sLONG						GetElementNamesCount() const;
+			VBinaryValueView			GetNthElementName( sLONG inIndex, VString *outName) const;
+			VBinaryValueView			GetElements( const StPackedDictionaryKey& inName) const;
+
+	// converters
+			VError						ToJSON( VJSONValue& outValue) const;
+			VError						ToBag( VValueBag& ioBag) const;		// bags only, adds attributes and elements to ioBag
+			VValueSingle*				CreateVValue() const;				// scalars only, NULL otherwise
+
+private:
+	friend class VBinaryValueReader;
+
+										VBinaryValueView( const VBinaryValueReader *inReader, uLONG inOffset) : fReader( inReader), fOffset( inOffset)	{;}
+
+			uLONG						_GetMembersOffset( bool inElements) const;
+			VBinaryValueView			_GetNthMember( uLONG inTableOffset, sLONG inIndex, VString *outName) const;
+			VBinaryValueView			_FindMember( uLONG inTableOffset, const StPackedDictionaryKey& inName) const;
+			// ioNodeBudget is the count of values that may still be converted
+			VError						_ToJSON( VJSONValue& outValue, sLONG inDepth, uLONG& ioNodeBudget) const;
+			VError						_ToBag( VValueBag& ioBag, sLONG inDepth, uLONG& ioNodeBudget) const;
+
+	const	VBinaryValueReader*			fReader;
+			uLONG						fOffset;	// of the type byte
+};
+
+
+/*!
+	@class	VBinaryValueReader
+	@abstract	Gives access to a binary document kept in memory or in a VFileMapping.
+	@discussion
+		The data is not copied: it must not change nor be released while the reader or its views are used.
+		Init only checks the header, values are checked when accessed.
+*/
+class XTOOLBOX_API VBinaryValueReader : public VObject
+{
+public:
+										VBinaryValueReader();
+	virtual								~VBinaryValueReader();
+
+			VError						Init( const void *inData, VSize inSize);
+
+	// retains the mapping
+			VError						Init( VFileMapping *inMapping);
+
+			VBinaryValueView			GetRoot() const				{ return VBinaryValueView( this, fRootOffset);}
+
+private:
+	friend class VBinaryValueView;
+
+										VBinaryValueReader( const VBinaryValueReader&);	// no copy
+			VBinaryValueReader&			operator=( const VBinaryValueReader&);
+
+			bool						_GetByte( uLONG inOffset, uBYTE *outValue) const;
+			bool						_GetLong( uLONG inOffset, uLONG *outValue) const;
+			bool						_GetLong8( uLONG inOffset, uLONG8 *outValue) const;
+			bool						_GetString( uLONG inIndex, const char **outString, uLONG *outLength) const;
+
+	const	uBYTE*						fData;
+			uLONG						fSize;
+			uLONG						fStringTableOffset;
+			uLONG						fStringCount;
+			uLONG						fRootOffset;
+			VFileMapping*				fMapping;
+};
+
+
+/*!
+	@class	VBinaryValueWriter
+	@abstract	Builds a binary document from a VValueBag or a VJSONValue.
+	@discussion
+		A writer produces one document: call WriteBag or WriteJSON once, then GetData or WriteToStream.
+		VJSONObject properties and bag attributes keep their order.
+*/
+class XTOOLBOX_API VBinaryValueWriter : public VObject
+{
+public:
+										VBinaryValueWriter();
+	virtual								~VBinaryValueWriter();
+
+			VError						WriteBag( const VValueBag& inBag);
+			VError						WriteJSON( const VJSONValue& inValue);
+
+			const void*					GetData() const				{ return fData.empty() ? NULL : &fData.front();}
+			VSize						GetSize() const				{ return fData.size();}
+
+			VError						WriteToStream( VStream *ioStream) const;
+
+private:
+	typedef	std::pair<uLONG,uLONG>		Member;		// name string index, value offset
+	typedef	std::vector<Member>			VectorOfMember;
+
+										VBinaryValueWriter( const VBinaryValueWriter&);	// no copy
+			VBinaryValueWriter&			operator=( const VBinaryValueWriter&);
+
+			void						_Begin();
+			VError						_Finish( uLONG inRootOffset);
+			uLONG						_InternString( const VString& inString);
+			uLONG						_WriteBag( const VValueBag& inBag, sLONG inDepth);
+			uLONG						_WriteJSON( const VJSONValue& inValue, sLONG inDepth);
+			uLONG						_WriteSingle( const VValueSingle& inValue);
+			void						_WriteMembers( const VectorOfMember& inMembers);
+			void						_PutByte( uBYTE inValue)		{ fData.push_back( inValue);}
+			void						_PutLong( uLONG inValue);
+			void						_PutLong8( uLONG8 inValue);
+			uLONG						_GetPos() const					{ return static_cast<uLONG>( fData.size());}
+
+			std::vector<uBYTE>			fData;
+			unordered_map_VString<uLONG>	fStringIndexes;
+			std::vector<char>			fStringBytes;		// utf-8 strings in index order, zero terminated
+			std::vector<uLONG>			fStringStarts;		// position of each string in fStringBytes
+			std::vector<uLONG>			fStringLengths;
+			bool						fFailed;
+};
+
+
+END_TOOLBOX_NAMESPACE
+
+#endif
@@ -17,8 +17,116 @@
 #include "VKernelPrecompiled.h"
 #include "VChecksumMD5.h"
 #include "VString.h"
+#include "VStream.h"
+#include "VErrorContext.h"
 #include "Base64Coder.h"
 
+// x86 extensions are compiled per function and selected at runtime
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#include <cpuid.h>
+	#include <immintrin.h>
+	#define CHECKSUM_WITH_X86			1
+	#define CHECKSUM_TARGET(_features_)	__attribute__((target(_features_)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+	#include <immintrin.h>
+	#define CHECKSUM_WITH_X86			1
+	#define CHECKSUM_TARGET(_features_)
+#else
+	#define CHECKSUM_WITH_X86			0
+#endif
+
+
+enum
+{
+	kCPU_SSSE3		= 1,
+	kCPU_SSE41		= 2,
+	kCPU_SSE42		= 4,
+	kCPU_SHA		= 8,
+	kCPU_Detected	= 0x40000000
+};
+
+static sLONG sCPUFeatures = 0;
+
+static sLONG _GetCPUFeatures()
+{
+	sLONG features = sCPUFeatures;
+	if (features == 0)
+	{
+		// every task computes the same value so there's no need to synchronize
+		features = kCPU_Detected;
+	#if CHECKSUM_WITH_X86
+		uLONG regs1[4] = { 0, 0, 0, 0};	// eax, ebx, ecx, edx
+		uLONG regs7[4] = { 0, 0, 0, 0};
+		#if defined(_MSC_VER)
+		int info[4];
+		__cpuid( info, 0);
+		uLONG maxLeaf = (uLONG) info[0];
+		__cpuid( info, 1);
+		for( int i = 0 ; i < 4 ; ++i)
+			regs1[i] = (uLONG) info[i];
+		if (maxLeaf >= 7)
+		{
+			__cpuidex( info, 7, 0);
+			for( int i = 0 ; i < 4 ; ++i)
+				regs7[i] = (uLONG) info[i];
+		}
+		#else
+		uLONG maxLeaf = __get_cpuid_max( 0, NULL);
+		if (maxLeaf >= 1)
+			__cpuid( 1, regs1[0], regs1[1], regs1[2], regs1[3]);
+		if (maxLeaf >= 7)
+			__cpuid_count( 7, 0, regs7[0], regs7[1], regs7[2], regs7[3]);
+		#endif
+		if (regs1[2] & (1 << 9))
+			features |= kCPU_SSSE3;
+		if (regs1[2] & (1 << 19))
+			features |= kCPU_SSE41;
+		if (regs1[2] & (1 << 20))
+			features |= kCPU_SSE42;
+		if (regs7[1] & (1 << 29))
+			features |= kCPU_SHA;
+	#endif
+		sCPUFeatures = features;
+	}
+	return features;
+}
+
+
+// reads inStream by chunks and passes them to ioChecksum.Update()
+template<class Checksum>
+static VError _UpdateFromStream( Checksum& ioChecksum, VStream *inStream, sLONG8 inMaxBytes)
+{
+	if (!testAssert( inStream != NULL))
+		return vThrowError( VE_INVALID_PARAMETER);
+
+	const VSize bufferSize = 64 * 1024L;
+	uBYTE *buffer = (uBYTE*) VMemory::NewPtr( bufferSize, 'chks');
+	if (buffer == NULL)
+		return vThrowError( VE_MEMORY_FULL);
+
+	VError err = VE_OK;
+	sLONG8 remaining = inMaxBytes;
+	{
+		StErrorContextInstaller filter( VE_STREAM_EOF, VE_OK);
+		while( (err == VE_OK) && (remaining != 0) )
+		{
+			VSize count = ( (remaining < 0) || (remaining > (sLONG8) bufferSize) ) ? bufferSize : (VSize) remaining;
+			err = inStream->GetData( buffer, &count);
+			ioChecksum.Update( buffer, count);
+			if (remaining > 0)
+				remaining -= count;
+		}
+	}
+
+	VMemory::DisposePtr( buffer);
+
+	if (err == VE_STREAM_EOF)
+		err = (remaining > 0) ? vThrowError( VE_STREAM_EOF) : VE_OK;
+
+	return err;
+}
+
 /*
  ***********************************************************************
  ** Copyright (C) 1990, RSA Data Security, Inc. All rights reserved.	**
@@ -217,6 +325,24 @@ void VChecksumMD5::GetChecksumFromStringUTF8Hexa( const VString& inString, VStri
 }
 
 
+VError VChecksumMD5::UpdateFromStream( VStream *inStream, sLONG8 inMaxBytes)
+{
+	return _UpdateFromStream( *this, inStream, inMaxBytes);
+}
+
+
+/*
+	static
+*/
+VError VChecksumMD5::GetChecksumFromStream( VStream *inStream, MD5& outChecksum)
+{
+	VChecksumMD5 checksum;
+	VError err = checksum.UpdateFromStream( inStream);
+	checksum.GetChecksum( outChecksum);
+	return err;
+}
+
+
 /* F, G, H and I are basic MD5 functions */
 #define F(x, y, z) (((x) & (y)) | ((~x) & (z)))
 #define G(x, y, z) (((x) & (z)) | ((y) & (~z)))
@@ -268,36 +394,53 @@ void VChecksumMD5::_MD5Init ()
 	 account for the presence of each of the characters inBuf[0..inLen-1]
 	 in the message whose digest is being computed.
  */
+static inline void _MD5DecodeBlock( const uBYTE *inBlock, uLONG *outWords)
+{
+	for( size_t i = 0, ii = 0; i < 16; i++, ii += 4)
+		outWords[i] = (((uLONG)inBlock[ii+3]) << 24) |
+						(((uLONG)inBlock[ii+2]) << 16) |
+						(((uLONG)inBlock[ii+1]) << 8) |
+						((uLONG)inBlock[ii]);
+}
+
 void VChecksumMD5::_MD5Update( const uBYTE *inBuf, size_t inLen)
 {
 	uLONG in[16];
-	sWORD mdi;
-	size_t i, ii;
+	size_t mdi;
 
 	/* compute number of bytes mod 64 */
-	mdi = (sWORD)((fContext.i[0] >> 3) & 0x3F);
+	mdi = (size_t)((fContext.i[0] >> 3) & 0x3F);
 
 	/* update number of bits */
 	if ((fContext.i[0] + ((uLONG)inLen << 3)) < fContext.i[0])
 		fContext.i[1]++;
 	fContext.i[0] += ((uLONG)inLen << 3);
-	fContext.i[1] += ((uLONG)inLen >> 29);
-
-	while (inLen--) {
-		/* add new character to buffer, increment mdi */
-		fContext.in[mdi++] = *inBuf++;
-
-		/* transform if necessary */
-		if (mdi == 0x40) {
-			for (i = 0, ii = 0; i < 16; i++, ii += 4)
-				in[i] = (((uLONG)fContext.in[ii+3]) << 24) |
-								(((uLONG)fContext.in[ii+2]) << 16) |
-								(((uLONG)fContext.in[ii+1]) << 8) |
-								((uLONG)fContext.in[ii]);
-			_Transform (fContext.buf, in);
-			mdi = 0;
-		}
+	fContext.i[1] += (uLONG) ((uLONG8)inLen >> 29);
+
+	/* complete the pending block */
+	if (mdi != 0)
+	{
+		size_t n = (inLen < 64 - mdi) ? inLen : 64 - mdi;
+		::memcpy( &fContext.in[mdi], inBuf, n);
+		mdi += n;
+		inBuf += n;
+		inLen -= n;
+		if (mdi < 64)
+			return;
+		_MD5DecodeBlock( fContext.in, in);
+		_Transform (fContext.buf, in);
 	}
+
+	/* transform whole blocks without copying them */
+	for( ; inLen >= 64 ; inBuf += 64, inLen -= 64)
+	{
+		_MD5DecodeBlock( inBuf, in);
+		_Transform (fContext.buf, in);
+	}
+
+	/* keep the remaining bytes for later */
+	if (inLen > 0)
+		::memcpy( fContext.in, inBuf, inLen);
 }
 
 /* Basic MD5 step. Transforms buf based on in.
@@ -503,6 +646,24 @@ void VChecksumSHA1::GetChecksumFromStringUTF8Hexa( const VString& inString, VStr
 }
 
 
+VError VChecksumSHA1::UpdateFromStream( VStream *inStream, sLONG8 inMaxBytes)
+{
+	return _UpdateFromStream( *this, inStream, inMaxBytes);
+}
+
+
+/*
+	static
+*/
+VError VChecksumSHA1::GetChecksumFromStream( VStream *inStream, SHA1& outChecksum)
+{
+	VChecksumSHA1 checksum;
+	VError err = checksum.UpdateFromStream( inStream);
+	checksum.GetChecksum( outChecksum);
+	return err;
+}
+
+
 //================================================================================
   
  /*
@@ -604,6 +765,109 @@ void VChecksumSHA1::SHA1Transform(uLONG state[5], const uBYTE buffer[SHA1_BLOCK_
 }
 
 
+#if CHECKSUM_WITH_X86
+
+/*
+ * Same as SHA1Transform for several blocks using the SHA extensions.
+ * Derived from Intel's SHA extensions white paper sample code.
+ */
+CHECKSUM_TARGET("sha,sse4.1,ssse3")
+static void _SHA1TransformBlocks_SHA( uLONG state[5], const uBYTE *data, size_t nbBlocks)
+{
+	const __m128i mask = _mm_set_epi64x( 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+
+	__m128i abcd = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*) state), 0x1B);
+	__m128i e0 = _mm_set_epi32( (int) state[4], 0, 0, 0);
+	__m128i e1;
+	__m128i msg[4];
+
+	for( ; nbBlocks > 0 ; --nbBlocks, data += 64)
+	{
+		__m128i abcd_save = abcd;
+		__m128i e0_save = e0;
+
+		// rounds 0-15 with the message words
+		msg[0] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*) (data + 0)), mask);
+		e0 = _mm_add_epi32( e0, msg[0]);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32( abcd, e0, 0);
+
+		msg[1] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*) (data + 16)), mask);
+		e1 = _mm_sha1nexte_epu32( e1, msg[1]);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32( abcd, e1, 0);
+		msg[0] = _mm_sha1msg1_epu32( msg[0], msg[1]);
+
+		msg[2] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*) (data + 32)), mask);
+		e0 = _mm_sha1nexte_epu32( e0, msg[2]);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32( abcd, e0, 0);
+		msg[1] = _mm_sha1msg1_epu32( msg[1], msg[2]);
+		msg[0] = _mm_xor_si128( msg[0], msg[2]);
+
+		msg[3] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*) (data + 48)), mask);
+		e1 = _mm_sha1nexte_epu32( e1, msg[3]);
+		e0 = abcd;
+		msg[0] = _mm_sha1msg2_epu32( msg[0], msg[3]);
+		abcd = _mm_sha1rnds4_epu32( abcd, e1, 0);
+		msg[2] = _mm_sha1msg1_epu32( msg[2], msg[3]);
+		msg[1] = _mm_xor_si128( msg[1], msg[3]);
+
+		// rounds 16-79 with the message schedule, four rounds at a time.
+		// the last steps compute schedule words that are never used, the compiler drops them.
+		#define SHA1_NI_ROUNDS(i, ecur, enext, func) \
+			ecur = _mm_sha1nexte_epu32( ecur, msg[(i) & 3]); \
+			enext = abcd; \
+			msg[((i) + 1) & 3] = _mm_sha1msg2_epu32( msg[((i) + 1) & 3], msg[(i) & 3]); \
+			abcd = _mm_sha1rnds4_epu32( abcd, ecur, func); \
+			msg[((i) + 3) & 3] = _mm_sha1msg1_epu32( msg[((i) + 3) & 3], msg[(i) & 3]); \
+			msg[((i) + 2) & 3] = _mm_xor_si128( msg[((i) + 2) & 3], msg[(i) & 3]);
+
+		SHA1_NI_ROUNDS( 4, e0, e1, 0)
+		SHA1_NI_ROUNDS( 5, e1, e0, 1)
+		SHA1_NI_ROUNDS( 6, e0, e1, 1)
+		SHA1_NI_ROUNDS( 7, e1, e0, 1)
+		SHA1_NI_ROUNDS( 8, e0, e1, 1)
+		SHA1_NI_ROUNDS( 9, e1, e0, 1)
+		SHA1_NI_ROUNDS( 10, e0, e1, 2)
+		SHA1_NI_ROUNDS( 11, e1, e0, 2)
+		SHA1_NI_ROUNDS( 12, e0, e1, 2)
+		SHA1_NI_ROUNDS( 13, e1, e0, 2)
+		SHA1_NI_ROUNDS( 14, e0, e1, 2)
+		SHA1_NI_ROUNDS( 15, e1, e0, 3)
+		SHA1_NI_ROUNDS( 16, e0, e1, 3)
+		SHA1_NI_ROUNDS( 17, e1, e0, 3)
+		SHA1_NI_ROUNDS( 18, e0, e1, 3)
+		SHA1_NI_ROUNDS( 19, e1, e0, 3)
+
+		#undef SHA1_NI_ROUNDS
+
+		e0 = _mm_sha1nexte_epu32( e0, e0_save);
+		abcd = _mm_add_epi32( abcd, abcd_save);
+	}
+
+	_mm_storeu_si128( (__m128i*) state, _mm_shuffle_epi32( abcd, 0x1B));
+	state[4] = (uLONG) _mm_extract_epi32( e0, 3);
+}
+
+#endif
+
+
+void VChecksumSHA1::SHA1TransformBlocks(uLONG state[5], const uBYTE *data, size_t nbBlocks)
+{
+#if CHECKSUM_WITH_X86
+	const sLONG needed = kCPU_SHA | kCPU_SSE41 | kCPU_SSSE3;
+	if ( (nbBlocks > 0) && ((_GetCPUFeatures() & needed) == needed) )
+	{
+		_SHA1TransformBlocks_SHA( state, data, nbBlocks);
+		return;
+	}
+#endif
+	for( ; nbBlocks > 0 ; --nbBlocks, data += SHA1_BLOCK_LENGTH)
+		SHA1Transform( state, data);
+}
+
+
 /*
  * SHA1Init - Initialize new context
  */
@@ -631,9 +895,9 @@ void VChecksumSHA1::SHA1Update(SHA1_CTX *context, const uBYTE *data, size_t len)
 	context->count += (len << 3);
 	if ((j + len) > 63) {
 		(void)memcpy(&context->buffer[j], data, (i = 64-j));
-		SHA1Transform(context->state, context->buffer);
-		for ( ; i + 63 < len; i += 64)
-			SHA1Transform(context->state, (uBYTE *)&data[i]);
+		SHA1TransformBlocks(context->state, context->buffer, 1);
+		SHA1TransformBlocks(context->state, &data[i], (len - i) / 64);
+		i += ((len - i) / 64) * 64;
 		j = 0;
 	} else {
 		i = 0;
@@ -660,3 +924,131 @@ void VChecksumSHA1::SHA1Pad(SHA1_CTX *context)
 	SHA1Update(context, finalcount, 8); /* Should cause a SHA1Transform() */
 }
 
+
+
+//================================================================================
+
+
+/*
+ * CRC-32C, reflected polynomial 0x82F63B78.
+ * Portable version processes 8 bytes per step with 8 lookup tables (slicing-by-8).
+ */
+
+class VCRC32CTables
+{
+public:
+	VCRC32CTables()
+	{
+		for( uLONG n = 0 ; n < 256 ; ++n)
+		{
+			uLONG crc = n;
+			for( int k = 0 ; k < 8 ; ++k)
+				crc = (crc & 1) ? ((crc >> 1) ^ 0x82F63B78) : (crc >> 1);
+			fTable[0][n] = crc;
+		}
+		for( uLONG n = 0 ; n < 256 ; ++n)
+		{
+			for( int k = 1 ; k < 8 ; ++k)
+				fTable[k][n] = (fTable[k-1][n] >> 8) ^ fTable[0][fTable[k-1][n] & 0xFF];
+		}
+	}
+
+	uLONG	fTable[8][256];
+};
+
+static const VCRC32CTables sCRC32CTables;
+
+
+static uLONG _CRC32C_Portable( uLONG inCRC, const uBYTE *inData, size_t inSize)
+{
+	const uLONG (*table)[256] = sCRC32CTables.fTable;
+	uLONG crc = inCRC;
+
+	for( ; inSize >= 8 ; inSize -= 8, inData += 8)
+	{
+		uLONG low = crc ^ ((uLONG) inData[0] | ((uLONG) inData[1] << 8) | ((uLONG) inData[2] << 16) | ((uLONG) inData[3] << 24));
+		crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24]
+			^ table[3][inData[4]] ^ table[2][inData[5]] ^ table[1][inData[6]] ^ table[0][inData[7]];
+	}
+
+	for( ; inSize > 0 ; --inSize)
+		crc = table[0][(crc ^ *inData++) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+
+#if CHECKSUM_WITH_X86
+
+CHECKSUM_TARGET("sse4.2")
+static uLONG _CRC32C_SSE42( uLONG inCRC, const uBYTE *inData, size_t inSize)
+{
+	uLONG crc = inCRC;
+
+	for( ; (inSize > 0) && (((uLONG_PTR) inData & 7) != 0) ; --inSize)
+		crc = _mm_crc32_u8( crc, *inData++);
+
+#if ARCH_64
+	uLONG8 crc8 = crc;
+	for( ; inSize >= 8 ; inSize -= 8, inData += 8)
+		crc8 = _mm_crc32_u64( crc8, *(const uLONG8*) inData);
+	crc = (uLONG) crc8;
+#else
+	for( ; inSize >= 4 ; inSize -= 4, inData += 4)
+		crc = _mm_crc32_u32( crc, *(const uLONG*) inData);
+#endif
+
+	for( ; inSize > 0 ; --inSize)
+		crc = _mm_crc32_u8( crc, *inData++);
+
+	return crc;
+}
+
+#endif
+
+
+/*
+	static
+*/
+uLONG VChecksumCRC32C::Extend( uLONG inChecksum, const void *inData, size_t inSize)
+{
+	if ( (inData == NULL) || (inSize == 0) )
+		return inChecksum;
+
+	uLONG crc = ~inChecksum;
+#if CHECKSUM_WITH_X86
+	if (_GetCPUFeatures() & kCPU_SSE42)
+		crc = _CRC32C_SSE42( crc, (const uBYTE*) inData, inSize);
+	else
+#endif
+		crc = _CRC32C_Portable( crc, (const uBYTE*) inData, inSize);
+	return ~crc;
+}
+
+
+/*
+	static
+*/
+void VChecksumCRC32C::EncodeChecksumHexa( uLONG inDigest, VString& outChecksumHexa)
+{
+	uBYTE digest[4] = { (uBYTE) (inDigest >> 24), (uBYTE) (inDigest >> 16), (uBYTE) (inDigest >> 8), (uBYTE) inDigest };
+	_EncodeChecksumHexa( digest, sizeof( digest), outChecksumHexa);
+}
+
+
+VError VChecksumCRC32C::UpdateFromStream( VStream *inStream, sLONG8 inMaxBytes)
+{
+	return _UpdateFromStream( *this, inStream, inMaxBytes);
+}
+
+
+/*
+	static
+*/
+VError VChecksumCRC32C::GetChecksumFromStream( VStream *inStream, uLONG& outChecksum)
+{
+	VChecksumCRC32C checksum;
+	VError err = checksum.UpdateFromStream( inStream);
+	outChecksum = checksum.GetChecksum();
+	return err;
+}
@@ -19,6 +19,7 @@
 BEGIN_TOOLBOX_NAMESPACE
 
 class VString;
+class VStream;
 
 /* Data structure for MD5 (Message-Digest) computation */
 const size_t MD5_SIZE = 16;
@@ -45,6 +46,10 @@ public:
 			void	Clear();
 			void	Update( const void *inData, size_t inSize );
 			void	GetChecksum( MD5& outChecksum );
+
+	// feeds the bytes of a stream opened for reading, from its current position up to its end or up to inMaxBytes bytes if inMaxBytes >= 0.
+			VError	UpdateFromStream( VStream *inStream, sLONG8 inMaxBytes = -1);
+	static	VError	GetChecksumFromStream( VStream *inStream, MD5& outChecksum);
 	
 private:
 					VChecksumMD5( const VChecksumMD5&);
@@ -86,6 +91,10 @@ public:
 			void	Clear();
 			void	Update( const void *inData, size_t inSize );
 			void	GetChecksum( SHA1& outChecksum );
+
+	// feeds the bytes of a stream opened for reading, from its current position up to its end or up to inMaxBytes bytes if inMaxBytes >= 0.
+			VError	UpdateFromStream( VStream *inStream, sLONG8 inMaxBytes = -1);
+	static	VError	GetChecksumFromStream( VStream *inStream, SHA1& outChecksum);
 	
 private:
 	enum { SHA1_BLOCK_LENGTH = 64};
@@ -100,6 +109,7 @@ private:
 					VChecksumSHA1& operator=( const VChecksumSHA1&);
 	static	void	SHA1Init(SHA1_CTX *context);
 	static	void	SHA1Transform(uLONG state[5], const uBYTE buffer[SHA1_BLOCK_LENGTH]);
+	static	void	SHA1TransformBlocks(uLONG state[5], const uBYTE *data, size_t nbBlocks);	// uses SHA extensions if available
 	static	void	SHA1Update(SHA1_CTX *context, const uBYTE *data, size_t len);
 	static	void	SHA1Pad(SHA1_CTX *context);
 
@@ -108,6 +118,40 @@ private:
 };
 
 
+/*
+	CRC-32C (Castagnoli polynomial) for integrity checks: much faster than MD5 or SHA1 but not a cryptographic hash.
+	Uses the SSE 4.2 crc32 instruction if the processor has it.
+*/
+class XTOOLBOX_API VChecksumCRC32C : public VObject
+{
+public:
+
+	typedef uLONG	digest_type;
+
+	// common checksum computation
+	static	uLONG	GetChecksumFromBytes( const void *inData, size_t inSize)		{ return Extend( 0, inData, inSize);}
+	static	VError	GetChecksumFromStream( VStream *inStream, uLONG& outChecksum);
+
+	// continues a checksum with more bytes: Extend( GetChecksumFromBytes( a), b) == GetChecksumFromBytes( a + b)
+	static	uLONG	Extend( uLONG inChecksum, const void *inData, size_t inSize);
+
+	// big endian, 8 chars
+	static	void	EncodeChecksumHexa( uLONG inDigest, VString& outChecksumHexa);
+
+	// incremental computation
+					VChecksumCRC32C() : fChecksum( 0)							{;}
+			void	Clear()														{ fChecksum = 0;}
+			void	Update( const void *inData, size_t inSize )					{ fChecksum = Extend( fChecksum, inData, inSize);}
+			uLONG	GetChecksum() const											{ return fChecksum;}
+
+	// feeds the bytes of a stream opened for reading, from its current position up to its end or up to inMaxBytes bytes if inMaxBytes >= 0.
+			VError	UpdateFromStream( VStream *inStream, sLONG8 inMaxBytes = -1);
+
+private:
+			uLONG	fChecksum;
+};
+
+
 END_TOOLBOX_NAMESPACE
 
 #endif
\ No newline at end of file
@@ -119,6 +119,23 @@ bool VCollator::EndsWithString( const UniChar* inText, sLONG inTextSize, const U
 }
 
 
+bool VCollator::GetSortKey( const UniChar* /*inText*/, sLONG /*inSize*/, bool /*inWithDiacritics*/, std::vector<uBYTE>& outKey)
+{
+	outKey.clear();
+	return false;
+}
+
+
+CompareResult VCollator::CompareSortKeys( const uBYTE *inKey1, sLONG inSize1, const uBYTE *inKey2, sLONG inSize2)
+{
+	sLONG size = (inSize1 < inSize2) ? inSize1 : inSize2;
+	int r = (size > 0) ? ::memcmp( inKey1, inKey2, size) : 0;
+	if (r == 0)
+		r = inSize1 - inSize2;
+	return (r < 0) ? CR_SMALLER : ((r > 0) ? CR_BIGGER : CR_EQUAL);
+}
+
+
 bool VCollator::IsPatternCompatibleWithDichotomyAndDiacritics( const UniChar *inPattern, const sLONG inSize)
 {
 	bool compatible = true;
@@ -505,6 +522,187 @@ bool VCollator::EqualString_Like( const UniChar* inText, sLONG inTextSize, const
 	return equal;
 }
 
+
+/************************************************************************/
+// sort keys cache
+/************************************************************************/
+
+VCollatorSortKeyCache::VCollatorSortKeyCache()
+: fSlots( kSlotCount)
+, fHits( 0)
+, fMisses( 0)
+{
+}
+
+
+VCollatorSortKeyCache::~VCollatorSortKeyCache()
+{
+}
+
+
+uLONG VCollatorSortKeyCache::_Hash( const UniChar* inText, sLONG inSize, bool inWithDiacritics)
+{
+	// FNV-1a
+	uLONG hash = inWithDiacritics ? 2166136261U : 2166136261U ^ 0x5A5A5A5AU;
+	for( const UniChar *p = inText, *end = inText + inSize ; p != end ; ++p)
+	{
+		hash ^= *p;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+
+bool VCollatorSortKeyCache::_Matches( const Slot& inSlot, uLONG inHash, const UniChar* inText, sLONG inSize, bool inWithDiacritics)
+{
+	return inSlot.fUsed
+		&& (inSlot.fHash == inHash)
+		&& (inSlot.fWithDiacritics == inWithDiacritics)
+		&& (inSlot.fText.size() == (size_t) inSize)
+		&& ( (inSize == 0) || (::memcmp( &inSlot.fText[0], inText, inSize * sizeof( UniChar)) == 0) );
+}
+
+
+bool VCollatorSortKeyCache::_CompareSlots( uLONG inHash1, const UniChar* inText1, sLONG inSize1, uLONG inHash2, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics, CompareResult& outResult)
+{
+	const Slot& slot1 = fSlots[inHash1 & (kSlotCount - 1)];
+	const Slot& slot2 = fSlots[inHash2 & (kSlotCount - 1)];
+
+	// always lock stripes in the same order
+	sLONG stripe1 = inHash1 & (kStripeCount - 1);
+	sLONG stripe2 = inHash2 & (kStripeCount - 1);
+	VCriticalSection& first = fLocks[(stripe1 < stripe2) ? stripe1 : stripe2];
+	VCriticalSection& second = fLocks[(stripe1 < stripe2) ? stripe2 : stripe1];
+
+	first.Lock();
+	if (stripe1 != stripe2)
+		second.Lock();
+
+	bool found = _Matches( slot1, inHash1, inText1, inSize1, inWithDiacritics) && _Matches( slot2, inHash2, inText2, inSize2, inWithDiacritics);
+	if (found)
+	{
+		if (&slot1 == &slot2)
+			outResult = CR_EQUAL;
+		else
+			outResult = VCollator::CompareSortKeys( &slot1.fKey[0], (sLONG) slot1.fKey.size(), &slot2.fKey[0], (sLONG) slot2.fKey.size());
+	}
+
+	if (stripe1 != stripe2)
+		second.Unlock();
+	first.Unlock();
+
+	return found;
+}
+
+
+bool VCollatorSortKeyCache::_Admit( uLONG inHash, const UniChar* inText, sLONG inSize, bool inWithDiacritics)
+{
+	Slot& slot = fSlots[inHash & (kSlotCount - 1)];
+	VCriticalSection& lock = fLocks[inHash & (kStripeCount - 1)];
+
+	lock.Lock();
+	bool admit;
+	if (_Matches( slot, inHash, inText, inSize, inWithDiacritics))
+	{
+		admit = false;
+	}
+	else if (slot.fCandidateHash == inHash)
+	{
+		admit = true;
+	}
+	else
+	{
+		slot.fCandidateHash = inHash;
+		admit = false;
+	}
+	lock.Unlock();
+
+	return admit;
+}
+
+
+void VCollatorSortKeyCache::_Store( uLONG inHash, const UniChar* inText, sLONG inSize, bool inWithDiacritics, std::vector<uBYTE>& ioKey)
+{
+	Slot& slot = fSlots[inHash & (kSlotCount - 1)];
+	VCriticalSection& lock = fLocks[inHash & (kStripeCount - 1)];
+
+	lock.Lock();
+	try
+	{
+		slot.fText.assign( inText, inText + inSize);
+		slot.fKey.swap( ioKey);
+		slot.fHash = inHash;
+		slot.fWithDiacritics = inWithDiacritics;
+		slot.fCandidateHash = 0;
+		slot.fUsed = true;
+	}
+	catch(...)
+	{
+		slot.fUsed = false;
+	}
+	lock.Unlock();
+}
+
+
+bool VCollatorSortKeyCache::CompareStrings( VCollator *inCollator, const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics, CompareResult& outResult)
+{
+	if ( (inSize1 > kMaxTextLength) || (inSize2 > kMaxTextLength) || (inSize1 < 0) || (inSize2 < 0) )
+		return false;
+
+	uLONG hash1 = _Hash( inText1, inSize1, inWithDiacritics);
+	uLONG hash2 = _Hash( inText2, inSize2, inWithDiacritics);
+
+	if (_CompareSlots( hash1, inText1, inSize1, hash2, inText2, inSize2, inWithDiacritics, outResult))
+	{
+		VInterlocked::Increment( &fHits);
+		return true;
+	}
+
+	VInterlocked::Increment( &fMisses);
+
+	// compute keys of strings that are hot enough outside of the locks
+	bool stored = false;
+	std::vector<uBYTE> key;
+	if (_Admit( hash1, inText1, inSize1, inWithDiacritics) && inCollator->GetSortKey( inText1, inSize1, inWithDiacritics, key))
+	{
+		_Store( hash1, inText1, inSize1, inWithDiacritics, key);
+		stored = true;
+	}
+	if (_Admit( hash2, inText2, inSize2, inWithDiacritics) && inCollator->GetSortKey( inText2, inSize2, inWithDiacritics, key))
+	{
+		_Store( hash2, inText2, inSize2, inWithDiacritics, key);
+		stored = true;
+	}
+
+	return stored && _CompareSlots( hash1, inText1, inSize1, hash2, inText2, inSize2, inWithDiacritics, outResult);
+}
+
+
+void VCollatorSortKeyCache::Clear()
+{
+	for( sLONG i = 0 ; i < kSlotCount ; ++i)
+	{
+		VCriticalSection& lock = fLocks[i & (kStripeCount - 1)];
+		lock.Lock();
+		Slot& slot = fSlots[i];
+		slot.fUsed = false;
+		slot.fCandidateHash = 0;
+		std::vector<UniChar>().swap( slot.fText);
+		std::vector<uBYTE>().swap( slot.fKey);
+		lock.Unlock();
+	}
+}
+
+
+void VCollatorSortKeyCache::GetStatistics( uLONG *outHits, uLONG *outMisses) const
+{
+	if (outHits != NULL)
+		*outHits = (uLONG) VInterlocked::AtomicGet( &fHits);
+	if (outMisses != NULL)
+		*outMisses = (uLONG) VInterlocked::AtomicGet( &fMisses);
+}
+
+
 #if !VERSION_LINUX
 
 /************************************************************/
@@ -837,6 +1035,7 @@ VICUCollator::VICUCollator( DialectCode inDialect, xbox_icu::Locale *inLocale, x
 , fSearchWithoutDiacritics( NULL)
 , fUseOptimizedSort(false)
 , fElementKeyMask( (inOptions & COL_EqualityUsesSecondaryStrength) ? (UCOL_PRIMARYMASK | UCOL_SECONDARYMASK) : UCOL_PRIMARYMASK)
+, fSortKeyCache( new VCollatorSortKeyCache)
 {
 	uWORD primaryLanguage=DC_PRIMARYLANGID(inDialect);
 	
@@ -858,6 +1057,8 @@ VICUCollator::~VICUCollator()
 	
 	delete fLocale;
 	
+	ReleaseRefCountable( &fSortKeyCache);
+
 	if (fSearchWithDiacritics != NULL)
 	{
 		ubrk_close( const_cast<UBreakIterator*>( usearch_getBreakIterator( fSearchWithDiacritics)));
@@ -883,6 +1084,7 @@ VICUCollator::VICUCollator(const VICUCollator& inCollator)
 , fSearchWithDiacritics( NULL)
 , fSearchWithoutDiacritics( NULL)
 , fElementKeyMask( inCollator.fElementKeyMask)
+, fSortKeyCache( RetainRefCountable( inCollator.fSortKeyCache))
 {
 	fUseOptimizedSort = inCollator.fUseOptimizedSort;
 	fLocale = inCollator.fLocale->clone();
@@ -917,7 +1119,6 @@ const char order_chars[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 28, 29, 30, 31, 32, 9, 1
 CompareResult VICUCollator::CompareString (const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics)
 {
 	static const UniChar nullStr[] = {0};
-	UErrorCode status = U_ZERO_ERROR;
 	
 	// icu doesn't accept null pointer even if the associated size parameter is zero
 	if (inText1 == NULL)
@@ -971,7 +1172,7 @@ CompareResult VICUCollator::CompareString (const UniChar* inText1, sLONG inSize1
 					}
 					else
 					{
-						result = (CompareResult) fTertiaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status);
+						result = _CollateString( inText1,  inSize1,  inText2, inSize2, true);
 					}
 					break;
 				}
@@ -980,13 +1181,13 @@ CompareResult VICUCollator::CompareString (const UniChar* inText1, sLONG inSize1
 					if (*p1 < 127)
 						result = CR_BIGGER;
 					else
-						result = (CompareResult) fTertiaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status);
+						result = _CollateString( inText1,  inSize1,  inText2, inSize2, true);
 					break;
 				}
 				else if ( (*p1 > 127 || *p2 > 127) || (*p1 == 0x60) || (*p2 == 0x60) || (*p1 == 0x5E) || (*p2 == 0x5E) )
 				{
 					// everything above latin basic and not Grave Accent nor Circumflex Accent
-					result = (CompareResult) fTertiaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status);
+					result = _CollateString( inText1,  inSize1,  inText2, inSize2, true);
 					break;
 				}
 				else
@@ -1019,6 +1220,7 @@ CompareResult VICUCollator::CompareString (const UniChar* inText1, sLONG inSize1
 			} while( true);
 
 	#if VERSIONDEBUG
+			UErrorCode status = U_ZERO_ERROR;
 			CompareResult icu_result = (CompareResult) fTertiaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status);
 			if (result != icu_result)
 			{
@@ -1044,7 +1246,7 @@ CompareResult VICUCollator::CompareString (const UniChar* inText1, sLONG inSize1
 					else if (*p2 < 127)
 						result = CR_SMALLER;
 					else
-						result = (CompareResult) fPrimaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status);
+						result = _CollateString( inText1,  inSize1,  inText2, inSize2, false);
 					break;
 				}
 				else if (p2 == p2_end)
@@ -1052,13 +1254,13 @@ CompareResult VICUCollator::CompareString (const UniChar* inText1, sLONG inSize1
 					if (*p1 < 127)
 						result = CR_BIGGER;
 					else
-						result = (CompareResult) fPrimaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status);
+						result = _CollateString( inText1,  inSize1,  inText2, inSize2, false);
 					break;
 				}
 				else if ( (*p1 > 127 || *p2 > 127) || (*p1 == 0x60) || (*p2 == 0x60) || (*p1 == 0x5E) || (*p2 == 0x5E) )
 				{
 					// everything above latin basic and not Grave Accent nor Circumflex Accent
-					result = (CompareResult) fPrimaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status);
+					result = _CollateString( inText1,  inSize1,  inText2, inSize2, false);
 					break;
 				}
 				else
@@ -1080,6 +1282,7 @@ CompareResult VICUCollator::CompareString (const UniChar* inText1, sLONG inSize1
 			} while( true);
 
 	#if VERSIONDEBUG
+			UErrorCode status = U_ZERO_ERROR;
 			CompareResult icu_result = (CompareResult)fPrimaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status);
 			if (result != icu_result)
 			{
@@ -1093,16 +1296,7 @@ CompareResult VICUCollator::CompareString (const UniChar* inText1, sLONG inSize1
 	}
 	else
 	{
-
-		UCollationResult result;
-		if (inWithDiacritics)
-			result = fTertiaryCollator->compare( inText1, inSize1, inText2, inSize2, status);
-		else
-			result = fPrimaryCollator->compare( inText1, inSize1, inText2, inSize2, status);
-		
-		xbox_assert( U_SUCCESS( status));
-
-		return (CompareResult) result;
+		return _CollateString( inText1, inSize1, inText2, inSize2, inWithDiacritics);
 	}
 	
 }
@@ -1110,7 +1304,6 @@ CompareResult VICUCollator::CompareString (const UniChar* inText1, sLONG inSize1
 
 bool VICUCollator::EqualString(const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics)
 {
-	UErrorCode status = U_ZERO_ERROR;
 	const UniChar *p1 = inText1;
 	const UniChar *p1_end = inText1 + inSize1;
 
@@ -1137,7 +1330,7 @@ bool VICUCollator::EqualString(const UniChar* inText1, sLONG inSize1, const UniC
 				else if (*p2 < 127)
 					equal = false;
 				else
-					equal = fTertiaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status) == UCOL_EQUAL;
+					equal = _CollateString( inText1,  inSize1,  inText2, inSize2, true) == CR_EQUAL;
 				break;
 			}
 			else if (p2 == p2_end)
@@ -1145,14 +1338,14 @@ bool VICUCollator::EqualString(const UniChar* inText1, sLONG inSize1, const UniC
 				if (*p1 < 127)
 					equal = false;
 				else
-					equal = fTertiaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status) == UCOL_EQUAL;
+					equal = _CollateString( inText1,  inSize1,  inText2, inSize2, true) == CR_EQUAL;
 				break;
 			}
 
 			// everything above latin basic and not Grave Accent nor Circumflex Accent
 			if ( (*p1 > 127 || *p2 > 127) || (*p1 == 0x60) || (*p2 == 0x60) || (*p1 == 0x5E) || (*p2 == 0x5E) )
 			{
-				equal = fTertiaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status) == UCOL_EQUAL;
+				equal = _CollateString( inText1,  inSize1,  inText2, inSize2, true) == CR_EQUAL;
 				break;
 			}
 			else
@@ -1186,7 +1379,7 @@ bool VICUCollator::EqualString(const UniChar* inText1, sLONG inSize1, const UniC
 				else if (*p2 < 127)
 					equal = false;
 				else
-					equal = fPrimaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status) == UCOL_EQUAL;
+					equal = _CollateString( inText1,  inSize1,  inText2, inSize2, false) == CR_EQUAL;
 				break;
 			}
 			else if (p2 == p2_end)
@@ -1194,14 +1387,14 @@ bool VICUCollator::EqualString(const UniChar* inText1, sLONG inSize1, const UniC
 				if (*p1 < 127)
 					equal = false;
 				else
-					equal = fPrimaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status) == UCOL_EQUAL;
+					equal = _CollateString( inText1,  inSize1,  inText2, inSize2, false) == CR_EQUAL;
 				break;
 			}
 
 			// everything above latin basic and not Grave Accent nor Circumflex Accent
 			if ( (*p1 > 127 || *p2 > 127) || (*p1 == 0x60) || (*p2 == 0x60) || (*p1 == 0x5E) || (*p2 == 0x5E) )
 			{
-				equal = fPrimaryCollator->compare( inText1,  inSize1,  inText2, inSize2, status) == UCOL_EQUAL;
+				equal = _CollateString( inText1,  inSize1,  inText2, inSize2, false) == CR_EQUAL;
 				break;
 			}
 			else
@@ -1230,6 +1423,56 @@ bool VICUCollator::EqualString(const UniChar* inText1, sLONG inSize1, const UniC
 }
 
 
+// Full ICU comparison, through the sort keys cache for hot short strings.
+CompareResult VICUCollator::_CollateString( const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics)
+{
+	CompareResult result;
+	if ( (fSortKeyCache == NULL) || !fSortKeyCache->CompareStrings( this, inText1, inSize1, inText2, inSize2, inWithDiacritics, result) )
+	{
+		UErrorCode status = U_ZERO_ERROR;
+		if (inWithDiacritics)
+			result = (CompareResult) fTertiaryCollator->compare( inText1, inSize1, inText2, inSize2, status);
+		else
+			result = (CompareResult) fPrimaryCollator->compare( inText1, inSize1, inText2, inSize2, status);
+		xbox_assert( U_SUCCESS( status));
+	}
+	return result;
+}
+
+
+bool VICUCollator::GetSortKey( const UniChar* inText, sLONG inSize, bool inWithDiacritics, std::vector<uBYTE>& outKey)
+{
+	static const UniChar nullStr[] = {0};
+
+	// icu doesn't accept null pointer even if the associated size parameter is zero
+	if (inText == NULL)
+		inText = nullStr;
+
+	xbox_icu::Collator *collator = inWithDiacritics ? fTertiaryCollator : fPrimaryCollator;
+
+	try
+	{
+		if (outKey.size() < 64)
+			outKey.resize( 64);
+
+		int32_t length = collator->getSortKey( inText, inSize, &outKey[0], (int32_t) outKey.size());
+		if (length > (int32_t) outKey.size())
+		{
+			outKey.resize( length);
+			length = collator->getSortKey( inText, inSize, &outKey[0], (int32_t) outKey.size());
+		}
+		outKey.resize( (length > 0) ? length : 0);
+	}
+	catch(...)
+	{
+		outKey.clear();
+		return false;
+	}
+
+	return !outKey.empty();
+}
+
+
 VICUCollator* VICUCollator::Create( DialectCode inDialect, const xbox_icu::Locale *inLocale, CollatorOptions inOptions)
 {
 	VICUCollator* col = NULL;
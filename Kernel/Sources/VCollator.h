@@ -44,6 +44,13 @@ public:
 	virtual	bool					BeginsWithString( const UniChar* inText, sLONG inTextSize, const UniChar* inPattern, sLONG inPatternSize, bool inWithDiacritics, sLONG *outFoundLength);
 	virtual	bool					EndsWithString( const UniChar* inText, sLONG inTextSize, const UniChar* inPattern, sLONG inPatternSize, bool inWithDiacritics, sLONG *outFoundLength);
 
+	// Builds a binary key such that comparing two keys byte per byte (the shortest first on a tie) gives the same result as CompareString.
+	// Returns false if this collator can't build sort keys.
+	virtual	bool					GetSortKey( const UniChar* inText, sLONG inSize, bool inWithDiacritics, std::vector<uBYTE>& outKey);
+
+	// Compares two keys built by GetSortKey.
+	static	CompareResult			CompareSortKeys( const uBYTE *inKey1, sLONG inSize1, const uBYTE *inKey2, sLONG inSize2);
+
 	virtual	VCollator*				Clone() const = 0;
 
 			UniChar					GetWildChar() const					{ return fWildChar;}
@@ -80,6 +87,55 @@ protected:
 };
 
 
+/*
+	Bounded cache of the sort keys of short strings, shared by a collator and its clones.
+
+	Keys are stored in a fixed number of slots indexed by the string hash.
+	A string is admitted the second time it misses its slot so that strings seen once don't evict hot ones.
+	Slots are protected by striped critical sections so that the cache can be used by several tasks.
+*/
+class XTOOLBOX_API VCollatorSortKeyCache : public VObject, public IRefCountable
+{
+public:
+	enum { kMaxTextLength = 128, kSlotCount = 4096, kStripeCount = 16 };
+
+									VCollatorSortKeyCache();
+
+	// Compares two strings using their cached keys. Keys of hot strings are computed with inCollator->GetSortKey.
+	// Returns false if a key is missing, in which case the caller must collate the strings itself.
+			bool					CompareStrings( VCollator *inCollator, const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics, CompareResult& outResult);
+
+			void					Clear();
+
+			void					GetStatistics( uLONG *outHits, uLONG *outMisses) const;
+
+private:
+	virtual							~VCollatorSortKeyCache();
+
+	struct Slot
+	{
+									Slot() : fUsed( false), fWithDiacritics( false), fHash( 0), fCandidateHash( 0)	{;}
+			bool					fUsed;
+			bool					fWithDiacritics;
+			uLONG					fHash;
+			uLONG					fCandidateHash;		// hash of the last string that missed this slot
+			std::vector<UniChar>	fText;
+			std::vector<uBYTE>		fKey;
+	};
+
+	static	uLONG					_Hash( const UniChar* inText, sLONG inSize, bool inWithDiacritics);
+	static	bool					_Matches( const Slot& inSlot, uLONG inHash, const UniChar* inText, sLONG inSize, bool inWithDiacritics);
+			bool					_CompareSlots( uLONG inHash1, const UniChar* inText1, sLONG inSize1, uLONG inHash2, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics, CompareResult& outResult);
+			bool					_Admit( uLONG inHash, const UniChar* inText, sLONG inSize, bool inWithDiacritics);
+			void					_Store( uLONG inHash, const UniChar* inText, sLONG inSize, bool inWithDiacritics, std::vector<uBYTE>& ioKey);
+
+			std::vector<Slot>		fSlots;
+			VCriticalSection		fLocks[kStripeCount];
+	mutable	sLONG					fHits;
+	mutable	sLONG					fMisses;
+};
+
+
 #if !VERSION_LINUX
 
 /************************************************************/
@@ -149,6 +205,7 @@ public:
 	virtual	sLONG						ReversedFindString( const UniChar* inText, sLONG inTextSize, const UniChar* inPattern, sLONG inPatternSize, bool inWithDiacritics, sLONG *outFoundLength);
 	virtual	bool						BeginsWithString( const UniChar* inText, sLONG inTextSize, const UniChar* inPattern, sLONG inPatternSize, bool inWithDiacritics, sLONG *outFoundLength);
 	virtual	bool						EndsWithString( const UniChar* inText, sLONG inTextSize, const UniChar* inPattern, sLONG inPatternSize, bool inWithDiacritics, sLONG *outFoundLength);
+	virtual	bool						GetSortKey( const UniChar* inText, sLONG inSize, bool inWithDiacritics, std::vector<uBYTE>& outKey);
 	
 	static	VICUCollator*				Create( DialectCode inDialect, const xbox_icu::Locale *inLocale, CollatorOptions inOptions);
 	virtual VICUCollator*				Clone() const	{ return new VICUCollator(*this);}
@@ -159,6 +216,8 @@ public:
 
 			xbox_icu::Locale*			GetLocale() const	{ return fLocale;}
 
+			VCollatorSortKeyCache*		GetSortKeyCache() const	{ return fSortKeyCache;}
+
 	virtual	void						GetStringComparisonAlgorithmSignature( VString& outSignature) const;			
 private:
 										VICUCollator( const VICUCollator& inCollator);
@@ -169,6 +228,7 @@ private:
 			CompareResult				_CompareString_LikeNoDiac_secondary( const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2);
 			CompareResult				_CompareString_LikeDiac( const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2);
 			CompareResult				_BeginsWithString_NoDiac( const UniChar* inText, sLONG inTextSize, const UniChar* inPattern, sLONG inPatternSize);
+			CompareResult				_CollateString( const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics);
 	
 			UStringSearch*				_InitSearch( const UniChar* inText, sLONG inTextSize, const UniChar* inPattern, sLONG inPatternSize, bool inWithDiacritics, void *outStatus);
 			void						_UpdateWildCharPrimaryKey();
@@ -186,6 +246,8 @@ private:
 			sLONG						fWildCharKey;	// primary key for wild char using fTextElements
 
 			bool						fUseOptimizedSort;
+
+			VCollatorSortKeyCache*		fSortKeyCache;	// shared with clones
 };
 
 END_TOOLBOX_NAMESPACE
@@ -20,6 +20,7 @@
 #include "VKernelPrecompiled.h"
 #include "VError.h"
 #include "VTask.h"
+#include "VErrorContext.h"
 #include "VProcess.h"
 #include "VString.h"
 #include "VArrayValue.h"
@@ -541,6 +542,11 @@ void _ThrowError( VError inErrCode, const VString* p1, const VString* p2, const
 {
 	if (VProcess::Get() != NULL)
 	{
+		// a StErrorCapture only needs the code
+		VErrorTaskContext *context = VTask::GetErrorContext( false);
+		if ( (context != NULL) && context->CaptureError( inErrCode, 0) )
+			return;
+
 		StAllocateInMainMem mainAllocator;
 		VErrorBase* err = new VErrorBase( inErrCode, 0);
 		if (err != NULL)
@@ -564,6 +570,10 @@ VError _ThrowNativeError( VNativeError inNativeErrCode)
 
 	if (VProcess::Get() != NULL)
 	{
+		VErrorTaskContext *context = VTask::GetErrorContext( false);
+		if ( (context != NULL) && context->CaptureError( xbox_err, inNativeErrCode) )
+			return xbox_err;
+
 		StAllocateInMainMem mainAllocator;
 		
 		VErrorBase* err = new VErrorBase( xbox_err, inNativeErrCode);
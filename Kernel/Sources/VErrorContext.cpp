@@ -265,6 +265,7 @@ void VErrorContext::PushErrors( const VErrorContext& inFromContext)
 
 VErrorTaskContext::VErrorTaskContext()
 : fRecycledCleanContext( new VErrorContext)
+, fCapture( NULL)
 {
 }
 
@@ -272,13 +273,41 @@ VErrorTaskContext::VErrorTaskContext()
 VErrorTaskContext::~VErrorTaskContext()
 {
 	xbox_assert(fStack.size() <= 1); // zero or one context (the current context)
+	xbox_assert( fCapture == NULL);
 	ReleaseRefCountable( &fRecycledCleanContext);
 }
 
 
+StErrorCapture* VErrorTaskContext::_GetActiveCapture() const
+{
+	// a capture is active until a regular context is pushed over it
+	return ( (fCapture != NULL) && (fCapture->fStackDepth == fStack.size()) ) ? fCapture : NULL;
+}
+
+
+bool VErrorTaskContext::_CaptureError( VError inError, VNativeError inNativeError)
+{
+	StErrorCapture *capture = _GetActiveCapture();
+	if ( (capture == NULL) || (capture->fContext != NULL) )
+		return false;
+
+	capture->_Record( inError, inNativeError);
+	return true;
+}
+
+
 VErrorBase* VErrorTaskContext::GetLast() const
 {
 	VErrorBase *err = NULL;
+
+	StErrorCapture *capture = _GetActiveCapture();
+	if ( (capture != NULL) && (capture->GetErrorCount() > 0) )
+	{
+		VErrorContext *context = capture->_Materialize();
+		if (context != NULL)
+			err = context->GetLast();
+	}
+
 	for( VectorOfVErrorContext::const_reverse_iterator i = fStack.rbegin() ; (i != fStack.rend()) && (err == NULL) ; ++i)
 		err = (*i)->GetLast();
 	
@@ -299,7 +328,10 @@ VErrorBase* VErrorTaskContext::GetFirst() const
 void VErrorTaskContext::Flush()
 {
 	// only flush current context but reset last error
-	if (!fStack.empty())
+	StErrorCapture *capture = _GetActiveCapture();
+	if (capture != NULL)
+		capture->Flush();
+	else if (!fStack.empty())
 		fStack.back()->Flush();
 }
 
@@ -309,7 +341,22 @@ bool VErrorTaskContext::PushError( VErrorBase* inError, bool *outSilent)
 	bool isPushed = false;
 	bool silent = false;
 	
-	if (inError != NULL)
+	StErrorCapture *capture = (inError != NULL) ? _GetActiveCapture() : NULL;
+	if (capture != NULL)
+	{
+		// captured errors are always silent
+		silent = true;
+		if (capture->fContext != NULL)
+		{
+			isPushed = capture->fContext->PushError( inError);
+		}
+		else
+		{
+			capture->_Record( inError->GetError(), inError->GetNativeError());
+			isPushed = true;
+		}
+	}
+	else if (inError != NULL)
 	{
 		try
 		{
@@ -438,7 +485,13 @@ void VErrorTaskContext::PopContext()
 
 		if ( !context->IsEmpty() && context->IsKeepingErrors())
 		{
-			if (fStack.size() == 1)
+			if ( (fCapture != NULL) && (fCapture->fStackDepth == fStack.size() - 1) )
+			{
+				// hand errors over to the capture the context was installed in
+				fStack.pop_back();
+				PushErrorsFromContext( context);
+			}
+			else if (fStack.size() == 1)
 			{
 				VErrorContext *mergeContext = new VErrorContext( *context);
 				if (mergeContext != NULL)
@@ -520,7 +573,17 @@ void VErrorTaskContext::MergeAndFlushLastContext( bool inContextInitializedSilen
 	{
 		if (backContext->IsKeepingErrors())
 		{
-			if (fStack.size() > 1)
+			if ( (fCapture != NULL) && (fCapture->fStackDepth == fStack.size() - 1) )
+			{
+				for( VErrorStack::const_iterator i = backContext->GetErrorStack().begin() ; i != backContext->GetErrorStack().end() ; ++i)
+				{
+					if (fCapture->fContext != NULL)
+						fCapture->fContext->PushError( *i);
+					else
+						fCapture->_Record( (*i)->GetError(), (*i)->GetNativeError());
+				}
+			}
+			else if (fStack.size() > 1)
 				fStack[fStack.size()-2]->PushErrors( *backContext);
 			else
 			{
@@ -554,12 +617,19 @@ void VErrorTaskContext::GetErrors( VErrorContext& inContext) const
 	{
 		inContext.PushErrors( *(i->Get()));
 	}
+
+	StErrorCapture *capture = _GetActiveCapture();
+	if (capture != NULL)
+		capture->GetErrors( inContext);
 }
 
 
 bool VErrorTaskContext::FailedForMemory() const
 {
-	if (fStack.empty())
+	StErrorCapture *capture = _GetActiveCapture();
+	if (capture != NULL)
+		return capture->FailedForMemory();
+	else if (fStack.empty())
 		return false;
 	else
 		return fStack.back()->FailedForMemory();
@@ -573,13 +643,24 @@ VErrorBase *VErrorTaskContext::Find( VError inError) const
 	{
 		err = (*i)->Find( inError);
 	}
+
+	StErrorCapture *capture = _GetActiveCapture();
+	if ( (err == NULL) && (capture != NULL) && capture->Find( inError) )
+	{
+		VErrorContext *context = capture->_Materialize();
+		if (context != NULL)
+			err = context->Find( inError);
+	}
 	return err;
 }
 
 
 VError VErrorTaskContext::GetLastError() const
 {
-	if (fStack.empty())
+	StErrorCapture *capture = _GetActiveCapture();
+	if (capture != NULL)
+		return capture->GetLastError();
+	else if (fStack.empty())
 		return VE_OK;
 	else
 		return fStack.back()->GetLastError();
@@ -646,3 +727,135 @@ StErrorContextInstaller::~StErrorContextInstaller()
 	}
 }
 
+
+//====================================================================================================================================
+
+
+StErrorCapture::StErrorCapture()
+: fTaskContext( VTask::GetErrorContext( true))
+, fPrevious( NULL)
+, fStackDepth( 0)
+, fContext( NULL)
+, fCount( 0)
+, fFailedForMemory( false)
+{
+	if (fTaskContext != NULL)
+	{
+		fPrevious = fTaskContext->fCapture;
+		fStackDepth = fTaskContext->fStack.size();
+		fTaskContext->fCapture = this;
+	}
+}
+
+
+StErrorCapture::~StErrorCapture()
+{
+	if (fTaskContext != NULL)
+	{
+		xbox_assert( fTaskContext->fCapture == this);
+		fTaskContext->fCapture = fPrevious;
+	}
+	ReleaseRefCountable( &fContext);
+}
+
+
+void StErrorCapture::_Record( VError inError, VNativeError inNativeError)
+{
+	if (inError == VE_MEMORY_FULL)
+		fFailedForMemory = true;
+
+	// when full, the last slot keeps the last error
+	sLONG index = (fCount < kCapacity) ? fCount : kCapacity - 1;
+	fErrors[index] = inError;
+	fNativeErrors[index] = inNativeError;
+	++fCount;
+}
+
+
+VErrorContext* StErrorCapture::_Materialize()
+{
+	if (fContext == NULL)
+	{
+		StAllocateInMainMem mainAllocator;
+
+		fContext = new VErrorContext( false, true);
+		if (fContext != NULL)
+		{
+			for( sLONG i = 0 ; i < fCount && i < kCapacity ; ++i)
+			{
+				VErrorBase *error = new VErrorBase( fErrors[i], fNativeErrors[i]);
+				fContext->PushError( error);
+				ReleaseRefCountable( &error);
+			}
+			fContext->SetFailedForMemory( fFailedForMemory);
+		}
+	}
+	return fContext;
+}
+
+
+VError StErrorCapture::GetLastError() const
+{
+	if (fContext != NULL)
+		return fContext->GetLastError();
+
+	return (fCount > 0) ? fErrors[((fCount < kCapacity) ? fCount : kCapacity) - 1] : VE_OK;
+}
+
+
+VError StErrorCapture::GetFirstError() const
+{
+	if (fContext != NULL)
+	{
+		VErrorBase *error = fContext->GetFirst();
+		return (error != NULL) ? error->GetError() : VE_OK;
+	}
+
+	return (fCount > 0) ? fErrors[0] : VE_OK;
+}
+
+
+sLONG StErrorCapture::GetErrorCount() const
+{
+	return (fContext != NULL) ? (sLONG) fContext->GetErrorStack().size() : fCount;
+}
+
+
+bool StErrorCapture::Find( VError inError) const
+{
+	if (fContext != NULL)
+		return fContext->Find( inError) != NULL;
+
+	for( sLONG i = 0 ; i < fCount && i < kCapacity ; ++i)
+	{
+		if (fErrors[i] == inError)
+			return true;
+	}
+	return false;
+}
+
+
+bool StErrorCapture::FailedForMemory() const
+{
+	return (fContext != NULL) ? fContext->FailedForMemory() : fFailedForMemory;
+}
+
+
+void StErrorCapture::Flush()
+{
+	fCount = 0;
+	fFailedForMemory = false;
+	if (fContext != NULL)
+		fContext->Flush();
+}
+
+
+void StErrorCapture::GetErrors( VErrorContext& ioContext)
+{
+	if (GetErrorCount() > 0)
+	{
+		VErrorContext *context = _Materialize();
+		if (context != NULL)
+			ioContext.PushErrors( *context);
+	}
+}
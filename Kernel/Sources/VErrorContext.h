@@ -21,6 +21,7 @@
 BEGIN_TOOLBOX_NAMESPACE
 
 class VJSONArrayWriter;
+class StErrorCapture;
 
 /*!
 	@class VErrorContext
@@ -159,12 +160,23 @@ public:
 			void					RecycleContext( VErrorContext *inContext);
 
 	static	void					BuildErrorStack(VValueBag& outBag);
+
+			/** @brief records the error code without any allocation if a StErrorCapture is the innermost context.
+				Returns false if the error must be pushed as a VErrorBase object.
+			**/
+			bool					CaptureError( VError inError, VNativeError inNativeError)	{ return (fCapture != NULL) && _CaptureError( inError, inNativeError);}
 	
 private:
+	friend class StErrorCapture;
+
 			VErrorTaskContext( const VErrorTaskContext& /*inContext*/) {};
 
+			StErrorCapture*			_GetActiveCapture() const;
+			bool					_CaptureError( VError inError, VNativeError inNativeError);
+
 			VErrorContext*			fRecycledCleanContext;
 			VectorOfVErrorContext	fStack;
+			StErrorCapture*			fCapture;		// innermost StErrorCapture of the task
 };
 
 
@@ -209,6 +221,64 @@ private:
 
 
 
+/*!
+	@class StErrorCapture
+	@abstract Lightweight replacement for StErrorContextInstaller( false) on hot paths
+	@discussion
+		Like StErrorContextInstaller( false), thrown errors are silent and dropped by the destructor.
+		But while it is the innermost context of the task, vThrowError and vThrowNativeError only record
+		the error codes in a fixed buffer of the StErrorCapture itself: no VErrorBase, no VErrorContext is allocated.
+		Errors pushed as objects (StThrowError, VTask::PushError) are recorded by code too.
+
+		VErrorBase objects are only built when someone asks for them (GetErrors, VTask::GetLastError stays cheap
+		but VErrorTaskContext::GetLast or Find materialize them). Such rebuilt errors have no parameters.
+		Once materialized, following errors are pushed as regular objects.
+
+		If more than kCapacity errors are thrown, the first kCapacity-1 and the last one are kept.
+		An StErrorContextInstaller installed inside a StErrorCapture works as usual and hands its kept errors over to the capture.
+*/
+class XTOOLBOX_API StErrorCapture
+{
+public:
+	enum { kCapacity = 8 };
+
+									StErrorCapture();
+									~StErrorCapture();
+
+			VError					GetLastError() const;
+			VError					GetFirstError() const;
+			sLONG					GetErrorCount() const;		// may be greater than kCapacity
+
+			bool					Find( VError inError) const;
+			bool					FailedForMemory() const;
+
+			void					Flush();
+
+			// builds the VErrorBase objects
+			void					GetErrors( VErrorContext& ioContext);
+
+									operator VError() const							{ return GetLastError(); }
+
+private:
+	friend class VErrorTaskContext;
+
+									StErrorCapture( const StErrorCapture&);		// no copy
+			StErrorCapture&			operator=( const StErrorCapture&);
+
+			void					_Record( VError inError, VNativeError inNativeError);
+			VErrorContext*			_Materialize();
+
+			VErrorTaskContext*		fTaskContext;
+			StErrorCapture*			fPrevious;
+			size_t					fStackDepth;		// contexts count of the task when installed
+			VErrorContext*			fContext;			// once materialized
+			sLONG					fCount;
+			bool					fFailedForMemory;
+			VError					fErrors[kCapacity];
+			VNativeError			fNativeErrors[kCapacity];
+};
+
+
 END_TOOLBOX_NAMESPACE
 
 #endif
\ No newline at end of file
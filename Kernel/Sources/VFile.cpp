@@ -24,6 +24,13 @@
 #include "VTime.h"
 #include "VTextConverter.h"
 
+#if !VERSIONWIN
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 
 BEGIN_TOOLBOX_NAMESPACE
 
@@ -277,6 +284,68 @@ VError VFileDesc::Flush() const
 }
 
 
+#pragma mark  -
+#pragma mark VFileMapping
+// --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- ---
+
+VFileMapping::VFileMapping( void *inAddress, VSize inMappedSize, VSize inDataOffset, VSize inSize, sLONG8 inOffset)
+: fAddress( inAddress)
+, fMappedSize( inMappedSize)
+, fData( (inAddress != NULL) ? (const uBYTE*) inAddress + inDataOffset : NULL)
+, fSize( inSize)
+, fOffset( inOffset)
+{
+}
+
+
+VFileMapping::~VFileMapping()
+{
+	if (fAddress != NULL)
+	{
+	#if VERSIONWIN
+		::UnmapViewOfFile( fAddress);
+	#else
+		::munmap( fAddress, fMappedSize);
+	#endif
+	}
+}
+
+
+VError VFileMapping::Advise( FileMapOptions inOptions, VSize inOffset, VSize inSize) const
+{
+	if (!testAssert( inOffset <= fSize))
+		return vThrowError( VE_INVALID_PARAMETER);
+
+	if ( (inSize == 0) || (inSize > fSize - inOffset) )
+		inSize = fSize - inOffset;
+
+	if ( (fData == NULL) || (inSize == 0) )
+		return VE_OK;
+
+#if VERSIONWIN
+	// no madvise equivalent before Windows 8, FILE_FLAG_SEQUENTIAL_SCAN like read ahead is done by the cache manager anyway
+	return VE_OK;
+#else
+	// madvise needs a page aligned address
+	uLONG_PTR pageSize = (uLONG_PTR) ::sysconf( _SC_PAGESIZE);
+	uLONG_PTR start = (uLONG_PTR) (fData + inOffset);
+	uLONG_PTR alignedStart = start & ~(pageSize - 1);
+	void *address = (void*) alignedStart;
+	size_t length = (size_t) (start - alignedStart) + inSize;
+
+	int res = 0;
+	if (inOptions & FM_SequentialScan)
+		res = ::madvise( address, length, MADV_SEQUENTIAL);
+	else if (inOptions & FM_RandomAccess)
+		res = ::madvise( address, length, MADV_RANDOM);
+	if ( (res == 0) && (inOptions & FM_WillNeed) )
+		res = ::madvise( address, length, MADV_WILLNEED);
+
+	return (res == 0) ? VE_OK : vThrowPosixError( errno);
+#endif
+}
+
+
 #pragma mark  -
 #pragma mark VFile
 // --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- ---
@@ -1350,7 +1419,7 @@ VError VFile::GetContent( VMemoryBuffer<>& outContent) const
 	if (err == VE_OK)
 	{
 		sLONG8 size = desc->GetSize();
-		if ( (size > kMAX_VSize) || !outContent.SetSize( (VSize) size) )
+		if ( ((uLONG8) size > (uLONG8) kMAX_VSize) || !outContent.SetSize( (VSize) size) )
 		{
 			StThrowFileError errThrow( this, err, VNE_OK);
 			err = errThrow.GetError();
@@ -1365,6 +1434,142 @@ VError VFile::GetContent( VMemoryBuffer<>& outContent) const
 }
 
 
+VError VFile::Map( VFileMapping **outMapping, sLONG8 inOffset, sLONG8 inSize, FileMapOptions inOptions) const
+{
+	if (!testAssert( outMapping != NULL))
+		return vThrowError( VE_INVALID_PARAMETER);
+
+	*outMapping = NULL;
+
+	VError err = VE_OK;
+	sLONG8 fileSize = 0;
+
+#if VERSIONMAC
+	// the carbon fork can't be mapped, use the posix path instead
+	VString path;
+	GetPath( path, FPS_POSIX);
+	VStringConvertBuffer posixPath( path, VTC_UTF_8);
+	int fd = ::open( posixPath.GetCPointer(), O_RDONLY);
+	struct stat fileInfo;
+	if ( (fd < 0) || (::fstat( fd, &fileInfo) != 0) )
+	{
+		vThrowPosixError( errno);
+		StThrowFileError errThrow( this, VE_FILE_CANNOT_OPEN);
+		err = errThrow.GetError();
+	}
+	else
+	{
+		fileSize = fileInfo.st_size;
+	}
+#else
+	VFileDesc *desc = NULL;
+	err = Open( FA_READ, &desc, (inOptions & FM_RandomAccess) ? FO_RandomAccess : FO_SequentialScan);
+	if (err == VE_OK)
+		fileSize = desc->GetSize();
+#endif
+
+	if ( (err == VE_OK) && ( (inOffset < 0) || (inOffset > fileSize) ) )
+	{
+		StThrowFileError errThrow( this, VE_INVALID_PARAMETER);
+		errThrow->SetLong8( "offset", inOffset);
+		errThrow->SetLong8( "size", fileSize);
+		err = errThrow.GetError();
+	}
+
+	if (err == VE_OK)
+	{
+		sLONG8 size = ( (inSize < 0) || (inSize > fileSize - inOffset) ) ? fileSize - inOffset : inSize;
+		if ((uLONG8) size > (uLONG8) kMAX_VSize)
+		{
+			err = vThrowError( VE_MEMORY_FULL);
+		}
+		else if (size == 0)
+		{
+			*outMapping = new VFileMapping( NULL, 0, 0, 0, inOffset);
+		}
+		else
+		{
+			// the system mapping must start on the allocation granularity
+		#if VERSIONWIN
+			SYSTEM_INFO systemInfo;
+			::GetSystemInfo( &systemInfo);
+			sLONG8 granularity = systemInfo.dwAllocationGranularity;
+		#else
+			sLONG8 granularity = ::sysconf( _SC_PAGESIZE);
+		#endif
+			sLONG8 mapOffset = inOffset - (inOffset % granularity);
+			VSize dataOffset = (VSize) (inOffset - mapOffset);
+			VSize mapSize = (VSize) size + dataOffset;
+			void *address = NULL;
+
+		#if VERSIONWIN
+			DWORD winErr = 0;
+			HANDLE mapping = ::CreateFileMappingW( desc->GetSystemRef(), NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping != NULL)
+			{
+				address = ::MapViewOfFile( mapping, FILE_MAP_READ, (DWORD) (mapOffset >> 32), (DWORD) (mapOffset & 0xFFFFFFFF), mapSize);
+				if (address == NULL)
+					winErr = ::GetLastError();
+
+				// the view keeps the mapping object alive
+				::CloseHandle( mapping);
+			}
+			else
+			{
+				winErr = ::GetLastError();
+			}
+
+			if (address == NULL)
+			{
+				StThrowFileError errThrow( this, VE_FILE_CANNOT_OPEN, MAKE_NATIVE_VERROR( winErr));
+				errThrow->SetLong8( "offset", inOffset);
+				err = errThrow.GetError();
+			}
+		#else
+			#if VERSIONMAC
+			int mapFd = fd;
+			#else
+			int mapFd = desc->GetSystemRef();
+			#endif
+			address = ::mmap( NULL, mapSize, PROT_READ, MAP_SHARED, mapFd, (off_t) mapOffset);
+			if (address == MAP_FAILED)
+			{
+				address = NULL;
+				#if VERSIONMAC
+				vThrowPosixError( errno);
+				StThrowFileError errThrow( this, VE_FILE_CANNOT_OPEN);
+				#else
+				StThrowFileError errThrow( this, VE_FILE_CANNOT_OPEN, MAKE_NATIVE_VERROR( errno));
+				#endif
+				errThrow->SetLong8( "offset", inOffset);
+				err = errThrow.GetError();
+			}
+		#endif
+
+			if (address != NULL)
+				*outMapping = new VFileMapping( address, mapSize, dataOffset, (VSize) size, inOffset);
+		}
+	}
+
+	// the mapping does not need the file to stay opened
+#if VERSIONMAC
+	if (fd >= 0)
+		::close( fd);
+#else
+	delete desc;
+#endif
+
+	if ( (*outMapping != NULL) && (inOptions != FM_Default) )
+	{
+		// only a hint: its failure must not be seen by the caller's error context
+		StErrorContextInstaller errorContext( false);
+		(*outMapping)->Advise( inOptions);
+	}
+
+	return err;
+}
+
+
 VError VFile::SetContent( const void *inDataPtr, size_t inDataSize) const
 {
 	VFileDesc *desc = NULL;
@@ -103,6 +103,41 @@ private:
 			XFileDescImpl		fImpl;
 };
 
+/*
+	Read-only view of a file range mapped in memory, obtained with VFile::Map().
+	The view does not depend on any VFileDesc and stays valid until it is released.
+	The file must not be truncated while it is mapped: reading pages past its end crashes on most systems.
+*/
+class XTOOLBOX_API VFileMapping : public VObject, public IRefCountable
+{
+public:
+			const void*			GetDataPtr() const									{ return fData; }	// NULL if empty
+			VSize				GetDataSize() const									{ return fSize; }
+
+			// offset in the file of the first byte
+			sLONG8				GetOffset() const									{ return fOffset; }
+
+			// Tells the system how a part of the mapping will be read (FM_SequentialScan, FM_RandomAccess and/or FM_WillNeed).
+			// inSize == 0 means up to the end of the mapping.
+			VError				Advise( FileMapOptions inOptions, VSize inOffset = 0, VSize inSize = 0) const;
+
+private:
+	friend class VFile;
+
+								VFileMapping( void *inAddress, VSize inMappedSize, VSize inDataOffset, VSize inSize, sLONG8 inOffset);
+	virtual						~VFileMapping();
+
+								VFileMapping( const VFileMapping& inOther);	// no copy
+			VFileMapping&		operator=( const VFileMapping& inOther);	// no copy
+
+			void*				fAddress;		// system mapping, starts on the allocation granularity
+			VSize				fMappedSize;
+			const uBYTE*		fData;
+			VSize				fSize;
+			sLONG8				fOffset;
+};
+
+
 class VFileSystemNamespace;
 
 class XTOOLBOX_API VFile : public VObject, public IRefCountable
@@ -270,6 +305,11 @@ public:
 			// May throw error and returns false if failed.
 			VError				GetContent( VMemoryBuffer<>& outContent) const;
 
+			// Maps inSize bytes of the file at inOffset read-only in memory (inSize < 0 means up to the end of file).
+			// The data is not copied into the heap, pages are read by the system on first access.
+			// inOptions are passed to VFileMapping::Advise(). The returned mapping must be released.
+			VError				Map( VFileMapping **outMapping, sLONG8 inOffset = 0, sLONG8 inSize = -1, FileMapOptions inOptions = FM_Default) const;
+
 			// Open file in FA_READ_WRITE mode and set its contents to provided data only.
 			// On success, the file is exactly of size inDataSize.
 			VError				SetContent( const void *inDataPtr, size_t inDataSize) const;
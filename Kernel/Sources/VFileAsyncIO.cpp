@@ -0,0 +1,697 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VKernelPrecompiled.h"
+#include "VFileAsyncIO.h"
+#include "VInterlocked.h"
+#include "VErrorContext.h"
+#include "VSystem.h"
+#include "VString.h"
+
+#if VERSION_LINUX
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#include <linux/io_uring.h>
+#define FILEASYNC_WITH_IOURING	1
+#endif
+#endif
+#endif
+
+#ifndef FILEASYNC_WITH_IOURING
+#define FILEASYNC_WITH_IOURING	0
+#endif
+
+
+BEGIN_TOOLBOX_NAMESPACE
+
+
+// An idle worker checks the queue at least that often, in case a wake up was missed.
+const sLONG	kIdleSleepMilliseconds = 50;
+
+
+#if FILEASYNC_WITH_IOURING
+
+/*
+	A request in the ring.
+	The iovec must live until the kernel completes the operation.
+*/
+class VFileAsyncRingOp
+{
+public:
+								VFileAsyncRingOp( VFileAsyncRequest *inRequest) : fRequest( inRequest)
+								{
+									fIOVec.iov_base = inRequest->GetBuffer();
+									fIOVec.iov_len = inRequest->GetRequestedCount();
+								}
+
+			VFileAsyncRequest*	fRequest;
+			struct iovec		fIOVec;
+};
+
+
+/*
+	io_uring instance used through raw syscalls, so that liburing is not needed.
+	Any task may submit (under fLock), only the reaper task consumes completions.
+	At most fDepth requests are in flight so that the completion queue (twice as big) never overflows.
+*/
+class VFileAsyncRing : public VObject
+{
+public:
+	// Returns NULL if io_uring is not supported by the kernel or forbidden.
+	static	VFileAsyncRing*		Create( VFileAsyncIO *inEngine, sLONG inDepth);
+
+	virtual						~VFileAsyncRing();
+
+	// Returns false if the ring is full or stopping, the caller must then use another way.
+			bool				Submit( VFileAsyncRequest *inRequest);
+
+	// Waits for in flight requests and kills the reaper task.
+			void				Stop();
+
+private:
+								VFileAsyncRing( VFileAsyncIO *inEngine);
+
+			bool				_Setup( sLONG inDepth);
+			void				_PushWL( uBYTE inOpCode, int inFd, sLONG8 inOffset, VFileAsyncRingOp *inOp);
+			void				_Completed( VFileAsyncRingOp *inOp, sLONG inResult);
+	static	sLONG				_ReaperTaskProc( VTask *inTask);
+
+			VFileAsyncIO*		fEngine;
+			int					fRingFd;
+			sLONG				fDepth;
+			sLONG				fInFlight;		// under fLock
+			bool				fStopping;		// under fLock
+			VCriticalSection	fLock;
+			VTask*				fReaper;
+
+			void*				fSQRing;
+			size_t				fSQRingSize;
+			void*				fCQRing;
+			size_t				fCQRingSize;
+			io_uring_sqe*		fSQEs;
+			size_t				fSQEsSize;
+
+			unsigned*			fSQHead;
+			unsigned*			fSQTail;
+			unsigned*			fSQMask;
+			unsigned*			fSQArray;
+			unsigned*			fCQHead;
+			unsigned*			fCQTail;
+			unsigned*			fCQMask;
+			io_uring_cqe*		fCQEs;
+};
+
+
+static int _io_uring_enter( int inFd, unsigned inToSubmit, unsigned inMinComplete, unsigned inFlags)
+{
+	return (int) ::syscall( __NR_io_uring_enter, inFd, inToSubmit, inMinComplete, inFlags, NULL, 0);
+}
+
+
+VFileAsyncRing::VFileAsyncRing( VFileAsyncIO *inEngine)
+: fEngine( inEngine)
+, fRingFd( -1)
+, fDepth( 0)
+, fInFlight( 0)
+, fStopping( false)
+, fReaper( NULL)
+, fSQRing( MAP_FAILED)
+, fSQRingSize( 0)
+, fCQRing( MAP_FAILED)
+, fCQRingSize( 0)
+, fSQEs( (io_uring_sqe*) MAP_FAILED)
+, fSQEsSize( 0)
+{
+}
+
+
+VFileAsyncRing::~VFileAsyncRing()
+{
+	xbox_assert( fInFlight == 0);
+	ReleaseRefCountable( &fReaper);
+
+	if (fSQEs != MAP_FAILED)
+		::munmap( fSQEs, fSQEsSize);
+	if (fCQRing != MAP_FAILED)
+		::munmap( fCQRing, fCQRingSize);
+	if (fSQRing != MAP_FAILED)
+		::munmap( fSQRing, fSQRingSize);
+	if (fRingFd >= 0)
+		::close( fRingFd);
+}
+
+
+//static
+VFileAsyncRing* VFileAsyncRing::Create( VFileAsyncIO *inEngine, sLONG inDepth)
+{
+	VFileAsyncRing *ring = new VFileAsyncRing( inEngine);
+	if ( (ring != NULL) && !ring->_Setup( inDepth) )
+	{
+		delete ring;
+		ring = NULL;
+	}
+	return ring;
+}
+
+
+bool VFileAsyncRing::_Setup( sLONG inDepth)
+{
+	io_uring_params params;
+	::memset( &params, 0, sizeof( params));
+
+	// ENOSYS on old kernels, EPERM when disabled by sysctl or seccomp
+	fRingFd = (int) ::syscall( __NR_io_uring_setup, (unsigned) inDepth, &params);
+	if (fRingFd < 0)
+		return false;
+
+	fSQRingSize = params.sq_off.array + params.sq_entries * sizeof( unsigned);
+	fSQRing = ::mmap( NULL, fSQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fRingFd, IORING_OFF_SQ_RING);
+	if (fSQRing == MAP_FAILED)
+		return false;
+
+	fCQRingSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe);
+	fCQRing = ::mmap( NULL, fCQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fRingFd, IORING_OFF_CQ_RING);
+	if (fCQRing == MAP_FAILED)
+		return false;
+
+	fSQEsSize = params.sq_entries * sizeof( io_uring_sqe);
+	fSQEs = (io_uring_sqe*) ::mmap( NULL, fSQEsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fRingFd, IORING_OFF_SQES);
+	if (fSQEs == MAP_FAILED)
+		return false;
+
+	char *sq = (char*) fSQRing;
+	fSQHead = (unsigned*) (sq + params.sq_off.head);
+	fSQTail = (unsigned*) (sq + params.sq_off.tail);
+	fSQMask = (unsigned*) (sq + params.sq_off.ring_mask);
+	fSQArray = (unsigned*) (sq + params.sq_off.array);
+
+	char *cq = (char*) fCQRing;
+	fCQHead = (unsigned*) (cq + params.cq_off.head);
+	fCQTail = (unsigned*) (cq + params.cq_off.tail);
+	fCQMask = (unsigned*) (cq + params.cq_off.ring_mask);
+	fCQEs = (io_uring_cqe*) (cq + params.cq_off.cqes);
+
+	// the kernel rounds the depth up to a power of 2
+	fDepth = (sLONG) params.sq_entries;
+
+	fReaper = new VTask( this, 0, eTaskStylePreemptive, &VFileAsyncRing::_ReaperTaskProc);
+	if (fReaper == NULL)
+		return false;
+
+	fReaper->SetName( CVSTR( "File async I/O reaper"));
+	fReaper->SetKind( VFileAsyncIO::kFileAsyncIOTaskKind);
+	fReaper->SetKindData( (sLONG_PTR) this);
+	fReaper->Run();
+
+	return true;
+}
+
+
+void VFileAsyncRing::_PushWL( uBYTE inOpCode, int inFd, sLONG8 inOffset, VFileAsyncRingOp *inOp)
+{
+	// only submitters write the tail and there is always room since in flight requests are bounded by the depth
+	unsigned tail = *fSQTail;
+	xbox_assert( tail - __atomic_load_n( fSQHead, __ATOMIC_ACQUIRE) < (unsigned) fDepth);
+
+	unsigned index = tail & *fSQMask;
+	io_uring_sqe *sqe = &fSQEs[index];
+	::memset( sqe, 0, sizeof( *sqe));
+	sqe->opcode = inOpCode;
+	sqe->fd = inFd;
+	sqe->off = (uLONG8) inOffset;
+	if ( (inOpCode == IORING_OP_READV) || (inOpCode == IORING_OP_WRITEV) )
+	{
+		sqe->addr = (uLONG8) (uLONG_PTR) &inOp->fIOVec;
+		sqe->len = 1;
+	}
+	sqe->user_data = (uLONG8) (uLONG_PTR) inOp;	// 0 for the stop request
+	fSQArray[index] = index;
+
+	// publishes the entry before the kernel reads the tail
+	__atomic_store_n( fSQTail, tail + 1, __ATOMIC_RELEASE);
+
+	int result;
+	do
+	{
+		result = _io_uring_enter( fRingFd, 1, 0, 0);
+		if ( (result < 0) && (errno != EINTR) )
+		{
+			// EAGAIN or EBUSY: the kernel is short of resources, the entry stays in the ring
+			xbox_assert( (errno == EAGAIN) || (errno == EBUSY) );
+			VTask::YieldNow();
+		}
+	} while( result < 0);
+}
+
+
+bool VFileAsyncRing::Submit( VFileAsyncRequest *inRequest)
+{
+	int fd = inRequest->fDesc->GetSystemRef();
+	if (fd < 0)
+		return false;
+
+	uBYTE opCode;
+	switch( inRequest->fKind)
+	{
+		case eFileAsyncRead:	opCode = IORING_OP_READV; break;
+		case eFileAsyncWrite:	opCode = IORING_OP_WRITEV; break;
+		case eFileAsyncFlush:	opCode = IORING_OP_FSYNC; break;
+		default:				return false;
+	}
+
+	StLocker<VCriticalSection> lock( &fLock);
+
+	if (fStopping || (fInFlight >= fDepth) )
+		return false;
+
+	VFileAsyncRingOp *op = new VFileAsyncRingOp( inRequest);
+	if (op == NULL)
+		return false;
+
+	++fInFlight;
+	_PushWL( opCode, fd, inRequest->fOffset, op);
+
+	return true;
+}
+
+
+void VFileAsyncRing::_Completed( VFileAsyncRingOp *inOp, sLONG inResult)
+{
+	VFileAsyncRequest *request = inOp->fRequest;
+	VError err = VE_OK;
+
+	if (inResult < 0)
+	{
+		VError defaultErr;
+		if (request->fKind == eFileAsyncRead)
+			defaultErr = VE_STREAM_CANNOT_GET_DATA;
+		else if (request->fKind == eFileAsyncWrite)
+			defaultErr = VE_STREAM_CANNOT_PUT_DATA;
+		else
+			defaultErr = VE_STREAM_CANNOT_FLUSH;
+		err = VErrorBase::EncodedNativeErrorToVError( MAKE_NATIVE_VERROR( -inResult), defaultErr);
+	}
+	else if (request->fKind != eFileAsyncFlush)
+	{
+		request->fDoneCount += (VSize) inResult;
+		if ( (inResult > 0) && (request->fDoneCount < request->fCount) )
+		{
+			// short transfer: submit the remaining part again, it keeps its in flight slot
+			inOp->fIOVec.iov_base = (char*) request->fBuffer + request->fDoneCount;
+			inOp->fIOVec.iov_len = request->fCount - request->fDoneCount;
+
+			StLocker<VCriticalSection> lock( &fLock);
+			_PushWL( (request->fKind == eFileAsyncRead) ? IORING_OP_READV : IORING_OP_WRITEV, request->fDesc->GetSystemRef(), request->fOffset + request->fDoneCount, inOp);
+			return;
+		}
+
+		if (request->fDoneCount < request->fCount)
+		{
+			if (request->fKind == eFileAsyncRead)
+				err = VE_STREAM_EOF;
+			else
+				err = VE_STREAM_CANNOT_PUT_DATA;
+		}
+	}
+
+	delete inOp;
+
+	{
+		StLocker<VCriticalSection> lock( &fLock);
+		--fInFlight;
+	}
+
+	fEngine->_Completed( request, err);
+}
+
+
+//static
+sLONG VFileAsyncRing::_ReaperTaskProc( VTask *inTask)
+{
+	VFileAsyncRing *ring = (VFileAsyncRing*) inTask->GetKindData();
+
+	for(;;)
+	{
+		int result = _io_uring_enter( ring->fRingFd, 0, 1, IORING_ENTER_GETEVENTS);
+		xbox_assert( (result >= 0) || (errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY) );
+
+		unsigned head = *ring->fCQHead;
+		unsigned tail = __atomic_load_n( ring->fCQTail, __ATOMIC_ACQUIRE);
+		while( head != tail)
+		{
+			io_uring_cqe *cqe = &ring->fCQEs[head & *ring->fCQMask];
+			uLONG8 userData = cqe->user_data;
+			sLONG res = cqe->res;
+
+			// frees the entry before completing, completion may submit again
+			__atomic_store_n( ring->fCQHead, ++head, __ATOMIC_RELEASE);
+
+			if (userData != 0)
+				ring->_Completed( (VFileAsyncRingOp*) (uLONG_PTR) userData, res);
+		}
+
+		StLocker<VCriticalSection> lock( &ring->fLock);
+		if (ring->fStopping && (ring->fInFlight == 0) )
+			break;
+	}
+
+	return 0;
+}
+
+
+void VFileAsyncRing::Stop()
+{
+	{
+		StLocker<VCriticalSection> lock( &fLock);
+		if (fStopping)
+			return;
+		fStopping = true;
+
+		// a nop wakes the reaper up in case nothing is in flight
+		_PushWL( IORING_OP_NOP, -1, 0, NULL);
+	}
+
+	fReaper->Kill();
+
+	// in flight requests point to buffers of the callers: the reaper must see them all
+	while( !fReaper->WaitForDeath( 5000))
+		;
+}
+
+#else
+
+class VFileAsyncRing : public VObject
+{
+public:
+			bool				Submit( VFileAsyncRequest* /*inRequest*/)		{ return false;}
+			void				Stop()											{;}
+};
+
+#endif
+
+
+//================================================================================================================
+
+
+VFileAsyncRequest::VFileAsyncRequest( EFileAsyncKind inKind, const VFileDesc *inDesc, void *inBuffer, VSize inCount, sLONG8 inOffset)
+: fKind( inKind)
+, fDesc( inDesc)
+, fBuffer( inBuffer)
+, fCount( inCount)
+, fOffset( inOffset)
+, fDoneCount( 0)
+, fError( VE_OK)
+, fCompleted( 0)
+, fEngine( NULL)
+, fCompletionTask( NULL)
+, fSubmitTime( 0)
+{
+}
+
+
+VFileAsyncRequest::~VFileAsyncRequest()
+{
+	ReleaseRefCountable( &fCompletionTask);
+}
+
+
+bool VFileAsyncRequest::Wait( sLONG inTimeoutMilliseconds)
+{
+	if (!IsCompleted())
+	{
+		if (inTimeoutMilliseconds < 0)
+			fCompletedEvent.Lock();
+		else
+			fCompletedEvent.Lock( inTimeoutMilliseconds);
+	}
+	return IsCompleted();
+}
+
+
+void VFileAsyncRequest::DoExecute()
+{
+	DoComplete();
+}
+
+
+//================================================================================================================
+
+
+VFileAsyncIO* VFileAsyncIO::sInstance = NULL;
+
+
+VFileAsyncIO::VFileAsyncIO( sLONG inThreadCount, sLONG inQueueDepth, bool inAllowIOUring)
+: fThreadCount( (inThreadCount > 0) ? inThreadCount : 0)
+, fStarted( 0)
+, fRing( NULL)
+, fWakeUp( 0, (inThreadCount > 0) ? inThreadCount : 1)
+{
+	::memset( &fStatistics, 0, sizeof( fStatistics));
+
+	#if FILEASYNC_WITH_IOURING
+	if (inAllowIOUring && (inQueueDepth > 0) )
+		fRing = VFileAsyncRing::Create( this, inQueueDepth);
+	#endif
+}
+
+
+VFileAsyncIO::~VFileAsyncIO()
+{
+	Stop();
+	delete fRing;
+}
+
+
+//static
+VFileAsyncIO* VFileAsyncIO::Get()
+{
+	if (sInstance == NULL)
+	{
+		VFileAsyncIO *engine = new VFileAsyncIO;
+		if (VInterlocked::CompareExchangePtr( (void**) &sInstance, NULL, engine) != NULL)
+			engine->Release();	// another task was faster
+	}
+	return sInstance;
+}
+
+
+//static
+void VFileAsyncIO::DeInit()
+{
+	VFileAsyncIO *engine = VInterlocked::ExchangePtr( &sInstance);
+	ReleaseRefCountable( &engine);
+}
+
+
+// fLock must be held
+bool VFileAsyncIO::_StartWorkers()
+{
+	if (fStarted == 0)
+	{
+		for( sLONG i = 0 ; i < fThreadCount ; ++i)
+		{
+			VTask *task = new VTask( this, 0, eTaskStylePreemptive, &VFileAsyncIO::_WorkerTaskProc);
+			if (task == NULL)
+				break;
+
+			VString name( "File async I/O worker ");
+			name.AppendLong( i + 1);
+			task->SetName( name);
+			task->SetKind( kFileAsyncIOTaskKind);
+			task->SetKindData( (sLONG_PTR) this);
+			fWorkers.push_back( task);
+		}
+
+		for( std::vector<VTask*>::iterator i = fWorkers.begin() ; i != fWorkers.end() ; ++i)
+			(*i)->Run();
+
+		fStarted = 1;
+	}
+
+	return (fStarted == 1) && !fWorkers.empty();
+}
+
+
+VError VFileAsyncIO::Submit( VFileAsyncRequest *inRequest, VTask *inCompletionTask)
+{
+	if ( (inRequest == NULL) || (inRequest->fDesc == NULL) )
+		return vThrowError( VE_INVALID_PARAMETER);
+
+	// a request is submitted only once
+	xbox_assert( inRequest->fEngine == NULL);
+
+	inRequest->Retain();
+	inRequest->fEngine = this;
+	inRequest->fCompletionTask = RetainRefCountable( inCompletionTask);
+	VSystem::GetProfilingCounter( inRequest->fSubmitTime);
+
+	{
+		StLocker<VCriticalSection> lock( &fStatisticsLock);
+		++fStatistics.fSubmittedCount;
+		if (++fStatistics.fPendingCount > fStatistics.fMaxPendingCount)
+			fStatistics.fMaxPendingCount = fStatistics.fPendingCount;
+	}
+
+	if ( (fRing != NULL) && fRing->Submit( inRequest) )
+	{
+		StLocker<VCriticalSection> lock( &fStatisticsLock);
+		++fStatistics.fRingCount;
+		return VE_OK;
+	}
+
+	bool queued = false;
+	{
+		StLocker<VCriticalSection> lock( &fLock);
+		if (_StartWorkers())
+		{
+			fQueue.push_back( inRequest);
+			queued = true;
+		}
+	}
+
+	if (queued)
+		fWakeUp.Unlock();
+	else
+		_ExecuteSynchronously( inRequest);
+
+	return VE_OK;
+}
+
+
+void VFileAsyncIO::_ExecuteSynchronously( VFileAsyncRequest *inRequest)
+{
+	VError err;
+	{
+		// errors are reported through the request
+		StErrorCapture errorCapture;
+
+		switch( inRequest->fKind)
+		{
+			case eFileAsyncRead:	err = inRequest->fDesc->GetData( inRequest->fBuffer, inRequest->fCount, inRequest->fOffset, &inRequest->fDoneCount); break;
+			case eFileAsyncWrite:	err = inRequest->fDesc->PutData( inRequest->fBuffer, inRequest->fCount, inRequest->fOffset, &inRequest->fDoneCount); break;
+			case eFileAsyncFlush:	err = inRequest->fDesc->Flush(); break;
+			default:				err = VE_INVALID_PARAMETER; break;
+		}
+	}
+
+	_Completed( inRequest, err);
+}
+
+
+void VFileAsyncIO::_Completed( VFileAsyncRequest *inRequest, VError inError)
+{
+	inRequest->fError = inError;
+
+	sLONG8 now;
+	VSystem::GetProfilingCounter( now);
+	uLONG8 latency = (uLONG8) (((Real) (now - inRequest->fSubmitTime) * 1000000.0) / (Real) VSystem::GetProfilingFrequency());
+
+	{
+		StLocker<VCriticalSection> lock( &fStatisticsLock);
+		++fStatistics.fCompletedCount;
+		--fStatistics.fPendingCount;
+		fStatistics.fTotalLatency += latency;
+		if (latency > fStatistics.fMaxLatency)
+			fStatistics.fMaxLatency = latency;
+	}
+
+	VTask *task = inRequest->fCompletionTask;
+	inRequest->fCompletionTask = NULL;
+
+	VInterlocked::Exchange( &inRequest->fCompleted, 1);
+	inRequest->fCompletedEvent.Unlock();
+
+	if (task != NULL)
+	{
+		// the message queue retains the request
+		inRequest->PostTo( task);
+		task->Release();
+	}
+	else
+	{
+		inRequest->DoComplete();
+	}
+
+	inRequest->Release();
+}
+
+
+//static
+sLONG VFileAsyncIO::_WorkerTaskProc( VTask *inTask)
+{
+	VFileAsyncIO *engine = (VFileAsyncIO*) inTask->GetKindData();
+
+	// pending requests are executed before dying
+	for(;;)
+	{
+		VFileAsyncRequest *request = NULL;
+		{
+			StLocker<VCriticalSection> lock( &engine->fLock);
+			if (!engine->fQueue.empty())
+			{
+				request = engine->fQueue.front();
+				engine->fQueue.pop_front();
+			}
+		}
+
+		if (request != NULL)
+			engine->_ExecuteSynchronously( request);
+		else if (inTask->IsDying())
+			break;
+		else
+			engine->fWakeUp.Lock( kIdleSleepMilliseconds);
+	}
+
+	return 0;
+}
+
+
+void VFileAsyncIO::Stop()
+{
+	if (fRing != NULL)
+		fRing->Stop();
+
+	std::vector<VTask*> workers;
+	{
+		StLocker<VCriticalSection> lock( &fLock);
+		workers.swap( fWorkers);
+		fStarted = 2;
+	}
+
+	for( std::vector<VTask*>::iterator i = workers.begin() ; i != workers.end() ; ++i)
+		(*i)->Kill();
+
+	for( std::vector<VTask*>::iterator i = workers.begin() ; i != workers.end() ; ++i)
+	{
+		fWakeUp.Unlock();
+		(*i)->WaitForDeath( 5000);
+		(*i)->Release();
+	}
+}
+
+
+void VFileAsyncIO::GetStatistics( VFileAsyncIOStatistics& outStatistics) const
+{
+	StLocker<VCriticalSection> lock( &fStatisticsLock);
+	outStatistics = fStatistics;
+}
+
+
+END_TOOLBOX_NAMESPACE
@@ -0,0 +1,181 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VFileAsyncIO__
+#define __VFileAsyncIO__
+
+#include <deque>
+#include <vector>
+#include "Kernel/Sources/VTask.h"
+#include "Kernel/Sources/VMessage.h"
+#include "Kernel/Sources/VSyncObject.h"
+#include "Kernel/Sources/VFile.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+// Defined in VFileAsyncIO.cpp
+class VFileAsyncIO;
+class VFileAsyncRing;
+
+
+typedef enum
+{
+	eFileAsyncRead	= 1,
+	eFileAsyncWrite,
+	eFileAsyncFlush
+} EFileAsyncKind;
+
+
+/*!
+	@class	VFileAsyncRequest
+	@abstract	A read, a write or a flush submitted to VFileAsyncIO.
+	@discussion
+		Offsets are always absolute and the current position of the VFileDesc is left untouched
+		(except with the thread pool where the blocking VFileDesc calls are used).
+		The VFileDesc and the buffer must remain valid until the request is completed.
+
+		Once completed, the request is either posted to the completion task given to VFileAsyncIO::Submit,
+		where DoComplete() is called when that task executes its messages, or DoComplete() is called directly
+		from an engine task. Override DoComplete() for callbacks or use Wait() as a future.
+		DoComplete() is not called if the completion task dies before executing its messages.
+
+		Errors are not thrown: GetError() returns the code the blocking VFileDesc call would have returned.
+		A read that reaches the end of file returns VE_STREAM_EOF and GetCount() the bytes actually read.
+*/
+class XTOOLBOX_API VFileAsyncRequest : public VMessage
+{
+public:
+										VFileAsyncRequest( EFileAsyncKind inKind, const VFileDesc *inDesc, void *inBuffer, VSize inCount, sLONG8 inOffset);
+
+	static	VFileAsyncRequest*			NewRead( const VFileDesc *inDesc, void *outBuffer, VSize inCount, sLONG8 inOffset)			{ return new VFileAsyncRequest( eFileAsyncRead, inDesc, outBuffer, inCount, inOffset);}
+	static	VFileAsyncRequest*			NewWrite( const VFileDesc *inDesc, const void *inBuffer, VSize inCount, sLONG8 inOffset)	{ return new VFileAsyncRequest( eFileAsyncWrite, inDesc, const_cast<void*>( inBuffer), inCount, inOffset);}
+	static	VFileAsyncRequest*			NewFlush( const VFileDesc *inDesc)															{ return new VFileAsyncRequest( eFileAsyncFlush, inDesc, NULL, 0, 0);}
+
+			EFileAsyncKind				GetKind() const						{ return fKind;}
+			const VFileDesc*			GetFileDesc() const					{ return fDesc;}
+			void*						GetBuffer() const					{ return fBuffer;}
+			VSize						GetRequestedCount() const			{ return fCount;}
+			sLONG8						GetOffset() const					{ return fOffset;}
+
+			bool						IsCompleted() const					{ return VInterlocked::AtomicGet( &fCompleted) != 0;}
+
+	// valid once completed
+			VError						GetError() const					{ return fError;}
+			VSize						GetCount() const					{ return fDoneCount;}
+
+	// Waits for the completion of the I/O (not for DoComplete if the request is posted to a task).
+	// Returns false on timeout.
+			bool						Wait( sLONG inTimeoutMilliseconds = -1);
+
+protected:
+	virtual								~VFileAsyncRequest();
+
+	// Called once completed, from the completion task or from an engine task.
+	virtual	void						DoComplete()						{;}
+
+	virtual	void						DoExecute();
+
+private:
+	friend class VFileAsyncIO;
+	friend class VFileAsyncRing;
+
+			EFileAsyncKind				fKind;
+	const	VFileDesc*					fDesc;
+			void*						fBuffer;
+			VSize						fCount;
+			sLONG8						fOffset;
+			VSize						fDoneCount;
+			VError						fError;
+	mutable	sLONG						fCompleted;
+			VSyncEvent					fCompletedEvent;
+			VFileAsyncIO*				fEngine;
+			VTask*						fCompletionTask;
+			sLONG8						fSubmitTime;	// profiling counter
+};
+
+
+typedef struct VFileAsyncIOStatistics
+{
+	uLONG8		fSubmittedCount;
+	uLONG8		fCompletedCount;
+	uLONG8		fRingCount;				// requests handled by io_uring, the others went to the thread pool
+	sLONG		fPendingCount;			// current queue depth
+	sLONG		fMaxPendingCount;
+	uLONG8		fTotalLatency;			// microseconds between Submit and completion
+	uLONG8		fMaxLatency;
+} VFileAsyncIOStatistics;
+
+
+/*!
+	@class	VFileAsyncIO
+	@abstract	Completion based file I/O engine.
+	@discussion
+		On Linux, requests are submitted to an io_uring instance when the kernel supports it
+		and completions are reaped by a dedicated task.
+		Otherwise, or when the ring already holds its depth of requests, they are queued to a bounded
+		pool of preemptive tasks that call the blocking VFileDesc methods.
+
+		Requests submitted after Stop() are executed synchronously on the calling task.
+*/
+class XTOOLBOX_API VFileAsyncIO : public VObject, public IRefCountable
+{
+public:
+	enum { kFileAsyncIOTaskKind = 'FAIO' };
+
+										VFileAsyncIO( sLONG inThreadCount = 4, sLONG inQueueDepth = 64, bool inAllowIOUring = true);
+
+	// Shared engine created on first use.
+	static	VFileAsyncIO*				Get();
+	static	void						DeInit();
+
+	// Retains the request until it is completed.
+	// If inCompletionTask is not NULL, the completed request is posted to it.
+			VError						Submit( VFileAsyncRequest *inRequest, VTask *inCompletionTask = NULL);
+
+	// Waits for pending requests then kills the engine tasks.
+			void						Stop();
+
+			bool						IsUsingIOUring() const				{ return fRing != NULL;}
+
+			void						GetStatistics( VFileAsyncIOStatistics& outStatistics) const;
+
+private:
+	friend class VFileAsyncRing;
+
+	virtual								~VFileAsyncIO();
+
+			bool						_StartWorkers();
+			void						_ExecuteSynchronously( VFileAsyncRequest *inRequest);
+			void						_Completed( VFileAsyncRequest *inRequest, VError inError);
+	static	sLONG						_WorkerTaskProc( VTask *inTask);
+
+	static	VFileAsyncIO*				sInstance;
+
+			sLONG						fThreadCount;
+			sLONG						fStarted;		// 0: not yet, 1: started, 2: stopped
+			VFileAsyncRing*				fRing;
+			std::vector<VTask*>			fWorkers;
+			std::deque<VFileAsyncRequest*>	fQueue;			// under fLock
+			VSemaphore					fWakeUp;
+	mutable	VCriticalSection			fLock;
+
+	mutable	VCriticalSection			fStatisticsLock;
+			VFileAsyncIOStatistics		fStatistics;	// under fStatisticsLock
+};
+
+
+END_TOOLBOX_NAMESPACE
+
+#endif
@@ -356,3 +356,58 @@ void VFileStream::ReleaseBuffer()
 }
 
 
+#pragma mark-
+
+VFileMappingStream::VFileMappingStream( const VFile *inFile, FileMapOptions inOptions)
+: fFile( RetainRefCountable( inFile))
+, fMapping( NULL)
+, fOptions( inOptions)
+{
+	xbox_assert( inFile != NULL);
+	SetReadOnly( true);
+}
+
+
+VFileMappingStream::VFileMappingStream( VFileMapping *inMapping)
+: VConstPtrStream( inMapping->GetDataPtr(), inMapping->GetDataSize())
+, fFile( NULL)
+, fMapping( RetainRefCountable( inMapping))
+, fOptions( FM_Default)
+{
+}
+
+
+VFileMappingStream::~VFileMappingStream()
+{
+	ReleaseRefCountable( &fMapping);
+	ReleaseRefCountable( &fFile);
+}
+
+
+VError VFileMappingStream::DoOpenReading()
+{
+	VError err = VE_OK;
+	if (fFile != NULL)
+	{
+		xbox_assert( fMapping == NULL);
+		err = fFile->Map( &fMapping, 0, -1, fOptions);
+		if (err == VE_OK)
+		{
+			fData = fMapping->GetDataPtr();
+			fSize = fMapping->GetDataSize();
+		}
+	}
+	return err;
+}
+
+
+VError VFileMappingStream::DoCloseReading()
+{
+	if (fFile != NULL)
+	{
+		fData = NULL;
+		fSize = 0;
+		ReleaseRefCountable( &fMapping);
+	}
+	return VE_OK;
+}
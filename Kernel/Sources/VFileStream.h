@@ -65,6 +65,35 @@ protected:
 	void	ReleaseBuffer ();
 };
 
+
+/*
+	Read-only stream over a file mapped in memory (see VFile::Map).
+	Reading doesn't go through an intermediate buffer, and GetDataPtr() gives a direct access to the whole mapping
+	so that it can be handed to parsers and decoders working on a memory block.
+*/
+class XTOOLBOX_API VFileMappingStream : public VConstPtrStream
+{
+public:
+	// The file is mapped when the stream is opened for reading and unmapped when it is closed.
+	VFileMappingStream (const VFile* inFile, FileMapOptions inOptions = FM_SequentialScan);
+
+	// The mapping is retained.
+	VFileMappingStream (VFileMapping* inMapping);
+
+	virtual ~VFileMappingStream ();
+
+	VFileMapping*	GetMapping() const	{ return fMapping; }
+
+protected:
+	// Inherited from VStream
+	virtual VError	DoOpenReading ();
+	virtual VError	DoCloseReading ();
+
+	const VFile		*fFile;
+	VFileMapping	*fMapping;
+	FileMapOptions	fOptions;
+};
+
 END_TOOLBOX_NAMESPACE
 
 #endif
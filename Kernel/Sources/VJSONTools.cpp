@@ -25,6 +25,18 @@
 #include "VValueBag.h"
 #include "VFile.h"
 #include "VUnicodeTableFull.h"
+#include "VStream.h"
+#include "VFileStream.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define JSON_WITH_SSE2	1
+	#include <emmintrin.h>
+	#if COMPIL_VISUAL
+		#include <intrin.h>
+	#endif
+#else
+	#define JSON_WITH_SSE2	0
+#endif
 
 BEGIN_TOOLBOX_NAMESPACE
 
@@ -827,6 +839,37 @@ VError VJSONImporter::ParseFile( const VFile *inFile, VJSONValue& outValue, EJSO
 	VString sourceID;
 	inFile->GetPath( sourceID, FPS_POSIX);
 
+	if ((inOptions & EJSI_QuotesMandatoryForString) != 0)
+	{
+		// standard grammar: parse the file by chunks instead of loading and converting it, unless it's not UTF-8
+		VFileStream stream( inFile);
+		VError err = stream.OpenReading();
+		if (err == VE_OK)
+		{
+			bool isUTF8 = true;
+			if (stream.GetSize() >= 2)
+			{
+				uBYTE bom[2] = { 0, 0};
+				err = stream.GetData( bom, sizeof( bom));
+				isUTF8 = !( (bom[0] == 0xFF && bom[1] == 0xFE) || (bom[0] == 0xFE && bom[1] == 0xFF) );
+				if (err == VE_OK)
+					err = stream.SetPos( 0);
+			}
+
+			if ( (err == VE_OK) && isUTF8)
+			{
+				VJSONStreamParser parser( &stream, inOptions);
+				parser.SetSourceID( sourceID);
+				err = parser.ParseValue( outValue);
+				stream.CloseReading();
+				return err;
+			}
+			stream.CloseReading();
+		}
+		if (err != VE_OK)
+			return err;
+	}
+
 	VString source;
 	VError err = inFile->GetContentAsString( source, VTC_UTF_8);
 	if (err == VE_OK)
@@ -1024,6 +1067,781 @@ VError VJSONImporter::JSONObjectToBag( VValueBag& outBag)
 	return err;
 }
 
+// ===========================================================
+#pragma mark -
+#pragma mark VJSONStreamParser
+// ===========================================================
+
+const VSize kJSONStreamBufferSize = 64 * 1024;
+
+
+/*
+	Builds a VJSONValue tree from VJSONStreamParser events.
+	If an arena is given, all objects and arrays are allocated in it.
+*/
+class VJSONValueBuilder : public IJSONSaxHandler
+{
+public:
+									VJSONValueBuilder( bool inAllowDates, VJSONArena *inArena) : fAllowDates( inAllowDates), fArena( inArena)	{}
+
+			const VJSONValue&		GetValue() const	{ return fValue;}
+
+	virtual	VError					BeginObject()
+	{
+		VJSONObject *object = (fArena != NULL) ? fArena->NewObject() : new VJSONObject;
+		if (object == NULL)
+			return vThrowError( VE_MEMORY_FULL);
+
+		VJSONValue value;
+		value.SetObject( object);
+		ReleaseRefCountable( &object);
+
+		fContainers.push_back( value);	// containers are retained by the value: they are filled after being added to their parent
+		return (fContainers.size() > 1) ? _AddValue( value, fContainers[fContainers.size() - 2]) : _SetRoot( value);
+	}
+
+	virtual	VError					Key( const VString& inName)		{ fKey = inName; return VE_OK;}
+	virtual	VError					EndObject()						{ fContainers.pop_back(); return VE_OK;}
+
+	virtual	VError					BeginArray()
+	{
+		VJSONArray *array = (fArena != NULL) ? fArena->NewArray() : new VJSONArray;
+		if (array == NULL)
+			return vThrowError( VE_MEMORY_FULL);
+
+		VJSONValue value;
+		value.SetArray( array);
+		ReleaseRefCountable( &array);
+
+		fContainers.push_back( value);
+		return (fContainers.size() > 1) ? _AddValue( value, fContainers[fContainers.size() - 2]) : _SetRoot( value);
+	}
+
+	virtual	VError					EndArray()						{ fContainers.pop_back(); return VE_OK;}
+
+	virtual	VError					StringValue( const VString& inValue)
+	{
+		VJSONValue value;
+		VIndex len = inValue.GetLength();
+		const UniChar *p = inValue.GetCPointer();
+		if (fAllowDates && (len >= 4) && (p[0] == '!') && (p[1] == '!') && (p[len - 1] == '!') && (p[len - 2] == '!'))	// dates are "!!ISODATE!!"
+		{
+			VTime dd;
+			VString s;
+			inValue.GetSubString( 3, len - 4, s);
+			dd.FromXMLString( s);
+			value.SetTime( dd);
+		}
+		else
+		{
+			value.SetString( inValue);
+		}
+		return _Add( value);
+	}
+
+	virtual	VError					NumberValue( Real inValue)		{ VJSONValue value; value.SetNumber( inValue); return _Add( value);}
+	virtual	VError					BoolValue( bool inValue)		{ return _Add( inValue ? VJSONValue::sTrue : VJSONValue::sFalse);}
+	virtual	VError					NullValue()						{ return _Add( VJSONValue::sNull);}
+
+private:
+			VError					_Add( const VJSONValue& inValue)	{ return fContainers.empty() ? _SetRoot( inValue) : _AddValue( inValue, fContainers.back());}
+			VError					_SetRoot( const VJSONValue& inValue)	{ fValue = inValue; return VE_OK;}
+			VError					_AddValue( const VJSONValue& inValue, const VJSONValue& inContainer)
+	{
+		bool ok = inContainer.IsObject() ? inContainer.GetObject()->SetProperty( fKey, inValue) : inContainer.GetArray()->Push( inValue);
+		return ok ? VE_OK : vThrowError( VE_MEMORY_FULL);
+	}
+
+			VJSONValue				fValue;
+			std::vector<VJSONValue>	fContainers;
+			VString					fKey;
+			bool					fAllowDates;
+			VJSONArena*				fArena;
+};
+
+
+/*
+	Returns the first byte in [inPos, inEnd) that needs attention inside a JSON string:
+	quote, backslash, control char, or first byte of a multi-bytes UTF-8 sequence.
+*/
+static const uBYTE* _JSONScanPlainASCII( const uBYTE *inPos, const uBYTE *inEnd)
+{
+	const uBYTE *p = inPos;
+
+#if JSON_WITH_SSE2
+	const __m128i quote = _mm_set1_epi8( '"');
+	const __m128i backslash = _mm_set1_epi8( '\\');
+	const __m128i space = _mm_set1_epi8( 0x20);
+	while (inEnd - p >= 16)
+	{
+		__m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p));
+		// signed compare catches both control chars (< 0x20) and non ASCII bytes (>= 0x80 are negative)
+		__m128i special = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, quote), _mm_cmpeq_epi8( v, backslash)), _mm_cmplt_epi8( v, space));
+		int mask = _mm_movemask_epi8( special);
+		if (mask != 0)
+		{
+		#if COMPIL_VISUAL
+			unsigned long index;
+			_BitScanForward( &index, (unsigned long) mask);
+			return p + index;
+		#else
+			return p + __builtin_ctz( (unsigned int) mask);
+		#endif
+		}
+		p += 16;
+	}
+#endif
+
+	while ( (p != inEnd) && (*p >= 0x20) && (*p < 0x80) && (*p != '"') && (*p != '\\') )
+		++p;
+
+	return p;
+}
+
+
+static void _JSONAppendUTF8( std::vector<char>& ioBytes, uLONG inCodePoint)
+{
+	if (inCodePoint < 0x80)
+	{
+		ioBytes.push_back( (char) inCodePoint);
+	}
+	else if (inCodePoint < 0x800)
+	{
+		ioBytes.push_back( (char) (0xC0 | (inCodePoint >> 6)));
+		ioBytes.push_back( (char) (0x80 | (inCodePoint & 0x3F)));
+	}
+	else if (inCodePoint < 0x10000)
+	{
+		ioBytes.push_back( (char) (0xE0 | (inCodePoint >> 12)));
+		ioBytes.push_back( (char) (0x80 | ((inCodePoint >> 6) & 0x3F)));
+		ioBytes.push_back( (char) (0x80 | (inCodePoint & 0x3F)));
+	}
+	else
+	{
+		ioBytes.push_back( (char) (0xF0 | (inCodePoint >> 18)));
+		ioBytes.push_back( (char) (0x80 | ((inCodePoint >> 12) & 0x3F)));
+		ioBytes.push_back( (char) (0x80 | ((inCodePoint >> 6) & 0x3F)));
+		ioBytes.push_back( (char) (0x80 | (inCodePoint & 0x3F)));
+	}
+}
+
+
+VJSONStreamParser::VJSONStreamParser( VStream *inStream, VJSONImporter::EJSONImporterOptions inOptions)
+: fStream( inStream)
+, fOptions( inOptions)
+, fBuffer( kJSONStreamBufferSize)
+, fPos( NULL)
+, fEnd( NULL)
+, fEOF( false)
+, fStreamError( VE_OK)
+, fBufferOffset( 0)
+, fLineStart( 0)
+, fLine( 1)
+{
+}
+
+
+VJSONStreamParser::~VJSONStreamParser()
+{
+}
+
+
+/*
+	static
+*/
+VError VJSONStreamParser::ParseStream( VStream *inStream, VJSONValue& outValue, VJSONImporter::EJSONImporterOptions inOptions)
+{
+	VJSONStreamParser parser( inStream, inOptions);
+	return parser.ParseValue( outValue);
+}
+
+
+VError VJSONStreamParser::ParseValue( VJSONValue& outValue)
+{
+	// the arena is kept alive by its nodes: it goes away with the last reference to the tree
+	VJSONArena *arena = ((fOptions & VJSONImporter::EJSI_UseArena) != 0) ? new VJSONArena : NULL;
+
+	VError err;
+	{
+		VJSONValueBuilder builder( (fOptions & VJSONImporter::EJSI_AllowDates) != 0, arena);
+
+		err = Parse( &builder);
+
+		if ( (err != VE_OK) && ( (fOptions & VJSONImporter::EJSI_ReturnUndefinedWhenMalformed) != 0) )
+			outValue.SetUndefined();
+		else
+			outValue = builder.GetValue();
+	}
+
+	ReleaseRefCountable( &arena);
+
+	return err;
+}
+
+
+VError VJSONStreamParser::Parse( IJSONSaxHandler *inHandler)
+{
+	if (!testAssert( (fStream != NULL) && (inHandler != NULL)))
+		return VE_INVALID_PARAMETER;
+
+	VError err = VE_OK;
+	bool closeStream = false;
+	if (!fStream->IsReading())
+	{
+		err = fStream->OpenReading();
+		closeStream = (err == VE_OK);
+	}
+
+	if (err == VE_OK)
+	{
+		// skip UTF-8 BOM
+		if ( (fEnd == NULL) && _Fill() && (fEnd - fPos >= 3) && (fPos[0] == 0xEF) && (fPos[1] == 0xBB) && (fPos[2] == 0xBF) )
+			fPos += 3;
+
+		err = _Parse( inHandler);
+
+		// a read error is more meaningful than the malformed json error it leads to
+		if (fStreamError != VE_OK)
+			err = fStreamError;
+	}
+
+	if (closeStream)
+		fStream->CloseReading();
+
+	return err;
+}
+
+
+VError VJSONStreamParser::_Parse( IJSONSaxHandler *inHandler)
+{
+	typedef enum { eValue, eValueOrEnd, eKey, eKeyOrEnd, eNext } State;
+
+	VError err = VE_OK;
+	State state = eValue;
+	std::vector<uBYTE> containers;	// '{' or '[' for each open container
+	VString string;
+	bool done = false;
+
+	while( (err == VE_OK) && !done)
+	{
+		uBYTE c;
+		if (!_SkipWhiteSpaces( c))
+		{
+			if (containers.empty())
+				err = _ThrowError( VE_MALFORMED_JSON_EXPECTED_TOKEN, "\" 0-9 null true false { [");
+			else
+				err = _ThrowError( VE_MALFORMED_JSON_UNTERMINATED_TOKEN, (containers.back() == '{') ? "{" : "[");
+			break;
+		}
+
+		bool valueDone = false;
+
+		if (state == eValueOrEnd)
+		{
+			if (c == ']')
+			{
+				containers.pop_back();
+				err = inHandler->EndArray();
+				valueDone = true;
+			}
+			else
+			{
+				state = eValue;
+			}
+		}
+		else if (state == eKeyOrEnd)
+		{
+			if (c == '}')
+			{
+				containers.pop_back();
+				err = inHandler->EndObject();
+				valueDone = true;
+			}
+			else
+			{
+				state = eKey;
+			}
+		}
+
+		if (valueDone)
+		{
+		}
+		else if (state == eValue)
+		{
+			switch( c)
+			{
+				case '{':
+					containers.push_back( c);
+					err = inHandler->BeginObject();
+					state = eKeyOrEnd;
+					break;
+
+				case '[':
+					containers.push_back( c);
+					err = inHandler->BeginArray();
+					state = eValueOrEnd;
+					break;
+
+				case '"':
+					err = _ParseString( string);
+					if (err == VE_OK)
+						err = inHandler->StringValue( string);
+					valueDone = true;
+					break;
+
+				case 't':
+					err = _ParseLiteral( "true");
+					if (err == VE_OK)
+						err = inHandler->BoolValue( true);
+					valueDone = true;
+					break;
+
+				case 'f':
+					err = _ParseLiteral( "false");
+					if (err == VE_OK)
+						err = inHandler->BoolValue( false);
+					valueDone = true;
+					break;
+
+				case 'n':
+					err = _ParseLiteral( "null");
+					if (err == VE_OK)
+						err = inHandler->NullValue();
+					valueDone = true;
+					break;
+
+				default:
+					if ( (c == '-') || ( (c >= '0') && (c <= '9') ) )
+					{
+						Real number = 0;
+						err = _ParseNumber( c, number);
+						if (err == VE_OK)
+							err = inHandler->NumberValue( number);
+						valueDone = true;
+					}
+					else if ( (c == ']') && !containers.empty() && (containers.back() == '[') )
+					{
+						// just got a ,] sequence. It's generally an extraneous comma.
+						err = _ThrowError( VE_MALFORMED_JSON_EXTRA_COMMA, "]");
+					}
+					else
+					{
+						err = _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "\" 0-9 null true false { [");
+					}
+					break;
+			}
+		}
+		else if (state == eKey)
+		{
+			if (c == '"')
+			{
+				err = _ParseString( string);
+				if (err == VE_OK)
+					err = inHandler->Key( string);
+				if (err == VE_OK)
+				{
+					if (!_SkipWhiteSpaces( c))
+						err = _ThrowError( VE_MALFORMED_JSON_UNTERMINATED_TOKEN, "{");
+					else if (c != ':')
+						err = _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, ":");
+					else
+						state = eValue;
+				}
+			}
+			else if (c == '}')
+			{
+				// just got a ,} sequence. It's generally an extraneous comma.
+				err = _ThrowError( VE_MALFORMED_JSON_EXTRA_COMMA, "}");
+			}
+			else
+			{
+				err = _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "\"");
+			}
+		}
+		else if (state == eNext)
+		{
+			bool inObject = (containers.back() == '{');
+			if (c == ',')
+			{
+				state = inObject ? eKey : eValue;
+			}
+			else if (inObject && (c == '}'))
+			{
+				containers.pop_back();
+				err = inHandler->EndObject();
+				valueDone = true;
+			}
+			else if (!inObject && (c == ']'))
+			{
+				containers.pop_back();
+				err = inHandler->EndArray();
+				valueDone = true;
+			}
+			else
+			{
+				err = _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, inObject ? "} ," : "] ,");
+			}
+		}
+
+		if (valueDone && (err == VE_OK))
+		{
+			if (containers.empty())
+				done = true;
+			else
+				state = eNext;
+		}
+	}
+
+	return err;
+}
+
+
+bool VJSONStreamParser::_Fill()
+{
+	if (fEOF)
+		return false;
+
+	if (fEnd != NULL)
+		fBufferOffset += fEnd - &fBuffer[0];
+
+	VSize count = fBuffer.size();
+	{
+		StErrorContextInstaller filter( VE_STREAM_EOF, VE_OK);
+		VError err = fStream->GetData( &fBuffer[0], &count);
+		if (err != VE_OK)
+		{
+			fEOF = true;
+			if (err != VE_STREAM_EOF)
+				fStreamError = err;
+		}
+	}
+
+	fPos = &fBuffer[0];
+	fEnd = fPos + count;
+
+	return count > 0;
+}
+
+
+bool VJSONStreamParser::_SkipWhiteSpaces( uBYTE& outByte)
+{
+	for(;;)
+	{
+		if ( (fPos == fEnd) && !_Fill())
+			return false;
+
+		uBYTE c = *fPos++;
+		if (c == '\n')
+		{
+			++fLine;
+			fLineStart = fBufferOffset + (fPos - &fBuffer[0]);
+		}
+		else if (c > 32)
+		{
+			outByte = c;
+			return true;
+		}
+	}
+}
+
+
+VError VJSONStreamParser::_ParseString( VString& outString)
+{
+	// the opening quote has been read.
+	// bytes are collected as utf-8 and converted once at the end.
+	fToken.clear();
+
+	for(;;)
+	{
+		if ( (fPos == fEnd) && !_Fill())
+			return _ThrowError( VE_MALFORMED_JSON_UNTERMINATED_TOKEN, "\"");
+
+		// fast path: copy the run of plain ascii chars
+		const uBYTE *run = _JSONScanPlainASCII( fPos, fEnd);
+		if (run != fPos)
+		{
+			fToken.insert( fToken.end(), fPos, run);
+			fPos = run;
+			if (fPos == fEnd)
+				continue;
+		}
+
+		uBYTE c = *fPos++;
+		if (c == '"')
+		{
+			break;
+		}
+		else if (c == '\\')
+		{
+			uBYTE e;
+			if (!_NextByte( e))
+				return _ThrowError( VE_MALFORMED_JSON_UNTERMINATED_TOKEN, "\"");
+
+			switch( e)
+			{
+				case '\\':
+				case '"':
+				case '/':	fToken.push_back( (char) e); break;
+				case 't':	fToken.push_back( 9); break;
+				case 'r':	fToken.push_back( 13); break;
+				case 'n':	fToken.push_back( 10); break;
+				case 'b':	fToken.push_back( 8); break;
+				case 'f':	fToken.push_back( 12); break;
+
+				case 'u':
+					{
+						uLONG codePoint = 0;
+						for( sLONG i = 0 ; i < 4 ; ++i)
+						{
+							uBYTE h;
+							if (!_NextByte( h))
+								return _ThrowError( VE_MALFORMED_JSON_UNTERMINATED_TOKEN, "\"");
+							if (h >= '0' && h <= '9')
+								codePoint = codePoint * 16 + (h - '0');
+							else if (h >= 'A' && h <= 'F')
+								codePoint = codePoint * 16 + (h - 'A') + 10;
+							else if (h >= 'a' && h <= 'f')
+								codePoint = codePoint * 16 + (h - 'a') + 10;
+							else
+								return _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "0-9 a-f A-F");
+						}
+
+						if ( (codePoint >= 0xD800) && (codePoint <= 0xDBFF) )
+						{
+							// high surrogate: must be followed by an escaped low surrogate
+							uBYTE u[6];
+							sLONG count = 0;
+							while( (count < 6) && _NextByte( u[count]))
+								++count;
+							uLONG low = 0;
+							bool isPair = (count == 6) && (u[0] == '\\') && (u[1] == 'u');
+							for( sLONG i = 2 ; isPair && (i < 6) ; ++i)
+							{
+								uBYTE h = u[i];
+								if (h >= '0' && h <= '9')
+									low = low * 16 + (h - '0');
+								else if (h >= 'A' && h <= 'F')
+									low = low * 16 + (h - 'A') + 10;
+								else if (h >= 'a' && h <= 'f')
+									low = low * 16 + (h - 'a') + 10;
+								else
+									isPair = false;
+							}
+							if (!isPair || (low < 0xDC00) || (low > 0xDFFF))
+								return _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "\\uDC00-\\uDFFF");
+							codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+						}
+						else if ( (codePoint >= 0xDC00) && (codePoint <= 0xDFFF) )
+						{
+							codePoint = 0xFFFD;	// lone low surrogate
+						}
+
+						if (codePoint != 0)	// same as VJSONImporter
+							_JSONAppendUTF8( fToken, codePoint);
+						break;
+					}
+
+				default:
+					return _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "\\ \" / b f n r t u");
+			}
+		}
+		else if (c < 0x20)
+		{
+			return _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "\"");
+		}
+		else
+		{
+			// multi-bytes utf-8 sequence: check it's well formed (no overlong form, no surrogate, <= U+10FFFF)
+			sLONG count;
+			uBYTE min2 = 0x80, max2 = 0xBF;
+			if (c >= 0xC2 && c <= 0xDF)
+			{
+				count = 1;
+			}
+			else if (c >= 0xE0 && c <= 0xEF)
+			{
+				count = 2;
+				if (c == 0xE0)
+					min2 = 0xA0;
+				else if (c == 0xED)
+					max2 = 0x9F;
+			}
+			else if (c >= 0xF0 && c <= 0xF4)
+			{
+				count = 3;
+				if (c == 0xF0)
+					min2 = 0x90;
+				else if (c == 0xF4)
+					max2 = 0x8F;
+			}
+			else
+			{
+				return _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "UTF-8");
+			}
+
+			fToken.push_back( (char) c);
+			for( sLONG i = 0 ; i < count ; ++i)
+			{
+				uBYTE cc;
+				if (!_NextByte( cc))
+					return _ThrowError( VE_MALFORMED_JSON_UNTERMINATED_TOKEN, "\"");
+				if ( (cc < ((i == 0) ? min2 : 0x80)) || (cc > ((i == 0) ? max2 : 0xBF)) )
+					return _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "UTF-8");
+				fToken.push_back( (char) cc);
+			}
+		}
+	}
+
+	if (fToken.empty())
+		outString.Clear();
+	else
+		outString.FromBlock( &fToken[0], fToken.size(), VTC_UTF_8);
+
+	return VE_OK;
+}
+
+
+VError VJSONStreamParser::_ParseNumber( uBYTE inFirstByte, Real& outNumber)
+{
+	fToken.clear();
+	fToken.push_back( (char) inFirstByte);
+
+	// collect [0-9+-.eE] chars
+	for(;;)
+	{
+		if ( (fPos == fEnd) && !_Fill())
+			break;
+		uBYTE c = *fPos;
+		if ( ( (c >= '0') && (c <= '9') ) || (c == '.') || (c == 'e') || (c == 'E') || (c == '+') || (c == '-') )
+		{
+			fToken.push_back( (char) c);
+			++fPos;
+		}
+		else
+		{
+			break;
+		}
+	}
+	fToken.push_back( 0);
+
+	// check grammar: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+	const char *p = &fToken[0];
+	bool negative = (*p == '-');
+	if (negative)
+		++p;
+
+	const char *digits = p;
+	bool ok = true;
+	if (*p == '0')
+		++p;
+	else if (*p >= '1' && *p <= '9')
+		while( *p >= '0' && *p <= '9')
+			++p;
+	else
+		ok = false;
+
+	sLONG countDigits = (sLONG) (p - digits);
+	bool isInteger = true;
+	if (ok && (*p == '.'))
+	{
+		isInteger = false;
+		++p;
+		ok = (*p >= '0' && *p <= '9');
+		while( *p >= '0' && *p <= '9')
+			++p;
+	}
+	if (ok && ( (*p == 'e') || (*p == 'E') ) )
+	{
+		isInteger = false;
+		++p;
+		if ( (*p == '+') || (*p == '-') )
+			++p;
+		ok = (*p >= '0' && *p <= '9');
+		while( *p >= '0' && *p <= '9')
+			++p;
+	}
+	ok = ok && (*p == 0);
+
+	if (!ok)
+		return _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "+- 0-9 eE");
+
+	if (isInteger && (countDigits <= 15))
+	{
+		// exact in a double, no need for a string conversion
+		sLONG8 value = 0;
+		for( const char *d = digits ; d != digits + countDigits ; ++d)
+			value = value * 10 + (*d - '0');
+		outNumber = (Real) (negative ? -value : value);
+	}
+	else
+	{
+		VString s;
+		s.FromBlock( &fToken[0], fToken.size() - 1, VTC_US_ASCII);
+		outNumber = s.GetReal();
+	}
+
+	return VE_OK;
+}
+
+
+VError VJSONStreamParser::_ParseLiteral( const char *inLiteral)
+{
+	// first char has been read
+	for( const char *p = inLiteral + 1 ; *p != 0 ; ++p)
+	{
+		uBYTE c;
+		if (!_NextByte( c) || (c != (uBYTE) *p))
+			return _ThrowError( VE_MALFORMED_JSON_INVALID_TOKEN, "\" 0-9 null true false { [");
+	}
+	return VE_OK;
+}
+
+
+VError VJSONStreamParser::_ThrowError( VError inError, const char *inExpected) const
+{
+	VErrorBase* err = new VErrorBase( inError, 0);
+	if (err != NULL)
+	{
+		if ( (inError == VE_MALFORMED_JSON_UNTERMINATED_TOKEN) || (inError == VE_MALFORMED_JSON_EXTRA_COMMA) )
+		{
+			err->GetBag()->SetString( "token", inExpected);
+		}
+		else
+		{
+			VString found;
+			if ( (fPos != NULL) && (fPos != &fBuffer[0]) && (inError != VE_MALFORMED_JSON_EXPECTED_TOKEN) )
+				found.AppendUniChar( fPos[-1]);
+			err->GetBag()->SetString( "found", found);
+			err->GetBag()->SetString( "expected", inExpected);
+		}
+		VTask::GetCurrent()->PushError( err);
+	}
+	ReleaseRefCountable( &err);
+
+	// throw last the generic 550 error with line number and byte position
+	err = new VErrorBase( VE_MALFORMED_JSON_DESCRIPTION, 0);
+	if (err != NULL)
+	{
+		VString source( fSourceID);
+		if (!source.IsEmpty())
+		{
+			source += ',';
+			source += ' ';
+		}
+		err->GetBag()->SetString( "source", source);
+
+		sLONG8 offset = (fPos != NULL) ? fBufferOffset + (fPos - &fBuffer[0]) : 0;
+		err->GetBag()->SetLong( "line", fLine);
+		err->GetBag()->SetLong( "position", (sLONG) (offset - fLineStart));
+
+		VTask::GetCurrent()->PushError( err);
+	}
+	ReleaseRefCountable( &err);
+
+	return VE_MALFORMED_JSON_DESCRIPTION;
+}
+
+
 // ===========================================================
 #pragma mark -
 #pragma mark VJSONArrayWriter
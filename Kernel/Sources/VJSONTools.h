@@ -23,6 +23,7 @@
 BEGIN_TOOLBOX_NAMESPACE
 
 class VJSONValue;
+class VStream;
 
 /**@brief	VJSONImporter contains two kind of routines:
 				-> Low-level, to parse a JSON string as you want
@@ -63,6 +64,7 @@ public:
 			EJSI_ReturnUndefinedWhenMalformed = 1,	// on maformed json always return json_undefined instead of what has been parsed so far
 			EJSI_QuotesMandatoryForString = 2,	// strings must be surrounded by double quotes (required by standard grammar)
 			EJSI_AllowDates = 64,
+			EJSI_UseArena = 128,	// VJSONStreamParser only: the whole tree is allocated in one VJSONArena (see VJSONValue.h)
 			EJSI_Default = 0,
 			EJSI_Strict = EJSI_ReturnUndefinedWhenMalformed | EJSI_QuotesMandatoryForString
 		};
@@ -133,6 +135,81 @@ private:
 	
 };
 
+/**@brief	IJSONSaxHandler receives the events produced by VJSONStreamParser, in document order.
+			Returning an error from any callback stops the parsing, and VJSONStreamParser::Parse() returns that error.
+*/
+class XTOOLBOX_API IJSONSaxHandler
+{
+public:
+	virtual							~IJSONSaxHandler()	{}
+
+	virtual	VError					BeginObject() = 0;
+	virtual	VError					Key( const VString& inName) = 0;
+	virtual	VError					EndObject() = 0;
+	virtual	VError					BeginArray() = 0;
+	virtual	VError					EndArray() = 0;
+	virtual	VError					StringValue( const VString& inValue) = 0;
+	virtual	VError					NumberValue( Real inValue) = 0;
+	virtual	VError					BoolValue( bool inValue) = 0;
+	virtual	VError					NullValue() = 0;
+};
+
+
+/**@brief	VJSONStreamParser parses one JSON value from a VStream of UTF-8 bytes and sends events to an IJSONSaxHandler.
+			The stream is read by chunks, so the document never needs to fit in memory, and there's no conversion to UTF-16
+			except for the strings handed to the handler. Unlike VJSONImporter, the grammar is always the standard one
+			(strings must be quoted), and invalid UTF-8 inside strings is an error.
+			
+			ParseStream() builds a VJSONValue tree from the events (EJSI_AllowDates and EJSI_ReturnUndefinedWhenMalformed are honored).
+			With EJSI_UseArena, the objects and arrays of that tree are allocated in a VJSONArena and freed together with it.
+			If the stream is not opened for reading, Parse() opens and closes it.
+			A leading UTF-8 BOM is skipped. Bytes following the value are not read.
+*/
+class XTOOLBOX_API VJSONStreamParser : public VObject
+{
+public:
+									VJSONStreamParser( VStream *inStream, VJSONImporter::EJSONImporterOptions inOptions = VJSONImporter::EJSI_Strict);
+	virtual							~VJSONStreamParser();
+
+			VError					Parse( IJSONSaxHandler *inHandler);
+
+			// Parse the stream and produces a value.
+			VError					ParseValue( VJSONValue& outValue);
+
+			// Parse some stream and produces a value.
+	static	VError					ParseStream( VStream *inStream, VJSONValue& outValue, VJSONImporter::EJSONImporterOptions inOptions = VJSONImporter::EJSI_Strict);
+
+			void					SetSourceID( const VString& inSourceID)		{ fSourceID = inSourceID;}
+			const VString&			GetSourceID() const							{ return fSourceID;}
+
+private:
+									VJSONStreamParser( const VJSONStreamParser&);	// forbidden
+			VJSONStreamParser&		operator=( const VJSONStreamParser&);	// forbidden
+
+			VError					_Parse( IJSONSaxHandler *inHandler);
+			bool					_Fill();
+			bool					_NextByte( uBYTE& outByte)	{ if ((fPos == fEnd) && !_Fill()) return false; outByte = *fPos++; return true;}
+			bool					_SkipWhiteSpaces( uBYTE& outByte);
+			VError					_ParseString( VString& outString);
+			VError					_ParseNumber( uBYTE inFirstByte, Real& outNumber);
+			VError					_ParseLiteral( const char *inLiteral);
+			VError					_ThrowError( VError inError, const char *inExpected) const;
+
+			VStream*				fStream;
+			VJSONImporter::EJSONImporterOptions	fOptions;
+			std::vector<uBYTE>		fBuffer;
+			const uBYTE*			fPos;
+			const uBYTE*			fEnd;
+			bool					fEOF;
+			VError					fStreamError;
+			sLONG8					fBufferOffset;	// stream offset of fBuffer[0]
+			sLONG8					fLineStart;		// stream offset of current line, for error reporting
+			sLONG					fLine;
+			std::vector<char>		fToken;
+			VString					fSourceID;
+};
+
+
 /** @brief	VJSONArrayWriter creates a JSON array: ["string",123,"2008-12-10T00:00:00",3.14,true]
 			No spaces, no human-more-easy-readable formating. For example, the php json_decode does'nt want carrage return,
 			it only allows a space after the comma between each element.
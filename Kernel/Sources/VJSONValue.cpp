@@ -126,9 +126,10 @@ void VJSONGraph::Connect( VJSONGraph** inRetainerGraph, VJSONGraph** inRetainedG
 */
 void VJSONGraph::Connect( VJSONGraph** inRetainerGraph, const VJSONValue& inRetainedValue)
 {
-	if (inRetainedValue.IsObject())
+	// arena nodes are released as a whole by their arena and never take part in cycle detection
+	if (inRetainedValue.IsObject() && (inRetainedValue.GetObject()->GetArena() == NULL))
 		Connect( inRetainerGraph, inRetainedValue.GetObject()->GetGraph());
-	else if (inRetainedValue.IsArray())
+	else if (inRetainedValue.IsArray() && (inRetainedValue.GetArray()->GetArena() == NULL))
 		Connect( inRetainerGraph, inRetainedValue.GetArray()->GetGraph());
 }
 
@@ -163,9 +164,9 @@ void VJSONGraph::CollectObjectReferences( VJSONObject *inObject, std::vector<VJS
 		for( VJSONPropertyConstIterator i( inObject) ; i.IsValid() ; ++i)
 		{
 			const VJSONValue& value = i.GetValue();
-			if (value.IsObject())
+			if (value.IsObject() && (value.GetObject()->GetArena() == NULL))
 				CollectObjectReferences( value.GetObject(), ioObjects, ioArrays, ioReferencesTotal, outCyclic);
-			else if (value.IsArray())
+			else if (value.IsArray() && (value.GetArray()->GetArena() == NULL))
 				CollectArrayReferences( value.GetArray(), ioObjects, ioArrays, ioReferencesTotal, outCyclic);
 		}
 	}
@@ -191,9 +192,9 @@ void VJSONGraph::CollectArrayReferences( VJSONArray *inArray, std::vector<VJSONO
 		for( size_t i = 0 ; i < count ; ++i)
 		{
 			const VJSONValue& value = (*inArray)[i];
-			if (value.IsObject())
+			if (value.IsObject() && (value.GetObject()->GetArena() == NULL))
 				CollectObjectReferences( value.GetObject(), ioObjects, ioArrays, ioReferencesTotal, outCyclic);
-			else if (value.IsArray())
+			else if (value.IsArray() && (value.GetArray()->GetArena() == NULL))
 				CollectArrayReferences( value.GetArray(), ioObjects, ioArrays, ioReferencesTotal, outCyclic);
 		}
 	}
@@ -963,6 +964,16 @@ EJSONStatus IJSONObject::IJSON_Clone( const VJSONObject *inOwner, VJSONCloner& i
 VJSONObject::VJSONObject( IJSONObject *inImplementation)
 : fGraph( NULL)
 , fImpl( RetainRef( inImplementation))
+, fArena( NULL)
+{
+	VInterlocked::Increment( &sCount);
+}
+
+
+VJSONObject::VJSONObject( VJSONArena& inArena)
+: fGraph( NULL)
+, fImpl( NULL)
+, fArena( &inArena)
 {
 	VInterlocked::Increment( &sCount);
 }
@@ -976,8 +987,20 @@ VJSONObject::~VJSONObject()
 }
 
 
+sLONG VJSONObject::Retain( const char* inDebugInfo) const
+{
+	if (fArena != NULL)
+		return fArena->RetainNodes();
+
+	return IRefCountable::Retain( inDebugInfo);
+}
+
+
 sLONG VJSONObject::Release( const char* inDebugInfo) const
 {
+	if (fArena != NULL)
+		return fArena->ReleaseNodes();
+
 	if (VJSONGraph::IsPossiblyCyclic( fGraph))
 		VJSONGraph::ReleaseObjectDependenciesIfNecessary( const_cast<VJSONObject*>( this));
 
@@ -1025,16 +1048,27 @@ bool VJSONObject::SetProperty( const VString& inName, const VJSONValue& inValue)
 		{
 			ok = true;
 			if (inValue.IsUndefined())
-				fMap.erase( inName);
+			{
+				MapType::iterator i = fMap.find( inName);
+				if (i != fMap.end())
+				{
+					_UnadoptValue( i->second.first);
+					fMap.erase( i);
+				}
+			}
 			else
 			{
-				std::pair<MapType::iterator,bool> i = fMap.insert( MapType::value_type( inName, std::pair<VJSONValue,size_t>(inValue,fMap.size())));
+				const VString& name = (fArena != NULL) ? fArena->InternKey( inName) : inName;
+				std::pair<MapType::iterator,bool> i = fMap.insert( MapType::value_type( name, std::pair<VJSONValue,size_t>(inValue,fMap.size())));
 				if (!i.second)
 				{
+					_UnadoptValue( i.first->second.first);
 					i.first->second.first = inValue;
 				}
+				_AdoptValue( inValue);
 					
-				VJSONGraph::Connect( &fGraph, inValue);
+				if (fArena == NULL)
+					VJSONGraph::Connect( &fGraph, inValue);
 			}
 		}
 		catch(...)
@@ -1068,6 +1102,7 @@ void VJSONObject::RemoveProperty( const VString& inName)
 				if (j->second.second > index)
 					j->second.second -= 1;
 			}
+			_UnadoptValue( i->second.first);
 			fMap.erase( i);
 		}
 	}
@@ -1081,10 +1116,32 @@ void VJSONObject::Clear()
 		bool ok = fImpl->IJSON_Clear( this);
 	}
 
+	if (fArena != NULL)
+	{
+		for( MapType::const_iterator i = fMap.begin() ; i != fMap.end() ; ++i)
+			_UnadoptValue( i->second.first);
+	}
+
 	fMap.clear();
 }
 
 
+void VJSONObject::_AdoptValue( const VJSONValue& inValue) const
+{
+	// storing inValue retained the arena nodes: references between nodes of the same arena are not counted
+	if ( (fArena != NULL) && fArena->IsArenaNode( inValue))
+		fArena->ForgetNodeReference();
+}
+
+
+void VJSONObject::_UnadoptValue( const VJSONValue& inValue) const
+{
+	// balances the release that will occur when inValue is removed
+	if ( (fArena != NULL) && fArena->IsArenaNode( inValue))
+		fArena->RetainNodes();
+}
+
+
 bool VJSONObject::IsEmpty() const
 {
 	bool isEmpty = fMap.empty();
@@ -1192,7 +1249,16 @@ VError VJSONObject::CloneProperties( VJSONCloner& inCloner, VJSONObject *inDesti
 		}
 		
 		if (err == VE_OK)
+		{
+			if (inDestination->fArena != NULL)
+			{
+				for( MapType::const_iterator i = inDestination->fMap.begin() ; i != inDestination->fMap.end() ; ++i)
+					inDestination->_UnadoptValue( i->second.first);
+				for( MapType::const_iterator i = clonedMap.begin() ; i != clonedMap.end() ; ++i)
+					inDestination->_AdoptValue( i->second.first);
+			}
 			inDestination->fMap.swap( clonedMap);
+		}
 	}
 	return err;
 }
@@ -1221,6 +1287,15 @@ VJSONPropertyConstOrderedIterator::VJSONPropertyConstOrderedIterator( const VJSO
 
 VJSONArray::VJSONArray()
 : fGraph( NULL)
+, fArena( NULL)
+{
+	VInterlocked::Increment( &sCount);
+}
+
+
+VJSONArray::VJSONArray( VJSONArena& inArena)
+: fGraph( NULL)
+, fArena( &inArena)
 {
 	VInterlocked::Increment( &sCount);
 }
@@ -1233,8 +1308,20 @@ VJSONArray::~VJSONArray()
 }
 
 
+sLONG VJSONArray::Retain( const char* inDebugInfo) const
+{
+	if (fArena != NULL)
+		return fArena->RetainNodes();
+
+	return IRefCountable::Retain( inDebugInfo);
+}
+
+
 sLONG VJSONArray::Release( const char* inDebugInfo) const
 {
+	if (fArena != NULL)
+		return fArena->ReleaseNodes();
+
 	if (VJSONGraph::IsPossiblyCyclic( fGraph))
 		VJSONGraph::ReleaseArrayDependenciesIfNecessary( const_cast<VJSONArray*>( this));
 
@@ -1249,7 +1336,9 @@ bool VJSONArray::Push( const VJSONValue& inValue)
 	{
 		// undefined values are legal as in JavaScript
 		fVector.push_back( inValue);
-		VJSONGraph::Connect( &fGraph, inValue);
+		_AdoptValue( inValue);
+		if (fArena == NULL)
+			VJSONGraph::Connect( &fGraph, inValue);
 	}
 	catch(...)
 	{
@@ -1263,8 +1352,11 @@ void VJSONArray::SetNth( size_t inIndex, const VJSONValue& inValue)
 {
 	if (testAssert( (inIndex > 0) && (inIndex <= fVector.size()) ))
 	{
+		_UnadoptValue( fVector[inIndex-1]);
 		fVector[inIndex-1] = inValue;
-		VJSONGraph::Connect( &fGraph, inValue);
+		_AdoptValue( inValue);
+		if (fArena == NULL)
+			VJSONGraph::Connect( &fGraph, inValue);
 	}
 }
 
@@ -1274,6 +1366,8 @@ bool VJSONArray::Resize( size_t inSize)
 	bool ok = true;
 	try
 	{
+		for( size_t i = inSize ; i < fVector.size() ; ++i)
+			_UnadoptValue( fVector[i]);
 		fVector.resize( inSize);
 	}
 	catch(...)
@@ -1286,10 +1380,206 @@ bool VJSONArray::Resize( size_t inSize)
 
 void VJSONArray::Clear()
 {
+	if (fArena != NULL)
+	{
+		for( VectorType::const_iterator i = fVector.begin() ; i != fVector.end() ; ++i)
+			_UnadoptValue( *i);
+	}
 	fVector.clear();
 }
 
 
+void VJSONArray::_AdoptValue( const VJSONValue& inValue) const
+{
+	// storing inValue retained the arena nodes: references between nodes of the same arena are not counted
+	if ( (fArena != NULL) && fArena->IsArenaNode( inValue))
+		fArena->ForgetNodeReference();
+}
+
+
+void VJSONArray::_UnadoptValue( const VJSONValue& inValue) const
+{
+	// balances the release that will occur when inValue is removed
+	if ( (fArena != NULL) && fArena->IsArenaNode( inValue))
+		fArena->RetainNodes();
+}
+
+
+//---------------------------------------------------
+
+VJSONArena::VJSONArena( VSize inChunkSize)
+: fChunkSize( (inChunkSize < 1024) ? 1024 : inChunkSize)
+, fPos( NULL)
+, fEnd( NULL)
+, fAllocatedSize( 0)
+, fNodeRefs( 0)
+, fDisposing( false)
+{
+}
+
+
+VJSONArena::~VJSONArena()
+{
+	xbox_assert( fNodeRefs == 0);
+	fDisposing = true;
+
+	// first empty all nodes while they are all alive, so that values pointing to other nodes
+	// of this arena are released (which does nothing) before any node is destroyed.
+	for( std::vector<VJSONObject*>::iterator i = fObjects.begin() ; i != fObjects.end() ; ++i)
+		(*i)->fMap.clear();
+	for( std::vector<VJSONArray*>::iterator i = fArrays.begin() ; i != fArrays.end() ; ++i)
+		(*i)->fVector.clear();
+
+	for( std::vector<VJSONObject*>::iterator i = fObjects.begin() ; i != fObjects.end() ; ++i)
+		(*i)->~VJSONObject();
+	for( std::vector<VJSONArray*>::iterator i = fArrays.begin() ; i != fArrays.end() ; ++i)
+		(*i)->~VJSONArray();
+
+	for( std::vector<char*>::iterator i = fChunks.begin() ; i != fChunks.end() ; ++i)
+		VMemory::DisposePtr( *i);
+}
+
+
+void* VJSONArena::Allocate( VSize inSize)
+{
+	inSize = (inSize + 7) & ~((VSize) 7);
+
+	if ( (fPos == NULL) || ((VSize) (fEnd - fPos) < inSize) )
+	{
+		// big blocks get their own chunk, so that the current one is not wasted
+		VSize chunkSize = (inSize > fChunkSize / 4) ? inSize : fChunkSize;
+		char *chunk = (char*) VMemory::NewPtr( chunkSize, 'jsar');
+		if (chunk == NULL)
+			return NULL;
+
+		try
+		{
+			fChunks.push_back( chunk);
+		}
+		catch(...)
+		{
+			VMemory::DisposePtr( chunk);
+			return NULL;
+		}
+		fAllocatedSize += chunkSize;
+
+		if (chunkSize != fChunkSize)
+			return chunk;
+
+		fPos = chunk;
+		fEnd = chunk + chunkSize;
+	}
+
+	void *p = fPos;
+	fPos += inSize;
+	return p;
+}
+
+
+VJSONObject* VJSONArena::NewObject()
+{
+	VJSONObject *object = NULL;
+	void *p = Allocate( sizeof( VJSONObject));
+	if (p != NULL)
+	{
+		try
+		{
+			object = new (p) VJSONObject( *this);
+			fObjects.push_back( object);
+			RetainNodes();
+		}
+		catch(...)
+		{
+			// push_back has no effect if it throws: the node is not owned by the arena
+			if (object != NULL)
+				object->~VJSONObject();
+			object = NULL;
+		}
+	}
+	return object;
+}
+
+
+VJSONArray* VJSONArena::NewArray()
+{
+	VJSONArray *array = NULL;
+	void *p = Allocate( sizeof( VJSONArray));
+	if (p != NULL)
+	{
+		try
+		{
+			array = new (p) VJSONArray( *this);
+			fArrays.push_back( array);
+			RetainNodes();
+		}
+		catch(...)
+		{
+			// push_back has no effect if it throws: the node is not owned by the arena
+			if (array != NULL)
+				array->~VJSONArray();
+			array = NULL;
+		}
+	}
+	return array;
+}
+
+
+const VString& VJSONArena::InternKey( const VString& inName)
+{
+	try
+	{
+		return fKeys.insert( unordered_map_VString<bool>::value_type( inName, true)).first->first;
+	}
+	catch(...)
+	{
+		return inName;
+	}
+}
+
+
+sLONG VJSONArena::RetainNodes() const
+{
+	if (fDisposing)
+		return 1;
+
+	sLONG count = VInterlocked::Increment( &fNodeRefs);
+	if (count == 1)
+		Retain();	// nodes keep their arena alive
+	return count;
+}
+
+
+sLONG VJSONArena::ReleaseNodes() const
+{
+	if (fDisposing)
+		return 1;
+
+	sLONG count = VInterlocked::Decrement( &fNodeRefs);
+	xbox_assert( count >= 0);
+	if (count == 0)
+		Release();
+	return count;
+}
+
+
+void VJSONArena::ForgetNodeReference() const
+{
+	if (!fDisposing)
+	{
+		// the caller holds another node reference, so it never reaches zero here
+		sLONG count = VInterlocked::Decrement( &fNodeRefs);
+		xbox_assert( count > 0);
+	}
+}
+
+
+bool VJSONArena::IsArenaNode( const VJSONValue& inValue) const
+{
+	return (inValue.IsObject() && (inValue.GetObject()->GetArena() == this))
+		|| (inValue.IsArray() && (inValue.GetArray()->GetArena() == this));
+}
+
+
 VError VJSONArray::GetString( VString& outString) const
 {
 	VError err = VE_OK;
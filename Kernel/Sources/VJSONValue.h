@@ -40,6 +40,7 @@ class VJSONArray;
 class VJSONWriter;
 class VJSONCloner;
 class VJSONGraph;
+class VJSONArena;
 class VFile;
 
 /*
@@ -277,11 +278,13 @@ class XTOOLBOX_API VJSONObject : public VObject, public IRefCountable
 	friend class VJSONPropertyConstIterator;
 	friend class VJSONPropertyConstOrderedIterator;
 	friend class VJSONWriter;
+	friend class VJSONArena;
 public:
 			// construct an empty collection optionally bound to a virtual implementation.
 									VJSONObject( IJSONObject *inImplementation = NULL);
 
-			// overriden Release() method to handle cyclic dependencies
+			// overriden Retain() and Release() methods to handle arena nodes and cyclic dependencies
+	virtual	sLONG					Retain( const char* inDebugInfo = 0) const;
 	virtual	sLONG					Release( const char* inDebugInfo = 0) const;
 
 			// gets the property named inName or returns a JSON_undefined value if property is not found.
@@ -377,6 +380,9 @@ public:
 			
 			IJSONObject*			GetImplementation() const	{ return fImpl;}
 
+			// the arena this object lives in, if it was created with VJSONArena::NewObject()
+			VJSONArena*				GetArena() const			{ return fArena;}
+
 			// to detect leaks
 	static	sLONG					GetInstancesCount()		{ return sCount;}
 
@@ -390,11 +396,17 @@ protected:
 			void					Connect( VJSONGraph** inOtherGraph);
 
 private:
+	explicit						VJSONObject( VJSONArena& inArena);
+
+			void					_AdoptValue( const VJSONValue& inValue) const;
+			void					_UnadoptValue( const VJSONValue& inValue) const;
+
 	static	sLONG					sCount;
 			typedef unordered_map_VString<std::pair<VJSONValue,size_t> >	MapType;
 			MapType					fMap;
 	mutable	VJSONGraph*				fGraph;
 			IJSONObject*			fImpl;
+			VJSONArena*				fArena;
 };
 
 
@@ -485,8 +497,10 @@ private:
 */
 class XTOOLBOX_API VJSONArray : public VObject, public IRefCountable
 {
+	friend class VJSONArena;
 public:
 									VJSONArray();
+	virtual	sLONG					Retain( const char* inDebugInfo = 0) const;
 	virtual	sLONG					Release( const char* inDebugInfo = 0) const;
 
 			const VJSONValue&		operator[]( size_t inPos) const		{ return fVector[inPos];}
@@ -518,6 +532,9 @@ public:
 
 			VJSONGraph**			GetGraph()							{ return &fGraph;}
 
+			// the arena this array lives in, if it was created with VJSONArena::NewArray()
+			VJSONArena*				GetArena() const					{ return fArena;}
+
 			// to detect leaks
 	static	sLONG					GetInstancesCount()					{ return sCount;}
 			
@@ -525,10 +542,82 @@ protected:
 	virtual							~VJSONArray();
 			
 private:
+	explicit						VJSONArray( VJSONArena& inArena);
+
+			void					_AdoptValue( const VJSONValue& inValue) const;
+			void					_UnadoptValue( const VJSONValue& inValue) const;
+
 	static	sLONG					sCount;
 			typedef std::vector<VJSONValue>	VectorType;
 			VectorType				fVector;
 	mutable	VJSONGraph*				fGraph;
+			VJSONArena*				fArena;
+};
+
+
+/*
+	VJSONArena lets you build parse-once/read-many documents with few allocations.
+	
+	Objects and arrays created with NewObject() and NewArray() are allocated in the arena memory chunks.
+	They share a single reference count: retaining or releasing any of them retains or releases the whole document,
+	and references between nodes of the same arena are not counted at all (so they don't need cycle detection).
+	When the last reference on the arena and on its nodes is released, all nodes are disposed at once
+	and the memory chunks are freed, instead of one free per node.
+	
+	Property names set on arena objects are interned: identical names share the same string buffer.
+	
+	Building a document is not thread safe. Reading it from several threads is.
+	Don't make a cycle between arena nodes and regular VJSONObject or VJSONArray (it would leak).
+	Don't modify arena objects through VJSONPropertyIterator::GetValue().
+
+	VJSONArena *arena = new VJSONArena;
+	VJSONObject *object = arena->NewObject();
+	ReleaseRefCountable( &arena);	// the document keeps the arena alive
+	object->SetProperty( CVSTR( "name"), VJSONValue( CVSTR( "john")));
+	ReleaseRefCountable( &object);	// disposes everything
+*/
+class XTOOLBOX_API VJSONArena : public VObject, public IRefCountable
+{
+public:
+	explicit						VJSONArena( VSize inChunkSize = 64 * 1024);
+
+			// new retained empty object or array living in this arena.
+			// returns NULL if memory is full.
+			VJSONObject*			NewObject();
+			VJSONArray*				NewArray();
+
+			// returns the interned copy of inName
+			const VString&			InternKey( const VString& inName);
+
+			// raw memory that lives as long as the arena (8 bytes aligned)
+			void*					Allocate( VSize inSize);
+
+			VSize					GetAllocatedSize() const			{ return fAllocatedSize;}
+			size_t					GetNodesCount() const				{ return fObjects.size() + fArrays.size();}
+
+			// node reference counting, for VJSONObject and VJSONArray
+			sLONG					RetainNodes() const;
+			sLONG					ReleaseNodes() const;
+			void					ForgetNodeReference() const;
+			bool					IsArenaNode( const VJSONValue& inValue) const;
+
+protected:
+	virtual							~VJSONArena();
+
+private:
+									VJSONArena( const VJSONArena&);				// forbidden
+			VJSONArena&				operator=( const VJSONArena&);	// forbidden
+
+			VSize					fChunkSize;
+			std::vector<char*>		fChunks;
+			char*					fPos;
+			char*					fEnd;
+			VSize					fAllocatedSize;
+			std::vector<VJSONObject*>	fObjects;
+			std::vector<VJSONArray*>	fArrays;
+			unordered_map_VString<bool>	fKeys;
+	mutable	sLONG					fNodeRefs;
+			bool					fDisposing;
 };
 
 /*
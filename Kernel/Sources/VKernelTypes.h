@@ -301,6 +301,14 @@ enum {
 	FO_Default				= FO_SequentialScan		// file must exist
 };
 
+typedef uLONG FileMapOptions;	// options for VFile::Map and VFileMapping::Advise
+enum {
+	FM_SequentialScan		= 1,	// The mapping is to be read sequentially from beginning to end
+	FM_RandomAccess			= 2,	// The mapping is to be read randomly
+	FM_WillNeed				= 4,	// The mapping will be read soon, the system may start reading it ahead
+	FM_Default				= 0
+};
+
 typedef uLONG FileCreateOptions;	// options for VFile::Create
 enum {
 	FCR_Overwrite			= 4,	// overwrite destination file
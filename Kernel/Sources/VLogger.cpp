@@ -18,6 +18,7 @@
 #include "VFile.h"
 #include "VLogger.h"
 #include "VProcess.h"
+#include "VInterlocked.h"
 
 
 
@@ -42,14 +43,21 @@ static const char *GetMessageLevelName( EMessageLevel inLevel)
 
 
 VLogger::VLogger()// const VFolder& inLogFolder, const VString& inLogName)
-: fLogName("")//inLogName)
-, fIsStarted( false)
+: fSlots(NULL)
+, fCapacity(0)
+, fEnqueuePos(0)
+, fDequeuePos(0)
+, fFullPolicy(eLoggerFull_Drop)
+, fEnqueuedCount(0)
+, fDroppedCount(0)
+, fFlushedCount(0)
 , fMessagesLost(false)
+, fLogName("")//inLogName)
 , fFilter((1<<EML_Information) | (1<<EML_Warning) | (1<<EML_Error) | (1<<EML_Fatal) | (1<<EML_Debug) | (1<<EML_Assert) /*| (1<<EML_Trace) | (1<<EML_Dump)*/)
+, fIsStarted( false)
 , fLogReaderTask(NULL)
 {
-	fStartIndex = 0;
-	fEndIndex = 0;
+	AllocateSlots( kDefaultQueueCapacity);
 	//inLogFolder.GetPath( fFolderPath);
 
 }
@@ -68,6 +76,63 @@ VLogger::~VLogger()
 
 	xbox_assert( fLogReaderTask == NULL || fLogReaderTask->GetState() == TS_DEAD);
 	ReleaseRefCountable( &fLogReaderTask);
+
+	std::vector<const VValueBag*>	valuesVector;
+	Read( valuesVector);
+	for( size_t idx = 0; idx < valuesVector.size(); idx++ )
+	{
+		valuesVector[idx]->Release();
+	}
+
+	delete [] fSlots;
+}
+
+
+void VLogger::AllocateSlots( sLONG inCapacity)
+{
+	sLONG capacity = 2;
+	while( (capacity < inCapacity) && (capacity < (1 << 24)) )
+		capacity <<= 1;
+
+	LogSlot *slots = new LogSlot[capacity];
+	for( sLONG idx = 0; idx < capacity; idx++ )
+	{
+		slots[idx].fSequence = (uLONG) idx;
+		slots[idx].fBag = NULL;
+	}
+
+	delete [] fSlots;
+	fSlots = slots;
+	fCapacity = capacity;
+	fEnqueuePos = 0;
+	fDequeuePos = 0;
+}
+
+
+bool VLogger::SetQueueCapacity( sLONG inCapacity)
+{
+	// producers don't lock anything, so the ring can only be replaced while nobody can log
+	if (fIsStarted || (fLogReaderTask != NULL) || (inCapacity <= 0))
+		return false;
+
+	fLock.Lock();
+	bool isEmpty = (fEnqueuePos == fDequeuePos);
+	if (isEmpty)
+		AllocateSlots( inCapacity);
+	fLock.Unlock();
+
+	return isEmpty;
+}
+
+
+void VLogger::GetCounters( uLONG *outEnqueued, uLONG *outDropped, uLONG *outFlushed) const
+{
+	if (outEnqueued != NULL)
+		*outEnqueued = (uLONG) VInterlocked::AtomicGet( &fEnqueuedCount);
+	if (outDropped != NULL)
+		*outDropped = (uLONG) VInterlocked::AtomicGet( &fDroppedCount);
+	if (outFlushed != NULL)
+		*outFlushed = (uLONG) VInterlocked::AtomicGet( &fFlushedCount);
 }
 
 void VLogger::Stop()
@@ -109,10 +174,15 @@ void VLogger::Flush()
 		{
 			fLogListeners[idxListener]->Put(valuesVector);
 		}
+		VInterlocked::AtomicAdd( &fFlushedCount, nbRead);
 	}
 
 	fLock.Unlock();
 
+	// wake up the producers waiting for room (eLoggerFull_Wait)
+	if (nbRead)
+		fRoomEvent.Unlock();
+
 	for( size_t idx = 0; idx < valuesVector.size(); idx++ )
 	{
 		valuesVector[idx]->Release();
@@ -185,35 +255,73 @@ bool VLogger::RemoveLogListener(ILogListener* inLogListener)
 }
 
 
-sLONG VLogger::Next(sLONG inIndex)
+bool VLogger::Push( const VValueBag *inMessage)
 {
-	sLONG	nextIndex = inIndex + 1;
-	if (nextIndex >= K_NB_MAX_BAGS)
+	uLONG mask = (uLONG) fCapacity - 1;
+
+	for(;;)
 	{
-		nextIndex = 0;
+		// positions are unsigned so that they wrap around without overflow
+		uLONG pos = (uLONG) VInterlocked::AtomicGet( (sLONG*) &fEnqueuePos);
+		LogSlot *slot = &fSlots[pos & mask];
+		sLONG diff = (sLONG) ((uLONG) VInterlocked::AtomicGet( (sLONG*) &slot->fSequence) - pos);
+
+		if (diff == 0)
+		{
+			// the slot is free for this position, try to claim it
+			if ((uLONG) VInterlocked::CompareExchange( (sLONG*) &fEnqueuePos, (sLONG) pos, (sLONG) (pos + 1)) == pos)
+			{
+				slot->fBag = inMessage;
+				VInterlocked::Exchange( (sLONG*) &slot->fSequence, (sLONG) (pos + 1));	// publish to the reader
+				return true;
+			}
+		}
+		else if (diff < 0)
+		{
+			// the reader has not consumed this slot yet: the queue is full
+			return false;
+		}
+		// else another producer claimed the position: retry
 	}
-	return nextIndex;
 }
 
+
 void VLogger::LogBag( const VValueBag *inMessage)
 {
 	if ( ShouldLog(ILoggerBagKeys::level.Get(inMessage)) )
 	{
-		fLock.Lock();
-		sLONG	nextIndex = Next(fEndIndex);
+		inMessage->Retain();
 
-		if (nextIndex == fStartIndex)
+		bool pushed = Push( inMessage);
+		while (!pushed && (fFullPolicy == eLoggerFull_Wait))
 		{
-			fMessagesLost = true;
+			// backpressure: wake up the reader and wait for it, unless it cannot make room
+			VTask *reader = fLogReaderTask;
+			if ( (reader == NULL) || reader->IsCurrent() || reader->IsDying() || (reader->GetState() == TS_DEAD) )
+				break;
+
+			// the event is reset before trying again so that slots freed meanwhile are not missed.
+			// Another producer may reset it after the reader signaled it, hence the time-out.
+			fRoomEvent.Reset();
+			pushed = Push( inMessage);
+			if (!pushed)
+			{
+				reader->WakeUp();
+				fRoomEvent.Lock( 100);
+				pushed = Push( inMessage);
+			}
+		}
+
+		if (pushed)
+		{
+			VInterlocked::Increment( &fEnqueuedCount);
 		}
 		else
 		{
-			inMessage->Retain();
-			fValues[fEndIndex] = inMessage;
-			fEndIndex = nextIndex;
+			fMessagesLost = true;
+			VInterlocked::Increment( &fDroppedCount);
+			inMessage->Release();
 		}
-
-		fLock.Unlock();
 	}
 }
 
@@ -293,37 +401,35 @@ bool VLogger::WithTag(uLONG inTag, bool inFlag)
 
 sLONG VLogger::Read(std::vector<const VValueBag*>& ioValuesVector,bool inAlreadyLocked )
 {
+	// single consumer: fDequeuePos is protected by fLock
 	sLONG	nbRead = 0;
+	uLONG	mask = (uLONG) fCapacity - 1;
 	ioValuesVector.clear();
-	if (fStartIndex != fEndIndex)
+
+	if (!inAlreadyLocked)
 	{
-		if (!inAlreadyLocked)
-		{
-			fLock.Lock();
-		}
-		nbRead = fEndIndex - fStartIndex;
-		if (nbRead < 0)
-		{
-			nbRead += K_NB_MAX_BAGS;
-		}
-		/*if (inSize < nbRead)
-		{
-			nbRead = inSize;
-		}*/
-		sLONG curtIndex = fStartIndex;
-		for( sLONG idx = 0; idx < nbRead; idx++ )
-		{
-			ioValuesVector.push_back(fValues[curtIndex]);
-			fValues[curtIndex] = NULL;
-			curtIndex = Next(curtIndex);
-		}
-		fStartIndex = curtIndex;
-		if (!inAlreadyLocked)
-		{
-			fLock.Unlock();
-		}
+		fLock.Lock();
+	}
+
+	for(;;)
+	{
+		LogSlot *slot = &fSlots[fDequeuePos & mask];
+		sLONG diff = (sLONG) ((uLONG) VInterlocked::AtomicGet( (sLONG*) &slot->fSequence) - (fDequeuePos + 1));
+		if (diff < 0)
+			break;	// empty, or the producer of this slot has not published yet
+
+		xbox_assert( diff == 0);
+		ioValuesVector.push_back( slot->fBag);
+		slot->fBag = NULL;
+		VInterlocked::Exchange( (sLONG*) &slot->fSequence, (sLONG) (fDequeuePos + (uLONG) fCapacity));	// free the slot for next round
+		++fDequeuePos;
+		++nbRead;
+	}
+
+	if (!inAlreadyLocked)
+	{
+		fLock.Unlock();
 	}
 
 	return nbRead;
 }
-
@@ -53,6 +53,15 @@ public:
 
 	enum { kLoggerTaskKind = 'LOGG' };
 
+	/** @brief	What LogBag() does when the message queue is full. */
+	typedef enum
+	{
+		eLoggerFull_Drop = 0,		// the message is dropped and counted (default)
+		eLoggerFull_Wait			// the calling task waits for the logger task to make room (never the logger task itself)
+	} ELoggerFullPolicy;
+
+	enum { kDefaultQueueCapacity = 1024 };
+
 			VLogger();// const VFolder& inLogFolder, const VString& inLogName);
 	virtual ~VLogger();
 
@@ -94,13 +103,39 @@ public:
 			bool					AddLogListener(ILogListener* inLogListener);
 			bool					RemoveLogListener(ILogListener* inLogListener);
 
+			/** @brief	Message queue capacity, rounded up to a power of 2. Can only be changed before Start(). */
+			bool					SetQueueCapacity( sLONG inCapacity);
+			sLONG					GetQueueCapacity() const				{ return fCapacity;}
+
+			void					SetFullQueuePolicy( ELoggerFullPolicy inPolicy)	{ fFullPolicy = inPolicy;}
+			ELoggerFullPolicy		GetFullQueuePolicy() const				{ return fFullPolicy;}
+
+			/** @brief	Counts of messages queued, dropped because the queue was full, and handed to listeners. */
+			void					GetCounters( uLONG *outEnqueued, uLONG *outDropped, uLONG *outFlushed) const;
+
 private:
 			bool					WithTag(uLONG inTag, bool inFlag);
 
-	#define K_NB_MAX_BAGS			(1000)
-			const VValueBag*		fValues[K_NB_MAX_BAGS];
-			sLONG					fStartIndex;	
-			sLONG					fEndIndex;
+			// Bounded multi-producers / single consumer ring : LogBag() never takes a lock.
+			// Each slot carries a sequence number telling whether it is free for position n (sequence == n)
+			// or holds the message of position n (sequence == n+1).
+			// Positions wrap around, the capacity being a power of 2 the slot index stays consistent.
+			typedef struct
+			{
+				uLONG				fSequence;
+				const VValueBag*	fBag;
+			} LogSlot;
+
+			LogSlot*				fSlots;
+			sLONG					fCapacity;
+			uLONG					fEnqueuePos;	// shared by producers
+			uLONG					fDequeuePos;	// consumer only (under fLock)
+			ELoggerFullPolicy		fFullPolicy;
+	mutable	sLONG					fEnqueuedCount;
+	mutable	sLONG					fDroppedCount;
+	mutable	sLONG					fFlushedCount;
+			VSyncEvent				fRoomEvent;		// signaled by the reader when it has freed slots
+
 	mutable	VCriticalSection		fLock;
 			bool					fMessagesLost;
 			VFilePath				fFolderPath;
@@ -111,7 +146,8 @@ private:
 
 			sLONG					Read(std::vector<const VValueBag*>& ioValuesVector, bool inAlreadyLocked = false);
 
-			sLONG					Next(sLONG inIndex);
+			bool					Push( const VValueBag *inMessage);
+			void					AllocateSlots( sLONG inCapacity);
 
 			std::vector<ILogListener*>		fLogListeners;
 	static	sLONG				LogReaderTaskProc(XBOX::VTask* inTask);
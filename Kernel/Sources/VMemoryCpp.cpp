@@ -344,6 +344,8 @@ void VCppMemMgr::_Init( EAllocatorKind inKind, bool inWithDebugInfo, bool inWith
 	fWaitBeforeNewPtrStarter = 0;
 	fPurgeProc = NULL;
 	fDebugCheck = 0;
+	fTaskCacheKey = 0;
+	fFirstTaskCache = NULL;
 	fInfoFirstFree = NULL;
 
 	EAllocatorKind kind;
@@ -434,6 +436,10 @@ VCppMemMgr::~VCppMemMgr()
 	}
 	else
 	{
+		// remaining task caches are leaked, their blocks belong to the allocations released below
+		if (fTaskCacheKey != 0)
+			VTask::DeleteDataKey( fTaskCacheKey);
+
 		for (memarray::iterator cur = fMems.begin(), end = fMems.end(); cur != end; cur++)
 			delete *cur;
 	}
@@ -471,10 +477,134 @@ void* VCppMemMgr::TryToMalloc(VSize inNbBytes, bool inIsVObject, sLONG inTag, sL
 }
 
 
+VMemTaskCache* VCppMemMgr::_GetTaskCache()
+{
+	// only VTask have a cache, and only once the task manager is running
+	VTask* task = VTask::GetCurrent();
+	if (task == NULL)
+		return NULL;
+
+	// the key is published with a barrier so that it's never seen before it's valid
+	size_t key = (size_t) VInterlocked::CompareExchangePtr( (void**) &fTaskCacheKey, NULL, NULL);
+	if (key == 0)
+	{
+		VKernelTaskLock lock(&fMgrMutex);
+		key = fTaskCacheKey;
+		if (key == 0)
+		{
+			key = VTask::CreateDataKey( _DisposeTaskCache);
+			VInterlocked::ExchangeVoidPtr( (void**) &fTaskCacheKey, (void*) key);
+		}
+	}
+
+	VMemTaskCache* cache = (VMemTaskCache*) VTask::GetCurrentData( key);
+	if (cache == NULL && !task->IsDying())
+	{
+		// A dying task may have disposed its cache already and would never dispose a new one.
+		// The cache itself must not come from this allocator
+		void* p = ::malloc( sizeof(VMemTaskCache));
+		if (p != NULL)
+		{
+			cache = new (p) VMemTaskCache( this);
+			{
+				VKernelTaskLock lock(&fMgrMutex);
+				cache->Link( &fFirstTaskCache);
+			}
+			VTask::SetCurrentData( key, cache);
+		}
+	}
+
+	return cache;
+}
+
+
+void VCppMemMgr::_RefillTaskCache( VMemTaskCache* inCache, sLONG inStep, VSize inNbBytes)
+{
+	// take a batch of blocks of the same size at once, half the cache capacity
+	sLONG count = inCache->GetMaxCount( inStep) / 2 - inCache->GetCount( inStep);
+	for (sLONG i = 0; i < count; i++)
+	{
+		void* block = TryToMalloc( inNbBytes, false, 0, -1);
+		if (block == NULL)
+			break;
+		xbox_assert( VMemCppImpl::IsSmallBlock( block) && VMemTaskCache::GetStepFromBlock( block) == inStep);
+		inCache->Push( inStep, (VMemImplSmallBlock*) ( ((char*)block) - VMemThreadImpl::SizeSmallHeader ));
+	}
+}
+
+
+void VCppMemMgr::_DrainTaskCache( VMemTaskCache* inCache, sLONG inStep, sLONG inCount)
+{
+	for (sLONG i = 0; i < inCount; i++)
+	{
+		VMemImplSmallBlock* x = inCache->Pop( inStep);
+		if (x == NULL)
+			break;
+		// VMemCppImpl::Free forwards the block to the VMemCppImpl owning its page
+		fMems[0]->Free( ((char*)x) + VMemThreadImpl::SizeSmallHeader);
+	}
+}
+
+
+void VCppMemMgr::_FlushTaskCache( VMemTaskCache* inCache)
+{
+	VKernelTaskLock lock(&fMgrMutex);
+
+	// the owning task may be using the cache without lock
+	inCache->Lock();
+	for (sLONG i = 0; i < kTotalStepAllocPagesInThread; i++)
+		_DrainTaskCache( inCache, i, inCache->GetCount( i));
+	inCache->Unlock();
+}
+
+
+void VCppMemMgr::_FlushAllTaskCaches()
+{
+	VKernelTaskLock lock(&fMgrMutex);
+
+	for (VMemTaskCache* cache = fFirstTaskCache; cache != NULL; cache = cache->GetNext())
+		_FlushTaskCache( cache);
+}
+
+
+void VCppMemMgr::_DisposeTaskCache( void* inData)
+{
+	// called when the task dies
+	VMemTaskCache* cache = (VMemTaskCache*) inData;
+	VCppMemMgr* owner = cache->GetOwner();
+
+	// the dispose procs of the other task data run after this one and may still free memory
+	if (VTask::GetCurrentData( owner->fTaskCacheKey) == cache)
+		VTask::SetCurrentData( owner->fTaskCacheKey, NULL);
+	{
+		VKernelTaskLock lock(&owner->fMgrMutex);
+		owner->_FlushTaskCache( cache);
+		cache->Unlink( &owner->fFirstTaskCache);
+	}
+	cache->~VMemTaskCache();
+	::free( cache);
+}
+
+
+void VCppMemMgr::FlushTaskCache()
+{
+	size_t key = (size_t) VInterlocked::CompareExchangePtr( (void**) &fTaskCacheKey, NULL, NULL);
+	if (!fUseStdLibMgr && key != 0 && VTask::GetCurrent() != NULL)
+	{
+		VMemTaskCache* cache = (VMemTaskCache*) VTask::GetCurrentData( key);
+		if (cache != NULL)
+			_FlushTaskCache( cache);
+	}
+}
+
+
 void VCppMemMgr::PurgeMem(sLONG whatBlock)
 {
 	if (!fUseStdLibMgr)
 	{
+		// the blocks cached by all tasks, not only the current one
+		_FlushAllTaskCaches();
+
 		fMgrMutex.Lock();
 
 		sLONG curmem = whatBlock;
@@ -532,6 +662,21 @@ void* VCppMemMgr::Malloc(VSize inNbBytes, bool inIsVObject, sLONG inTag, sLONG p
 		result = fStdMemMgr->Malloc(inNbBytes, false, inIsVObject, inTag);
 	else
 	{
+		// small blocks are first looked for in current task cache, without locking
+		VMemTaskCache* cache = NULL;
+		sLONG step = -1;
+		if (inNbBytes < kThirdStepAlloc && preferedBlock < 0 && !fWithDebugInfo && !fWithStrangeFill)
+		{
+			cache = _GetTaskCache();
+			if (cache != NULL)
+			{
+				step = VMemTaskCache::GetStepFromSize(inNbBytes);
+				result = cache->Malloc(step, inIsVObject, inTag);
+				if (result != NULL)
+					return result;
+			}
+		}
+
 		fMgrMutex.Lock();
 
 		Check();
@@ -598,6 +743,10 @@ void* VCppMemMgr::Malloc(VSize inNbBytes, bool inIsVObject, sLONG inTag, sLONG p
 				}
 			}
 		} while (result == NULL && fCurrentMem != startmem);
+
+		if (result != NULL && cache != NULL)
+			_RefillTaskCache(cache, step, size);
+
 		fMgrMutex.Unlock();
 	}
 
@@ -875,30 +1024,46 @@ void VCppMemMgr::Free(void* ioPtr)
 		fStdMemMgr->Free(ioPtr);
 	else
 	{
-		VKernelTaskLock lock(&fMgrMutex);
-		Check();
+		// small blocks go to current task cache, without locking, whatever the task that allocated them
+		// (but blocks of another VCppMemMgr must go back to their own pages)
+		VMemTaskCache* cache = NULL;
+		if (ioPtr != NULL && !fWithDebugInfo && !fWithStrangeFill && VMemCppImpl::IsSmallBlock(ioPtr) && VMemCppImpl::GetSmallBlockMemMgr(ioPtr) == this)
+			cache = _GetTaskCache();
 
-		if (ioPtr != NULL)
+		if (cache == NULL || !cache->Free(ioPtr))
 		{
-			if (CheckPtr(ioPtr))
+			VKernelTaskLock lock(&fMgrMutex);
+			Check();
+
+			// cache is full for that size, give half of it back to the pages
+			if (cache != NULL)
 			{
-			#if VERSIONDEBUG
-				XMemCppImpl* memimpl = GetMemMgrImpl();
-				if (fWithDebugInfo)
-				{
-					DebugBlockHeader *block = reinterpret_cast<DebugBlockHeader*>(ioPtr) - 1;
-					UnregisterBlock(block);
-					if (fWithStrangeFill)
-						::memset(block, 0x42, memimpl->GetPtrSize(block));
-					memimpl->Free(block);
-				}
-				else if (fWithStrangeFill)
+				sLONG step = VMemTaskCache::GetStepFromBlock(ioPtr);
+				_DrainTaskCache(cache, step, cache->GetMaxCount(step) / 2);
+			}
+
+			if (ioPtr != NULL)
+			{
+				if (CheckPtr(ioPtr))
 				{
-					::memset(ioPtr, 0x42, memimpl->GetPtrSize(ioPtr));
-				}
-			#endif
+				#if VERSIONDEBUG
+					XMemCppImpl* memimpl = GetMemMgrImpl();
+					if (fWithDebugInfo)
+					{
+						DebugBlockHeader *block = reinterpret_cast<DebugBlockHeader*>(ioPtr) - 1;
+						UnregisterBlock(block);
+						if (fWithStrangeFill)
+							::memset(block, 0x42, memimpl->GetPtrSize(block));
+						memimpl->Free(block);
+					}
+					else if (fWithStrangeFill)
+					{
+						::memset(ioPtr, 0x42, memimpl->GetPtrSize(ioPtr));
+					}
+				#endif
 
-				fMems[0]->Free(ioPtr);
+					fMems[0]->Free(ioPtr);
+				}
 			}
 		}
 	}
@@ -55,6 +55,7 @@ class XTOOLBOX_API VMemoryHog
 class IMemoryWalker;
 class VArrayLong;
 class VCppMemMgr;
+class VMemTaskCache;
 
 // Class definitions
 typedef VSize (*PurgeHandlerProc) (sLONG allocationBlockNumber, VSize inNeededBytes, bool withFlush);
@@ -302,11 +303,22 @@ public:
 
 			void PurgeMem(sLONG whatBlock = -1);
 
+			// give back to the shared pages the small blocks cached by current task (see VMemTaskCache)
+			void FlushTaskCache();
+
 
 private:
 			void	_Init( EAllocatorKind inKind, bool inWithDebugInfo, bool inWithStrangeFill);
 			void*	TryToMalloc( VSize inNbBytes, bool inIsVObject, sLONG inTag, sLONG preferedBlock);
 
+	// Per task small blocks cache support (fMgrMutex must be held for refill and drain)
+			VMemTaskCache*	_GetTaskCache();
+			void	_RefillTaskCache( VMemTaskCache* inCache, sLONG inStep, VSize inNbBytes);
+			void	_DrainTaskCache( VMemTaskCache* inCache, sLONG inStep, sLONG inCount);
+			void	_FlushTaskCache( VMemTaskCache* inCache);
+			void	_FlushAllTaskCaches();
+	static	void	_DisposeTaskCache( void* inData);
+
 			//XMemCppImpl*					fMemMgr;
 			VKernelCriticalSection			fMgrMutex;
 			XMemCppImpl*					fStdMemMgr;
@@ -334,6 +346,8 @@ private:
 			VCriticalSection				fWaitBeforeNewPtrMutex;
 			sLONG							fWaitBeforeNewPtrStarter;
 			VStackOfMemHogs					fMemHogsStack;
+			size_t							fTaskCacheKey;		// VTaskDataKey, created on first use, accessed with VInterlocked
+			VMemTaskCache*					fFirstTaskCache;	// chain of all task caches, under fMgrMutex
 
 	// Private allocation support
 			void	RegisterBlock( DebugBlockHeader* inAddr, VSize inUserSize, bool inIsVObject);
@@ -656,6 +656,148 @@ Boolean VMemThreadImpl::Check(void* skipthisone)
 
 
 
+/* --------------------------------------------------- */
+
+VMemTaskCache::VMemTaskCache(VCppMemMgr* inOwner)
+{
+	fOwner = inOwner;
+	fNext = NULL;
+	fPrevious = NULL;
+	fBusy = 0;
+
+	sLONG i;
+	for (i = 0; i < kTotalStepAllocPagesInThread; i++)
+	{
+		fFirstFree[i] = NULL;
+		fCounts[i] = 0;
+	}
+}
+
+
+sLONG VMemTaskCache::GetMaxCount(sLONG inStep) const
+{
+	// keep about the same amount of memory in cache whatever the block size
+
+	sLONG maxcount;
+	sLONG elemsize;
+
+	if (inStep < VMemThreadImpl::stage2)
+		elemsize = inStep * kFirstStepAllocInc;
+	else if (inStep < VMemThreadImpl::stage3)
+		elemsize = kFirstStepAlloc + (inStep - VMemThreadImpl::stage2) * kSecondStepAllocInc;
+	else
+		elemsize = kSecondStepAlloc + (inStep - VMemThreadImpl::stage3) * kThirdStepAllocInc;
+
+	if (elemsize <= 0)
+		return kMaxCachedBlocksPerStep;
+
+	maxcount = kMaxCachedBytesPerStep / elemsize;
+	if (maxcount > kMaxCachedBlocksPerStep)
+		maxcount = kMaxCachedBlocksPerStep;
+	else if (maxcount < kMinCachedBlocksPerStep)
+		maxcount = kMinCachedBlocksPerStep;
+
+	return maxcount;
+}
+
+
+sLONG VMemTaskCache::GetStepFromBlock(const void* inBlock)
+{
+	VMemImplSmallBlock *xsmall = (VMemImplSmallBlock*) ( ((char*)inBlock) - VMemThreadImpl::SizeSmallHeader );
+	VPageAllocationImpl* page = VMemCppImpl::GetSmallBlockPage(xsmall);
+
+	return VMemThreadImpl::GetStepFromSize(page->GetElemSize() - VMemThreadImpl::SizeSmallHeader, NULL);
+}
+
+
+void VMemTaskCache::Push(sLONG inStep, VMemImplSmallBlock* inBlock)
+{
+	inBlock->SetNext(fFirstFree[inStep]);
+	fFirstFree[inStep] = inBlock;
+	fCounts[inStep]++;
+}
+
+
+VMemImplSmallBlock* VMemTaskCache::Pop(sLONG inStep)
+{
+	VMemImplSmallBlock* x = fFirstFree[inStep];
+	if (x != NULL)
+	{
+		fFirstFree[inStep] = x->GetNext();
+		fCounts[inStep]--;
+	}
+	return x;
+}
+
+
+void VMemTaskCache::Lock()
+{
+	// the owning task never waits while holding the flag
+	while (!TryLock())
+		VTask::YieldNow();
+}
+
+
+void VMemTaskCache::Link(VMemTaskCache** ioFirst)
+{
+	fPrevious = NULL;
+	fNext = *ioFirst;
+	if (fNext != NULL)
+		fNext->fPrevious = this;
+	*ioFirst = this;
+}
+
+
+void VMemTaskCache::Unlink(VMemTaskCache** ioFirst)
+{
+	if (fPrevious != NULL)
+		fPrevious->fNext = fNext;
+	else
+		*ioFirst = fNext;
+	if (fNext != NULL)
+		fNext->fPrevious = fPrevious;
+	fNext = NULL;
+	fPrevious = NULL;
+}
+
+
+void* VMemTaskCache::Malloc(sLONG inStep, Boolean isAnObject, sLONG inTag)
+{
+	if (!TryLock())
+		return NULL;
+
+	VMemImplSmallBlock* x = Pop(inStep);
+	Unlock();
+	if (x == NULL)
+		return NULL;
+
+	// on remet le meme offset en changeant simplement le dernier bit (voir VPageAllocationImpl::Malloc)
+	sLONG offset = x->GetOffset(); 
+	offset = (-offset) & -2;
+	sLONG plus = isAnObject ? 1 : 0;
+	x->SetOffset(-(offset + plus));
+#if CPPMEM_CACHE_INFO
+	x->SetTag(inTag);
+#endif
+	return (void*) (((char*)x) + VMemThreadImpl::SizeSmallHeader);
+}
+
+
+bool VMemTaskCache::Free(void* inBlock)
+{
+	sLONG step = GetStepFromBlock(inBlock);
+	if (!TryLock())
+		return false;
+
+	bool ok = fCounts[step] < GetMaxCount(step);
+	if (ok)
+		Push(step, (VMemImplSmallBlock*) ( ((char*)inBlock) - VMemThreadImpl::SizeSmallHeader ));
+	Unlock();
+	return ok;
+}
+
+
+
 /* --------------------------------------------------- */
 
 VMemCppImpl::VMemCppImpl(sLONG inBlockNumber)
@@ -1117,6 +1259,22 @@ VSize VMemCppImpl::GetPtrSize( const void *inBlock)
 }
 
 
+VPageAllocationImpl* VMemCppImpl::GetSmallBlockPage(const VMemImplSmallBlock *inBlock)
+{
+	// offset is negative and its lower bit tells if the block is an object
+	sLONG offset = inBlock->GetOffset();
+	offset = (-offset) & -2;
+	return (VPageAllocationImpl*) (((char*)inBlock)-offset);
+}
+
+
+VCppMemMgr* VMemCppImpl::GetSmallBlockMemMgr(const void *inBlock)
+{
+	VMemImplSmallBlock *xsmall = (VMemImplSmallBlock*) ( ((char*)inBlock) - VMemThreadImpl::SizeSmallHeader );
+	return GetSmallBlockPage(xsmall)->GetOwner()->GetOwner()->fOwner;
+}
+
+
 sLONG VMemCppImpl::GetAllocationBlockNumber(void *inBlock)
 {
 	assert(inBlock != NULL);
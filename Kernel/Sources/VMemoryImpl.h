@@ -258,13 +258,74 @@ public:
 
 	Boolean	Check (void* skipthisone = NULL);
 
+	static	sLONG	GetStepFromSize (VSize inSize, sLONG* outStepInc);
+
 private:
 	VMemCppImpl*	fOwner;
 	//VKernelCriticalSection	fMutex;
 	//VPageAllocationImpl*	fPages[kTotalStepAllocPagesInThread];
 	VPageAllocationImpl*	fNotFullPages[kTotalStepAllocPagesInThread];
-	
-	sLONG	GetStepFromSize (VSize inSize, sLONG* outStepInc);
+};
+
+
+
+/*
+	Per task cache of small blocks, one per VTask and VCppMemMgr.
+
+	Blocks are taken from VPageAllocationImpl pages in batches while holding the VCppMemMgr mutex, then handed out
+	and taken back by the owning task without any lock. From the pages point of view, cached blocks are allocated.
+	A block freed by another task than the one which allocated it simply goes to the cache of the freeing task.
+	When the cache for a size is full, half of it is given back to the pages (see VCppMemMgr::Free).
+
+	All caches of a VCppMemMgr are chained so that a purge can empty them. The lock free accesses of the owning task
+	are guarded by a spin flag that the purge takes while it holds the VCppMemMgr mutex: if the flag is taken,
+	the owning task simply goes through the locked path.
+*/
+class VMemTaskCache
+{
+public:
+	enum {
+		kMaxCachedBytesPerStep = 16384,
+		kMaxCachedBlocksPerStep = 64,
+		kMinCachedBlocksPerStep = 4
+	};
+
+	VMemTaskCache (VCppMemMgr* inOwner);
+
+	VCppMemMgr*	GetOwner () const { return fOwner; };
+
+	// Lock free, return NULL if nothing is cached for that size or if the cache is being flushed
+	void*	Malloc (sLONG inStep, Boolean isAnObject, sLONG inTag);
+
+	// Lock free, return false if cache for that block size is full or if the cache is being flushed
+	bool	Free (void* inBlock);
+
+	// Spin flag guarding the lock free accesses, held for a few instructions only
+	bool	TryLock () { return VInterlocked::CompareExchange(&fBusy, 0, 1) == 0; };
+	void	Lock ();
+	void	Unlock () { VInterlocked::Exchange(&fBusy, 0); };
+
+	// Chain of the caches of a VCppMemMgr, under its mutex
+	VMemTaskCache*	GetNext () const { return fNext; };
+	void	Link (VMemTaskCache** ioFirst);
+	void	Unlink (VMemTaskCache** ioFirst);
+
+	void	Push (sLONG inStep, VMemImplSmallBlock* inBlock);
+	VMemImplSmallBlock*	Pop (sLONG inStep);
+
+	sLONG	GetCount (sLONG inStep) const { return fCounts[inStep]; };
+	sLONG	GetMaxCount (sLONG inStep) const;
+
+	static	sLONG	GetStepFromSize (VSize inSize) { return VMemThreadImpl::GetStepFromSize(inSize + VMemThreadImpl::SizeSmallHeader, NULL); };
+	static	sLONG	GetStepFromBlock (const void* inBlock);
+
+private:
+	VCppMemMgr*	fOwner;
+	VMemTaskCache*	fNext;
+	VMemTaskCache*	fPrevious;
+	sLONG	fBusy;
+	VMemImplSmallBlock*	fFirstFree[kTotalStepAllocPagesInThread];
+	sLONG	fCounts[kTotalStepAllocPagesInThread];
 };
 
 
@@ -336,6 +397,11 @@ public:
 
 	sLONG GetAllocationBlockNumber(void *inBlock);
 
+	// Small blocks are allocated in VPageAllocationImpl pages (see VMemThreadImpl)
+	static bool IsSmallBlock (const void *inBlock) { return ((const VMemImplBlock*) ( ((const char*)inBlock) - SizeHeader ))->IsASmallBlock(); };
+	static VPageAllocationImpl* GetSmallBlockPage (const VMemImplSmallBlock *inBlock);
+	static VCppMemMgr* GetSmallBlockMemMgr (const void *inBlock);
+
 
 private:
 	//VKernelCriticalSection	fMutex;
@@ -66,6 +66,7 @@ VMessage::VMessage()
 , fIsAnswered( false)
 , fIsAborted( false)
 , fContext( NULL)
+, fNextQueued( NULL)
 {
 }
 
@@ -514,6 +515,8 @@ bool VMessage::DoCoalesce(const VMessage& /*inNewMessage*/)
 
 
 VMessageQueue::VMessageQueue()
+: fInbox( NULL)
+, fCount( 0)
 {
 	fCriticalSection = new VCriticalSection;
 	fEvent = new VSyncEvent;
@@ -522,15 +525,80 @@ VMessageQueue::VMessageQueue()
 
 VMessageQueue::~VMessageQueue()
 {
+	_DrainInbox();
 	fMessageBox.clear();
 	delete fCriticalSection;
 	ReleaseRefCountable( &fEvent);
 }
 
 
+void VMessageQueue::_DrainInbox() const
+{
+	// must be called under fCriticalSection
+	VMessage *list = VInterlocked::ExchangePtr( &fInbox);
+	if (list == NULL)
+		return;
+
+	// the inbox is LIFO
+	VMessage *reversed = NULL;
+	while( list != NULL)
+	{
+		VMessage *next = list->fNextQueued;
+		list->fNextQueued = reversed;
+		reversed = list;
+		list = next;
+	}
+
+	// the inbox reference is given to fMessageBox
+	while( reversed != NULL)
+	{
+		VMessage *msg = reversed;
+		reversed = msg->fNextQueued;
+		msg->fNextQueued = NULL;
+		try
+		{
+			fMessageBox.push_back( VRefPtr<VMessage>( msg, false));
+		}
+		catch(...)
+		{
+			msg->Abort();
+			msg->Release();
+			VInterlocked::Decrement( &fCount);
+		}
+	}
+}
+
+
+// VInterlocked::AtomicAdd returns the previous value on Windows and Linux but the new one on Mac.
+static sLONG _AtomicAddAndFetch( sLONG *ioValue, sLONG inAddValue)
+{
+	sLONG value;
+	do
+	{
+		value = *ioValue;
+	} while( VInterlocked::CompareExchange( ioValue, value, value + inAddValue) != value);
+
+	return value + inAddValue;
+}
+
+
+void VMessageQueue::_MessagesRemoved( sLONG inCount)
+{
+	if ( (inCount > 0) && (_AtomicAddAndFetch( &fCount, -inCount) == 0) )
+	{
+		fEvent->Reset();
+
+		// a message may have been posted between the decrement and the reset
+		if (VInterlocked::AtomicGet( &fCount) > 0)
+			fEvent->Unlock();
+	}
+}
+
+
 bool VMessageQueue::AddMessage( VMessage* inMessage)
 {
 	xbox_assert(!inMessage->Answered() /* on envoie un msg deja valide ??? */);
+	xbox_assert(inMessage->fNextQueued == NULL);
 
 	// process special messages
 	bool isOK = true;
@@ -540,6 +608,8 @@ bool VMessageQueue::AddMessage( VMessage* inMessage)
 	{
 		VTaskLock lock( fCriticalSection);
 		
+		_DrainInbox();
+
 		DequeOfVMessage::iterator i = fMessageBox.begin();
 		for(  ; (i != fMessageBox.end()) && ((*i)->GetCoalescingSignature() != signature) ; ++i)
 			;
@@ -550,24 +620,42 @@ bool VMessageQueue::AddMessage( VMessage* inMessage)
 			// warning: called from inside the task lock! (to avoid Getting this message while processing it)
 			isOK = tocoalesce->DoCoalesce( *inMessage);
 		}
-	}
-
-	// push it
-	if (isOK)
-	{
-		VTaskLock lock( fCriticalSection);
 
-		try
+		// push it behind the inbox messages just drained
+		if (isOK)
 		{
-			// optim: if the message box was not empty, no need to set the event because it should be already set.
-			if (fMessageBox.empty())
+			try
+			{
+				fMessageBox.push_back( inMessage);
+			}
+			catch(...)
+			{
+				isOK = false;
+			}
+
+			if (isOK && (VInterlocked::Increment( &fCount) == 1))
 				fEvent->Unlock();
-			fMessageBox.push_back( inMessage);
 		}
-		catch(...)
+	}
+	else
+	{
+		// count it first so that the reading side never counts it twice
+		bool wasEmpty = (VInterlocked::Increment( &fCount) == 1);
+
+		inMessage->Retain();
+		VMessage *head = fInbox;
+		for(;;)
 		{
-			isOK = false;
+			inMessage->fNextQueued = head;
+			VMessage *previous = (VMessage*) VInterlocked::CompareExchangePtr( (void**) &fInbox, head, inMessage);
+			if (previous == head)
+				break;
+			head = previous;
 		}
+
+		// optim: if the queue was not empty, no need to set the event because it should be already set.
+		if (wasEmpty)
+			fEvent->Unlock();
 	}
 	
 	return isOK;
@@ -580,8 +668,7 @@ VMessage* VMessageQueue::_RetainFrontMessage()
 	fMessageBox.pop_front();
 	XBOX_ASSERT_VOBJECT( msg);
 	xbox_assert(!msg->Answered() /* on envoie un msg deja executed ??? */);
-	if (fMessageBox.empty())
-		fEvent->Reset();
+	_MessagesRemoved( 1);
 	
 	return msg;
 }
@@ -589,8 +676,14 @@ VMessage* VMessageQueue::_RetainFrontMessage()
 
 VMessage* VMessageQueue::RetainMessage()
 {
+	if (VInterlocked::AtomicGet( &fCount) <= 0)
+		return NULL;
+
 	VTaskLock lock( fCriticalSection);
 
+	if (fMessageBox.empty())
+		_DrainInbox();
+
 	return fMessageBox.empty() ? NULL : _RetainFrontMessage();
 }
 
@@ -602,11 +695,16 @@ VMessage* VMessageQueue::RetainMessageWithTimeout( sLONG inTimeoutMilliseconds)
 	
 	VTaskLock lock( fCriticalSection);
 
+	if (fMessageBox.empty())
+		_DrainInbox();
+
 	VMessage *msg;
 	if (fMessageBox.empty())
 	{
 		// the event was triggered from the outside, we must reset here ourselves
 		fEvent->Reset();
+		if (VInterlocked::AtomicGet( &fCount) > 0)
+			fEvent->Unlock();
 		msg = NULL;
 	}
 	else
@@ -617,19 +715,83 @@ VMessage* VMessageQueue::RetainMessageWithTimeout( sLONG inTimeoutMilliseconds)
 }
 
 
-void VMessageQueue::CancelMessages( IMessageable* inTarget)
+sLONG VMessageQueue::RetainMessages( std::vector<VMessage*>& outMessages, sLONG inMaxCount)
 {
+	if ( (inMaxCount <= 0) || (VInterlocked::AtomicGet( &fCount) <= 0) )
+		return 0;
+
 	VTaskLock lock( fCriticalSection);
 
-	DequeOfVMessage::iterator i = std::remove_if( fMessageBox.begin(), fMessageBox.end(), IMessageableCompareTarget( inTarget));
-	
-	for( ; i != fMessageBox.end() ; ++i)
-		(*i)->Abort();
-	
-	fMessageBox.erase( i, fMessageBox.end());
+	if ((sLONG) fMessageBox.size() < inMaxCount)
+		_DrainInbox();
 
-	if (fMessageBox.empty())
+	sLONG count = 0;
+	try
+	{
+		outMessages.reserve( outMessages.size() + std::min<size_t>( fMessageBox.size(), inMaxCount));
+		for( ; (count < inMaxCount) && !fMessageBox.empty() ; ++count)
+		{
+			VMessage *msg = fMessageBox.front().Forget();
+			fMessageBox.pop_front();
+			XBOX_ASSERT_VOBJECT( msg);
+			outMessages.push_back( msg);
+		}
+	}
+	catch(...)
+	{
+	}
+	_MessagesRemoved( count);
+
+	return count;
+}
+
+
+sLONG VMessageQueue::RetainMessagesWithTimeout( std::vector<VMessage*>& outMessages, sLONG inMaxCount, sLONG inTimeoutMilliseconds)
+{
+	if (!fEvent->Lock( inTimeoutMilliseconds))
+		return 0;
+
+	sLONG count = RetainMessages( outMessages, inMaxCount);
+	if (count == 0)
+	{
+		// the event was triggered from the outside, we must reset here ourselves
+		VTaskLock lock( fCriticalSection);
 		fEvent->Reset();
+		if (VInterlocked::AtomicGet( &fCount) > 0)
+			fEvent->Unlock();
+	}
+	return count;
+}
+
+
+void VMessageQueue::CancelMessages( IMessageable* inTarget)
+{
+	VTaskLock lock( fCriticalSection);
+
+	_DrainInbox();
+
+	// std::remove_if would leave unspecified values in the tail, so partition by hand
+	IMessageableCompareTarget isForTarget( inTarget);
+	DequeOfVMessage kept;
+	sLONG count = 0;
+	for( DequeOfVMessage::iterator i = fMessageBox.begin() ; i != fMessageBox.end() ; ++i)
+	{
+		if (isForTarget( *i))
+		{
+			(*i)->Abort();
+			++count;
+		}
+		else
+		{
+			kept.push_back( *i);
+		}
+	}
+	
+	if (count > 0)
+	{
+		fMessageBox.swap( kept);
+		_MessagesRemoved( count);
+	}
 }
 
 
@@ -637,15 +799,17 @@ void VMessageQueue::CancelMessages()
 {
 	VTaskLock lock( fCriticalSection);
 
+	_DrainInbox();
+
 	DequeOfVMessage::iterator i = fMessageBox.begin();
 
 	for( ; i != fMessageBox.end() ; ++i)
 		(*i)->Abort();
 	
-	fMessageBox.erase( i, fMessageBox.end());
+	sLONG count = (sLONG) fMessageBox.size();
+	fMessageBox.clear();
 
-	if (fMessageBox.empty())
-		fEvent->Reset();
+	_MessagesRemoved( count);
 }
 
 
@@ -653,14 +817,15 @@ bool VMessageQueue::RemoveMessage( VMessage* inMessage)
 {
 	VTaskLock lock( fCriticalSection);
 	
+	_DrainInbox();
+
 	DequeOfVMessage::iterator i = std::find( fMessageBox.begin(), fMessageBox.end(), VRefPtr<VMessage>( inMessage));
 
 	bool isFound = (i != fMessageBox.end());
 	if (isFound)
 	{
 		fMessageBox.erase( i);
-		if (fMessageBox.empty())
-			fEvent->Reset();
+		_MessagesRemoved( 1);
 	}
 
 	return isFound;
@@ -669,8 +834,8 @@ bool VMessageQueue::RemoveMessage( VMessage* inMessage)
 
 sLONG VMessageQueue::CountMessages() const
 {
-	VTaskLock lock( fCriticalSection);
-	return (sLONG) fMessageBox.size();
+	sLONG count = VInterlocked::AtomicGet( &fCount);
+	return (count > 0) ? count : 0;
 }
 
 
@@ -678,6 +843,8 @@ sLONG VMessageQueue::CountMessagesFor(IMessageable* inTarget) const
 {
 	VTaskLock lock( fCriticalSection);
 
+	_DrainInbox();
+
 	sLONG count = 0;
 	for( DequeOfVMessage::const_iterator i = fMessageBox.begin() ; i != fMessageBox.end() ; ++i)
 	{
@@ -690,9 +857,7 @@ sLONG VMessageQueue::CountMessagesFor(IMessageable* inTarget) const
 
 bool VMessageQueue::IsEmpty() const
 {
-	VTaskLock lock( fCriticalSection);
-	
-	return fMessageBox.empty();
+	return VInterlocked::AtomicGet( &fCount) <= 0;
 }
 
 
@@ -304,6 +304,8 @@ private:
 			bool	_Send( VMessagingContext* inRetainedContext, sLONG inTimeoutMilliseconds, bool inIndefiniteTimeout);
 			bool	_Post( VMessagingContext* inRetainedContext, bool inSynchronousIfSameTask);
 			VTask*	_InstallContextAndRetainTask( VMessagingContext* inRetainedContext);
+
+			VMessage*	fNextQueued;	// link in VMessageQueue lock-free inbox
 };
 
 
@@ -321,6 +323,11 @@ public:
 	
 			VMessage*			RetainMessage();
 			VMessage*			RetainMessageWithTimeout( sLONG inTimeoutMilliseconds);
+
+			// Appends up to inMaxCount retained messages in queue order and returns how many were appended.
+			// Messages taken that way are no longer seen by CancelMessages or RemoveMessage.
+			sLONG				RetainMessages( std::vector<VMessage*>& outMessages, sLONG inMaxCount);
+			sLONG				RetainMessagesWithTimeout( std::vector<VMessage*>& outMessages, sLONG inMaxCount, sLONG inTimeoutMilliseconds);
 			
 			bool				AddMessage( VMessage* inMessage);
 			bool				RemoveMessage( VMessage* inMessage);
@@ -339,8 +346,15 @@ public:
 
 private:
 			VMessage*			_RetainFrontMessage();
+			void				_DrainInbox() const;
+			void				_MessagesRemoved( sLONG inCount);
 			
-			DequeOfVMessage		fMessageBox;
+			// Posting a message never takes fCriticalSection: messages are pushed on the fInbox lock-free stack (LIFO)
+			// and moved in order into fMessageBox by the reading side, under fCriticalSection.
+			// fCount counts messages in both and the event is only set when it goes from 0 to 1.
+	mutable	DequeOfVMessage		fMessageBox;
+	mutable	VMessage*			fInbox;
+	mutable	sLONG				fCount;
 			VCriticalSection*	fCriticalSection;
 			VSyncEvent*			fEvent;
 };
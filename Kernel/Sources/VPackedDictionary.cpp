@@ -22,58 +22,20 @@
 
 const uLONG _VHashKeyMap::tag_empty = 0xffffffffu;
 
-size_t _VHashKeyMap::_ComputeHashVectorSize( size_t inCountValues)
-{
-
-	static const size_t sVHashKeyMap_Capacities[42] = {
-	    4, 8, 17, 29, 47, 76, 123, 199, 322, 521, 843, 1364, 2207, 3571, 5778, 9349,
-	    15127, 24476, 39603, 64079, 103682, 167761, 271443, 439204, 710647, 1149851, 1860498,
-	    3010349, 4870847, 7881196, 12752043, 20633239, 33385282, 54018521, 87403803, 141422324,
-	    228826127, 370248451, 599074578, 969323029, 1568397607, 2537720636U
-	};
-
-	static const size_t sVHashKeyMap_Buckets[42] = {	// primes
-	    5, 11, 23, 41, 67, 113, 199, 317, 521, 839, 1361, 2207, 3571, 5779, 9349, 15121,
-	    24473, 39607, 64081, 103681, 167759, 271429, 439199, 710641, 1149857, 1860503, 3010349,
-	    4870843, 7881193, 12752029, 20633237, 33385273, 54018521, 87403763, 141422317, 228826121,
-	    370248451, 599074561, 969323023, 1568397599, 2537720629U, 4106118251U
-	};
-
-    size_t i = 0;
-    while( i < 42 && sVHashKeyMap_Capacities[i] < inCountValues)
-    	++i;
-    assert( i < 42);
-    return sVHashKeyMap_Buckets[i];
-}
-
-
 bool _VHashKeyMap::Rebuild( size_t inCountValues)
 {
-	bool ok;
-	try
-	{
-		hash_vector temp( _ComputeHashVectorSize( inCountValues), tag_empty);
-		fIndex.swap( temp);
-		ok = true;
-	}
-	catch(...)
-	{
-		clear();
-		ok = false;
-	}
-	return ok;
-}
+	// at most half full
+	size_t capacity = 16;
+	while( capacity < 2 * inCountValues)
+		capacity *= 2;
 
-
-bool _VHashKeyMap::Rebuild( VStream *inStream)
-{
 	bool ok;
 	try
 	{
-		hash_vector temp( static_cast<size_t>( inStream->GetLong()), tag_empty);
-		sLONG count = static_cast<sLONG>( temp.size());
-		inStream->GetLongs( &temp.front(), &count);
-		fIndex.swap( temp);
+		bucket emptyBucket = { 0, tag_empty };
+		bucket_vector temp( capacity, emptyBucket);
+		fBuckets.swap( temp);
+		fCount = 0;
 		ok = true;
 	}
 	catch(...)
@@ -85,93 +47,142 @@ bool _VHashKeyMap::Rebuild( VStream *inStream)
 }
 
 
-bool _VHashKeyMap::Put( hashcode_type inHash, size_t inValue)
+void _VHashKeyMap::SkipFromStream( VStream *inStream)
 {
-	bool ok;
-	size_t probe = inHash % fIndex.size();
-	size_t start = probe;
-	for(;;)
+	// read by chunks, the stream may not support SetPos
+	uLONG buffer[256];
+	for( sLONG remaining = inStream->GetLong() ; (remaining > 0) && (inStream->GetLastError() == VE_OK) ; )
 	{
-		if (fIndex[probe] == tag_empty)
-		{
-			fIndex[probe] = static_cast<uLONG>( inValue);
-			ok = true;
+		sLONG count = Min( remaining, (sLONG) (sizeof( buffer) / sizeof( buffer[0])));
+		inStream->GetLongs( buffer, &count);
+		if (count <= 0)
 			break;
-		}
-		
-		++probe;
-		if (probe >= fIndex.size())
-			probe -= fIndex.size();
-		if (probe == start)
-		{
-			ok = false;
-			break;
-		}
+		remaining -= count;
 	}
-	return ok;
 }
 
 
-VError _VHashKeyMap::WriteToStream( VStream *inStream)
+bool _VHashKeyMap::Put( hashcode_type inHash, size_t inValue)
 {
-	sLONG count = static_cast<sLONG>( fIndex.size());
-	inStream->PutLong( count);
-	inStream->PutLongs( &fIndex.front(), count);
-	return inStream->GetLastError();
+	if ( fBuckets.empty() || (2 * (fCount + 1) > fBuckets.size()) )
+		return false;
+
+	size_t mask = fBuckets.size() - 1;
+	uLONG hash = static_cast<uLONG>( inHash);
+	size_t probe = hash & mask;
+	while( fBuckets[probe].fIndex != tag_empty)
+		probe = (probe + 1) & mask;
+
+	fBuckets[probe].fHash = hash;
+	fBuckets[probe].fIndex = static_cast<uLONG>( inValue);
+	++fCount;
+	return true;
 }
 
 
 //================================================================================================================
 
 
+StPackedDictionaryKey::char_type* StPackedDictionaryKey::_AllocateKey( size_t inLength)
+{
+	if (inLength < kInlineKeySize)
+		return fInlineKey;
+
+	fKeyBuffer = new char_type[inLength + 1];
+	return fKeyBuffer;
+}
+
+
 StPackedDictionaryKey::StPackedDictionaryKey( const wchar_t *inKey)
-: fKeyBuffer( new char_type[256])
+: fKeyBuffer( NULL)
 {
-	VFromUnicodeConverter_UTF8 converter;
-	VIndex charsConsumed;
-	VSize bytesProduced;
-
-	sLONG input_length = static_cast<sLONG>( ::wcslen( inKey));
-	Boolean conversionOK = converter.ConvertFrom_wchar( inKey, input_length, &charsConsumed, fKeyBuffer, 255, &bytesProduced);
-	if (!testAssert( conversionOK && (charsConsumed == input_length)))
-		bytesProduced = 0;
-	fLength = static_cast<size_t>( bytesProduced);
-	fKey = fKeyBuffer;
-	fKeyBuffer[fLength] = 0;
+	size_t input_length = ::wcslen( inKey);
+
+	// most keys are ascii and need no converter
+	bool isASCII = (input_length <= 255);
+	for( size_t i = 0 ; isASCII && (i < input_length) ; ++i)
+		isASCII = (inKey[i] >= 0) && (inKey[i] < 0x80);
+
+	char_type *key = isASCII ? _AllocateKey( input_length) : NULL;
+	if (key != NULL)
+	{
+		for( size_t i = 0 ; i < input_length ; ++i)
+			key[i] = static_cast<char_type>( inKey[i]);
+		fLength = input_length;
+	}
+	else
+	{
+		delete [] fKeyBuffer;
+		fKeyBuffer = key = new char_type[256];
+
+		VFromUnicodeConverter_UTF8 converter;
+		VIndex charsConsumed;
+		VSize bytesProduced;
+		Boolean conversionOK = converter.ConvertFrom_wchar( inKey, static_cast<sLONG>( input_length), &charsConsumed, key, 255, &bytesProduced);
+		if (!testAssert( conversionOK && (charsConsumed == static_cast<VIndex>( input_length))))
+			bytesProduced = 0;
+		fLength = static_cast<size_t>( bytesProduced);
+	}
+	fKey = key;
+	key[fLength] = 0;
 	fHashCode = GetHashCode( fKey, fLength);
 }
 
 
 StPackedDictionaryKey::StPackedDictionaryKey( const VString& inKey)
-: fKeyBuffer( new char_type[256])
+: fKeyBuffer( NULL)
 , fHashCode(0)
 {
-	VFromUnicodeConverter_UTF8 converter;
-	VIndex charsConsumed;
-	VSize bytesProduced;
-	bool conversionOK = converter.Convert( inKey.GetCPointer(), inKey.GetLength(), &charsConsumed, fKeyBuffer, 255, &bytesProduced);
-	if (!testAssert( conversionOK && (charsConsumed == inKey.GetLength())))
-		bytesProduced = 0;
-	fLength = static_cast<size_t>( bytesProduced);
-	fKey = fKeyBuffer;
-	fKeyBuffer[fLength] = 0;
+	const UniChar *input = inKey.GetCPointer();
+	VIndex input_length = inKey.GetLength();
+
+	// most keys are ascii and need no converter
+	bool isASCII = (input_length <= 255);
+	for( VIndex i = 0 ; isASCII && (i < input_length) ; ++i)
+		isASCII = (input[i] < 0x80);
+
+	char_type *key = isASCII ? _AllocateKey( static_cast<size_t>( input_length)) : NULL;
+	if (key != NULL)
+	{
+		for( VIndex i = 0 ; i < input_length ; ++i)
+			key[i] = static_cast<char_type>( input[i]);
+		fLength = static_cast<size_t>( input_length);
+	}
+	else
+	{
+		delete [] fKeyBuffer;
+		fKeyBuffer = key = new char_type[256];
+
+		VFromUnicodeConverter_UTF8 converter;
+		VIndex charsConsumed;
+		VSize bytesProduced;
+		bool conversionOK = converter.Convert( input, input_length, &charsConsumed, key, 255, &bytesProduced);
+		if (!testAssert( conversionOK && (charsConsumed == input_length)))
+			bytesProduced = 0;
+		fLength = static_cast<size_t>( bytesProduced);
+	}
+	fKey = key;
+	key[fLength] = 0;
 	fHashCode = GetHashCode( fKey, fLength);
 }
 
 
 StPackedDictionaryKey::StPackedDictionaryKey( const char *inKey, size_t inLength)
-: fLength( inLength)
+: fKeyBuffer( NULL)
 , fHashCode(GetHashCode( inKey, inLength))
 {
-	fKeyBuffer = new char_type[inLength + 1];
-	fKey = fKeyBuffer;
-	if (fKeyBuffer != NULL)
+	char_type *key = _AllocateKey( inLength);
+	fKey = key;
+	if (key != NULL)
 	{
-		::memcpy( fKeyBuffer, inKey, inLength + 1);
+		::memcpy( key, inKey, inLength);
+		key[inLength] = 0;
 		fLength = inLength;
 	}
 	else
 	{
+		fKey = fInlineKey;
+		fInlineKey[0] = 0;
 		fLength = 0;
 	}
 }
@@ -180,24 +191,26 @@ StPackedDictionaryKey::StPackedDictionaryKey( const char *inKey, size_t inLength
 void StPackedDictionaryKey::_CopyFrom( const StPackedDictionaryKey& inOther)
 {
 	fHashCode = inOther.fHashCode;
-	if (inOther.fKeyBuffer == NULL)
+	fKeyBuffer = NULL;
+	if ( (inOther.fKeyBuffer == NULL) && (inOther.fKey != inOther.fInlineKey) )
 	{
-		fKeyBuffer = NULL;
+		// not owned
 		fKey = inOther.fKey;
 		fLength = inOther.fLength;
 	}
 	else
 	{
-		xbox_assert( inOther.fKey == inOther.fKeyBuffer);
-		fKeyBuffer = new char_type[inOther.fLength + 1];
-		fKey = fKeyBuffer;
-		if (fKeyBuffer != NULL)
+		char_type *key = _AllocateKey( inOther.fLength);
+		if (key != NULL)
 		{
-			::memcpy( fKeyBuffer, inOther.fKeyBuffer, inOther.fLength + 1);
+			::memcpy( key, inOther.fKey, inOther.fLength + 1);
+			fKey = key;
 			fLength = inOther.fLength;
 		}
 		else
 		{
+			fKey = fInlineKey;
+			fInlineKey[0] = 0;
 			fLength = 0;
 		}
 	}
@@ -206,24 +219,16 @@ void StPackedDictionaryKey::_CopyFrom( const StPackedDictionaryKey& inOther)
 
 _VHashKeyMap::hashcode_type StPackedDictionaryKey::GetHashCode( const char_type *inKey, size_t inLength)
 {
-	// inspired from cfstring: for > 16 chars, consider only first and last 8 chars.
-	// always compute with 32 bits integers
-	uLONG result = static_cast<uLONG>( inLength);
+	// FNV-1a on all bytes (keys are at most 255 bytes), computed with 32 bits integers.
+	// It is never stored in streams so it may change.
+	uLONG result = 2166136261U;
 	const uBYTE *key = reinterpret_cast<const uBYTE*>( inKey);	// use unsigned bytes
-	const uBYTE *i;
-	if (inLength <= 16)
-	{
-		for( i = key ; i != key + inLength ; ++i)
-			result = result * 257 + *i;
-	}
-	else
-	{
-		for( i = key ; i != key + 8 ; ++i)
-			result = result * 257 + *i;
-		for( i = key + inLength - 8 ; i != key + inLength ; ++i)
-			result = result * 257 + *i;
-	}
+	for( const uBYTE *i = key ; i != key + inLength ; ++i)
+		result = (result ^ *i) * 16777619U;
+
+	// final mix so that low bits used by the hash table depend on all bytes
+	result ^= result >> 15;
+	result *= 0x2c1b3c6dU;
+	result ^= result >> 12;
 	return (_VHashKeyMap::hashcode_type) result;
 }
-
-
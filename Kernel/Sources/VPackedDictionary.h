@@ -24,31 +24,58 @@ BEGIN_TOOLBOX_NAMESPACE
 
 /*
 	private
+
+	Open addressing hash table of slot indexes with linear probing.
+	Each bucket keeps the full hash code so that keys are only compared when hash codes match,
+	and a lookup for a missing key stops at the first empty bucket.
+	The capacity is a power of 2 and the table is kept at most half full.
 */
 class XTOOLBOX_API _VHashKeyMap
 {
 public:
 	typedef size_t	hashcode_type;
-	typedef std::vector<uLONG>	hash_vector;
 	static	const uLONG tag_empty;
 
-							_VHashKeyMap()						{;}
+	typedef struct bucket
+	{
+		uLONG		fHash;
+		uLONG		fIndex;		// tag_empty if the bucket is free
+	} bucket;
+	typedef std::vector<bucket>	bucket_vector;
+
+							_VHashKeyMap():fCount( 0)			{;}
 
+	// returns false if the table is too full, it must then be rebuilt.
 			bool			Put( hashcode_type inHash, size_t inValue);
-			size_t			Get( hashcode_type inHash)			{ return static_cast<size_t>( fIndex[inHash % fIndex.size()]);}
+
+	// inEqual( size_t inIndex) tells if the slot at inIndex holds the searched key.
+	// returns tag_empty if not found.
+	template<class Equal>
+			size_t			Find( hashcode_type inHash, const Equal& inEqual) const
+							{
+								size_t mask = fBuckets.size() - 1;
+								uLONG hash = static_cast<uLONG>( inHash);
+								for( size_t probe = hash & mask ; ; probe = (probe + 1) & mask)
+								{
+									const bucket& b = fBuckets[probe];
+									if (b.fIndex == tag_empty)
+										return tag_empty;
+									if ( (b.fHash == hash) && inEqual( static_cast<size_t>( b.fIndex)) )
+										return static_cast<size_t>( b.fIndex);
+								}
+							}
 	
-			bool			empty() const						{ return fIndex.empty();}
-			void			clear() 							{ return fIndex.clear();}
+			bool			empty() const						{ return fBuckets.empty();}
+			void			clear() 							{ fBuckets.clear(); fCount = 0;}
 			
 			bool			Rebuild( size_t inCountValues);
-			bool			Rebuild( VStream *inCountValues);
 
-			VError			WriteToStream( VStream *inStream);
+	// skips an index written by previous versions
+	static	void			SkipFromStream( VStream *inStream);
 	
 private:
-	static	size_t			_ComputeHashVectorSize( size_t inCountValues);
-
-			hash_vector		fIndex;
+			bucket_vector	fBuckets;
+			size_t			fCount;
 };
 
 //================================================================================================================
@@ -74,6 +101,7 @@ class XTOOLBOX_API StPackedDictionaryKey
 public:
 	typedef char	char_type;
 	typedef uBYTE	length_type;
+	enum { kInlineKeySize = 32 };	// converted or copied keys shorter than this don't need a buffer allocation
 
 	StPackedDictionaryKey( const char *inKey):fKey( inKey),fLength( ::strlen( inKey)),fKeyBuffer(NULL),fHashCode(GetHashCode( fKey, fLength))	{;}	// beware: initialization order = declaration order
 	StPackedDictionaryKey( const char *inKey, size_t inLength);	// copy
@@ -110,11 +138,13 @@ public:
 
 private:
 				void				_CopyFrom( const StPackedDictionaryKey& inOther);
+				char_type*			_AllocateKey( size_t inLength);
 				
 			const char_type*				fKey;
 			size_t							fLength;
 			char_type*						fKeyBuffer;
 			_VHashKeyMap::hashcode_type		fHashCode;
+			char_type						fInlineKey[kInlineKeySize];
 };
 
 
@@ -134,7 +164,7 @@ public:
 				{
 				}
 			
-			VPackedDictionary_base( const VPackedDictionary_base& inOther):fKeys( inOther.fKeys), fSlots( inOther.fSlots)
+			VPackedDictionary_base( const VPackedDictionary_base& inOther):fKeys( inOther.fKeys), fSlots( inOther.fSlots), fHashKeyMap( inOther.fHashKeyMap)
 				{
 				}
 
@@ -229,28 +259,20 @@ protected:
 					return (inKey.GetKeyLength() == GetKeyLength( inSlot)) && (::memcmp( inKey.GetKeyAdress(), GetKeyAdress( inSlot), inKey.GetKeyLength()) == 0);
 				}
 
+			class _SlotKeyEqual
+			{
+			public:
+				_SlotKeyEqual( const VPackedDictionary_base& inDictionary, const StPackedDictionaryKey& inKey) : fDictionary( inDictionary), fKey( inKey)	{;}
+				bool operator()( size_t inIndex) const		{ return fDictionary._Equal( fKey, fDictionary.fSlots[inIndex]);}
+			private:
+				const VPackedDictionary_base&	fDictionary;
+				const StPackedDictionaryKey&	fKey;
+			};
+
 			typename slot_vector::iterator _FindWithMap( const StPackedDictionaryKey& inKey)
 				{
-					size_t start = fHashKeyMap.Get( inKey.GetHashCode());
-					if (start != _VHashKeyMap::tag_empty)
-					{
-						typename slot_vector::iterator i = fSlots.begin() + start; 
-						do {
-							if (_Equal( inKey, *i))
-								return i;
-						} while( ++i != fSlots.end());
-
-						if (start != 0)
-						{
-							i = fSlots.begin();
-							do {
-								if (_Equal( inKey, *i))
-									return i;
-							} while( ++i != fSlots.begin() + start);
-						}
-					}
-
-					return fSlots.end();
+					size_t index = fHashKeyMap.Find( inKey.GetHashCode(), _SlotKeyEqual( *this, inKey));
+					return (index != _VHashKeyMap::tag_empty) ? fSlots.begin() + index : fSlots.end();
 				}
 
 			typename slot_vector::iterator _Find( const StPackedDictionaryKey& inKey)
@@ -338,34 +360,25 @@ protected:
 						current_key += GetKeyLength( fKeys, *i) + 1;
 					}
 					
+					// the index is always rebuilt because its layout may change
+					fHashKeyMap.clear();
 					sBYTE withMap = inStream->GetByte();
 					assert( withMap == 0 || withMap == 1);
 					if (withMap == 1)
-						fHashKeyMap.Rebuild( inStream);
-					else
-						BuildHashKeyMapIfNecessary();
+						_VHashKeyMap::SkipFromStream( inStream);
+					BuildHashKeyMapIfNecessary();
 
 					return inStream->GetLastError();
 				}
 			
-			VError _WriteKeysToStream( VStream *inStream, bool inWithIndex) const
+			VError _WriteKeysToStream( VStream *inStream, bool /*inWithIndex*/) const
 				{
-					if (inWithIndex)
-						BuildHashKeyMapIfNecessary();
-					
 					inStream->PutLong( static_cast<uLONG>( fSlots.size()));
 					inStream->PutLong( static_cast<uLONG>( fKeys.size()));
 					inStream->PutData( &fKeys.front(), static_cast<sLONG>( fKeys.size()));
 					
-					if (inWithIndex && !fHashKeyMap.empty())
-					{
-						inStream->PutByte( 1);
-						fHashKeyMap.WriteToStream( inStream);
-					}
-					else
-					{
-						inStream->PutByte( 0);
-					}
+					// the index is no longer written: it's cheaper to rebuild it on reading
+					inStream->PutByte( 0);
 					
 					return inStream->GetLastError();
 				}
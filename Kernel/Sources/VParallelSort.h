@@ -0,0 +1,315 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VParallelSort__
+#define __VParallelSort__
+
+#include <algorithm>
+#include <vector>
+#include "Kernel/Sources/VTaskPool.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+/*
+	Typed sorting kernels.
+
+	RadixSort sorts integers and reals with a LSD radix sort, one byte per pass.
+	Passes where all elements share the same byte are skipped.
+
+	ParallelSort and ParallelRadixSort split big inputs in one chunk per task of VTaskPool::Get(),
+	sort the chunks in parallel and merge them two by two, also in parallel.
+	They need a temporary buffer as big as the input; if it can't be allocated, the sort stays on the calling task.
+	Comparators must be thread safe.
+*/
+
+// Under that count, the sort stays on the calling task.
+const sLONG	kParallelSortMinCount	= 65536;
+
+// Under that count, RadixSort uses std::sort.
+const sLONG	kRadixSortMinCount		= 256;
+
+
+// Maps a value to an unsigned key which natural order is the value order.
+template<class Type> class VRadixSortKey {};
+
+template<> class VRadixSortKey<sBYTE>
+{
+public:
+	typedef uBYTE	KeyType;
+	static	KeyType	Get( sBYTE inValue)		{ return (KeyType) ((uBYTE) inValue ^ 0x80U);}
+};
+
+template<> class VRadixSortKey<sWORD>
+{
+public:
+	typedef uWORD	KeyType;
+	static	KeyType	Get( sWORD inValue)		{ return (KeyType) ((uWORD) inValue ^ 0x8000U);}
+};
+
+template<> class VRadixSortKey<sLONG>
+{
+public:
+	typedef uLONG	KeyType;
+	static	KeyType	Get( sLONG inValue)		{ return (uLONG) inValue ^ 0x80000000U;}
+};
+
+template<> class VRadixSortKey<sLONG8>
+{
+public:
+	typedef uLONG8	KeyType;
+	static	KeyType	Get( sLONG8 inValue)	{ return (uLONG8) inValue ^ (((uLONG8) 1) << 63);}
+};
+
+// negative reals have all their bits flipped, positive ones only their sign bit.
+// -0.0 comes before +0.0 and NaNs are put at both ends depending on their sign.
+template<> class VRadixSortKey<Real>
+{
+public:
+	typedef uLONG8	KeyType;
+	static	KeyType	Get( Real inValue)
+	{
+		uLONG8 bits;
+		::memcpy( &bits, &inValue, sizeof( bits));
+		return (bits & (((uLONG8) 1) << 63)) ? ~bits : (bits | (((uLONG8) 1) << 63));
+	}
+};
+
+
+// The order used by RadixSort, so that radix sorted chunks can be merged.
+template<class Type>
+class VRadixSortLess
+{
+public:
+			VRadixSortLess( bool inDescending) : fDescending( inDescending)	{;}
+			bool	operator()( const Type& inA, const Type& inB) const
+			{
+				return fDescending ? (VRadixSortKey<Type>::Get( inB) < VRadixSortKey<Type>::Get( inA)) : (VRadixSortKey<Type>::Get( inA) < VRadixSortKey<Type>::Get( inB));
+			}
+private:
+			bool	fDescending;
+};
+
+
+// ioBuffer must have room for inNb elements.
+template<class Type>
+void RadixSort( Type *ioBase, Type *ioBuffer, sLONG inNb, bool inDescending)
+{
+	typedef typename VRadixSortKey<Type>::KeyType KeyType;
+	const sLONG passCount = (sLONG) sizeof( KeyType);
+
+	if (inNb < kRadixSortMinCount)
+	{
+		std::sort( ioBase, ioBase + inNb, VRadixSortLess<Type>( inDescending));
+		return;
+	}
+
+	// all histograms in one read
+	sLONG counts[sizeof( KeyType)][256];
+	::memset( counts, 0, sizeof( counts));
+	const KeyType flip = inDescending ? (KeyType) ~(KeyType) 0 : (KeyType) 0;
+	for( const Type *p = ioBase, *end = ioBase + inNb ; p != end ; ++p)
+	{
+		KeyType key = VRadixSortKey<Type>::Get( *p) ^ flip;
+		for( sLONG pass = 0 ; pass < passCount ; ++pass)
+			++counts[pass][(key >> (pass * 8)) & 0xFF];
+	}
+
+	Type *source = ioBase;
+	Type *destination = ioBuffer;
+	for( sLONG pass = 0 ; pass < passCount ; ++pass)
+	{
+		sLONG *count = counts[pass];
+
+		// skip the pass if all elements fall in the same bucket
+		KeyType firstKey = VRadixSortKey<Type>::Get( *source) ^ flip;
+		if (count[(firstKey >> (pass * 8)) & 0xFF] == inNb)
+			continue;
+
+		sLONG offset = 0;
+		for( sLONG i = 0 ; i < 256 ; ++i)
+		{
+			sLONG n = count[i];
+			count[i] = offset;
+			offset += n;
+		}
+
+		for( const Type *p = source, *end = source + inNb ; p != end ; ++p)
+		{
+			KeyType key = VRadixSortKey<Type>::Get( *p) ^ flip;
+			destination[count[(key >> (pass * 8)) & 0xFF]++] = *p;
+		}
+
+		std::swap( source, destination);
+	}
+
+	if (source != ioBase)
+		std::copy( source, source + inNb, ioBase);
+}
+
+
+// Sorts a chunk with std::sort.
+template<class Type, class Less>
+class VCompareChunkSorter
+{
+public:
+			VCompareChunkSorter( const Less& inLess) : fLess( inLess)	{;}
+			void	operator()( Type *ioBase, Type * /*ioBuffer*/, sLONG inNb) const		{ std::sort( ioBase, ioBase + inNb, fLess);}
+private:
+	const	Less&	fLess;
+};
+
+
+// Sorts a chunk with RadixSort.
+template<class Type>
+class VRadixChunkSorter
+{
+public:
+			VRadixChunkSorter( bool inDescending) : fDescending( inDescending)	{;}
+			void	operator()( Type *ioBase, Type *ioBuffer, sLONG inNb) const		{ RadixSort( ioBase, ioBuffer, inNb, fDescending);}
+private:
+			bool	fDescending;
+};
+
+
+template<class Type, class ChunkSorter>
+class VParallelSortChunkBody
+{
+public:
+			VParallelSortChunkBody( Type *ioBase, Type *ioBuffer, const std::vector<sLONG>& inBounds, const ChunkSorter& inSorter)
+				: fBase( ioBase), fBuffer( ioBuffer), fBounds( inBounds), fSorter( inSorter)	{;}
+
+			void	operator()( sLONG inBegin, sLONG inEnd) const
+			{
+				for( sLONG i = inBegin ; i < inEnd ; ++i)
+					fSorter( fBase + fBounds[i], fBuffer + fBounds[i], fBounds[i+1] - fBounds[i]);
+			}
+private:
+			Type*						fBase;
+			Type*						fBuffer;
+	const	std::vector<sLONG>&			fBounds;
+	const	ChunkSorter&				fSorter;
+};
+
+
+// Merges sorted runs of inWidth chunks two by two from inSource to outDestination.
+template<class Type, class Less>
+class VParallelSortMergeBody
+{
+public:
+			VParallelSortMergeBody( const Type *inSource, Type *outDestination, const std::vector<sLONG>& inBounds, sLONG inWidth, const Less& inLess)
+				: fSource( inSource), fDestination( outDestination), fBounds( inBounds), fWidth( inWidth), fLess( inLess)	{;}
+
+			void	operator()( sLONG inBegin, sLONG inEnd) const
+			{
+				sLONG chunkCount = (sLONG) fBounds.size() - 1;
+				for( sLONG pair = inBegin ; pair < inEnd ; ++pair)
+				{
+					sLONG first = pair * 2 * fWidth;
+					sLONG middle = std::min( first + fWidth, chunkCount);
+					sLONG last = std::min( first + 2 * fWidth, chunkCount);
+					std::merge( fSource + fBounds[first], fSource + fBounds[middle], fSource + fBounds[middle], fSource + fBounds[last], fDestination + fBounds[first], fLess);
+				}
+			}
+private:
+	const	Type*						fSource;
+			Type*						fDestination;
+	const	std::vector<sLONG>&			fBounds;
+			sLONG						fWidth;
+	const	Less&						fLess;
+};
+
+
+// Sorts chunks with inSorter in parallel then merges them with inLess, which must define the same order.
+// Returns false if the temporary buffer couldn't be allocated (ioBase is left untouched).
+template<class Type, class Less, class ChunkSorter>
+bool ParallelSortChunksAndMerge( Type *ioBase, sLONG inNb, const Less& inLess, const ChunkSorter& inSorter)
+{
+	VTaskPool *pool = VTaskPool::Get();
+	sLONG taskCount = pool->GetWorkerCount() + 1;
+	if ( (inNb < kParallelSortMinCount) || (taskCount < 2) )
+		taskCount = 1;
+
+	// a power of 2 of chunks so that every merge round is balanced
+	sLONG chunkCount = 1;
+	while( (chunkCount < taskCount) && (chunkCount < 64) )
+		chunkCount *= 2;
+
+	std::vector<Type> buffer;
+	std::vector<sLONG> bounds;
+	try
+	{
+		buffer.resize( inNb);
+		bounds.resize( chunkCount + 1);
+	}
+	catch(...)
+	{
+		return false;
+	}
+	for( sLONG i = 0 ; i <= chunkCount ; ++i)
+		bounds[i] = (sLONG) (((sLONG8) inNb * i) / chunkCount);
+
+	Type *source = ioBase;
+	Type *destination = &buffer[0];
+
+	if (chunkCount == 1)
+	{
+		inSorter( source, destination, inNb);
+		return true;
+	}
+
+	pool->ParallelFor( 0, chunkCount, 1, VParallelSortChunkBody<Type,ChunkSorter>( source, destination, bounds, inSorter));
+
+	for( sLONG width = 1 ; width < chunkCount ; width *= 2)
+	{
+		sLONG pairCount = (chunkCount + 2 * width - 1) / (2 * width);
+		pool->ParallelFor( 0, pairCount, 1, VParallelSortMergeBody<Type,Less>( source, destination, bounds, width, inLess));
+		std::swap( source, destination);
+	}
+
+	if (source != ioBase)
+		std::copy( source, source + inNb, ioBase);
+
+	return true;
+}
+
+
+// Sorts with a comparator, in parallel for big inputs.
+template<class Type, class Less>
+void ParallelSort( Type *ioBase, sLONG inNb, const Less& inLess)
+{
+	if (inNb < 2)
+		return;
+
+	if ( (inNb < kParallelSortMinCount) || !ParallelSortChunksAndMerge( ioBase, inNb, inLess, VCompareChunkSorter<Type,Less>( inLess)) )
+		std::sort( ioBase, ioBase + inNb, inLess);
+}
+
+
+// Sorts integers or reals with RadixSort, in parallel for big inputs.
+template<class Type>
+void ParallelRadixSort( Type *ioBase, sLONG inNb, bool inDescending)
+{
+	if (inNb < 2)
+		return;
+
+	VRadixSortLess<Type> less( inDescending);
+	if ( (inNb < kRadixSortMinCount) || !ParallelSortChunksAndMerge( ioBase, inNb, less, VRadixChunkSorter<Type>( inDescending)) )
+		std::sort( ioBase, ioBase + inNb, less);
+}
+
+
+END_TOOLBOX_NAMESPACE
+
+#endif
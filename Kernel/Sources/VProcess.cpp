@@ -19,6 +19,8 @@
 #include "VFolder.h"
 #include "VResource.h"
 #include "VTask.h"
+#include "VTaskPool.h"
+#include "VFileAsyncIO.h"
 #include "VIntlMgr.h"
 #include "VErrorContext.h"
 #include "VMemory.h"
@@ -255,6 +257,8 @@ void VProcess::_DeInit()
 
 	VDebugMgr::Get()->DeInit();
 	VErrorBase::DeInit();
+	VFileAsyncIO::DeInit();
+	VTaskPool::DeInit();
 	VTaskMgr::DeInit();
 	#if WITH_RESOURCE_FILE
 	VResourceFile::DeInit();
@@ -270,7 +270,7 @@ VError VStream::GuessCharSetFromLeadingBytes( CharSet inDefaultCharSet)
 	uBYTE c[4];
 	c[0] = c[1] = c[2] = c[3] = 0;
 	{
-		StErrorContextInstaller errorContext( false);	// no error
+		StErrorCapture errorCapture;	// no error
 		err = GetData( &c[0], 4, &readBytes);
 	}
 
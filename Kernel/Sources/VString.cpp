@@ -167,7 +167,7 @@ VSize VString_info::GetAvgSpace() const
 
 VString::VString():VValueSingle( false)
 {
-	fMaxBufferLength = (sizeof(fBuffer) / sizeof(UniChar)) - 1; // zero
+	fMaxBufferLength = (sizeof(fBuffer) / sizeof(UniChar)) - 1;
 	fMaxLength = fMaxBufferLength;
 	fString = fBuffer;
 	fLength = 0;
@@ -177,7 +177,7 @@ VString::VString():VValueSingle( false)
 
 VString::VString( bool inNull):VValueSingle( inNull)
 {
-	fMaxBufferLength = (sizeof(fBuffer) / sizeof(UniChar)) - 1; // zero
+	fMaxBufferLength = (sizeof(fBuffer) / sizeof(UniChar)) - 1;
 	fMaxLength = fMaxBufferLength;
 	fString = fBuffer;
 	fLength = 0;
@@ -380,7 +380,7 @@ VString::VString( UniChar* inUniCString, VIndex inLength, VSize inMaxBytes):VVal
 
 VString::VString( const VInlineString& inString):VValueSingle( false)
 {
-	fMaxBufferLength = (sizeof(fBuffer) / sizeof(UniChar)) - 1; // zero
+	fMaxBufferLength = (sizeof(fBuffer) / sizeof(UniChar)) - 1;
 	fString = inString.RetainBuffer( &fLength, &fMaxLength);
 	if (fString == NULL)
 	{
@@ -415,6 +415,26 @@ VString::~VString()
 }
 
 
+sLONG VString::sBufferAllocationCount = 0;
+sLONG VString::sBufferAllocationBytes = 0;
+
+
+void VString::_CountBufferAllocation( VSize inNbBytes)
+{
+	VInterlocked::Increment( &sBufferAllocationCount);
+	VInterlocked::AtomicAdd( &sBufferAllocationBytes, (sLONG) inNbBytes);
+}
+
+
+void VString::GetBufferAllocationStatistics( uLONG *outCount, uLONG *outBytes)
+{
+	if (outCount != NULL)
+		*outCount = (uLONG) VInterlocked::AtomicGet( &sBufferAllocationCount);
+	if (outBytes != NULL)
+		*outBytes = (uLONG) VInterlocked::AtomicGet( &sBufferAllocationBytes);
+}
+
+
 VString* VString::NewString( VIndex inNbChars)
 {
 	VString* str = new( CheckedCastToVIndex( inNbChars*sizeof(UniChar)) ) VString;
@@ -993,6 +1013,7 @@ bool VString::_ReallocBuffer( VIndex inNbChars, bool inCopyCharacters)
 
 			if (newBuffer != NULL)
 			{
+				_CountBufferAllocation( newSize * sizeof(UniChar));
 				::memcpy( newBuffer, fString, newLength * sizeof(UniChar));
 				_ReleaseBuffer();
 				_SetStringPointerOwner();
@@ -1015,6 +1036,7 @@ bool VString::_ReallocBuffer( VIndex inNbChars, bool inCopyCharacters)
 			newBuffer = (UniChar*) malloc( newSize * sizeof(UniChar));
 			if (newBuffer != NULL)
 			{
+				_CountBufferAllocation( newSize * sizeof(UniChar));
 				::memcpy( newBuffer, fString, newLength * sizeof(UniChar));
 				xbox_assert( (fString == fBuffer) || !_IsStringPointerOwner());	// cause we don't have any allocator to dispose the buffer (and it can't be sharable so soon)
 				_ClearStringPointerOwner();
@@ -1337,6 +1359,7 @@ UniChar *VString::RetainBuffer( VIndex *outLength, VIndex *outMaxLength) const
 			retainedBuffer = (UniChar*) _GetBufferAllocator()->NewPtr( newSize * sizeof(UniChar), false, 'strX');
 			if (retainedBuffer != NULL)
 			{
+				_CountBufferAllocation( newSize * sizeof(UniChar));
 				::memcpy( retainedBuffer, fString, (fLength + 1) * sizeof(UniChar));
 				*(sLONG*) (retainedBuffer + ((fLength + 2) & 0xFFFFFFFE)) = 1;	// set refcount
 				*outLength = *outMaxLength = fLength;
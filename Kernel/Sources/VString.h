@@ -41,7 +41,8 @@ typedef std::vector<VString> VectorOfVString;
 	@abstract Strings management classes.
 	@discussion
 		VString can be viewed as a null-terminated UTF16 string buffer.
-		It uses a private buffer which grows according to its needs.
+		Short strings are stored in a private buffer inside the VString itself,
+		longer ones in a heap buffer which grows according to its needs.
 		
 		VStr<> is a template derived from VString that let you specify a
 		private buffer size to optimize memory allocations.
@@ -57,6 +58,13 @@ typedef std::vector<VString> VectorOfVString;
 XTOOLBOX_API VSize	UniCStringLength( const UniChar* inString);
 
 
+// Number of chars a VString stores in its private buffer before allocating a heap buffer (not including the null char).
+// 21 makes a VString 80 bytes long on 64 bits platforms.
+#ifndef VSTRING_PRIVATE_BUFFER_LENGTH
+#define VSTRING_PRIVATE_BUFFER_LENGTH	21
+#endif
+
+
 class XTOOLBOX_API VString_info : public VValueInfo
 {
 public:
@@ -87,7 +95,8 @@ public:
 		
 		Whenever you attempt to add some characters, VString may try to allocate a
 		bigger buffer. This is the only occasion where the string buffer may be moved around.
-		See the VStr<> template definition for specifying a pre-allocated buffer size.
+		Strings up to VSTRING_PRIVATE_BUFFER_LENGTH chars don't allocate any buffer.
+		See the VStr<> template definition for specifying a bigger pre-allocated buffer size.
 
 		A VString is a VValue so it supports the IsDirty and the IsNull state flags.
 		
@@ -241,6 +250,14 @@ public:
 	*/
 	static	VString*			NewString( VIndex inNbChars);
 
+	/*!
+		@function	GetBufferAllocationStatistics
+		@abstract	Returns the number of heap buffers allocated by all VStrings since launch and their total size in bytes.
+		@discussion
+			Strings stored in their private buffer are not counted. Both counters wrap around.
+	*/
+	static	void				GetBufferAllocationStatistics( uLONG *outCount, uLONG *outBytes);
+
 	/*!
 		@function	DebugDump
 		@abstract	dump the contents of the VString for debugging purpose.
@@ -761,7 +778,7 @@ protected:
 			VIndex				fLength;	// Nb chars
 			VIndex				fMaxLength;	// Max nb of chars fString can handle( not including the null char)
 			VIndex				fMaxBufferLength;	// Max nb of chars fBuffer can handle( not including the null char)
-			UniChar				fBuffer[1];	// Private buffer, may be extended using the VStr template
+			UniChar				fBuffer[VSTRING_PRIVATE_BUFFER_LENGTH + 1];	// Private buffer, may be extended using the VStr template
 
 			// Inherited from VValue
 	virtual	void				DoNullChanged();
@@ -776,6 +793,10 @@ protected:
 			void				_AdjustPrivateBufferSize( VIndex inExtraChars)	{ fMaxBufferLength += inExtraChars; fMaxLength = fMaxBufferLength; }
 			void				_Clear();
 
+	static	void				_CountBufferAllocation( VSize inNbBytes);
+	static	sLONG				sBufferAllocationCount;
+	static	sLONG				sBufferAllocationBytes;
+
 			// reverse meaning cause by default VString owns its buffer
 			bool				_IsStringPointerOwner() const					{ return !GetFlag( Value_flag1); }
 			void				_SetStringPointerOwner()						{ ClearFlag( Value_flag1); }
@@ -0,0 +1,550 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VKernelPrecompiled.h"
+#include "VTaskPool.h"
+#include "VInterlocked.h"
+#include "VErrorContext.h"
+#include "VSystem.h"
+#include "VString.h"
+
+
+BEGIN_TOOLBOX_NAMESPACE
+
+
+// Number of empty lookups before an idle worker goes to sleep.
+const sLONG	kIdleSpinCount = 64;
+
+// An idle worker checks for jobs at least that often, in case a wake up was missed.
+const sLONG	kIdleSleepMilliseconds = 50;
+
+
+static sLONG _ComputeWorkerCount( sLONG inWorkerCount)
+{
+	if (inWorkerCount <= 0)
+	{
+		inWorkerCount = VSystem::GetNumberOfProcessors() - 1;
+		if (inWorkerCount < 0)
+			inWorkerCount = 0;
+	}
+	return inWorkerCount;
+}
+
+
+/*
+	A loop being run.
+	Lives on the stack of the calling task until fPendingChunks drops to zero.
+*/
+class VTaskPoolGroup
+{
+public:
+								VTaskPoolGroup( sLONG inBegin, sLONG inEnd, sLONG inGrainSize, IParallelChunkRunner *inRunner)
+									: fBegin( inBegin), fEnd( inEnd), fGrainSize( inGrainSize), fRunner( inRunner), fPendingChunks( 0), fFailed( 0), fErrors( NULL)
+									{
+										fChunkCount = (sLONG) (((sLONG8) inEnd - inBegin + inGrainSize - 1) / inGrainSize);
+										fPendingChunks = fChunkCount;
+									}
+
+								~VTaskPoolGroup()
+									{
+										ReleaseRefCountable( &fErrors);
+									}
+
+			void				RunChunk( sLONG inChunk);
+			bool				IsDone() const					{ return VInterlocked::AtomicGet( &fPendingChunks) <= 0;}
+
+			sLONG				fBegin;
+			sLONG				fEnd;
+			sLONG				fGrainSize;
+			sLONG				fChunkCount;
+			IParallelChunkRunner*	fRunner;
+	mutable	sLONG				fPendingChunks;
+			sLONG				fFailed;
+			VErrorContext*		fErrors;	// errors of the first failing chunk
+};
+
+
+void VTaskPoolGroup::RunChunk( sLONG inChunk)
+{
+	// once a chunk failed, remaining ones are only counted
+	if (VInterlocked::AtomicGet( &fFailed) != 0)
+		return;
+
+	// computed on 64 bits: begin + fGrainSize may not fit in a sLONG near the end of the range
+	sLONG8 begin = (sLONG8) fBegin + (sLONG8) inChunk * fGrainSize;
+	sLONG8 end = begin + fGrainSize;
+	if (end > fEnd)
+		end = fEnd;
+
+	// errors are collected here and pushed into the calling task context by VTaskPool::Run
+	StErrorContextInstaller errorContext( false);
+
+	fRunner->RunChunk( inChunk, (sLONG) begin, (sLONG) end);
+
+	if (errorContext.GetLastError() != VE_OK)
+	{
+		if (VInterlocked::Exchange( &fFailed, 1) == 0)
+			fErrors = new VErrorContext( *errorContext.GetContext());
+	}
+}
+
+
+/*
+	A range of chunks of a loop.
+*/
+class VTaskPoolJob : public VObject
+{
+public:
+								VTaskPoolJob( VTaskPoolGroup *inGroup, sLONG inFirstChunk, sLONG inEndChunk)
+									: fGroup( inGroup), fFirstChunk( inFirstChunk), fEndChunk( inEndChunk)	{;}
+
+			VTaskPoolGroup*		fGroup;
+			sLONG				fFirstChunk;
+			sLONG				fEndChunk;
+};
+
+
+/*
+	Chase-Lev work-stealing deque with a fixed capacity.
+	Only the owner calls Push and Pop (at the bottom), any other task may call Steal (at the top).
+	Indexes grow forever and wrap around: they are always compared through their difference.
+	When the deque is full the owner runs the job itself instead of splitting it further.
+*/
+class VWorkStealingDeque
+{
+public:
+	enum { kCapacity = 1024 };	// must be a power of 2
+
+								VWorkStealingDeque() : fTop( 0), fBottom( 0)		{ ::memset( fJobs, 0, sizeof( fJobs));}
+
+			bool				Push( VTaskPoolJob *inJob);
+			VTaskPoolJob*		Pop();
+			VTaskPoolJob*		Steal( bool *outContended);
+			bool				IsEmpty() const;
+
+private:
+	static	sLONG				_Distance( sLONG inFrom, sLONG inTo)				{ return (sLONG) ((uLONG) inTo - (uLONG) inFrom);}
+
+	mutable	sLONG				fTop;
+	mutable	sLONG				fBottom;
+			VTaskPoolJob*		fJobs[kCapacity];
+};
+
+
+bool VWorkStealingDeque::Push( VTaskPoolJob *inJob)
+{
+	sLONG bottom = fBottom;
+	sLONG top = VInterlocked::AtomicGet( &fTop);
+	if (_Distance( top, bottom) >= kCapacity)
+		return false;
+
+	fJobs[bottom & (kCapacity - 1)] = inJob;
+
+	// publishes the job (full barrier)
+	VInterlocked::Exchange( &fBottom, (sLONG) ((uLONG) bottom + 1));
+	return true;
+}
+
+
+VTaskPoolJob* VWorkStealingDeque::Pop()
+{
+	sLONG bottom = (sLONG) ((uLONG) fBottom - 1);
+
+	// the new bottom must be visible to thieves before reading top (full barrier)
+	VInterlocked::Exchange( &fBottom, bottom);
+	sLONG top = VInterlocked::AtomicGet( &fTop);
+
+	sLONG size = _Distance( top, bottom);
+	if (size < 0)
+	{
+		// was empty
+		VInterlocked::Exchange( &fBottom, top);
+		return NULL;
+	}
+
+	VTaskPoolJob *job = fJobs[bottom & (kCapacity - 1)];
+	if (size == 0)
+	{
+		// last job: race against thieves
+		if (VInterlocked::CompareExchange( &fTop, top, (sLONG) ((uLONG) top + 1)) != top)
+			job = NULL;
+		VInterlocked::Exchange( &fBottom, (sLONG) ((uLONG) top + 1));
+	}
+	return job;
+}
+
+
+VTaskPoolJob* VWorkStealingDeque::Steal( bool *outContended)
+{
+	sLONG top = VInterlocked::AtomicGet( &fTop);
+	sLONG bottom = VInterlocked::AtomicGet( &fBottom);
+
+	if (_Distance( top, bottom) <= 0)
+		return NULL;
+
+	VTaskPoolJob *job = fJobs[top & (kCapacity - 1)];
+	if (VInterlocked::CompareExchange( &fTop, top, (sLONG) ((uLONG) top + 1)) != top)
+	{
+		// lost the race against the owner or another thief
+		*outContended = true;
+		return NULL;
+	}
+	return job;
+}
+
+
+bool VWorkStealingDeque::IsEmpty() const
+{
+	return _Distance( VInterlocked::AtomicGet( &fTop), VInterlocked::AtomicGet( &fBottom)) <= 0;
+}
+
+
+/*
+	A worker task and its deque.
+*/
+class VTaskPoolWorker : public VObject
+{
+public:
+								VTaskPoolWorker( VTaskPool *inPool, sLONG inIndex)
+									: fPool( inPool), fIndex( inIndex), fTask( NULL), fRandomSeed( (uLONG) inIndex * 2654435761U + 1)	{;}
+
+								~VTaskPoolWorker()						{ ReleaseRefCountable( &fTask);}
+
+			// xorshift, used to pick a victim to steal from
+			uLONG				NextRandom()							{ fRandomSeed ^= fRandomSeed << 13; fRandomSeed ^= fRandomSeed >> 17; fRandomSeed ^= fRandomSeed << 5; return fRandomSeed;}
+
+			VTaskPool*			fPool;
+			sLONG				fIndex;
+			VTask*				fTask;
+			uLONG				fRandomSeed;
+			VWorkStealingDeque	fDeque;
+};
+
+
+//================================================================================================================
+
+
+VTaskPool *VTaskPool::sInstance = NULL;
+
+
+VTaskPool::VTaskPool( sLONG inWorkerCount)
+: fWorkerCount( _ComputeWorkerCount( inWorkerCount))
+, fStarted( 0)
+, fWakeUp( 0, (fWorkerCount > 0) ? fWorkerCount : 1)
+, fSleepingCount( 0)
+, fInjectedCount( 0)
+, fExecutedCount( 0)
+, fStolenCount( 0)
+{
+}
+
+
+VTaskPool::~VTaskPool()
+{
+	Stop();
+}
+
+
+//static
+VTaskPool* VTaskPool::Get()
+{
+	if (sInstance == NULL)
+	{
+		// workers are only started by the first loop
+		VTaskPool *pool = new VTaskPool;
+		if (VInterlocked::CompareExchangePtr( (void**) &sInstance, NULL, pool) != NULL)
+			pool->Release();	// another task was faster
+	}
+	return sInstance;
+}
+
+
+//static
+void VTaskPool::DeInit()
+{
+	VTaskPool *pool = VInterlocked::ExchangePtr( &sInstance);
+	ReleaseRefCountable( &pool);
+}
+
+
+bool VTaskPool::_StartWorkers()
+{
+	StLocker<VCriticalSection> lock( &fLock);
+
+	if (fStarted == 0)
+	{
+		for( sLONG i = 0 ; i < fWorkerCount ; ++i)
+		{
+			VTaskPoolWorker *worker = new VTaskPoolWorker( this, i);
+			VTask *task = (worker != NULL) ? new VTask( this, 0, eTaskStylePreemptive, &VTaskPool::_WorkerTaskProc) : NULL;
+			if (task == NULL)
+			{
+				delete worker;
+				break;
+			}
+
+			VString name( "Task pool worker ");
+			name.AppendLong( i + 1);
+			task->SetName( name);
+			task->SetKind( kTaskPoolTaskKind);
+			task->SetKindData( (sLONG_PTR) worker);
+			worker->fTask = task;
+			fWorkers.push_back( worker);
+		}
+
+		// the workers vector never changes while they are running
+		for( std::vector<VTaskPoolWorker*>::iterator i = fWorkers.begin() ; i != fWorkers.end() ; ++i)
+			(*i)->fTask->Run();
+
+		VInterlocked::Exchange( &fStarted, 1);
+	}
+
+	return fStarted == 1;
+}
+
+
+void VTaskPool::Stop()
+{
+	StLocker<VCriticalSection> lock( &fLock);
+
+	if (fStarted == 1)
+	{
+		for( std::vector<VTaskPoolWorker*>::iterator i = fWorkers.begin() ; i != fWorkers.end() ; ++i)
+			(*i)->fTask->Kill();
+
+		for( std::vector<VTaskPoolWorker*>::iterator i = fWorkers.begin() ; i != fWorkers.end() ; ++i)
+		{
+			fWakeUp.Unlock();
+			(*i)->fTask->WaitForDeath( 5000);
+		}
+
+		for( std::vector<VTaskPoolWorker*>::iterator i = fWorkers.begin() ; i != fWorkers.end() ; ++i)
+		{
+			xbox_assert( (*i)->fDeque.IsEmpty());
+			delete *i;
+		}
+		fWorkers.clear();
+	}
+	VInterlocked::Exchange( &fStarted, 2);
+}
+
+
+VTaskPoolWorker* VTaskPool::_GetCurrentWorker() const
+{
+	VTask *task = VTask::GetCurrent();
+	if ( (task != NULL) && (task->GetKind() == kTaskPoolTaskKind) )
+	{
+		VTaskPoolWorker *worker = (VTaskPoolWorker*) task->GetKindData();
+		if ( (worker != NULL) && (worker->fPool == this) )
+			return worker;
+	}
+	return NULL;
+}
+
+
+void VTaskPool::_WakeUpWorker()
+{
+	if (VInterlocked::AtomicGet( &fSleepingCount) > 0)
+		fWakeUp.Unlock();
+}
+
+
+void VTaskPool::_PushJob( VTaskPoolWorker *inWorker, VTaskPoolJob *inJob)
+{
+	if ( (inWorker == NULL) || !inWorker->fDeque.Push( inJob) )
+	{
+		StLocker<VCriticalSection> lock( &fLock);
+		fInjectedJobs.push_back( inJob);
+		VInterlocked::Increment( &fInjectedCount);
+	}
+	_WakeUpWorker();
+}
+
+
+VTaskPoolJob* VTaskPool::_StealJob( VTaskPoolWorker *inThief)
+{
+	sLONG count = (sLONG) fWorkers.size();
+	if (count == 0)
+		return NULL;
+
+	// visit every other worker starting with a random one, and retry while some steal failed on contention
+	bool contended;
+	do
+	{
+		contended = false;
+		sLONG start = (sLONG) (((inThief != NULL) ? inThief->NextRandom() : VSystem::GetCurrentTime()) % (uLONG) count);
+		for( sLONG i = 0 ; i < count ; ++i)
+		{
+			VTaskPoolWorker *victim = fWorkers[(start + i) % count];
+			if (victim != inThief)
+			{
+				VTaskPoolJob *job = victim->fDeque.Steal( &contended);
+				if (job != NULL)
+				{
+					VInterlocked::Increment( &fStolenCount);
+					return job;
+				}
+			}
+		}
+	} while( contended);
+
+	return NULL;
+}
+
+
+VTaskPoolJob* VTaskPool::_FindJob( VTaskPoolWorker *inWorker)
+{
+	VTaskPoolJob *job = (inWorker != NULL) ? inWorker->fDeque.Pop() : NULL;
+
+	if ( (job == NULL) && (VInterlocked::AtomicGet( &fInjectedCount) > 0) )
+	{
+		StLocker<VCriticalSection> lock( &fLock);
+		if (!fInjectedJobs.empty())
+		{
+			job = fInjectedJobs.back();
+			fInjectedJobs.pop_back();
+			VInterlocked::Decrement( &fInjectedCount);
+		}
+	}
+
+	if (job == NULL)
+		job = _StealJob( inWorker);
+
+	return job;
+}
+
+
+void VTaskPool::_ExecuteJob( VTaskPoolWorker *inWorker, VTaskPoolJob *inJob)
+{
+	VTaskPoolGroup *group = inJob->fGroup;
+	sLONG first = inJob->fFirstChunk;
+	sLONG end = inJob->fEndChunk;
+	delete inJob;
+
+	// give the upper half away until one chunk is left
+	while( end - first > 1)
+	{
+		sLONG middle = first + (end - first) / 2;
+		VTaskPoolJob *half = new VTaskPoolJob( group, middle, end);
+		if (half == NULL)
+			break;
+		_PushJob( inWorker, half);
+		end = middle;
+	}
+
+	for( sLONG chunk = first ; chunk < end ; ++chunk)
+		group->RunChunk( chunk);
+
+	VInterlocked::Increment( &fExecutedCount);
+
+	// the group may be gone as soon as its last chunks are counted
+	VInterlocked::AtomicAdd( &group->fPendingChunks, first - end);
+}
+
+
+VError VTaskPool::Run( sLONG inBegin, sLONG inEnd, sLONG inGrainSize, IParallelChunkRunner *inRunner)
+{
+	if (inEnd <= inBegin)
+		return VE_OK;
+
+	if (inGrainSize < 1)
+		inGrainSize = 1;
+
+	VTaskPoolGroup group( inBegin, inEnd, inGrainSize, inRunner);
+
+	if ( (group.fChunkCount == 1) || (fWorkerCount == 0) || (VInterlocked::AtomicGet( &fStarted) == 2) || ( (VInterlocked::AtomicGet( &fStarted) == 0) && !_StartWorkers()) )
+	{
+		// nothing to share
+		for( sLONG chunk = 0 ; chunk < group.fChunkCount ; ++chunk)
+			group.RunChunk( chunk);
+	}
+	else
+	{
+		VTaskPoolWorker *worker = _GetCurrentWorker();
+
+		VTaskPoolJob *job = new VTaskPoolJob( &group, 0, group.fChunkCount);
+		if (job == NULL)
+			return vThrowError( VE_MEMORY_FULL);
+
+		// the calling task runs the first half of the loop itself, and pending jobs until the loop is completed
+		_ExecuteJob( worker, job);
+		while( !group.IsDone())
+		{
+			job = _FindJob( worker);
+			if (job != NULL)
+				_ExecuteJob( worker, job);
+			else
+				VTask::YieldNow();
+		}
+	}
+
+	VError err = VE_OK;
+	if (group.fErrors != NULL)
+	{
+		VTask::PushErrors( group.fErrors);
+		err = group.fErrors->GetLastError();
+	}
+	return err;
+}
+
+
+//static
+sLONG VTaskPool::_WorkerTaskProc( VTask *inTask)
+{
+	VTaskPoolWorker *worker = (VTaskPoolWorker*) inTask->GetKindData();
+	VTaskPool *pool = worker->fPool;
+
+	sLONG idleCount = 0;
+	while( !inTask->IsDying())
+	{
+		VTaskPoolJob *job = pool->_FindJob( worker);
+		if (job != NULL)
+		{
+			pool->_ExecuteJob( worker, job);
+			idleCount = 0;
+		}
+		else if (++idleCount < kIdleSpinCount)
+		{
+			VTask::YieldNow();
+		}
+		else
+		{
+			// check again once registered as sleeping so that a job pushed meanwhile is not missed
+			VInterlocked::Increment( &pool->fSleepingCount);
+			job = pool->_FindJob( worker);
+			if (job == NULL)
+				pool->fWakeUp.Lock( kIdleSleepMilliseconds);
+			VInterlocked::Decrement( &pool->fSleepingCount);
+
+			if (job != NULL)
+				pool->_ExecuteJob( worker, job);
+			idleCount = 0;
+		}
+	}
+
+	return 0;
+}
+
+
+void VTaskPool::GetStatistics( uLONG *outExecutedJobs, uLONG *outStolenJobs) const
+{
+	if (outExecutedJobs != NULL)
+		*outExecutedJobs = (uLONG) VInterlocked::AtomicGet( &fExecutedCount);
+	if (outStolenJobs != NULL)
+		*outStolenJobs = (uLONG) VInterlocked::AtomicGet( &fStolenCount);
+}
+
+
+END_TOOLBOX_NAMESPACE
@@ -0,0 +1,189 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VTaskPool__
+#define __VTaskPool__
+
+#include "Kernel/Sources/VTask.h"
+#include "Kernel/Sources/VSyncObject.h"
+#include "Kernel/Sources/VError.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+// Defined in VTaskPool.cpp
+class VTaskPoolWorker;
+class VTaskPoolJob;
+class VTaskPoolGroup;
+
+
+/*
+	Body of a parallel loop.
+	RunChunk is called once for each chunk of the range, from any worker task of the pool or from the calling task.
+*/
+class XTOOLBOX_API IParallelChunkRunner
+{
+public:
+	virtual								~IParallelChunkRunner()	{;}
+
+	virtual	void						RunChunk( sLONG inChunk, sLONG inBegin, sLONG inEnd) = 0;
+};
+
+
+/*!
+	@class	VTaskPool
+	@abstract	Fixed-size pool of preemptive VTasks to run short CPU-bound jobs.
+	@discussion
+		Each worker owns a Chase-Lev deque: it pushes and pops its own jobs at the bottom while idle workers steal from the top.
+		A loop is split recursively in halves so that the stolen jobs are the biggest ones.
+		The calling task never sleeps while a loop is running: it runs or steals pending jobs until the loop completes,
+		so that loops can be nested inside jobs.
+
+		Jobs run on regular VTasks so VTask::GetCurrent(), task data keys and intl managers behave as usual.
+		Each chunk runs inside its own error context. When a chunk fails, the remaining chunks are skipped,
+		the errors of the first failing chunk are pushed into the calling task error context and its last error is returned.
+		Chunks must not throw C++ exceptions.
+*/
+class XTOOLBOX_API VTaskPool : public VObject, public IRefCountable
+{
+public:
+	enum { kTaskPoolTaskKind = 'TPOL' };
+
+	// inWorkerCount <= 0 means one worker per processor minus one since the calling task runs jobs too.
+	explicit							VTaskPool( sLONG inWorkerCount = 0);
+
+	// Shared pool created on first use.
+	static	VTaskPool*					Get();
+	static	void						DeInit();
+
+	// Kills the workers and waits for their death. Loops still work after that but run on the calling task only.
+	// Must not be called while loops are running.
+			void						Stop();
+
+			sLONG						GetWorkerCount() const						{ return fWorkerCount;}
+
+	// true if the current task is one of the workers of this pool.
+			bool						IsWorkerTask() const						{ return _GetCurrentWorker() != NULL;}
+
+	// Calls inRunner->RunChunk() for every chunk of inGrainSize items of [inBegin, inEnd[ and returns once all of them are done.
+			VError						Run( sLONG inBegin, sLONG inEnd, sLONG inGrainSize, IParallelChunkRunner *inRunner);
+
+	// inBody( sLONG inBegin, sLONG inEnd) is called for every chunk.
+	template<class Body>
+			VError						ParallelFor( sLONG inBegin, sLONG inEnd, sLONG inGrainSize, const Body& inBody);
+
+	// inBody( sLONG inBegin, sLONG inEnd, T& ioPartial) accumulates a chunk into a partial result initialized with inIdentity.
+	// inJoin( T& ioResult, const T& inPartial) is then called on the calling task in chunks order,
+	// so that the result does not depend on scheduling even if the join is not commutative.
+	template<class T, class Body, class Join>
+			VError						ParallelReduce( sLONG inBegin, sLONG inEnd, sLONG inGrainSize, const T& inIdentity, const Body& inBody, const Join& inJoin, T& outResult);
+
+	// Counts of jobs executed and of jobs stolen from another worker since the pool creation.
+			void						GetStatistics( uLONG *outExecutedJobs, uLONG *outStolenJobs) const;
+
+private:
+	friend class VTaskPoolWorker;
+
+	virtual								~VTaskPool();
+
+			bool						_StartWorkers();
+			VTaskPoolWorker*			_GetCurrentWorker() const;
+			VTaskPoolJob*				_FindJob( VTaskPoolWorker *inWorker);
+			VTaskPoolJob*				_StealJob( VTaskPoolWorker *inThief);
+			void						_PushJob( VTaskPoolWorker *inWorker, VTaskPoolJob *inJob);
+			void						_ExecuteJob( VTaskPoolWorker *inWorker, VTaskPoolJob *inJob);
+			void						_WakeUpWorker();
+	static	sLONG						_WorkerTaskProc( VTask *inTask);
+
+	static	VTaskPool*					sInstance;
+
+			sLONG						fWorkerCount;
+			sLONG						fStarted;		// 0: not yet, 1: started, 2: stopped
+			std::vector<VTaskPoolWorker*>	fWorkers;
+			VSemaphore					fWakeUp;
+			sLONG						fSleepingCount;
+	mutable	VCriticalSection			fLock;
+			std::vector<VTaskPoolJob*>	fInjectedJobs;	// jobs split by tasks that are not workers (under fLock)
+			sLONG						fInjectedCount;
+	mutable	sLONG						fExecutedCount;
+	mutable	sLONG						fStolenCount;
+};
+
+
+template<class Body>
+class VParallelForRunner : public IParallelChunkRunner
+{
+public:
+										VParallelForRunner( const Body& inBody) : fBody( inBody)	{;}
+	virtual	void						RunChunk( sLONG /*inChunk*/, sLONG inBegin, sLONG inEnd)	{ fBody( inBegin, inEnd);}
+private:
+			const Body&					fBody;
+};
+
+
+template<class T, class Body>
+class VParallelReduceRunner : public IParallelChunkRunner
+{
+public:
+										VParallelReduceRunner( const Body& inBody, std::vector<T>& ioPartials) : fBody( inBody), fPartials( ioPartials)	{;}
+	virtual	void						RunChunk( sLONG inChunk, sLONG inBegin, sLONG inEnd)	{ fBody( inBegin, inEnd, fPartials[inChunk]);}
+private:
+			const Body&					fBody;
+			std::vector<T>&				fPartials;
+};
+
+
+template<class Body>
+VError VTaskPool::ParallelFor( sLONG inBegin, sLONG inEnd, sLONG inGrainSize, const Body& inBody)
+{
+	VParallelForRunner<Body> runner( inBody);
+	return Run( inBegin, inEnd, inGrainSize, &runner);
+}
+
+
+template<class T, class Body, class Join>
+VError VTaskPool::ParallelReduce( sLONG inBegin, sLONG inEnd, sLONG inGrainSize, const T& inIdentity, const Body& inBody, const Join& inJoin, T& outResult)
+{
+	outResult = inIdentity;
+	if (inEnd <= inBegin)
+		return VE_OK;
+
+	if (inGrainSize < 1)
+		inGrainSize = 1;
+	sLONG8 count = ((sLONG8) inEnd - inBegin + inGrainSize - 1) / inGrainSize;
+
+	std::vector<T> partials;
+	try
+	{
+		partials.resize( (size_t) count, inIdentity);
+	}
+	catch(...)
+	{
+		return vThrowError( VE_MEMORY_FULL);
+	}
+
+	VParallelReduceRunner<T,Body> runner( inBody, partials);
+	VError err = Run( inBegin, inEnd, inGrainSize, &runner);
+	if (err == VE_OK)
+	{
+		for( typename std::vector<T>::const_iterator i = partials.begin() ; i != partials.end() ; ++i)
+			inJoin( outResult, *i);
+	}
+	return err;
+}
+
+
+END_TOOLBOX_NAMESPACE
+
+#endif
@@ -796,6 +796,16 @@ static bool _Convert(const T* inSource, VIndex inSourceChars, VIndex *outCharsCo
 
     while (srcPtr < srcEnd)
     {
+		// most strings are plain ascii: copy runs of them without computing the encoded length of each char
+		if ( (inBuffer != NULL) && (static_cast<uLONG>( *srcPtr) < 0x80) )
+		{
+			const T *runEnd = srcPtr + Min( (VSize) (srcEnd - srcPtr), (VSize) (outEnd - outPtr));
+			while( (srcPtr < runEnd) && (static_cast<uLONG>( *srcPtr) < 0x80) )
+				*outPtr++ = (uBYTE) *srcPtr++;
+			if (srcPtr == runEnd)
+				break;
+		}
+
         //
         //  Tentatively get the next char out. We have to get it into a
         //  32 bit value, because it could be a surrogate pair.
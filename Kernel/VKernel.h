@@ -50,6 +50,7 @@
 #include "Kernel/Sources/VPictureHelper.h"
 #include "Kernel/Sources/VJSONTools.h"
 #include "Kernel/Sources/VJSONValue.h"
+#include "Kernel/Sources/VBinaryValue.h"
 #include "Kernel/Sources/VLogger.h"
 #include "Kernel/Sources/VLog4jMsgFile.h"
 #include "Kernel/Sources/VTextStyle.h"
@@ -98,6 +99,9 @@
 #include "Kernel/Sources/VSmallCriticalSection.h"
 #include "Kernel/Sources/VSyncObject.h"
 #include "Kernel/Sources/VTask.h"
+#include "Kernel/Sources/VTaskPool.h"
+#include "Kernel/Sources/VParallelSort.h"
+#include "Kernel/Sources/VFileAsyncIO.h"
 #include "Kernel/Sources/VInterlocked.h"
 
 // Text Convertion Headers
@@ -97,6 +97,16 @@ sLONG VProcessLauncher::WaitForData ()
 	return fProcessLauncherImpl->WaitForData();
 }
 
+sLONG VProcessLauncher::WaitForData (sLONG inTimeoutMilliseconds)
+{
+	return fProcessLauncherImpl->WaitForData(inTimeoutMilliseconds);
+}
+
+void VProcessLauncher::InterruptWait ()
+{
+	fProcessLauncherImpl->InterruptWait();
+}
+
 sLONG VProcessLauncher::ReadFromChild(char *outBuffer, long inBufferSize)
 {
 	return fProcessLauncherImpl->ReadFromChild(outBuffer, inBufferSize);
@@ -114,6 +114,8 @@ public:
 	 
 					- eVPLTerminated		External process is terminated.
 	 
+					- eVPLTimeout			Timed wait only: timeout has elapsed or InterruptWait() has been called.
+	 
 	 */
 	
 	enum {
@@ -122,7 +124,8 @@ public:
 		eVPLStdOutFlag		= 1, 
 		eVPLStdErrFlag		= 2,
 		eVPLBothFlags		= eVPLStdOutFlag | eVPLStdErrFlag,
-		eVPLTerminated		= 4
+		eVPLTerminated		= 4,
+		eVPLTimeout			= 8
 		
 	};
 
@@ -218,6 +221,16 @@ static	bool		KillProcess (sLONG inPid);
 	
 		/** @brief	Block and wait for data or external process termination. */	
 		sLONG		WaitForData ();
+
+		/** @brief	Same as WaitForData() but returns eVPLTimeout after inTimeoutMilliseconds (-1 means no timeout) or if InterruptWait() is called.
+		 *			On Linux, termination is signaled as soon as it happens (pidfd). Elsewhere, it is signaled by the end of stdout and stderr, 
+		 *			or found by polling once they are closed. On Windows, this only sleeps a few milliseconds.
+		 *			Flags are hints: always read both pipes and check IsRunning() after the call.
+		 */
+		sLONG		WaitForData (sLONG inTimeoutMilliseconds);
+
+		/** @brief	Make a WaitForData( inTimeoutMilliseconds) pending in another thread return immediately. */
+		void		InterruptWait ();
 		
 		/** @brief	Read from the child's STDOUT. Returns the number of bytes read or -1. Non-blocking call, return 0 if no data.*/
 		sLONG		ReadFromChild(char *outBuffer, long inBufferSize);
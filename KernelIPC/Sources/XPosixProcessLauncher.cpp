@@ -19,6 +19,7 @@
 
 #include <sys/wait.h>
 #include <sys/select.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <set>
 #include <signal.h>
@@ -26,8 +27,16 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#if VERSION_LINUX
+#include <sys/syscall.h>
+#endif
+
 #define kInvalidDescriptor -1
 
+// Without pidfd, once stdout and stderr are closed, termination of the child is polled at this interval (milliseconds).
+
+#define kExitPollingInterval	10
+
 
 
 
@@ -112,6 +121,10 @@ XPosixProcessLauncher::XPosixProcessLauncher()
 	fPipeChildToParent[pWriteSide]		= kInvalidDescriptor ;
 	fPipeChildErrorToParent[pReadSide]	= kInvalidDescriptor ;
 	fPipeChildErrorToParent[pWriteSide] = kInvalidDescriptor ;
+	fWakeUpPipe[pReadSide]				= kInvalidDescriptor ;
+	fWakeUpPipe[pWriteSide]				= kInvalidDescriptor ;
+	fPidDescriptor						= kInvalidDescriptor ;
+	fIsStdOutClosed = fIsStdErrClosed = false;
 
 	fRedirectStandardInput = true;
 	fRedirectStandardOutput = true;
@@ -147,6 +160,8 @@ XPosixProcessLauncher::~XPosixProcessLauncher()
     _CloseRWPipe(fPipeParentToChild);
     _CloseRWPipe(fPipeChildToParent);
     _CloseRWPipe(fPipeChildErrorToParent);
+    _CloseRWPipe(fWakeUpPipe);
+    _CloseOnePipe(&fPidDescriptor);
     			
 	delete [] fCurrentDirectory;
 	delete [] fBinaryPath;
@@ -323,6 +338,121 @@ sLONG XPosixProcessLauncher::WaitForData ()
 		return VProcessLauncher::eVPLError;	
 }
 
+sLONG XPosixProcessLauncher::WaitForData (sLONG inTimeoutMilliseconds)
+{
+	if (!fIsRunning)
+
+		return VProcessLauncher::eVPLTerminated;
+
+	struct pollfd	fds[4];
+	int				count, stdOutIndex, stdErrIndex, pidIndex, wakeUpIndex;
+
+	count = 0;
+	stdOutIndex = stdErrIndex = pidIndex = wakeUpIndex = -1;
+
+	// A pipe which has been closed by the child would always be "ready", don't poll it anymore.
+
+	if (fPipeChildToParent[pReadSide] != kInvalidDescriptor && !fIsStdOutClosed) {
+
+		fds[count].fd = fPipeChildToParent[pReadSide];
+		fds[count].events = POLLIN;
+		stdOutIndex = count++;
+
+	}
+	if (fPipeChildErrorToParent[pReadSide] != kInvalidDescriptor && !fIsStdErrClosed) {
+
+		fds[count].fd = fPipeChildErrorToParent[pReadSide];
+		fds[count].events = POLLIN;
+		stdErrIndex = count++;
+
+	}
+	if (fPidDescriptor != kInvalidDescriptor) {
+
+		fds[count].fd = fPidDescriptor;
+		fds[count].events = POLLIN;
+		pidIndex = count++;
+
+	} else if (stdOutIndex < 0 && stdErrIndex < 0) {
+
+		// Nothing will tell the termination, poll it.
+
+		if (inTimeoutMilliseconds < 0 || inTimeoutMilliseconds > kExitPollingInterval)
+
+			inTimeoutMilliseconds = kExitPollingInterval;
+
+	}
+	if (fWakeUpPipe[pReadSide] != kInvalidDescriptor) {
+
+		fds[count].fd = fWakeUpPipe[pReadSide];
+		fds[count].events = POLLIN;
+		wakeUpIndex = count++;
+
+	}
+
+	int	r;
+
+	r = poll(fds, count, inTimeoutMilliseconds < 0 ? -1 : inTimeoutMilliseconds);
+	if (r < 0)
+
+		return errno == EINTR ? VProcessLauncher::eVPLTimeout : VProcessLauncher::eVPLError;
+
+	sLONG	code	= 0;
+
+	// BSD and Mac OS X report POLLHUP along with POLLIN for a closed pipe, even once it is drained. The flag
+	// is still returned so the caller reads what is left: nothing can be written to the pipe anymore.
+
+	if (stdOutIndex >= 0) {
+
+		if (fds[stdOutIndex].revents & POLLIN)
+
+			code |= VProcessLauncher::eVPLStdOutFlag;
+
+		if (fds[stdOutIndex].revents & (POLLHUP | POLLERR | POLLNVAL))
+
+			fIsStdOutClosed = true;
+
+	}
+	if (stdErrIndex >= 0) {
+
+		if (fds[stdErrIndex].revents & POLLIN)
+
+			code |= VProcessLauncher::eVPLStdErrFlag;
+
+		if (fds[stdErrIndex].revents & (POLLHUP | POLLERR | POLLNVAL))
+
+			fIsStdErrClosed = true;
+
+	}
+	if (pidIndex >= 0 && fds[pidIndex].revents)
+
+		code |= VProcessLauncher::eVPLTerminated;
+
+	if (wakeUpIndex >= 0 && (fds[wakeUpIndex].revents & POLLIN)) {
+
+		char	buffer[64];
+
+		while (read(fWakeUpPipe[pReadSide], buffer, sizeof(buffer)) > 0)
+
+			;
+
+	}
+
+	return code ? code : VProcessLauncher::eVPLTimeout;
+}
+
+void XPosixProcessLauncher::InterruptWait ()
+{
+	if (fWakeUpPipe[pWriteSide] != kInvalidDescriptor) {
+
+		char	c	= 0;
+
+		// Pipe is non-blocking, if full a wake up is already pending.
+
+		(void) write(fWakeUpPipe[pWriteSide], &c, 1);
+
+	}
+}
+
 
 sLONG XPosixProcessLauncher::ReadFromChild(char *outBuffer, long inBufferSize)
 {
@@ -505,6 +635,35 @@ sLONG XPosixProcessLauncher::Start(const EnvVarNamesAndValuesMap &inVarToUse)
 			_CloseOnePipe(&fPipeChildToParent[pWriteSide]);
 			_CloseOnePipe(&fPipeChildErrorToParent[pWriteSide]);
 
+			// Descriptors for WaitForData( inTimeoutMilliseconds). Children close all inherited descriptors, 
+			// so there is no need for close-on-exec.
+
+			fIsStdOutClosed = fIsStdErrClosed = false;
+			if (fWakeUpPipe[pReadSide] == kInvalidDescriptor) {
+
+				if (pipe(fWakeUpPipe) == 0) {
+
+					_SetNonBlocking(fWakeUpPipe[pReadSide]);
+					_SetNonBlocking(fWakeUpPipe[pWriteSide]);
+
+				} else
+
+					_InvalidateRWPipe(fWakeUpPipe);
+
+			}
+
+#if VERSION_LINUX && defined(__NR_pidfd_open)
+
+			// Fails with ENOSYS before Linux 5.3, termination is then polled.
+
+			_CloseOnePipe(&fPidDescriptor);
+			fPidDescriptor = (int) syscall(__NR_pidfd_open, fProcessID, 0);
+			if (fPidDescriptor < 0)
+
+				fPidDescriptor = kInvalidDescriptor;
+
+#endif
+
 			break;
 	}
 	
@@ -523,6 +682,8 @@ bool XPosixProcessLauncher::IsRunning()
 			fProcessID = 0;
 			fIsRunning = false;	
 
+			_CloseOnePipe(&fPidDescriptor);
+
 		}		
 		
 	}
@@ -630,6 +791,7 @@ sLONG XPosixProcessLauncher::Shutdown(bool inWithKillIndependantChildProcess)
 			fIsRunning = false;	
 		}
 	}
+	_CloseOnePipe(&fPidDescriptor);
 	
 	return error;
 }
@@ -912,7 +1074,11 @@ sLONG XPosixProcessLauncher::_ReadFromPipe(int inPipe, char *outBuffer, long inB
 	}
 	else if (nb_read == 0)
 	{
-		// there is nothing more to be read
+		// there is nothing more to be read, WaitForData( inTimeoutMilliseconds) mustn't poll it anymore
+		if (inPipe == fPipeChildToParent[pReadSide])
+			fIsStdOutClosed = true;
+		else if (inPipe == fPipeChildErrorToParent[pReadSide])
+			fIsStdErrClosed = true;
 		nb_read = -1;
 	}
 	
@@ -50,6 +50,8 @@ public:
 		sLONG		WriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes, bool inClosePipeAfterWritting = false);
 	
 		sLONG		WaitForData ();
+		sLONG		WaitForData (sLONG inTimeoutMilliseconds);
+		void		InterruptWait ();
 	
 		// Reads are non-blocking.
 		
@@ -86,6 +88,10 @@ private:
 		int			fPipeParentToChild[2];
 		int			fPipeChildToParent[2];
 		int			fPipeChildErrorToParent[2];
+		int			fWakeUpPipe[2];				// Written by InterruptWait().
+		int			fPidDescriptor;				// Linux pidfd, readable once the child has terminated.
+		bool		fIsStdOutClosed;			// Pipes seen closed by WaitForData( inTimeoutMilliseconds).
+		bool		fIsStdErrClosed;
 		
 		enum
 		{
@@ -15,6 +15,7 @@
 */
 #include "VKernelIPCPrecompiled.h"
 #include "XWinProcessLauncher.h"
+#include "VProcessLauncher.h"
 
 extern VMemory *gMemory;
 
@@ -217,6 +218,17 @@ sLONG XWinProcessLauncher::WriteToChild(const void *inBuffer, uLONG inBufferSize
 }
 
 
+// Anonymous pipes can't be waited on, so just sleep a little: the caller reads both pipes and checks IsRunning() anyway.
+
+sLONG XWinProcessLauncher::WaitForData (sLONG inTimeoutMilliseconds)
+{
+	static const sLONG	kMaximumSleep	= 10;
+
+	VTask::Sleep((inTimeoutMilliseconds < 0 || inTimeoutMilliseconds > kMaximumSleep) ? kMaximumSleep : inTimeoutMilliseconds);
+
+	return VProcessLauncher::eVPLTimeout;
+}
+
 sLONG XWinProcessLauncher::ReadFromChild(char *outBuffer, long inBufferSize)
 {
 	if(testAssert(fChildStdOutReadDup != INVALID_HANDLE_VALUE))
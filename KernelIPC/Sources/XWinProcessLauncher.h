@@ -50,6 +50,8 @@ inline	void		SetRedirectStandardOutput(bool isStandardOutputRedirected)		{ fRedi
 		sLONG		WriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes, bool inClosePipeAfterWritting = false);
 
 		sLONG		WaitForData ()	{ return 0;	/* TODO */ }
+		sLONG		WaitForData (sLONG inTimeoutMilliseconds);
+		void		InterruptWait ()	{}
 	
 		sLONG		ReadFromChild(char *outBuffer, long inBufferSize);
 		sLONG		ReadErrorFromChild(char *outBuffer, long inBufferSize);
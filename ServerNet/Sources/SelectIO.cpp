@@ -29,6 +29,13 @@
 	#include <functional>
 #endif
 
+#if VERSION_LINUX
+	#include <sys/epoll.h>
+	#include <sys/eventfd.h>
+	#include <unistd.h>
+	#include <errno.h>
+#endif
+
 
 BEGIN_TOOLBOX_NAMESPACE
 
@@ -162,6 +169,9 @@ VTCPSelectAction::VTCPSelectAction (Socket inSocket)
 	fLastSocketError = 0;
 	fLastSystemSocketError = 0;
 	fLastError = VE_OK;
+#if VERSION_LINUX
+	fPeerClosed = false;
+#endif
 }
 
 VTCPSelectAction::~VTCPSelectAction ()
@@ -238,6 +248,24 @@ void VTCPSelectReadAction::DoAction (fd_set* fdSockets)
 
 		return;
 
+	_ReadSocket();
+}
+
+bool VTCPSelectReadAction::_IsProcessed ()
+{
+	bool	bResult;
+
+	fProcessedLock.Lock();
+	bResult = fIsProcessed;
+	fProcessedLock.Unlock();
+
+	return bResult;
+}
+
+bool VTCPSelectReadAction::_ReadSocket ()
+{
+	int	nRawSocket	= GetRawSocket();
+
 #if VERSIONMAC || VERSION_LINUX
 	ssize_t nRead=0;
 #else
@@ -246,7 +274,14 @@ void VTCPSelectReadAction::DoAction (fd_set* fdSockets)
 	
 	if(fSslDelegate==NULL)
 	{
+#if VERSION_LINUX
+		nRead = recv(nRawSocket, GetBuffer(), *GetFullBufferSize(), MSG_DONTWAIT);
+
+		if (nRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return false;	//Spurious wakeup, keep reader waiting
+#else
 		nRead = recv(nRawSocket, GetBuffer(), *GetFullBufferSize(), 0);
+#endif
 		
 		DEBUG_CHECK_SOCK_RESULT( nRead, "recv", nRawSocket);
 	}
@@ -260,11 +295,20 @@ void VTCPSelectReadAction::DoAction (fd_set* fdSockets)
 		if(verr==VE_OK && size>0)
 			nRead=size;
 		else if(verr==VE_SOCK_WOULD_BLOCK)
-			return;	//Nothing to update, no notification
+			return false;	//Nothing to update, no notification
 	}
 
+	bool	bMayHaveMore = false;
+
 	if ( nRead > 0 ) {
 
+		// A full buffer means there may be more data, SSL may also have buffered some.
+		// Once the peer has closed, the end of stream will not be signaled by another edge.
+
+		bMayHaveMore = fSslDelegate != NULL || static_cast<uLONG>(nRead) == *GetFullBufferSize ( );
+#if VERSION_LINUX
+		bMayHaveMore = bMayHaveMore || IsPeerClosed ( );
+#endif
 		UpdateFullBufferSize ( static_cast<uLONG>(nRead) );
 
 	} else if ( nRead == 0 ) {
@@ -278,13 +322,14 @@ void VTCPSelectReadAction::DoAction (fd_set* fdSockets)
 
 		UpdateFullBufferSize ( 0 );
 		
-		//TODO : Put socket error in logs
 		SetLastSocketError ( static_cast<sLONG>(nRead));
 		SetLastSystemSocketError ( VTCPSelectIOHandler::GetLastSocketError ( ) );
 		SetLastError ( VE_SRVR_READ_FAILED );
 	
 	}
 	NotifyActionComplete ( );
+
+	return bMayHaveMore;
 }
 
 void VTCPSelectReadAction::HandleError (fd_set* fdSockets)
@@ -321,6 +366,65 @@ void VTCPSelectReadAction::HandleError (fd_set* fdSockets)
 	}
 }
 
+#if VERSION_LINUX
+
+bool VTCPSelectReadAction::DoEdgeAction ()
+{
+	// If no Read() is waiting, keep the edge until one is.
+
+	if (_IsProcessed())
+
+		return true;
+
+	return _ReadSocket();
+}
+
+bool VTCPSelectReadAction::HandleEdgeError ()
+{
+	// Pending error will be reported by recv() once a Read() is waiting.
+
+	if (_IsProcessed())
+
+		return true;
+
+	int				nError = 0;
+	socklen_t		nSize = sizeof ( nError );
+	int				nResult = getsockopt ( GetRawSocket ( ), SOL_SOCKET, SO_ERROR, ( char* ) &nError, &nSize );
+
+	DEBUG_CHECK_SOCK_RESULT( nResult, "getsockopt", GetRawSocket ( ));
+
+	if ( nError == 0 )
+
+		return true;	// Let the ready pass do the read.
+
+	SetLastSocketError ( -1 );
+	SetLastSystemSocketError ( nError );
+	SetLastError ( VE_SRVR_READ_FAILED );
+
+	UpdateFullBufferSize(0);
+	NotifyActionComplete();
+
+	return false;
+}
+
+bool VTCPSelectReadAction::CheckPendingRead ()
+{
+	if (_IsProcessed())
+
+		return false;
+
+	if (!TimeOutExpired())
+
+		return true;
+
+	SetLastError(VE_SRVR_READ_TIMED_OUT);
+	NotifyActionComplete();
+
+	return false;
+}
+
+#endif
+
 VTCPSelectWatchAction::VTCPSelectWatchAction (Socket inSocket, VEndPoint *inEndPoint, void *inData, CTCPSelectIOHandler::ReadCallback *inCallback)
 : VTCPSelectAction(inSocket)
 {
@@ -383,12 +487,73 @@ void VTCPSelectWatchAction::HandleError (fd_set* fdSockets)
 	}
 }
 
+#if VERSION_LINUX
+
+bool VTCPSelectWatchAction::DoEdgeAction ()
+{
+	if (!TriggerReadCallback(0)) {
+
+		SetLastError(VE_SRVR_READ_FAILED);	// Socket will no longer be watched.
+		return false;
+
+	}
+
+	// Callback usually reads only a buffer's worth of data. As the edge will not be reported again, peek
+	// for remaining data (or end of stream) and trigger callback again on next pass if any.
+
+	char	c;
+
+	return recv(GetRawSocket(), &c, 1, MSG_PEEK | MSG_DONTWAIT) >= 0;
+}
+
+bool VTCPSelectWatchAction::HandleEdgeError ()
+{
+	int				nError = 0;
+	socklen_t		nSize = sizeof ( nError );
+	int				nResult = getsockopt ( GetRawSocket ( ), SOL_SOCKET, SO_ERROR, ( char* ) &nError, &nSize );
+
+	DEBUG_CHECK_SOCK_RESULT( nResult, "getsockopt", GetRawSocket ( ));
+
+	if ( nError == 0 )
+
+		return true;
+
+	SetLastSocketError(-1);
+	SetLastSystemSocketError (nError);
+	SetLastError(VE_SRVR_READ_FAILED);
+
+	TriggerReadCallback(nError);
+
+	return false;
+}
+
+#endif
+
 VTCPSelectIOHandler::VTCPSelectIOHandler ( ) :
 									VTask ( NULL, 0, XBOX::eTaskStylePreemptive, NULL ),
 									fReadSockLock ( )
 {
 	SetName ( "ServerNet select I/O handler" );
 	fReadCount = 0;
+
+#if VERSION_LINUX
+
+	fEpollFD = epoll_create1(EPOLL_CLOEXEC);
+	fWakeUpFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	xbox_assert(fEpollFD != -1 && fWakeUpFD != -1);
+
+	if (fEpollFD != -1 && fWakeUpFD != -1) {
+
+		struct epoll_event	event;
+
+		event.events = EPOLLIN;
+		event.data.fd = fWakeUpFD;
+		epoll_ctl(fEpollFD, EPOLL_CTL_ADD, fWakeUpFD, &event);
+
+	}
+
+#endif
 }
 
 VTCPSelectIOHandler::~VTCPSelectIOHandler ( )
@@ -396,16 +561,391 @@ VTCPSelectIOHandler::~VTCPSelectIOHandler ( )
 	if ( !fReadSockLock. Lock ( ) )
 		return;
 
+#if VERSION_LINUX
+
+	fActions.clear();
+	fReadySockets.clear();
+	fPendingReads.clear();
+
+	if (fWakeUpFD != -1)
+		close(fWakeUpFD);
+
+	if (fEpollFD != -1)
+		close(fEpollFD);
+
+#else
+
 	fReadSockList.clear();
 
+#endif
+
 	fReadSockLock. Unlock ( );
 }
 
 void VTCPSelectIOHandler::Stop ( )
 {
 	Kill ( );
+
+#if VERSION_LINUX
+
+	_WakeUp();
+
+#endif
+}
+
+
+#if VERSION_LINUX
+
+Boolean VTCPSelectIOHandler::DoRun ( )
+{
+	return _DoRunEpoll();
+}
+
+Boolean VTCPSelectIOHandler::_DoRunEpoll ( )
+{
+	struct epoll_event	events[kMAX_EPOLL_EVENTS];
+
+	while ( GetState ( ) != TS_DYING && GetState ( ) != TS_DEAD )
+	{
+		StDropErrorContext errCtx;
+
+		// Don't wait if some ready sockets still have data for a watcher or a waiting reader.
+
+		bool	hasWork = false;
+
+		if ( !fReadSockLock. Lock ( ) )
+			break;
+
+		for (std::set<Socket>::iterator i = fReadySockets.begin(); i != fReadySockets.end() && !hasWork; ++i) {
+
+			MapOfActions::iterator	iterAction = fActions.find(*i);
+
+			hasWork = iterAction != fActions.end() 
+					&& (iterAction->second->GetType() == VTCPSelectAction::eTYPE_WATCH || fPendingReads.find(*i) != fPendingReads.end());
+
+		}
+
+		if ( !fReadSockLock. Unlock ( ) )
+			break;
+
+		int		nEvents = epoll_wait(fEpollFD, events, kMAX_EPOLL_EVENTS, hasWork ? 0 : kEPOLL_TIMEOUT);
+
+		if (nEvents < 0) {
+
+			if (errno != EINTR) {
+
+				DEBUG_CHECK_RESULT( nEvents, "epoll_wait from IOHandler");
+				Sleep ( 5 );
+
+			}
+			nEvents = 0;
+
+		}
+
+		if ( !fReadSockLock. Lock ( ) )
+			break;
+
+		if (nEvents > 0)
+			fReadCount++;
+
+		for (int i = 0; i < nEvents; i++) {
+
+			Socket	nRawSocket = events[i].data.fd;
+
+			if (nRawSocket == fWakeUpFD) {
+
+				uint64_t	value;
+
+				while (read(fWakeUpFD, &value, sizeof(value)) > 0)
+					;
+				continue;
+
+			}
+
+			// Action may have been removed since epoll_wait() returned.
+
+			MapOfActions::iterator	iterAction = fActions.find(nRawSocket);
+
+			if (iterAction == fActions.end() || iterAction->second->GetLastError() != VE_OK)
+
+				continue;
+
+			VRefPtr<VTCPSelectAction>	vtcpAction = iterAction->second;
+
+			if (events[i].events & (EPOLLRDHUP | EPOLLHUP))
+
+				vtcpAction->SetPeerClosed();
+
+			if ((events[i].events & EPOLLERR) && !vtcpAction->HandleEdgeError())
+
+				fReadySockets.erase(nRawSocket);
+
+			else
+
+				fReadySockets.insert(nRawSocket);
+
+		}
+
+		// Service ready sockets. Those which are drained are removed, they will be signaled again by epoll.
+		// Work on a copy, as a watch callback may remove its socket.
+
+		std::vector<Socket>	readySockets(fReadySockets.begin(), fReadySockets.end());
+
+		for (std::vector<Socket>::iterator i = readySockets.begin(); i != readySockets.end(); ++i) {
+
+			MapOfActions::iterator	iterAction = fActions.find(*i);
+
+			if (iterAction == fActions.end()) {
+
+				fReadySockets.erase(*i);
+				continue;
+
+			}
+
+			VRefPtr<VTCPSelectAction>	vtcpAction = iterAction->second;
+
+			if (vtcpAction->GetLastError() != VE_OK || !vtcpAction->DoEdgeAction())
+
+				fReadySockets.erase(*i);
+
+		}
+
+		// Check time-outs of waiting readers, they are few.
+
+		std::set<Socket>::iterator	iterPending = fPendingReads.begin();
+
+		while (iterPending != fPendingReads.end()) {
+
+			MapOfActions::iterator	iterAction = fActions.find(*iterPending);
+
+			if (iterAction == fActions.end() 
+			|| iterAction->second->GetType() != VTCPSelectAction::eTYPE_READ
+			|| !((VTCPSelectReadAction *) iterAction->second.Get())->CheckPendingRead())
+
+				fPendingReads.erase(iterPending++);
+
+			else
+
+				++iterPending;
+
+		}
+
+		if ( !fReadSockLock. Unlock ( ) )
+			break;
+
+		//Correction pour freeze des clients mono core : Corrige ce qui semble etre un pb d'ordonnancement sur les
+		//machines ne disposant que d'un coeur. ACI0068696
+		static sLONG cpuCount=VSystem::GetNumberOfProcessors();
+
+		if(cpuCount==1)
+			VTask::YieldNow();
+	}
+
+	/* TODO: Before exit, should notify all waiting threads and let them know that there will be no more reading/writing. */
+	return true;
+}
+
+VError VTCPSelectIOHandler::_AddAction (VTCPSelectAction *inAction)
+{
+	// Caller must hold fReadSockLock.
+
+	struct epoll_event	event;
+
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	event.data.fd = inAction->GetRawSocket();
+
+	if (fEpollFD == -1 || epoll_ctl(fEpollFD, EPOLL_CTL_ADD, inAction->GetRawSocket(), &event) != 0) {
+
+		DEBUG_CHECK_SOCK_RESULT( -1, "epoll_ctl", inAction->GetRawSocket());
+
+		// Let the pool try another handler.
+
+		return VE_SRVR_TOO_MANY_SOCKETS_FOR_SELECT_IO;
+
+	}
+
+	fActions[inAction->GetRawSocket()] = inAction;
+
+	return VE_OK;
+}
+
+VError VTCPSelectIOHandler::_RemoveAction (Socket inRawSocket, sLONG inType)
+{
+	// Caller must hold fReadSockLock.
+
+	MapOfActions::iterator	iterAction = fActions.find(inRawSocket);
+
+	if (iterAction == fActions.end())
+
+		return VE_SRVR_SOCKET_IS_NOT_READING;
+
+	xbox_assert(iterAction->second->GetType() == inType);
+
+	// Socket may already be closed, in which case it has been removed from epoll set automatically.
+
+	struct epoll_event	event;
+
+	epoll_ctl(fEpollFD, EPOLL_CTL_DEL, inRawSocket, &event);
+
+	if (inType == VTCPSelectAction::eTYPE_READ)
+
+		 // Socket may be removed for reading by another thread via ForceClose call.
+		 // In this case I need to notify original reader that the read is over.
+
+		((VTCPSelectReadAction *) iterAction->second.Get())->NotifyActionComplete();
+
+	fActions.erase(iterAction);
+	fReadySockets.erase(inRawSocket);
+	fPendingReads.erase(inRawSocket);
+
+	return VE_OK;
+}
+
+void VTCPSelectIOHandler::_WakeUp ()
+{
+	uint64_t	value	= 1;
+
+	if (fWakeUpFD != -1)
+		write(fWakeUpFD, &value, sizeof(value));
+}
+
+VError VTCPSelectIOHandler::AddSocketForReading ( Socket inRawSocket, VSslDelegate* inSSLDelegate )
+{
+	if ( !fReadSockLock. Lock ( ) )
+		return VE_SRVR_FAILED_TO_SYNC_LOCK;
+
+	xbox_assert( inRawSocket != -1);
+
+	VError				vError = VE_OK;
+	if ( fActions.find(inRawSocket) == fActions.end() )
+	{
+		VTCPSelectAction*			vtcpAction = new VTCPSelectReadAction ( inRawSocket, 0, 0, inSSLDelegate );
+		vError = _AddAction ( vtcpAction );
+		ReleaseRefCountable( &vtcpAction);
+	}
+	else
+		vError = VE_SRVR_SOCKET_ALREADY_READING;
+
+	if ( !fReadSockLock. Unlock ( ) )
+		if ( vError == VE_OK )
+			vError = VE_SRVR_FAILED_TO_SYNC_LOCK;
+
+	return vError;
+}
+
+VError VTCPSelectIOHandler::RemoveSocketForReading ( Socket inRawSocket )
+{
+	if ( !fReadSockLock. Lock ( ) )
+		return VE_SRVR_FAILED_TO_SYNC_LOCK;
+	
+	VError		vError = _RemoveAction ( inRawSocket, VTCPSelectAction::eTYPE_READ );
+
+	if ( !fReadSockLock. Unlock ( ) )
+		vError = VE_SRVR_FAILED_TO_SYNC_LOCK;
+
+	return vError;
 }
 
+VError VTCPSelectIOHandler::AddSocketForWatching (Socket inRawSocket, VEndPoint *inEndPoint, void *inData, CTCPSelectIOHandler::ReadCallback *inCallback)
+{
+	if (!fReadSockLock.Lock())
+
+		return VE_SRVR_FAILED_TO_SYNC_LOCK;
+
+	xbox_assert(inRawSocket != -1);
+
+	VError					vError = VE_OK;
+	MapOfActions::iterator	iterAction = fActions.find(inRawSocket);
+
+	if (iterAction == fActions.end()) {
+
+		VTCPSelectAction	*vtcpAction	= new VTCPSelectWatchAction(inRawSocket, inEndPoint, inData, inCallback);
+
+		vError = _AddAction(vtcpAction);
+		ReleaseRefCountable(&vtcpAction);
+
+	} else {
+
+		xbox_assert(iterAction->second->GetType() == VTCPSelectAction::eTYPE_WATCH);
+		vError = VE_SRVR_SOCKET_ALREADY_WATCHING;
+
+	}
+
+	if (!fReadSockLock.Unlock() && vError == VE_OK)
+
+		vError = VE_SRVR_FAILED_TO_SYNC_LOCK;
+
+	return vError;
+}
+
+VError VTCPSelectIOHandler::RemoveSocketForWatching (Socket inRawSocket)
+{
+	if (!fReadSockLock. Lock())
+
+		return VE_SRVR_FAILED_TO_SYNC_LOCK;
+	
+	VError	vError = _RemoveAction(inRawSocket, VTCPSelectAction::eTYPE_WATCH);
+
+	if (!fReadSockLock.Unlock())
+
+		vError = VE_SRVR_FAILED_TO_SYNC_LOCK;
+
+	return vError;
+}
+
+VError VTCPSelectIOHandler::Read ( Socket inRawSocket, char* inBuffer, uLONG* nBufferLength, sLONG& outError, sLONG& outSystemError, uLONG inTimeOutMillis )
+{
+	xbox_assert( inRawSocket != -1);
+
+	if ( !fReadSockLock. Lock ( ) )
+		return VE_SRVR_FAILED_TO_SYNC_LOCK;
+
+	VError							vError = VE_OK;
+	VRefPtr<VTCPSelectReadAction>	vtcpSelectReadAction;
+	MapOfActions::iterator			iterAction = fActions.find ( inRawSocket );
+
+	if ( iterAction == fActions. end ( ) )
+		vError = VE_SRVR_SOCKET_IS_NOT_READING;
+	else
+	{
+		xbox_assert(iterAction->second->GetType() == VTCPSelectAction::eTYPE_READ);
+
+		vtcpSelectReadAction = (VTCPSelectReadAction *) iterAction->second.Get();
+		vtcpSelectReadAction-> SetBuffer ( inBuffer );
+		vtcpSelectReadAction-> SetFullBufferSize ( nBufferLength );
+		vtcpSelectReadAction-> SetProcessed ( false );
+		vtcpSelectReadAction-> SetTimeOut ( inTimeOutMillis );
+
+		fPendingReads.insert ( inRawSocket );
+
+		// Data may have arrived before the read was requested, its edge has already been consumed.
+
+		if ( fReadySockets.find ( inRawSocket ) != fReadySockets.end ( ) )
+			_WakeUp ( );
+	}
+	
+	if ( !fReadSockLock. Unlock ( ) )
+		vError = VE_SRVR_FAILED_TO_SYNC_LOCK;
+
+	if ( vError != VE_OK )
+		return vError;
+
+	bool		bWait = vtcpSelectReadAction-> WaitForAction ( );
+	if ( !bWait )
+		vError = VE_SRVR_FAILED_TO_SYNC_LOCK;
+
+	vError = vtcpSelectReadAction-> GetLastError ( );
+	if ( vError != VE_OK )
+	{
+		outError = vtcpSelectReadAction-> GetLastSocketError ( );
+		outSystemError = vtcpSelectReadAction-> GetLastSystemSocketError ( );
+	}
+
+	return vError;
+}
+
+#else
+
 void VTCPSelectIOHandler::AddToFDSet ( VTCPSelectAction* vtcpSelectAction, fd_set* fdSockets )
 {
 	if ( vtcpSelectAction-> GetLastError ( ) != VE_OK )
@@ -727,6 +1267,8 @@ void VTCPSelectIOHandler::HandleError ( VTCPSelectAction* vtcpSelectAction, fd_s
 	vtcpSelectAction->HandleError(fdSockets);
 }
 
+#endif
+
 sLONG VTCPSelectIOHandler::GetLastSocketError ( )
 {
 	#if VERSIONWIN
@@ -736,6 +1278,8 @@ sLONG VTCPSelectIOHandler::GetLastSocketError ( )
 	#endif
 }
 
+#if !VERSION_LINUX
+
 sLONG VTCPSelectIOHandler::GetActiveReadCount ( )
 {
 	if ( !fReadSockLock. Lock ( ) )
@@ -756,4 +1300,6 @@ sLONG VTCPSelectIOHandler::GetActiveReadCount ( )
 	return nResult;
 }
 
+#endif
+
 END_TOOLBOX_NAMESPACE
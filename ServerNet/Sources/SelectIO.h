@@ -116,6 +116,22 @@ virtual	sLONG		GetType () = 0;
 virtual void		DoAction (fd_set* fdSockets) = 0;
 virtual void		HandleError (fd_set* fdSockets) = 0;
 
+#if VERSION_LINUX
+
+		// Edge-triggered (epoll) counterparts of DoAction() and HandleError(). Socket is known to be ready,
+		// return true if it may still have pending data (socket stays in handler's ready set).
+
+virtual bool		DoEdgeAction () = 0;
+virtual bool		HandleEdgeError () = 0;
+
+		// Peer has shut down its side (EPOLLRDHUP or EPOLLHUP). The read reporting end of stream must
+		// still be done, even if the last data came with the same edge.
+
+		void		SetPeerClosed ()						{	fPeerClosed = true;	}
+		bool		IsPeerClosed ()							{	return fPeerClosed;	}
+
+#endif
+
 	protected:
 
 					VTCPSelectAction (Socket inSocket);
@@ -128,6 +144,9 @@ virtual void		HandleError (fd_set* fdSockets) = 0;
 		sLONG		fLastSocketError;
 		sLONG		fLastSystemSocketError;
 		VError		fLastError;
+#if VERSION_LINUX
+		bool		fPeerClosed;
+#endif
 };
 
 
@@ -157,12 +176,28 @@ virtual sLONG	GetType ()									{	return VTCPSelectAction::eTYPE_READ;	}
 virtual void	DoAction (fd_set* fdSockets);
 virtual void	HandleError (fd_set* fdSockets);
 
+#if VERSION_LINUX
+
+virtual bool	DoEdgeAction ();
+virtual bool	HandleEdgeError ();
+
+		// Return true if a Read() is still waiting for data. Notify reader with VE_SRVR_READ_TIMED_OUT if its time-out has expired.
+
+		bool	CheckPendingRead ();
+
+#endif
+
 	protected:
 
 virtual			~VTCPSelectReadAction()	{}
 
 	private:
 
+		// Do the actual read and notify the waiting reader. Return true if socket may still have data.
+
+		bool				_ReadSocket ();
+		bool				_IsProcessed ();
+
 		char*				fBuffer;
 		uLONG*				fBufferSize;
 		VSyncEvent			fSyncEvtProcessed;
@@ -188,6 +223,13 @@ virtual sLONG	GetType ()					{	return VTCPSelectAction::eTYPE_WATCH;	}
 virtual void	DoAction (fd_set* fdSockets);
 virtual void	HandleError (fd_set* fdSockets);
 
+#if VERSION_LINUX
+
+virtual bool	DoEdgeAction ();
+virtual bool	HandleEdgeError ();
+
+#endif
+
 	protected:
 
 virtual			~VTCPSelectWatchAction ()	{}
@@ -224,17 +266,52 @@ class XTOOLBOX_API VTCPSelectIOHandler : public CTCPSelectIOHandler, public VTas
 
 	private :
 
+#if VERSION_LINUX
+
+		// On Linux, an edge-triggered epoll instance is used instead of select(). There is no FD_SETSIZE limit and 
+		// a wakeup only costs the ready sockets. As edges are reported only once, sockets signaled but not yet 
+		// drained are kept in fReadySockets. fPendingReads holds sockets with a Read() waiting (time-out check).
+
+		typedef std::map<Socket, XBOX::VRefPtr<VTCPSelectAction> >	MapOfActions;
+
+		enum {
+
+			kMAX_EPOLL_EVENTS	= 256,
+			kEPOLL_TIMEOUT		= 100	// milliseconds
+
+		};
+
+		MapOfActions									fActions;
+		std::set<Socket>								fReadySockets;
+		std::set<Socket>								fPendingReads;
+		int												fEpollFD;
+		int												fWakeUpFD;
+
+		VError			_AddAction (VTCPSelectAction *inAction);
+		VError			_RemoveAction (Socket inRawSocket, sLONG inType);
+		void			_WakeUp ();
+		Boolean			_DoRunEpoll ();
+
+#else
+
 		std::list<XBOX::VRefPtr<VTCPSelectAction> >		fReadSockList;
-		VCriticalSection								fReadSockLock;
 
 		fd_set											fReadSockSet;
+
+#endif
+
+		VCriticalSection								fReadSockLock;
 		sLONG8											fReadCount;
 
+#if !VERSION_LINUX
+
 		static void AddToFDSet ( VTCPSelectAction* vtcpSelectAction, fd_set* fdSockets );
 		static void HandleRead ( VTCPSelectAction* vtcpSelectAction, fd_set* fdSockets );
 		static void HandleError ( VTCPSelectAction* vtcpSelectAction, fd_set* fdSockets );
 
 		sLONG GetActiveReadCount ( );
+
+#endif
 };
 
 
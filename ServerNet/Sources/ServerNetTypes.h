@@ -54,6 +54,38 @@ HTTP_Method;
 
 const sLONG kAUTO_YIELD_TIMEOUT=50; //WaitFor will call Yield every 50 ms
 
+
+// One buffer of a scatter/gather write (see VTCPEndPoint::WriteBuffersExactly)
+typedef struct VNetBuffer
+{
+	const void*	fData;
+	uLONG		fLength;
+} VNetBuffer;
+
+// Scatter/gather writes on SSL sockets are coalesced in records of at most this size (max TLS record payload)
+const uLONG kMAX_COALESCED_SSL_WRITE=16384;
+
+// Copy as many bytes of inBuffers as possible in outDest (up to inMaxLen) ; returns the count of copied bytes.
+inline uLONG CoalesceNetBuffers(const VNetBuffer* inBuffers, uLONG inCount, char* outDest, uLONG inMaxLen)
+{
+	uLONG total=0;
+
+	for(uLONG i=0 ; i<inCount && total<inMaxLen ; i++)
+	{
+		uLONG len=inBuffers[i].fLength;
+
+		if(len>inMaxLen-total)
+			len=inMaxLen-total;
+
+		if(len>0)
+			::memcpy(outDest+total, inBuffers[i].fData, len);
+
+		total+=len;
+	}
+
+	return total;
+}
+
 #define WITH_SHARED_WORKERS 0
 
 
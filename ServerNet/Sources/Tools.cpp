@@ -25,6 +25,7 @@
 #include "VTCPEndPoint.h"
 
 #include "VProxyManager.h"
+#include "VHTTPClient.h"
 
 #if VERSIONMAC || VERSION_LINUX
 	#include <netdb.h>
@@ -250,6 +251,8 @@ void VServerNetManager::DeInit()
 		{
 			xbox_assert(sInstance->fInitCount==0);
 
+			VHTTPConnectionPool::DeInit();
+
 #if ALLOW_SERVERNET_DEINIT
 
 			delete sInstance;
@@ -78,6 +78,43 @@ XBOX::VError VEndPointStream::DoPutData (const void *inBuffer, VSize inNbBytes)
 		return XBOX::VE_OK;	
 }
 
+XBOX::VError VEndPointStream::PutBuffers (const VNetBuffer *inBuffers, uLONG inCount)
+{
+	xbox_assert(fEndPoint != NULL);
+
+	XBOX::VError	error;
+
+	if ((error = Flush()) != XBOX::VE_OK)
+
+		return error;
+
+	if ((error = fEndPoint->WriteBuffersExactly(inBuffers, inCount, fTimeOut)) == XBOX::VE_OK)
+
+		for (uLONG i = 0; i < inCount; i++)
+
+			fTotalBytes += inBuffers[i].fLength;
+
+	return error;
+}
+
+XBOX::VError VEndPointStream::PutFile (const XBOX::VFile &inFile, sLONG8 inOffset, sLONG8 inLength)
+{
+	xbox_assert(fEndPoint != NULL);
+
+	XBOX::VError	error;
+	sLONG8			size;
+
+	if ((error = Flush()) != XBOX::VE_OK)
+
+		return error;
+
+	size = 0;
+	error = fEndPoint->SendFile(inFile, inOffset, inLength, fTimeOut, &size);
+	fTotalBytes += size;
+
+	return error;
+}
+
 XBOX::VError VEndPointStream::DoGetData (void *inBuffer, VSize *ioCount)
 {
 	xbox_assert(fEndPoint != NULL);
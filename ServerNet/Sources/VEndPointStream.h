@@ -31,6 +31,12 @@ public:
 
 	void					SetTimeOut (sLONG inTimeOut);
 
+	// Scatter/gather and file writes, see VTCPEndPoint::WriteBuffersExactly() and VTCPEndPoint::SendFile().
+	// Data buffered by the stream, if any, is flushed first.
+
+	XBOX::VError			PutBuffers (const VNetBuffer *inBuffers, uLONG inCount);
+	XBOX::VError			PutFile (const XBOX::VFile &inFile, sLONG8 inOffset = 0, sLONG8 inLength = -1);
+
 protected:
 
 	// VTCPEndPoint opening or closing is not to be handled by VEndPointStream.
@@ -44,6 +44,16 @@ const sLONG	DEFAULT_HTTP_READ_WRITE_TIMEOUT					= 3600;		/* 60 mins in seconds *
 const sLONG DEFAULT_HTTP_MAX_REDIRECTIONS					= 2;
 const sLONG DEFAULT_HTTP_PORT								= 80;
 const sLONG DEFAULT_HTTPS_PORT								= 443;
+const sLONG DEFAULT_HTTP_MAX_PIPELINE_DEPTH					= 8;
+
+/*
+ *	Connection Pool
+ */
+const sLONG DEFAULT_POOL_MAX_CONNECTIONS_PER_HOST			= 16;
+const sLONG DEFAULT_POOL_MAX_IDLE_CONNECTIONS_PER_HOST		= 8;
+const sLONG DEFAULT_POOL_IDLE_TIMEOUT_MS					= 4000;		/* below the default keep-alive timeout of most servers */
+const uLONG POOL_PURGE_INTERVAL_MS							= 1000;
+const sLONG POOL_WAIT_STEP_MS								= 10;
 
 const XBOX::VString	HTTP_CLIENT_DEFAULT_USER_AGENT			= CVSTR ("4D_HTTP_Client");
 
@@ -743,6 +753,323 @@ void VAuthInfos::Clear()
 //--------------------------------------------------------------------------------------------------
 
 
+VHTTPConnectionPool *VHTTPConnectionPool::sInstance = NULL;
+
+
+VHTTPConnectionPool::VHTTPConnectionPool()
+: fMaxConnectionsPerHost (DEFAULT_POOL_MAX_CONNECTIONS_PER_HOST)
+, fMaxIdleConnectionsPerHost (DEFAULT_POOL_MAX_IDLE_CONNECTIONS_PER_HOST)
+, fIdleTimeoutMS (DEFAULT_POOL_IDLE_TIMEOUT_MS)
+, fLastPurge (XBOX::VSystem::GetCurrentTime())
+{
+	::memset (&fStatistics, 0, sizeof (fStatistics));
+}
+
+
+VHTTPConnectionPool::~VHTTPConnectionPool()
+{
+	PurgeIdleConnections (true);
+}
+
+
+//static
+VHTTPConnectionPool *VHTTPConnectionPool::Get()
+{
+	if (NULL == sInstance)
+	{
+		VHTTPConnectionPool *pool = new VHTTPConnectionPool();
+
+		if (NULL != XBOX::VInterlocked::CompareExchangePtr ((void **) &sInstance, NULL, pool))
+			delete pool;	// another task was faster
+	}
+
+	xbox_assert (NULL != sInstance);
+
+	return sInstance;
+}
+
+
+//static
+void VHTTPConnectionPool::DeInit()
+{
+	// leased connections may still be given back later: only idle ones are closed
+	if (NULL != sInstance)
+		sInstance->PurgeIdleConnections (true);
+}
+
+
+//static
+void VHTTPConnectionPool::MakeKey (bool inUseSSL, const XBOX::VString& inDomain, sLONG inPort, const XBOX::VString& inProxy, sLONG inProxyPort, XBOX::VString& outKey)
+{
+	XBOX::VString domain (inDomain);
+
+	domain.ToLowerCase();
+
+	outKey.FromCString (inUseSSL ? "https://" : "http://");
+	outKey.AppendString (domain);
+	outKey.AppendUniChar (CHAR_COLON);
+	outKey.AppendLong (inPort);
+
+	if (!inProxy.IsEmpty())
+	{
+		XBOX::VString proxy (inProxy);
+
+		proxy.ToLowerCase();
+
+		outKey.AppendCString (" via ");
+		outKey.AppendString (proxy);
+		outKey.AppendUniChar (CHAR_COLON);
+		outKey.AppendLong (inProxyPort);
+	}
+}
+
+
+XBOX::VError VHTTPConnectionPool::AcquireConnection (const XBOX::VString& inKey, sLONG inTimeoutMS, XBOX::VTCPEndPoint **outEndPoint)
+{
+	if (NULL == outEndPoint)
+		return XBOX::vThrowError (XBOX::VE_INVALID_PARAMETER);
+
+	*outEndPoint = NULL;
+
+	XBOX::VError						error = XBOX::VE_OK;
+	std::vector<XBOX::VTCPEndPoint*>	toClose;
+	uLONG								startTime = XBOX::VSystem::GetCurrentTime();
+	bool								isReserved = false;
+	bool								hasWaited = false;
+
+	while (!isReserved && (XBOX::VE_OK == error))
+	{
+		{
+			XBOX::StLocker<XBOX::VCriticalSection>	lock (&fLock);
+			uLONG									now = XBOX::VSystem::GetCurrentTime();
+
+			if ((now - fLastPurge) >= POOL_PURGE_INTERVAL_MS)
+			{
+				for (MapOfHostConnections::iterator i = fHosts.begin(); i != fHosts.end(); ++i)
+					_PurgeIdleConnections (i->second, now, false, toClose);
+				fLastPurge = now;
+			}
+
+			HostConnections& host = fHosts[inKey];
+
+			// most recently used first: it is the least likely to have been closed by the server
+			while (!host.fIdleConnections.empty() && (NULL == *outEndPoint))
+			{
+				IdleConnection idle = host.fIdleConnections.back();
+				host.fIdleConnections.pop_back();
+
+				if ((now - idle.fIdleSince) > (uLONG) fIdleTimeoutMS)
+				{
+					toClose.push_back (idle.fEndPoint);
+					++fStatistics.fEvicted;
+				}
+				else if (idle.fEndPoint->HasUnreadData())
+				{
+					// nothing should be readable on an idle keep-alive connection: the server closed it (or sent garbage)
+					toClose.push_back (idle.fEndPoint);
+					++fStatistics.fFailedHealthChecks;
+				}
+				else
+				{
+					*outEndPoint = idle.fEndPoint;
+				}
+			}
+
+			if (NULL != *outEndPoint)
+			{
+				++host.fLeasedCount;
+				++fStatistics.fHits;
+				isReserved = true;
+			}
+			else if (host.fLeasedCount < fMaxConnectionsPerHost)
+			{
+				++host.fLeasedCount;
+				++fStatistics.fMisses;
+				isReserved = true;
+			}
+			else if ((sLONG) (now - startTime) >= inTimeoutMS)
+			{
+				++fStatistics.fTimeouts;
+				error = VE_SRVR_CONNECTION_FAILED;
+			}
+			else if (!hasWaited)
+			{
+				++fStatistics.fWaits;
+				hasWaited = true;
+			}
+		}
+
+		// never close sockets while holding the lock
+		_CloseEndPoints (toClose);
+
+		if (XBOX::VE_OK != error)
+			error = XBOX::vThrowError (error);
+		else if (!isReserved)
+			XBOX::VTask::Sleep (POOL_WAIT_STEP_MS);
+	}
+
+	return error;
+}
+
+
+void VHTTPConnectionPool::RecycleConnection (const XBOX::VString& inKey, XBOX::VTCPEndPoint *inEndPoint)
+{
+	if (NULL == inEndPoint)
+	{
+		ForgetConnection (inKey, NULL);
+		return;
+	}
+
+	std::vector<XBOX::VTCPEndPoint*> toClose;
+
+	{
+		XBOX::StLocker<XBOX::VCriticalSection>	lock (&fLock);
+		MapOfHostConnections::iterator			i = fHosts.find (inKey);
+
+		if (testAssert ((i != fHosts.end()) && (i->second.fLeasedCount > 0)))
+		{
+			HostConnections&	host = i->second;
+			IdleConnection		idle;
+
+			idle.fEndPoint = inEndPoint;
+			idle.fIdleSince = XBOX::VSystem::GetCurrentTime();
+
+			--host.fLeasedCount;
+			host.fIdleConnections.push_back (idle);
+			++fStatistics.fRecycled;
+			inEndPoint = NULL;
+
+			// too many idle connections: close the oldest one
+			if (host.fIdleConnections.size() > (size_t) fMaxIdleConnectionsPerHost)
+			{
+				toClose.push_back (host.fIdleConnections.front().fEndPoint);
+				host.fIdleConnections.erase (host.fIdleConnections.begin());
+				++fStatistics.fEvicted;
+			}
+		}
+	}
+
+	if (NULL != inEndPoint)
+		toClose.push_back (inEndPoint);
+
+	_CloseEndPoints (toClose);
+}
+
+
+void VHTTPConnectionPool::ForgetConnection (const XBOX::VString& inKey, XBOX::VTCPEndPoint *inEndPoint)
+{
+	{
+		XBOX::StLocker<XBOX::VCriticalSection>	lock (&fLock);
+		MapOfHostConnections::iterator			i = fHosts.find (inKey);
+
+		if (testAssert ((i != fHosts.end()) && (i->second.fLeasedCount > 0)))
+			--i->second.fLeasedCount;
+	}
+
+	if (NULL != inEndPoint)
+	{
+		inEndPoint->Close();
+		XBOX::ReleaseRefCountable (&inEndPoint);
+	}
+}
+
+
+void VHTTPConnectionPool::PurgeIdleConnections (bool inAll)
+{
+	std::vector<XBOX::VTCPEndPoint*> toClose;
+
+	{
+		XBOX::StLocker<XBOX::VCriticalSection>	lock (&fLock);
+		uLONG									now = XBOX::VSystem::GetCurrentTime();
+
+		for (MapOfHostConnections::iterator i = fHosts.begin(); i != fHosts.end(); )
+		{
+			_PurgeIdleConnections (i->second, now, inAll, toClose);
+
+			if (i->second.fIdleConnections.empty() && (0 == i->second.fLeasedCount))
+				fHosts.erase (i++);
+			else
+				++i;
+		}
+		fLastPurge = now;
+	}
+
+	_CloseEndPoints (toClose);
+}
+
+
+void VHTTPConnectionPool::SetMaxConnectionsPerHost (sLONG inValue)
+{
+	fMaxConnectionsPerHost = (inValue > 0) ? inValue : 1;
+}
+
+
+void VHTTPConnectionPool::SetMaxIdleConnectionsPerHost (sLONG inValue)
+{
+	fMaxIdleConnectionsPerHost = (inValue >= 0) ? inValue : 0;
+}
+
+
+void VHTTPConnectionPool::GetStatistics (VHTTPConnectionPoolStatistics& outStatistics) const
+{
+	XBOX::StLocker<XBOX::VCriticalSection> lock (&fLock);
+
+	outStatistics = fStatistics;
+	outStatistics.fIdleCount = 0;
+	outStatistics.fLeasedCount = 0;
+
+	for (MapOfHostConnections::const_iterator i = fHosts.begin(); i != fHosts.end(); ++i)
+	{
+		outStatistics.fIdleCount += (sLONG) i->second.fIdleConnections.size();
+		outStatistics.fLeasedCount += i->second.fLeasedCount;
+	}
+}
+
+
+void VHTTPConnectionPool::ResetStatistics()
+{
+	XBOX::StLocker<XBOX::VCriticalSection> lock (&fLock);
+
+	::memset (&fStatistics, 0, sizeof (fStatistics));
+}
+
+
+void VHTTPConnectionPool::_PurgeIdleConnections (HostConnections& ioHost, uLONG inNow, bool inAll, std::vector<XBOX::VTCPEndPoint*>& ioToClose)
+{
+	std::vector<IdleConnection>::iterator i = ioHost.fIdleConnections.begin();
+
+	while (i != ioHost.fIdleConnections.end())
+	{
+		if (inAll || ((inNow - i->fIdleSince) > (uLONG) fIdleTimeoutMS))
+		{
+			ioToClose.push_back (i->fEndPoint);
+			i = ioHost.fIdleConnections.erase (i);
+			++fStatistics.fEvicted;
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+
+//static
+void VHTTPConnectionPool::_CloseEndPoints (std::vector<XBOX::VTCPEndPoint*>& ioEndPoints)
+{
+	for (std::vector<XBOX::VTCPEndPoint*>::iterator i = ioEndPoints.begin(); i != ioEndPoints.end(); ++i)
+	{
+		(*i)->Close();
+		XBOX::ReleaseRefCountable (&(*i));
+	}
+
+	ioEndPoints.clear();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+
+
 VAuthInfos						VHTTPClient::fSavedHTTPAuthenticationInfos;
 VAuthInfos						VHTTPClient::fSavedProxyAuthenticationInfos;
 XBOX::VString					VHTTPClient::fUserAgent;
@@ -785,6 +1112,10 @@ VHTTPClient::VHTTPClient()
 , fContentType()
 , fTCPEndPoint (NULL)
 , fNumberOfRequests (0)
+, fUseConnectionPool (false)
+, fPoolKey()
+, fConnectionReused (false)
+, fMaxPipelineDepth (DEFAULT_HTTP_MAX_PIPELINE_DEPTH)
 , fUseHTTPCompression (false)
 , fFollowRedirect (true)
 , fMaxRedirections (DEFAULT_HTTP_MAX_REDIRECTIONS)
@@ -833,6 +1164,10 @@ VHTTPClient::VHTTPClient (const XBOX::VURL& inURL, const XBOX::VString& inConten
 , fContentType()
 , fTCPEndPoint (NULL)
 , fNumberOfRequests (0)
+, fUseConnectionPool (false)
+, fPoolKey()
+, fConnectionReused (false)
+, fMaxPipelineDepth (DEFAULT_HTTP_MAX_PIPELINE_DEPTH)
 , fUseHTTPCompression (false)
 , fFollowRedirect (true)
 , fMaxRedirections (DEFAULT_HTTP_MAX_REDIRECTIONS)
@@ -1061,6 +1396,9 @@ XBOX::VError VHTTPClient::OpenConnection (XBOX::VTCPSelectIOPool *inSelectIOPool
 	XBOX::VString			dnsNameOrIP;
 	sLONG					port = 0;
 	bool					bSendConnectToProxy = false;
+	bool					bUseProxy = false;
+
+	fConnectionReused = false;
 
 	if (!fProxy.IsEmpty() && !XBOX::VProxyManager::ByPassProxyOnLocalhost (fDomain))
 	{
@@ -1078,6 +1416,7 @@ XBOX::VError VHTTPClient::OpenConnection (XBOX::VTCPSelectIOPool *inSelectIOPool
 		 *				communication (HTTPS) through an unencrypted HTTP proxy.[14][15]
 		 */
 		bSendConnectToProxy = fUseSSL;
+		bUseProxy = true;
 	}
 	else
 	{
@@ -1106,6 +1445,23 @@ XBOX::VError VHTTPClient::OpenConnection (XBOX::VTCPSelectIOPool *inSelectIOPool
 		}
 	}
 
+	if ((XBOX::VE_OK == error) && fUseConnectionPool && fKeepAlive && !fUpgradeRequest && (NULL == inSelectIOPool) && (NULL == fTCPEndPoint))
+	{
+		/*
+		 *	Take an idle connection from the pool (or reserve a slot for a new one)
+		 */
+		XBOX::VString poolKey;
+
+		VHTTPConnectionPool::MakeKey (fUseSSL, fDomain, fPort, bUseProxy ? fProxy : XBOX::VString(), fProxyPort, poolKey);
+
+		error = VHTTPConnectionPool::Get()->AcquireConnection (poolKey, XBOX::Abs(fConnectionTimeout) * 1000, &fTCPEndPoint);
+		if (XBOX::VE_OK == error)
+		{
+			fPoolKey.FromString (poolKey);
+			fConnectionReused = (NULL != fTCPEndPoint);
+		}
+	}
+
 	if (XBOX::VE_OK == error)
 	{
 		/*
@@ -1113,12 +1469,16 @@ XBOX::VError VHTTPClient::OpenConnection (XBOX::VTCPSelectIOPool *inSelectIOPool
 		 */
 		error = _OpenConnection (dnsNameOrIP, port, bSendConnectToProxy ? false : fUseSSL, inSelectIOPool);
 
+		if ((XBOX::VE_OK != error) && !fPoolKey.IsEmpty())
+			CloseConnection();	// frees the slot reserved in the pool
+
 		if (XBOX::VE_OK == error)
 		{
-			if (fNumberOfRequests > 0)
+			if ((fNumberOfRequests > 0) || fConnectionReused)
 				fLeftOver.Clear();
 
-			if (bSendConnectToProxy)
+			// a pooled connection through a proxy has already been tunneled
+			if (bSendConnectToProxy && !fConnectionReused)
 			{
 				XBOX::VSize				bufferSize = HTTP_CLIENT_BUFFER_SIZE;
 				char *					buffer = (char *) malloc (HTTP_CLIENT_BUFFER_SIZE);
@@ -1184,7 +1544,14 @@ XBOX::VError VHTTPClient::CloseConnection()
 {
 	XBOX::VError error = XBOX::VE_OK;
 
-	if (NULL != fTCPEndPoint)
+	if (!fPoolKey.IsEmpty())
+	{
+		// the pool closes the endpoint and frees its slot
+		VHTTPConnectionPool::Get()->ForgetConnection (fPoolKey, fTCPEndPoint);
+		fTCPEndPoint = NULL;
+		fPoolKey.Clear();
+	}
+	else if (NULL != fTCPEndPoint)
 	{
 		error = fTCPEndPoint->Close();
 		XBOX::ReleaseRefCountable (&fTCPEndPoint);
@@ -1193,6 +1560,23 @@ XBOX::VError VHTTPClient::CloseConnection()
 	return error;
 }
 
+
+void VHTTPClient::_ReleaseConnection (bool inReusable)
+{
+	if (!inReusable)
+	{
+		CloseConnection();
+	}
+	else if (!fPoolKey.IsEmpty() && (NULL != fTCPEndPoint))
+	{
+		VHTTPConnectionPool::Get()->RecycleConnection (fPoolKey, fTCPEndPoint);
+		fTCPEndPoint = NULL;
+		fPoolKey.Clear();
+	}
+	// else the keep-alive connection remains owned by this client
+}
+
+
 XBOX::VTCPEndPoint *VHTTPClient::StealEndPoint ()
 {
 	XBOX::VTCPEndPoint	*endPoint;
@@ -1202,6 +1586,13 @@ XBOX::VTCPEndPoint *VHTTPClient::StealEndPoint ()
 		fTCPEndPoint = NULL;
 	}
 
+	if (!fPoolKey.IsEmpty())
+	{
+		// the endpoint doesn't belong to the pool anymore
+		VHTTPConnectionPool::Get()->ForgetConnection (fPoolKey, NULL);
+		fPoolKey.Clear();
+	}
+
 	return endPoint;
 }
 
@@ -1219,11 +1610,21 @@ XBOX::VError VHTTPClient::SendRequest (HTTP_Method inMethod)
 }
 
 XBOX::VError VHTTPClient::ReadResponseHeader ()
+{	
+	return _ReadResponseHeader (false);
+}
+
+
+XBOX::VError VHTTPClient::_ReadResponseHeader (bool inKeepLeftOver)
 {	
 	XBOX::VError	error;
 	sLONG			tryCount;
 
-	StartReadingResponseHeader();
+	// with pipelining, data read after the previous response belong to this one
+	if (inKeepLeftOver)
+		fResponseHeaderBuffer.Clear();
+	else
+		StartReadingResponseHeader();
 	tryCount = 0;
 	for ( ; ; ) {
 
@@ -1318,7 +1719,19 @@ XBOX::VError VHTTPClient::ContinueReadingResponseHeader (const char *inBuffer, V
 			p = (const uBYTE *) fResponseHeaderBuffer.GetDataPtr();
 			p += responseSize;			
 
-			if (!fLeftOver.PutDataAmortized(0, p, leftOver))
+			if (fLeftOver.GetDataSize() > 0)
+			{
+				// data not consumed yet (pipelining) follow the ones read with the header
+				XBOX::VMemoryBuffer<>	tempBuffer;
+
+				if (!tempBuffer.PutDataAmortized(0, p, leftOver) || !tempBuffer.PutDataAmortized(leftOver, fLeftOver.GetDataPtr(), fLeftOver.GetDataSize()))
+
+					return XBOX::VE_MEMORY_FULL;
+
+				fLeftOver.SetDataPtr(tempBuffer.GetDataPtr(), tempBuffer.GetDataSize(), tempBuffer.GetDataSize());
+				tempBuffer.ForgetData();
+			}
+			else if (!fLeftOver.PutDataAmortized(0, p, leftOver))
 
 				return XBOX::VE_MEMORY_FULL;
 
@@ -1484,7 +1897,8 @@ XBOX::VError VHTTPClient::_ReadFromSocket(void *ioBuffer, const XBOX::VSize inMa
 			}
 		}
 
-		if ((XBOX::VE_OK == error) && (bufferSize > 0))
+		// do not wait for the socket when some buffered data can already be returned
+		if ((XBOX::VE_OK == error) && (bufferSize > 0) && (0 == bufferOffset))
 		{
 			nBytesRead = bufferSize;
 			error = _ReadWithTimeoutFromEndPoint(fTCPEndPoint, (char *)ioBuffer + bufferOffset, &nBytesRead, fReadWriteTimeout * 1000);
@@ -1987,6 +2401,104 @@ XBOX::VError VHTTPClient::Send (HTTP_Method inMethod)
 }
 
 
+XBOX::VError VHTTPClient::SendPipelined (HTTP_Method inMethod, const XBOX::VectorOfVString& inPaths, HTTPPipelinedResponseCallBack inCallBack, void *inPrivateData)
+{
+	if (((HTTP_GET != inMethod) && (HTTP_HEAD != inMethod)) || (NULL == inCallBack) || fUpgradeRequest)
+		return XBOX::vThrowError (XBOX::VE_INVALID_PARAMETER);
+
+	if (inPaths.empty())
+		return XBOX::VE_OK;
+
+	XBOX::VError	error = XBOX::VE_OK;
+	XBOX::VString	savedFolder (fFolder);
+	XBOX::VString	savedQuery (fQuery);
+	bool			savedKeepAlive = fKeepAlive;
+	size_t			sentCount = 0;
+	size_t			receivedCount = 0;
+	bool			hasAnswered = false;	// a response has been read on the current connection
+	bool			isReusable = true;		// the last response left the connection ready for another request
+
+	fKeepAlive = true;
+	fQuery.Clear();
+	fRequestBody.Clear();
+	fResponseHeaderBuffer.Clear();
+
+	error = _GenerateRequest (inMethod);
+
+	if (XBOX::VE_OK == error)
+		error = OpenConnection (NULL);
+
+	fLeftOver.Clear();
+
+	while ((XBOX::VE_OK == error) && (receivedCount < inPaths.size()))
+	{
+		XBOX::StErrorContextInstaller	errorContext;
+		bool							isDelimited = false;
+
+		// keep up to fMaxPipelineDepth requests in flight
+		while ((XBOX::VE_OK == error) && (sentCount < inPaths.size()) && ((sentCount - receivedCount) < (size_t) fMaxPipelineDepth))
+		{
+			fFolder.FromString (inPaths[sentCount]);
+			error = _SendRequestHeader();
+			++sentCount;
+		}
+
+		if (XBOX::VE_OK == error)
+		{
+			_ReinitResponseHeader();
+			fResponseBody.Clear();
+			error = _ReceiveResponse (true, isDelimited);
+		}
+
+		if ((XBOX::VE_OK != error) && fConnectionReused && !hasAnswered && (0 == fResponseHeaderBuffer.GetDataSize()))
+		{
+			/*
+			 *	The pooled connection was closed by the server: requests are idempotent, send them again on another one
+			 */
+			errorContext.Flush();
+			CloseConnection();
+			sentCount = receivedCount;
+			error = OpenConnection (NULL);
+		}
+		else if (XBOX::VE_OK == error)
+		{
+			hasAnswered = true;
+			++fNumberOfRequests;
+
+			error = inCallBack (inPrivateData, (sLONG) receivedCount, *this);
+			++receivedCount;
+
+			isReusable = isDelimited && !_IsConnectionClosedByServer();
+
+			if ((XBOX::VE_OK == error) && !isReusable && (receivedCount < inPaths.size()))
+			{
+				/*
+				 *	The connection can't carry more responses: send unanswered requests again on a new one
+				 */
+				CloseConnection();
+				sentCount = receivedCount;
+				hasAnswered = false;
+				isReusable = true;
+				error = OpenConnection (NULL);
+			}
+		}
+	}
+
+	// requests still in flight (when stopped by an error) make the connection unusable
+	if ((XBOX::VE_OK == error) && (sentCount == receivedCount))
+		_ReleaseConnection (savedKeepAlive && isReusable && (0 == fLeftOver.GetDataSize()));
+	else
+		CloseConnection();
+
+	fKeepAlive = savedKeepAlive;
+	fFolder.FromString (savedFolder);
+	fQuery.FromString (savedQuery);
+	fHeader.Clear();
+
+	return error;
+}
+
+
 bool VHTTPClient::GetResponseHeaderValue (const XBOX::VString& inName, XBOX::VString& outValue)
 {
 	return fResponseHeader.GetHeaderValue (inName, outValue);
@@ -2457,228 +2969,295 @@ bool VHTTPClient::AddNtlmAuthorizationHeader (const XBOX::VString& inAuthorizati
 XBOX::VError VHTTPClient::_SendRequestAndReceiveResponse()
 {
 	XBOX::VError			error = XBOX::VE_OK;
-	bool					isHeaderOK = false;
 	sLONG					progressionPercentage = 15;
+	bool					isDelimited = false;
+	bool					retry = false;
 
 	if (NULL != fProgressionCallBackPtr)
 		fProgressionCallBackPtr(fProgressionCallBackPrivateData, PROGSTATUS_STARTING, 0);
 
-	error = OpenConnection(NULL);
+	do
+	{
+		XBOX::StErrorContextInstaller	errorContext;
+
+		retry = false;
+
+		error = OpenConnection(NULL);
+
+#if WITH_HTTP_CLIENT_DEBUG_LOG
+		_LogData((char *)REQUEST_MARKER_STRING, strlen(REQUEST_MARKER_STRING));
+#endif
+
+		if (XBOX::VE_OK == error)
+		{
+			error = _SendRequestHeader();
+			
+			if (NULL != fProgressionCallBackPtr)
+				fProgressionCallBackPtr (fProgressionCallBackPrivateData, PROGSTATUS_SENDING_REQUEST, ++progressionPercentage);
+		}
+
+		if ((XBOX::VE_OK == error) && (fRequestBody.GetDataSize() > 0))
+		{
+			error = _WriteToSocket (fRequestBody.GetDataPtr(), (uLONG)fRequestBody.GetDataSize());
+
+			if ((NULL != fProgressionCallBackPtr) && (progressionPercentage < 25))
+				fProgressionCallBackPtr (fProgressionCallBackPrivateData, PROGSTATUS_SENDING_REQUEST, ++progressionPercentage);
+		}
+
+		if (NULL != fProgressionCallBackPtr)
+			fProgressionCallBackPtr (fProgressionCallBackPrivateData, PROGSTATUS_RECEIVING_RESPONSE, 101);
 
 #if WITH_HTTP_CLIENT_DEBUG_LOG
-	_LogData((char *)REQUEST_MARKER_STRING, strlen(REQUEST_MARKER_STRING));
+		_LogData((char *)RESPONSE_MARKER_STRING, strlen(RESPONSE_MARKER_STRING));
 #endif
 
+		if (XBOX::VE_OK == error)
+			error = _ReceiveResponse (false, isDelimited);
+
+		/*
+		 *	A pooled connection may have been closed by the server after it has been checked:
+		 *	send the request again on another connection if nothing has been received (but never send a POST twice).
+		 */
+		if ((XBOX::VE_OK != error) && fConnectionReused && (0 == fResponseHeaderBuffer.GetDataSize()) && (HTTP_POST != fRequestMethod))
+		{
+			errorContext.Flush();
+			CloseConnection();
+			error = XBOX::VE_OK;
+			retry = true;
+		}
+	}
+	while (retry);
+
+	/*
+	 *	J.F. Do not close the stream if an error has been raised
+	 *	(The comm has already been closed)
+	 */
 	if (XBOX::VE_OK == error)
 	{
-		error = _SendRequestHeader();
-		
-		if (NULL != fProgressionCallBackPtr)
-			fProgressionCallBackPtr (fProgressionCallBackPrivateData, PROGSTATUS_SENDING_REQUEST, ++progressionPercentage);
+		/*
+		 *	Verify if the Server does not close the connection
+		 */
+		_ReleaseConnection (fKeepAlive && !_IsConnectionClosedByServer() && isDelimited && (0 == fLeftOver.GetDataSize()));
+	}
+	else
+	{
+		CloseConnection();
 	}
 
-	if ((XBOX::VE_OK == error) && (fRequestBody.GetDataSize() > 0))
+	if (XBOX::VE_OK == error)
 	{
-		error = _WriteToSocket (fRequestBody.GetDataPtr(), (uLONG)fRequestBody.GetDataSize());
+		++fNumberOfRequests;
+	}
 
-		if ((NULL != fProgressionCallBackPtr) && (progressionPercentage < 25))
-			fProgressionCallBackPtr (fProgressionCallBackPrivateData, PROGSTATUS_SENDING_REQUEST, ++progressionPercentage);
+	return error;
+}
+
+
+bool VHTTPClient::_IsConnectionClosedByServer()
+{
+	bool connectionCloseByServer = false;
+
+	if (fResponseHeader.IsHeaderSet (CONST_STRING_CONNECTION))
+	{
+		XBOX::VString connectionValue;
+		fResponseHeader.GetHeaderValue (CONST_STRING_CONNECTION, connectionValue);
+		connectionCloseByServer = (FindASCIIString (connectionValue, "keep-alive") == 0);
 	}
 
-	if (NULL != fProgressionCallBackPtr)
-		fProgressionCallBackPtr (fProgressionCallBackPrivateData, PROGSTATUS_RECEIVING_RESPONSE, 101);
+	return connectionCloseByServer;
+}
 
-#if WITH_HTTP_CLIENT_DEBUG_LOG
-	_LogData((char *)RESPONSE_MARKER_STRING, strlen(RESPONSE_MARKER_STRING));
-#endif
 
+/*
+ *	Reads a response header and its body. outIsDelimited tells whether the end of the body was found from the response
+ *	itself (HEAD, Content-Length or chunked encoding), which is required to read another response on the same connection.
+ */
+XBOX::VError VHTTPClient::_ReceiveResponse (bool inKeepLeftOver, bool& outIsDelimited)
+{
+	XBOX::VError	error = XBOX::VE_OK;
+
+	outIsDelimited = false;
+
+	XBOX::VSize	bufferSize = HTTP_CLIENT_BUFFER_SIZE;
+	char *		buffer = (char *) malloc (HTTP_CLIENT_BUFFER_SIZE);
+
+	if (NULL == buffer)
+		return XBOX::vThrowError (XBOX::VE_MEMORY_FULL);
+
+	error = _ReadResponseHeader (inKeepLeftOver);
 	if (XBOX::VE_OK == error)
 	{
-		XBOX::VSize	bufferSize = HTTP_CLIENT_BUFFER_SIZE;
-		char *		buffer = (char *) malloc (HTTP_CLIENT_BUFFER_SIZE);
-		bool		previousLineEndedWithCRLF = false;
+		bool		isChunked = _IsChunkedResponse();
+		XBOX::VSize contentLength = 0;
+		bool		hasContentLength = fResponseHeader.GetContentLength (contentLength);
 
-		if (NULL == buffer)
-			error = XBOX::vThrowError (XBOX::VE_MEMORY_FULL);
+		/*
+		 *	Responses to HEAD requests and 1xx, 204 and 304 responses never have a body (RFC 7230, 3.3.3)
+		 */
+		bool		hasNoBody = (HTTP_HEAD == fRequestMethod) || ((fStatusCode >= 100) && (fStatusCode < 200)) || (204 == fStatusCode) || (304 == fStatusCode)
+								|| (!isChunked && hasContentLength && (0 == contentLength));
 
-		error = ReadResponseHeader ();
-		if (XBOX::VE_OK == error)
+		if (hasNoBody)	// YT 19-Sep-2011 - ACI0073045 - Do not try to read message body with HEAD request
 		{
-			if (HTTP_HEAD != fRequestMethod)	// YT 19-Sep-2011 - ACI0073045 - Do not try to read message body with HEAD request
-			{
-				bool		isChunked = _IsChunkedResponse();
-				sLONG8		curr_body_len = -1;
-				XBOX::VSize contentLength = 0;
-
-				fResponseHeader.GetContentLength (contentLength);
+			outIsDelimited = true;
+		}
+		else
+		{
+			sLONG8		curr_body_len = -1;
 
-				if (!isChunked && (contentLength > 0)) // YT 21-Jun-2011 - ACI0071986
-					curr_body_len = contentLength;
+			if (!isChunked && (contentLength > 0)) // YT 21-Jun-2011 - ACI0071986
+				curr_body_len = contentLength;
 
-				if (curr_body_len >= 0)
+			if (curr_body_len >= 0)
+			{
+				// cool, there is a Content-Length
+				if (curr_body_len > 0)	// if 0, do nothing
 				{
-					// cool, there is a Content-Length
-					if (curr_body_len > 0)	// if 0, do nothing
+					XBOX::VMemoryBuffer<>	memoryBuffer;
+					XBOX::VSize				chunkSize = 0;
+					do
 					{
-						XBOX::VMemoryBuffer<>	memoryBuffer;
-						XBOX::VSize				chunkSize = 0;
-						do
-						{
-							chunkSize = HTTP_CLIENT_BUFFER_SIZE;
-							error = _ReadFromSocket(buffer, HTTP_CLIENT_BUFFER_SIZE, chunkSize);
-
-							if ((XBOX::VE_OK == error) && (chunkSize > 0))
-							{
-								memoryBuffer.PutDataAmortized(memoryBuffer.GetDataSize(), (const void *)buffer, chunkSize);
-								curr_body_len -= chunkSize;
-							}
-
-							XBOX::VTask::Yield();
-						}
-						while ((XBOX::VE_OK == error) && (curr_body_len > 0));
+						// never read past the body: the next response may follow on a keep-alive connection
+						chunkSize = (curr_body_len < (sLONG8) HTTP_CLIENT_BUFFER_SIZE) ? (XBOX::VSize) curr_body_len : HTTP_CLIENT_BUFFER_SIZE;
+						error = _ReadFromSocket(buffer, chunkSize, chunkSize);
 
-						if (NULL != memoryBuffer.GetDataPtr())
+						if ((XBOX::VE_OK == error) && (chunkSize > 0))
 						{
-							_SetBodyReply((char *)memoryBuffer.GetDataPtr(), memoryBuffer.GetDataSize());
-							memoryBuffer.ForgetData();
+							memoryBuffer.PutDataAmortized(memoryBuffer.GetDataSize(), (const void *)buffer, chunkSize);
+							curr_body_len -= chunkSize;
 						}
 
-						error = XBOX::VE_OK;
+						XBOX::VTask::Yield();
 					}
+					while ((XBOX::VE_OK == error) && (curr_body_len > 0));
+
+					outIsDelimited = (0 == curr_body_len);
+
+					if (NULL != memoryBuffer.GetDataPtr())
+					{
+						_SetBodyReply((char *)memoryBuffer.GetDataPtr(), memoryBuffer.GetDataSize());
+						memoryBuffer.ForgetData();
+					}
+
+					error = XBOX::VE_OK;
 				}
-				else
-				{
-					XBOX::VMemoryBuffer<> memoryBuffer;
+			}
+			else
+			{
+				XBOX::VMemoryBuffer<> memoryBuffer;
 
-					if (isChunked)
+				if (isChunked)
+				{
+					/*
+					 *	Yes, we do support HTTP Chunk encoding
+					 *	(that way we really are HTTP/1.1 compliant)
+					 */
+					bool stopReading = false;
+					while ((XBOX::VE_OK == error) && (bufferSize > 0) && !stopReading)
 					{
-						/*
-						 *	Yes, we do support HTTP Chunk encoding
-						 *	(that way we really are HTTP/1.1 compliant)
-						 */
-						bool stopReading = false;
-						while ((XBOX::VE_OK == error) && (bufferSize > 0) && !stopReading)
+						// first, we need to read the length of the next chunk												
+						bufferSize = 0;	// ReadLine b/c chunk length ends with CRLF
+						error = _ReadFromSocket (buffer, HTTP_CLIENT_BUFFER_SIZE, bufferSize);
+
+						if ((bufferSize == 2) && (buffer[0] == '\r') && (buffer[1] == '\n'))
 						{
-							// first, we need to read the length of the next chunk												
 							bufferSize = 0;	// ReadLine b/c chunk length ends with CRLF
 							error = _ReadFromSocket (buffer, HTTP_CLIENT_BUFFER_SIZE, bufferSize);
-
-							if ((bufferSize == 2) && (buffer[0] == '\r') && (buffer[1] == '\n'))
-							{
-								bufferSize = 0;	// ReadLine b/c chunk length ends with CRLF
-								error = _ReadFromSocket (buffer, HTTP_CLIENT_BUFFER_SIZE, bufferSize);
-							}
-							if ((XBOX::VE_OK == error) && (bufferSize > 0))
+						}
+						if ((XBOX::VE_OK == error) && (bufferSize > 0))
+						{
+							XBOX::VSize chunkSize = _GetChunkSize(buffer);
+							if (chunkSize)
 							{
-								XBOX::VSize chunkSize = _GetChunkSize(buffer);
-								if (chunkSize)
+								bufferSize = chunkSize;	// check size <32k
+								if (bufferSize <= HTTP_CLIENT_BUFFER_SIZE)
 								{
-									bufferSize = chunkSize;	// check size <32k
-									if (bufferSize <= HTTP_CLIENT_BUFFER_SIZE)
-									{
-										// optim: we can use buffer b/c it's big enough
-										error = _ReadExactlyFromSocket(buffer, HTTP_CLIENT_BUFFER_SIZE, bufferSize);
+									// optim: we can use buffer b/c it's big enough
+									error = _ReadExactlyFromSocket(buffer, HTTP_CLIENT_BUFFER_SIZE, bufferSize);
 
-										if ((XBOX::VE_OK == error) && (bufferSize > 0))
-										{
-											memoryBuffer.PutDataAmortized (memoryBuffer.GetDataSize(), (const void *)buffer, bufferSize);
-										}
+									if ((XBOX::VE_OK == error) && (bufferSize > 0))
+									{
+										memoryBuffer.PutDataAmortized (memoryBuffer.GetDataSize(), (const void *)buffer, bufferSize);
 									}
-									else
+								}
+								else
+								{
+									// DAMNED ! this is a big boy. Deal with it.
+									char *temp_buffer2 = (char *)malloc (bufferSize);
+									if (temp_buffer2)
 									{
-										// DAMNED ! this is a big boy. Deal with it.
-										char *temp_buffer2 = (char *)malloc (bufferSize);
-										if (temp_buffer2)
-										{
-											error = _ReadExactlyFromSocket(temp_buffer2, bufferSize, bufferSize);
+										error = _ReadExactlyFromSocket(temp_buffer2, bufferSize, bufferSize);
 
-											if ((XBOX::VE_OK == error) && (bufferSize > 0))
-											{
-												memoryBuffer.PutDataAmortized (memoryBuffer.GetDataSize(), (const void *)temp_buffer2, bufferSize);
-											}
-											free (temp_buffer2);
+										if ((XBOX::VE_OK == error) && (bufferSize > 0))
+										{
+											memoryBuffer.PutDataAmortized (memoryBuffer.GetDataSize(), (const void *)temp_buffer2, bufferSize);
 										}
+										free (temp_buffer2);
 									}
-
-									// Sanity check
-									xbox_assert(bufferSize == chunkSize);
 								}
-								else
-									stopReading = true;
+
+								// Sanity check
+								xbox_assert(bufferSize == chunkSize);
 							}
+							else
+								stopReading = true;
 						}
 					}
-					else
+
+					if (stopReading)
 					{
 						/*
-						 *	Some servers do that :-(
-						 *	Just read until there is nothing left...
+						 *	Skip the trailer up to the final empty line, so that the connection is ready for the next response
 						 */
-						if (XBOX::VE_OK == error)
+						do
 						{
-							do
-							{
-								bufferSize = HTTP_CLIENT_BUFFER_SIZE;	// YT 07-Nov-2008 - ACI0059719 & ACI0058995
-								error = _ReadFromSocket (buffer, HTTP_CLIENT_BUFFER_SIZE, bufferSize);
+							bufferSize = 0;	// ReadLine
+							error = _ReadFromSocket (buffer, HTTP_CLIENT_BUFFER_SIZE, bufferSize);
+						}
+						while ((XBOX::VE_OK == error) && (bufferSize > 0) && !((bufferSize == 2) && (buffer[0] == '\r') && (buffer[1] == '\n')));
 
-								if ((XBOX::VE_OK == error) && (bufferSize > 0))
-								{
-									memoryBuffer.PutDataAmortized (memoryBuffer.GetDataSize(), (const void *)buffer, bufferSize);
-								}
+						outIsDelimited = (XBOX::VE_OK == error) && (bufferSize == 2);
+					}
+				}
+				else
+				{
+					/*
+					 *	Some servers do that :-(
+					 *	Just read until there is nothing left...
+					 */
+					if (XBOX::VE_OK == error)
+					{
+						do
+						{
+							bufferSize = HTTP_CLIENT_BUFFER_SIZE;	// YT 07-Nov-2008 - ACI0059719 & ACI0058995
+							error = _ReadFromSocket (buffer, HTTP_CLIENT_BUFFER_SIZE, bufferSize);
 
-								XBOX::VTask::Yield();
+							if ((XBOX::VE_OK == error) && (bufferSize > 0))
+							{
+								memoryBuffer.PutDataAmortized (memoryBuffer.GetDataSize(), (const void *)buffer, bufferSize);
 							}
-							while ((XBOX::VE_OK == error) && (bufferSize > 0));
-						}
-					}
 
-					if (NULL != memoryBuffer.GetDataPtr())
-					{
-						_SetBodyReply((char *)memoryBuffer.GetDataPtr(), memoryBuffer.GetDataSize());
-						memoryBuffer.ForgetData();
+							XBOX::VTask::Yield();
+						}
+						while ((XBOX::VE_OK == error) && (bufferSize > 0));
 					}
-
-					error = XBOX::VE_OK;
 				}
-			}
-		}
 
-		if (NULL != buffer)
-		{
-			free (buffer);
-			buffer = NULL;
-		}
-	}
-	/*
-	 *	J.F. Do not close the stream if an error has been raised
-	 *	(The comm has already been closed)
-	 */
-	if (XBOX::VE_OK == error)
-	{
-		/*
-		 *	Verify if the Server does not close the connection
-		 */
-		bool connectionCloseByServer = false;
-		if (fKeepAlive && fResponseHeader.IsHeaderSet (CONST_STRING_CONNECTION))
-		{
-			XBOX::VString connectionValue;
-			fResponseHeader.GetHeaderValue (CONST_STRING_CONNECTION, connectionValue);
-			connectionCloseByServer = (FindASCIIString (connectionValue, "keep-alive") == 0);
-		}
+				if (NULL != memoryBuffer.GetDataPtr())
+				{
+					_SetBodyReply((char *)memoryBuffer.GetDataPtr(), memoryBuffer.GetDataSize());
+					memoryBuffer.ForgetData();
+				}
 
-		if (!fKeepAlive || connectionCloseByServer)
-		{
-			CloseConnection();
+				error = XBOX::VE_OK;
+			}
 		}
 	}
-	else
-	{
-		CloseConnection();
-	}
 
-	if (XBOX::VE_OK == error)
+	if (NULL != buffer)
 	{
-		++fNumberOfRequests;
+		free (buffer);
+		buffer = NULL;
 	}
 
 	return error;
@@ -69,6 +69,109 @@ typedef void (* HTTPRequestProgressionCallBack) (void *ioPrivateData, sLONG inMe
 typedef void (* HTTPRequestAuthenticationDialogCallBack) (VAuthInfos& ioAuthenticationInfos, void *inPrivateData);
 
 
+class VHTTPClient;
+
+/*
+ *	Called by VHTTPClient::SendPipelined() for each response, in request order.
+ *	Response getters of inClient (status code, headers, body) describe the response of request inRequestIndex during the call.
+ *	Returning an error stops the pipeline.
+ */
+typedef XBOX::VError (* HTTPPipelinedResponseCallBack) (void *inPrivateData, sLONG inRequestIndex, VHTTPClient& inClient);
+
+
+typedef struct VHTTPConnectionPoolStatistics
+{
+	uLONG									fHits;					// connections reused from the pool
+	uLONG									fMisses;				// new connections opened because no idle one was available
+	uLONG									fWaits;					// acquisitions which had to wait for the per-host limit
+	uLONG									fTimeouts;				// acquisitions which gave up waiting for the per-host limit
+	uLONG									fRecycled;				// connections given back to the pool
+	uLONG									fEvicted;				// idle connections closed because of idle timeout or idle limit
+	uLONG									fFailedHealthChecks;	// idle connections closed by the server (or with unexpected data) found when acquiring
+	sLONG									fIdleCount;				// currently idle connections
+	sLONG									fLeasedCount;			// currently used connections (including those being opened)
+} VHTTPConnectionPoolStatistics;
+
+
+/*
+ *	Process-wide pool of HTTP/1.1 keep-alive connections, shared by all VHTTPClient with SetUseConnectionPool (true).
+ *
+ *	Connections are keyed by scheme, host, port and proxy (see MakeKey()). Idle connections are reused most recent first,
+ *	after checking that the server did not close them meanwhile, and closed after the idle timeout.
+ *	The number of connections per key (idle or used) is limited: AcquireConnection() waits for a connection to be released
+ *	when the limit is reached. All methods are thread safe.
+ */
+class XTOOLBOX_API VHTTPConnectionPool : public XBOX::VObject
+{
+public:
+	static	VHTTPConnectionPool *			Get();
+	static	void							DeInit();
+
+	static	void							MakeKey (bool inUseSSL, const XBOX::VString& inDomain, sLONG inPort, const XBOX::VString& inProxy, sLONG inProxyPort, XBOX::VString& outKey);
+
+	/*
+	 *	Returns a retained idle connection in *outEndPoint, or NULL if caller must open a new connection.
+	 *	In both cases a slot is reserved for inKey and must be given back with RecycleConnection() or ForgetConnection().
+	 *	Returns VE_SRVR_CONNECTION_FAILED if no slot could be reserved before inTimeoutMS.
+	 */
+	XBOX::VError							AcquireConnection (const XBOX::VString& inKey, sLONG inTimeoutMS, XBOX::VTCPEndPoint **outEndPoint);
+
+	// Gives back a connection which can carry another request (ownership is transferred to the pool).
+	void									RecycleConnection (const XBOX::VString& inKey, XBOX::VTCPEndPoint *inEndPoint);
+
+	// Frees the slot reserved for inKey. inEndPoint, if not NULL, is closed and released.
+	void									ForgetConnection (const XBOX::VString& inKey, XBOX::VTCPEndPoint *inEndPoint);
+
+	// Closes idle connections which timed out (or all idle connections).
+	void									PurgeIdleConnections (bool inAll = false);
+
+	void									SetMaxConnectionsPerHost (sLONG inValue);
+	sLONG									GetMaxConnectionsPerHost() const { return fMaxConnectionsPerHost; }
+	void									SetMaxIdleConnectionsPerHost (sLONG inValue);
+	sLONG									GetMaxIdleConnectionsPerHost() const { return fMaxIdleConnectionsPerHost; }
+	void									SetIdleTimeout (sLONG inMilliseconds) { fIdleTimeoutMS = inMilliseconds; }
+	sLONG									GetIdleTimeout() const { return fIdleTimeoutMS; }
+
+	void									GetStatistics (VHTTPConnectionPoolStatistics& outStatistics) const;
+	void									ResetStatistics();
+
+private:
+											VHTTPConnectionPool();
+	virtual									~VHTTPConnectionPool();
+
+	typedef struct IdleConnection
+	{
+		XBOX::VTCPEndPoint *				fEndPoint;
+		uLONG								fIdleSince;
+	} IdleConnection;
+
+	typedef struct HostConnections
+	{
+											HostConnections() : fLeasedCount (0) {}
+
+		std::vector<IdleConnection>			fIdleConnections;		// most recently used at the end
+		sLONG								fLeasedCount;
+	} HostConnections;
+
+	typedef std::map<XBOX::VString, HostConnections>	MapOfHostConnections;
+
+	void									_PurgeIdleConnections (HostConnections& ioHost, uLONG inNow, bool inAll, std::vector<XBOX::VTCPEndPoint*>& ioToClose);
+	static	void							_CloseEndPoints (std::vector<XBOX::VTCPEndPoint*>& ioEndPoints);
+
+	static	VHTTPConnectionPool *			sInstance;
+
+	mutable XBOX::VCriticalSection			fLock;
+	MapOfHostConnections					fHosts;
+	sLONG									fMaxConnectionsPerHost;
+	sLONG									fMaxIdleConnectionsPerHost;
+	sLONG									fIdleTimeoutMS;
+	uLONG									fLastPurge;
+	VHTTPConnectionPoolStatistics			fStatistics;
+};
+
+
+
+
 class XTOOLBOX_API VHTTPClient : public XBOX::VObject
 {
 public:
@@ -121,6 +224,17 @@ public:
 	 */
 	XBOX::VError							Send (HTTP_Method inMethod);
 
+	/*
+	 *	HTTP/1.1 pipelining: sends requests on the same connection without waiting for the previous responses
+	 *	(at most GetMaxPipelineDepth() unanswered requests) and calls inCallBack for each response, in order.
+	 *	Only for GET and HEAD (idempotent, no body). inPaths are request paths on the URL host, without the leading '/'
+	 *	(and with their query string, if any). If the server closes the connection, unanswered requests are sent again
+	 *	on a new one. Authentication and redirections are not handled.
+	 */
+	XBOX::VError							SendPipelined (HTTP_Method inMethod, const XBOX::VectorOfVString& inPaths, HTTPPipelinedResponseCallBack inCallBack, void *inPrivateData);
+	void									SetMaxPipelineDepth (sLONG inValue) { fMaxPipelineDepth = (inValue > 0) ? inValue : 1; }
+	sLONG									GetMaxPipelineDepth() const { return fMaxPipelineDepth; }
+
 	/*
 	 *	For WebSockets
 	 */
@@ -168,6 +282,13 @@ public:
 	void									SetKeepAlive (bool inValue) { fKeepAlive = inValue; }
 	bool									GetKeepAlive() const { return fKeepAlive; }
 
+	/*
+	 *	Connection pool: keep-alive connections are taken from and given back to VHTTPConnectionPool after each request,
+	 *	instead of being owned by this client. Ignored for upgrade requests and when a VTCPSelectIOPool is used.
+	 */
+	void									SetUseConnectionPool (bool inValue) { fUseConnectionPool = inValue; }
+	bool									GetUseConnectionPool() const { return fUseConnectionPool; }
+
 	/*
 	 *	Connection Timeout (in seconds)
 	 */
@@ -228,6 +349,9 @@ public:
 
 private:
 	XBOX::VError							_SendRequestAndReceiveResponse();
+	XBOX::VError							_ReceiveResponse (bool inKeepLeftOver, bool& outIsDelimited);
+	XBOX::VError							_ReadResponseHeader (bool inKeepLeftOver);
+	bool									_IsConnectionClosedByServer();
 	XBOX::VError							_SendCONNECTToProxy();
 	XBOX::VError							_SendRequestHeader();
 	bool									_ParseURL (const XBOX::VURL& inURL);
@@ -244,6 +368,7 @@ private:
 
 	XBOX::VError							_OpenConnection (const XBOX::VString& inDNSNameOrIP, const sLONG inPort, bool inUseSSL, XBOX::VTCPSelectIOPool *inSelectIOPool);
 	bool									_ConnectionOpened();
+	void									_ReleaseConnection (bool inReusable);
 	XBOX::VError							_PromoteToSSL();
 	XBOX::VError							_WriteToSocket (void *inBuffer, XBOX::VSize inBufferSize);
 	XBOX::VError							_ReadFromSocket (void *ioBuffer, const XBOX::VSize inMaxBufferSize, XBOX::VSize& ioBufferSize);
@@ -328,6 +453,10 @@ private:
 	sLONG									fNumberOfRequests;
 	XBOX::VString							fLastAddressUsed;
 	bool									fUpgradeRequest;		// If it is a upgrade request, this will override fKeepAlive.
+	bool									fUseConnectionPool;
+	XBOX::VString							fPoolKey;				// not empty while fTCPEndPoint is leased from VHTTPConnectionPool
+	bool									fConnectionReused;		// fTCPEndPoint was an idle connection of the pool
+	sLONG									fMaxPipelineDepth;
 
 	/*
 	 *	Content-Encoding
@@ -594,10 +594,12 @@ XBOX::VError VMIMEMessage::ToStream (XBOX::VStream& outStream, sLONG inEncoding)
 
 				if (bEncodeBody)
 				{
-					XBOX::VMemoryBuffer<> buffer;
-					if (XBOX::Base64Coder::Encode ((*it)->GetData().GetDataPtr(), (*it)->GetData().GetDataSize(), buffer, kBASE64_QUADS_PER_LINE))
+					// Encode by chunks straight into outStream rather than in a temporary buffer as big as the attachment.
+					XBOX::VBase64EncoderStream encoder (&outStream, kBASE64_QUADS_PER_LINE);
+					if (encoder.OpenWriting() == XBOX::VE_OK)
 					{
-						outStream.PutData (buffer.GetDataPtr(), buffer.GetDataSize());
+						encoder.PutData ((*it)->GetData().GetDataPtr(), (*it)->GetData().GetDataSize());
+						encoder.CloseWriting();
 					}
 				}
 				else
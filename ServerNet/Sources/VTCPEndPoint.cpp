@@ -757,6 +757,192 @@ VError VTCPEndPoint::DoWriteExactly(const void *inBuff, uLONG* ioLen, sLONG inMs
 }
 
 
+VError VTCPEndPoint::DoWriteBuffersExactly(const VNetBuffer* inBuffers, uLONG inCount, sLONG8* outLen, sLONG inMsTimeout)
+{
+	if (fSock==NULL)
+		return ReportError( VE_SRVR_NULL_ENDPOINT );
+
+	if(outLen==NULL || (inBuffers==NULL && inCount>0) || inMsTimeout<0)
+		return ReportError(VE_INVALID_PARAMETER);
+
+	*outLen=0;
+
+	xbox_assert ( !fIsInAutoReconnect || ( fIsInAutoReconnect && fIsInUse ) );
+
+	//Local copy, so we can move forward after a partial write without touching caller's buffers.
+	std::vector<VNetBuffer> buffers(inBuffers, inBuffers+inCount);
+
+	uLONG first=0;
+
+	bool withTimeout=(inMsTimeout>0);
+	
+	sLONG timeoutMs=inMsTimeout;
+
+	for(;;)
+	{
+		while(first<buffers.size() && buffers[first].fLength==0)
+			first++;
+
+		if(first>=buffers.size())
+			break;
+
+		//Zero would mean blocking for the socket : the deadline is checked first.
+		if(withTimeout && timeoutMs<=0)
+			return ReportError(VE_SRVR_WRITE_TIMED_OUT, false, false);
+
+		uLONG len=0;
+		sLONG spentMs=0;
+
+		VError verr=fSock->WriteBuffers(&buffers[first], static_cast<uLONG>(buffers.size()-first), &len, withTimeout ? timeoutMs : 0, &spentMs);
+
+		if(withTimeout)
+			timeoutMs-=spentMs;
+
+		*outLen+=len;
+
+		if(verr==VE_SOCK_CONNECTION_BROKEN)
+			return ReportError(VE_SRVR_CONNECTION_BROKEN);
+
+		if(verr==VE_SOCK_TIMED_OUT)
+			return ReportError(VE_SRVR_WRITE_TIMED_OUT, false, false);
+			
+		if(verr==VE_SOCK_WRITE_FAILED || verr==VE_SSL_WRITE_FAILED)
+			return ReportError(VE_SRVR_WRITE_FAILED);
+
+		xbox_assert(verr==VE_OK);	//No unhandled error !
+
+		if(verr!=VE_OK)
+			return ReportError(VE_SRVR_WRITE_FAILED);
+
+		//Skip what was sent
+		while(len>0 && first<buffers.size())
+		{
+			VNetBuffer& buff=buffers[first];
+
+			if(len>=buff.fLength)
+			{
+				len-=buff.fLength;
+				first++;
+			}
+			else
+			{
+				buff.fData=reinterpret_cast<const char*>(buff.fData)+len;
+				buff.fLength-=len;
+				len=0;
+			}
+		}
+
+		if(first>=buffers.size())
+			break;
+
+		if ( fShouldStop )
+			return ReportError(VE_SRVR_WRITE_FAILED, false, false);
+		
+		VTask::Yield();
+	}
+
+	return VE_OK;
+}
+
+
+VError VTCPEndPoint::DoSendFile(VFileDesc* inDesc, sLONG8 inOffset, sLONG8 inLength, sLONG8* outLen, sLONG inMsTimeout)
+{
+	if (fSock==NULL)
+		return ReportError( VE_SRVR_NULL_ENDPOINT );
+
+	if(inDesc==NULL || outLen==NULL || inMsTimeout<0)
+		return ReportError(VE_INVALID_PARAMETER);
+
+	*outLen=0;
+
+#if VERSION_LINUX
+
+	if(!fSock->IsSSL())
+	{
+		bool withTimeout=(inMsTimeout>0);
+		
+		sLONG timeoutMs=inMsTimeout;
+
+		const sLONG8 kMaxChunk=0x40000000;	//sendfile() never sends more than ~2GB at once anyway
+
+		while(*outLen<inLength)
+		{
+			sLONG8 remaining=inLength-*outLen;
+			
+			if(withTimeout && timeoutMs<=0)
+				return ReportError(VE_SRVR_WRITE_TIMED_OUT, false, false);
+
+			uLONG len=static_cast<uLONG>(remaining<kMaxChunk ? remaining : kMaxChunk);
+			sLONG spentMs=0;
+
+			VError verr=fSock->SendFile(inDesc->GetSystemRef(), inOffset+*outLen, &len, withTimeout ? timeoutMs : 0, &spentMs);
+
+			if(withTimeout)
+				timeoutMs-=spentMs;
+
+			*outLen+=len;
+
+			if(verr==VE_SOCK_CONNECTION_BROKEN)
+				return ReportError(VE_SRVR_CONNECTION_BROKEN);
+
+			if(verr==VE_SOCK_TIMED_OUT)
+				return ReportError(VE_SRVR_WRITE_TIMED_OUT, false, false);
+
+			if(verr!=VE_OK || len==0)	//len==0 : file was truncated meanwhile
+				return ReportError(VE_SRVR_WRITE_FAILED);
+
+			if(*outLen<inLength && fShouldStop)
+				return ReportError(VE_SRVR_WRITE_FAILED, false, false);
+		}
+
+		return VE_OK;
+	}
+
+#endif
+
+	//SSL or no sendfile() : read and write by chunks
+	
+	const VSize kChunkSize=64*1024;
+	
+	VPtr buffer=VMemory::NewPtr(kChunkSize, 'SNSF');
+
+	if(buffer==NULL)
+		return ReportError(VE_MEMORY_FULL);
+
+	VError verr=VE_OK;
+
+	while(*outLen<inLength && verr==VE_OK)
+	{
+		sLONG8 remaining=inLength-*outLen;
+		
+		VSize len=static_cast<VSize>(remaining<(sLONG8)kChunkSize ? remaining : kChunkSize);
+		VSize readLen=0;
+
+		verr=inDesc->GetData(buffer, len, inOffset+*outLen, &readLen);
+
+		if(verr==VE_STREAM_EOF && readLen>0)
+			verr=VE_OK;
+
+		if(verr!=VE_OK || readLen==0)
+		{
+			if(verr==VE_OK)
+				verr=ReportError(VE_SRVR_WRITE_FAILED);
+			break;
+		}
+
+		uLONG writeLen=static_cast<uLONG>(readLen);
+
+		verr=DoWriteExactly(buffer, &writeLen, inMsTimeout);
+
+		*outLen+=writeLen;
+	}
+
+	VMemory::DisposePtr(buffer);
+
+	return verr;
+}
+
+
 ReadNotificationMessage::ReadNotificationMessage(VTCPEndPoint* inEndPoint) : fEndPoint(inEndPoint)
 {
 	RetainRefCountable(fEndPoint);
@@ -1668,6 +1854,105 @@ VError VTCPEndPoint::WriteExactly(const void *inBuff, uLONG inLen, sLONG inMsTim
 }
 
 
+VError VTCPEndPoint::WriteBuffersExactly(const VNetBuffer* inBuffers, uLONG inCount, sLONG inMsTimeout)
+{
+	ILogger* logger=VProcess::Get()->GetLogger();
+	
+	bool shouldTrace=(logger!=NULL) ? logger->ShouldLog(EML_Trace) : false;
+	
+	VValueBag* tBag=NULL;
+	
+	if(shouldTrace)
+		tBag=new VValueBag;
+	
+	shouldTrace&=(tBag!=NULL);
+	
+	if(shouldTrace)
+	{
+		sLONG8 asked=0;
+
+		for(uLONG i=0 ; inBuffers!=NULL && i<inCount ; i++)
+			asked+=inBuffers[i].fLength;
+
+		ILoggerBagKeys::level.Set(tBag, EML_Trace);
+		ILoggerBagKeys::component_signature.Set(tBag, kSERVER_NET_SIGNATURE);
+		ILoggerBagKeys::task_id.Set(tBag, VTask::GetCurrentID());
+		ILoggerBagKeys::message.Set(tBag, CVSTR("VTCPEndPoint::WriteBuffersExactly"));
+		ILoggerBagKeys::count_bytes_asked.Set(tBag, static_cast<sLONG>(asked));
+		ILoggerBagKeys::ms_timeout.Set(tBag, inMsTimeout);
+		ILoggerBagKeys::socket.Set(tBag, GetRawSocket());
+		ILoggerBagKeys::is_ssl.Set(tBag, IsSSL());
+	}
+	
+	//Same blocking tweak as WriteExactly : timeout zero really means blocking.
+	bool wasBlocking = fSock!=NULL ? fSock->IsBlocking() : true;
+	
+	if(inMsTimeout<=0 && !wasBlocking)
+		fSock->SetBlocking(true);
+	
+	sLONG8 sentLen=0;
+	
+	VError verr=DoWriteBuffersExactly(inBuffers, inCount, &sentLen, inMsTimeout);
+	
+	if(fSock!=NULL && fSock->IsBlocking()!=wasBlocking)
+		fSock->SetBlocking(wasBlocking);
+	
+	if(shouldTrace)
+	{		
+		ILoggerBagKeys::error_code.Set(tBag, verr);
+		ILoggerBagKeys::count_bytes_sent.Set(tBag, static_cast<sLONG>(sentLen));
+		
+		logger->LogBag(tBag);
+	}
+	
+	if(tBag!=NULL)
+		ReleaseRefCountable(&tBag);
+	
+	return verr;
+}
+
+
+VError VTCPEndPoint::SendFile(const VFile& inFile, sLONG8 inOffset, sLONG8 inLength, sLONG inMsTimeout, sLONG8* outSentLen)
+{
+	if(outSentLen!=NULL)
+		*outSentLen=0;
+
+	if(inOffset<0)
+		return ReportError(VE_INVALID_PARAMETER);
+
+	VFileDesc* desc=NULL;
+	
+	VError verr=inFile.Open(FA_READ, &desc);
+	
+	if(verr!=VE_OK || desc==NULL)
+		return verr!=VE_OK ? verr : ReportError(VE_SRVR_WRITE_FAILED);
+
+	sLONG8 fileSize=desc->GetSize();
+	
+	if(inLength<0 || inOffset+inLength>fileSize)
+		inLength=(inOffset<fileSize) ? fileSize-inOffset : 0;
+
+	bool wasBlocking = fSock!=NULL ? fSock->IsBlocking() : true;
+	
+	if(inMsTimeout<=0 && !wasBlocking)
+		fSock->SetBlocking(true);
+
+	sLONG8 sentLen=0;
+
+	verr=DoSendFile(desc, inOffset, inLength, &sentLen, inMsTimeout);
+
+	if(fSock!=NULL && fSock->IsBlocking()!=wasBlocking)
+		fSock->SetBlocking(wasBlocking);
+
+	delete desc;
+
+	if(outSentLen!=NULL)
+		*outSentLen=sentLen;
+
+	return verr;
+}
+
+
 VError VTCPEndPoint::NotifyReadWithMessage(VMessage* inMsg)
 {
 	if(fIsWatching)
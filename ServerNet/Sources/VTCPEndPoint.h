@@ -68,6 +68,14 @@ public:
 	virtual VError ReadExactly(void *outBuff, uLONG inLen, sLONG inTimeOutMillis=0);
 	virtual VError WriteExactly(const void *inBuff, uLONG inLen, sLONG inTimeOutMillis=0);
 
+	//Scatter/gather WriteExactly : all buffers are sent in order, with as few system calls as possible
+	//(writev style on plain sockets, small buffers coalesced in a single record with SSL).
+	virtual VError WriteBuffersExactly(const VNetBuffer* inBuffers, uLONG inCount, sLONG inTimeOutMillis=0);
+
+	//Sends inLength bytes of inFile from inOffset (inLength < 0 means up to end of file). On Linux, plain sockets use
+	//sendfile() and data is not copied through user space ; otherwise the file is read and written by chunks.
+	virtual VError SendFile(const VFile& inFile, sLONG8 inOffset=0, sLONG8 inLength=-1, sLONG inTimeOutMillis=0, sLONG8* outSentLen=NULL);
+
 	//Helps to wait (block) on message queue AND network read at the same time
 	virtual VError NotifyReadWithMessage(VMessage* inMsg=NULL);
 
@@ -145,6 +153,8 @@ private :
 	
 	virtual VError DoWrite(void *inBuff, uLONG *ioLen, sLONG inTimeoutMs=0, sLONG* outMsSpent=NULL, bool inWithEmptyTail=false);
 	virtual VError DoWriteExactly(const void *inBuff, uLONG* ioLen, sLONG inTimeOutMillis=0);
+	virtual VError DoWriteBuffersExactly(const VNetBuffer* inBuffers, uLONG inCount, sLONG8* outLen, sLONG inTimeOutMillis=0);
+	virtual VError DoSendFile(VFileDesc* inDesc, sLONG8 inOffset, sLONG8 inLength, sLONG8* outLen, sLONG inTimeOutMillis=0);
 
 	static bool DoNotifyReadCallback(Socket /*inRawSocket*/, VEndPoint* inEndPoint, void *inData, sLONG /*inErrorCode*/);
 
@@ -17,6 +17,22 @@
 
 #include "VWebSocket.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define WEBSOCKET_WITH_SSE2	1
+	#include <emmintrin.h>
+#else
+	#define WEBSOCKET_WITH_SSE2	0
+#endif
+
+// AVX2 is only used if the compiler is allowed to generate it for the whole file (-mavx2, /arch:AVX2).
+
+#if defined(__AVX2__)
+	#define WEBSOCKET_WITH_AVX2	1
+	#include <immintrin.h>
+#else
+	#define WEBSOCKET_WITH_AVX2	0
+#endif
+
 USING_TOOLBOX_NAMESPACE
 
 // See section 4.2.2 of spec.
@@ -58,16 +74,107 @@ void VWebSocketFrame::ApplyMaskingKey (
 {
 	xbox_assert(inMaskedData != NULL && outUnmaskedData != NULL && !(inModuloIndex & ~0x3));
 
-	uBYTE	maskingKey[4];
+	// Repeat the key, rotated so that the pattern starts at inModuloIndex. All blocks below are multiple of 4 bytes long, 
+	// so the pattern stays in phase with the data pointer. Each byte only depends on itself, so in-place masking 
+	// (inMaskedData == outUnmaskedData) is fine.
+
+	uBYTE	maskingKey[4], pattern[32];
 
 	maskingKey[0] = inMaskingKey >> 24;
 	maskingKey[1] = inMaskingKey >> 16;
 	maskingKey[2] = inMaskingKey >> 8;
 	maskingKey[3] = inMaskingKey;
 
-	for (VSize i = 0; i < inDataLength; i++, inModuloIndex = (inModuloIndex + 1) & 0x3)
+	for (uLONG i = 0; i < sizeof(pattern); i++)
+
+		pattern[i] = maskingKey[(i + inModuloIndex) & 0x3];
+
+	const uBYTE	*p		= inMaskedData;
+	uBYTE		*q		= outUnmaskedData;
+	VSize		left	= inDataLength;
+
+#if WEBSOCKET_WITH_AVX2
+
+	if (left >= 32) {
+
+		__m256i	mask256	= _mm256_loadu_si256((const __m256i *) pattern);
+
+		for ( ; left >= 32; p += 32, q += 32, left -= 32) 
+
+			_mm256_storeu_si256((__m256i *) q, _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) p), mask256));
+
+	}
+
+#endif
+
+#if WEBSOCKET_WITH_SSE2
+
+	if (left >= 16) {
+
+		__m128i	mask128	= _mm_loadu_si128((const __m128i *) pattern);
+
+		for ( ; left >= 64; p += 64, q += 64, left -= 64) {
+
+			__m128i	a	= _mm_loadu_si128((const __m128i *) p);
+			__m128i	b	= _mm_loadu_si128((const __m128i *) (p + 16));
+			__m128i	c	= _mm_loadu_si128((const __m128i *) (p + 32));
+			__m128i	d	= _mm_loadu_si128((const __m128i *) (p + 48));
+
+			_mm_storeu_si128((__m128i *) q, _mm_xor_si128(a, mask128));
+			_mm_storeu_si128((__m128i *) (q + 16), _mm_xor_si128(b, mask128));
+			_mm_storeu_si128((__m128i *) (q + 32), _mm_xor_si128(c, mask128));
+			_mm_storeu_si128((__m128i *) (q + 48), _mm_xor_si128(d, mask128));
+
+		}
+
+		for ( ; left >= 16; p += 16, q += 16, left -= 16) 
+
+			_mm_storeu_si128((__m128i *) q, _mm_xor_si128(_mm_loadu_si128((const __m128i *) p), mask128));
+
+	}
+
+#endif
+
+	// Word size blocks, memcpy() of 8 bytes compiles to unaligned moves.
+
+	if (left >= 8) {
+
+		uLONG8	mask64;
+
+		::memcpy(&mask64, pattern, 8);
+		for ( ; left >= 8; p += 8, q += 8, left -= 8) {
+
+			uLONG8	word;
+
+			::memcpy(&word, p, 8);
+			word ^= mask64;
+			::memcpy(q, &word, 8);
+
+		}
+
+	}
+
+	for (VSize i = 0; i < left; i++)
+
+		q[i] = p[i] ^ pattern[i];
+}
+
+void VWebSocketFrame::UnmaskPayloadData (uBYTE *ioFrame)
+{
+	xbox_assert(ioFrame != NULL);
+	xbox_assert(fPayloadData != NULL && fPayloadData >= ioFrame);
+
+	if (fMaskingKeyFlag) {
+
+		// fPayloadData points into ioFrame (given to Decode()), so it is actually writable.
 
-		outUnmaskedData[i] = inMaskedData[i] ^ maskingKey[inModuloIndex];
+		uBYTE	*payloadData	= ioFrame + (fPayloadData - ioFrame);
+
+		xbox_assert(fPayloadDataLength <= kMAX_VSize);
+		ApplyMaskingKey(payloadData, payloadData, fMaskingKey, (VSize) fPayloadDataLength, 0);
+		fMaskingKeyFlag = false;
+
+	}
 }
 
 XBOX::VError VWebSocketFrame::Decode (const uBYTE *inFrame, VSize *ioFrameLength)
@@ -260,9 +367,7 @@ XBOX::VError VWebSocketFrame::Encode (XBOX::VMemoryBuffer<> *outFrame, VSize inD
 		maskingKey[3] = fMaskingKey;
 
 		maskedPayloadData = maskingKey + 4;
-		for (VSize i = 0; i < inDataLength; i++)
-
-			maskedPayloadData[i] = fPayloadData[i] ^ maskingKey[i & 0x3];		
+		ApplyMaskingKey(fPayloadData, maskedPayloadData, fMaskingKey, inDataLength, 0);
 
 	} else 
 
@@ -494,8 +599,14 @@ XBOX::VError VWebSocket::ReadSocket ()
 }
 
 XBOX::VError VWebSocket::HandleFrame (const uBYTE *inFrame, VSize *ioFrameLength)
+{
+	return _HandleFrame(inFrame, ioFrameLength, NULL);
+}
+
+XBOX::VError VWebSocket::_HandleFrame (const uBYTE *inFrame, VSize *ioFrameLength, uBYTE *ioWritableFrame)
 {
 	xbox_assert(inFrame != NULL && ioFrameLength != NULL);
+	xbox_assert(ioWritableFrame == NULL || ioWritableFrame == inFrame);
 
 	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
 
@@ -511,6 +622,13 @@ XBOX::VError VWebSocket::HandleFrame (const uBYTE *inFrame, VSize *ioFrameLength
 
 		uBYTE	opcode;
 
+		// Control frames in the read buffer are unmasked there, no copy is needed to answer them. Data frames are 
+		// left masked, VWebSocketMessage unmasks them while appending them to the message.
+
+		if (ioWritableFrame != NULL && (fDecodingWebSocketFrame.GetOpcode() & 0x8))
+
+			fDecodingWebSocketFrame.UnmaskPayloadData(ioWritableFrame);
+
 		if ((opcode = fDecodingWebSocketFrame.GetOpcode()) == VWebSocketFrame::OPCODE_PING) {
 
 			// Answer ping.
@@ -587,7 +705,7 @@ XBOX::VError VWebSocket::ReadFrame ()
 
 	buffer = (uBYTE *) fReadBuffer.GetDataPtr();
 	frameSize = fReadBuffer.GetDataSize();
-	if ((error = HandleFrame((const uBYTE *) buffer, &frameSize)) == XBOX::VE_OK) 
+	if ((error = _HandleFrame((const uBYTE *) buffer, &frameSize, buffer)) == XBOX::VE_OK) 
 
 		fLastFrameSize = frameSize;
 
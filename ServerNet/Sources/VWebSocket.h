@@ -112,6 +112,11 @@ public:
 						VSize inDataLength,
 						uLONG inModuloIndex);
 
+	// Unmask the payload data of a decoded frame in place, ioFrame must be the (writable) buffer given to Decode(). 
+	// Afterwards the frame has no masking key anymore. Does nothing if the frame isn't masked.
+
+	void			UnmaskPayloadData (uBYTE *ioFrame);
+
 	// Decode a potentially partial WebSocket protocol frame. The payload data is a pointer into inFrame memory and it 
 	// isn't "unmasked" (use ApplyMaskingKey() to do so if necessary). A frame can be "partial", that is only the header
 	// and the beginning of the payload data is read, in which case method returns VE_SRVR_WEBSOCKET_FRAME_TOO_SHORT. 
@@ -311,6 +316,10 @@ friend class VWebSocketMessage;
 
 	XBOX::VError				_SendPingOrPong (uBYTE inRSVFlags, const uBYTE *inData, VSize inDataLength, bool inIsPing);
 	XBOX::VError				_UnmaskPayloadData (XBOX::VMemoryBuffer<> *outBuffer);
+
+	// If ioWritableFrame isn't NULL (frame is in the read buffer), control frames are unmasked in place.
+
+	XBOX::VError				_HandleFrame (const uBYTE *inFrame, VSize *ioFrameLength, uBYTE *ioWritableFrame);
 };
 
 // Helper to receive WebSocket messages.
@@ -27,6 +27,11 @@
 #include <sys/socket.h>
 #include <net/if.h>
 #include <unistd.h>
+#include <sys/uio.h>
+
+#if VERSION_LINUX
+#include <sys/sendfile.h>
+#endif
 
 
 #define SNET_HAVE_GROUP_REQ 0
@@ -59,6 +64,8 @@ XBsdTCPSocket::~XBsdTCPSocket()
 	
 	if(fSslDelegate!=NULL)
 		delete fSslDelegate;
+	
+	delete[] fSslRecord;
 }
 
 
@@ -874,6 +881,231 @@ VError XBsdTCPSocket::DoWriteWithTimeout(const void* inBuff, uLONG* ioLen, sLONG
 }
 
 
+VError XBsdTCPSocket::WriteBuffers(const VNetBuffer* inBuffers, uLONG inCount, uLONG* outLen, sLONG inMsTimeout, sLONG* outMsSpent)
+{
+	// - inBuffers and outLen are mandatory ; outLen is always modified (set to 0 on error)
+	// - Partial write is not an error ; caller resumes after the *outLen first bytes.
+	// - With inMsTimeout <= 0, caller should deal with special error VE_SOCK_WOULD_BLOCK (as with Write)
+
+	if(inBuffers==NULL || outLen==NULL)
+		return vThrowError(VE_INVALID_PARAMETER);
+
+	*outLen=0;
+
+	if(outMsSpent!=NULL)
+		*outMsSpent=0;
+
+	while(inCount>0 && inBuffers->fLength==0)
+	{
+		inBuffers++;
+		inCount--;
+	}
+
+	if(inCount==0)
+		return VE_OK;
+
+	if(fSslDelegate!=NULL)
+	{
+		//One SSL write per buffer would produce one TLS record (and often one TCP segment) per buffer ; small
+		//buffers (headers, chunk sizes...) are coalesced in a single record. A large buffer is sent as is.
+		const void* buff=inBuffers[0].fData;
+		uLONG len=inBuffers[0].fLength;
+
+		if(inCount>1 && len<kMAX_COALESCED_SSL_WRITE)
+		{
+			if(fSslRecord==NULL)
+				fSslRecord=new char[kMAX_COALESCED_SSL_WRITE];
+
+			if(fSslRecord==NULL)
+				return vThrowError(VE_MEMORY_FULL);
+
+			len=CoalesceNetBuffers(inBuffers, inCount, fSslRecord, kMAX_COALESCED_SSL_WRITE);
+			buff=fSslRecord;
+		}
+
+		VError verr=(inMsTimeout>0) ? DoWriteWithTimeout(buff, &len, inMsTimeout, outMsSpent) : DoWrite(buff, &len);
+
+		*outLen=len;
+
+		return verr;
+	}
+
+	if(inMsTimeout<=0)
+		return DoWriteBuffers(inBuffers, inCount, outLen);
+
+	//Same loop as DoWriteWithTimeout, without SSL
+
+	VError verr=VE_OK;
+	uLONG len=0;
+	sLONG timeout=inMsTimeout;
+	sLONG spentTotal=0;
+
+	do
+	{
+		len=0;
+
+		sLONG spentOnStep=0;
+
+		verr=WaitForWrite(timeout, &spentOnStep);
+
+		if(verr==VE_OK)
+			verr=DoWriteBuffers(inBuffers, inCount, &len);
+
+		if(len>0)	//We sent some data ; that's enough for now.
+			break;
+
+		if(verr==VE_SOCK_WOULD_BLOCK)
+		{
+			//See DoWriteWithTimeout
+			VTask::Sleep(100);
+			timeout-=100;
+			spentTotal+=100;
+			verr=VE_OK;
+		}
+
+		timeout-=spentOnStep;
+		spentTotal+=spentOnStep;
+	}
+	while(verr==VE_OK);
+
+	xbox_assert((len==0 && verr!=VE_OK) || (len>0 && verr==VE_OK));
+	xbox_assert(verr!=VE_SOCK_WOULD_BLOCK);
+
+	*outLen=len;
+
+	if(outMsSpent!=NULL)
+		*outMsSpent=spentTotal;
+
+	return vThrowError(verr);	//might be VE_OK, which throws nothing.
+}
+
+
+VError XBsdTCPSocket::DoWriteBuffers(const VNetBuffer* inBuffers, uLONG inCount, uLONG* ioLen)
+{
+	// - Plain sockets only ; ioLen is always modified (set to 0 on error)
+	// - Caller should deal with special error VE_SOCK_WOULD_BLOCK
+
+	const uLONG kMaxIov=64;	//Remaining buffers go with the next call ; well below IOV_MAX on all our platforms.
+
+	struct iovec iov[kMaxIov];
+	
+	uLONG count=0;
+	
+	for(uLONG i=0 ; i<inCount && count<kMaxIov ; i++)
+	{
+		if(inBuffers[i].fLength==0)
+			continue;
+		
+		iov[count].iov_base=const_cast<void*>(inBuffers[i].fData);
+		iov[count].iov_len=inBuffers[i].fLength;
+		count++;
+	}
+
+	struct msghdr msg;
+	::memset(&msg, 0, sizeof(msg));
+	
+	msg.msg_iov=iov;
+	msg.msg_iovlen=count;
+
+	int flags=0;
+
+#if VERSION_LINUX
+	flags|=MSG_NOSIGNAL;
+#endif
+
+	ssize_t n=sendmsg(fSock, &msg, flags);
+
+	if(n>=0)
+	{
+		*ioLen=static_cast<uLONG>(n);
+		return VE_OK;
+	}
+
+	*ioLen=0;
+
+	if(errno==EWOULDBLOCK)
+		return VE_SOCK_WOULD_BLOCK;
+
+	if(errno==ECONNRESET || errno==ENOTSOCK || errno==EBADF)
+		return vThrowNativeCombo(VE_SOCK_CONNECTION_BROKEN, errno);
+
+	return vThrowNativeCombo(VE_SOCK_WRITE_FAILED, errno);
+}
+
+
+#if VERSION_LINUX
+
+VError XBsdTCPSocket::SendFile(int inFd, sLONG8 inOffset, uLONG* ioLen, sLONG inMsTimeout, sLONG* outMsSpent)
+{
+	// - ioLen is mandatory and always modified (set to 0 on error) ; partial send is not an error
+	// - With inMsTimeout <= 0, caller should deal with special error VE_SOCK_WOULD_BLOCK
+	
+	if(ioLen==NULL || inFd<0 || inOffset<0)
+		return vThrowError(VE_INVALID_PARAMETER);
+
+	if(fSslDelegate!=NULL)
+		return vThrowError(VE_UNIMPLEMENTED);	//Data must go through the SSL layer ; caller should fall back on regular writes.
+
+	uLONG len=0;
+	sLONG timeout=inMsTimeout;
+	sLONG spentTotal=0;
+	VError verr=VE_OK;
+
+	do
+	{
+		sLONG spentOnStep=0;
+
+		if(inMsTimeout>0)
+			verr=WaitForWrite(timeout, &spentOnStep);
+
+		if(verr==VE_OK)
+		{
+			off_t offset=static_cast<off_t>(inOffset);
+
+			ssize_t n=sendfile(fSock, inFd, &offset, *ioLen);
+
+			if(n>=0)
+			{
+				len=static_cast<uLONG>(n);
+				break;
+			}
+
+			if(errno==EWOULDBLOCK)
+				verr=VE_SOCK_WOULD_BLOCK;
+			else if(errno==ECONNRESET || errno==ENOTSOCK || errno==EBADF || errno==EPIPE)
+				verr=vThrowNativeCombo(VE_SOCK_CONNECTION_BROKEN, errno);
+			else
+				verr=vThrowNativeCombo(VE_SOCK_WRITE_FAILED, errno);
+		}
+
+		if(verr==VE_SOCK_WOULD_BLOCK && inMsTimeout>0)
+		{
+			//See DoWriteWithTimeout
+			VTask::Sleep(100);
+			timeout-=100;
+			spentTotal+=100;
+			verr=VE_OK;
+		}
+
+		timeout-=spentOnStep;
+		spentTotal+=spentOnStep;
+	}
+	while(verr==VE_OK && inMsTimeout>0);
+
+	*ioLen=len;
+
+	if(outMsSpent!=NULL)
+		*outMsSpent=spentTotal;
+
+	if(verr==VE_SOCK_WOULD_BLOCK)
+		return verr;
+	
+	return vThrowError(verr);	//might be VE_OK, which throws nothing.
+}
+
+#endif
+
+
 //static
 void XBsdTCPSocket::TrashWithTimeout(Socket inFd, sLONG inMsTimeout, sLONG* outMsSpent)
 {
@@ -64,6 +64,15 @@ class XTOOLBOX_API XBsdTCPSocket : public VObject
 	VError ReadWithTimeout(void* outBuff, uLONG* ioLen, sLONG inMsTimeout, sLONG* outMsSpent=NULL);
 	VError WriteWithTimeout(const void* inBuff, uLONG* ioLen, sLONG inMsTimeout, sLONG* outMsSpent=NULL, bool unusedWithEmptyTail=false);
 
+	//Scatter/gather write : sends as much of inBuffers as possible with a single system call (sendmsg), or as a single
+	//record with SSL. *outLen receives the count of bytes sent ; inMsTimeout <= 0 behaves like Write, > 0 like WriteWithTimeout.
+	VError WriteBuffers(const VNetBuffer* inBuffers, uLONG inCount, uLONG* outLen, sLONG inMsTimeout=0, sLONG* outMsSpent=NULL);
+
+#if VERSION_LINUX
+	//Sends up to *ioLen bytes of file inFd from inOffset with sendfile() ; data is not copied through user space. Not for SSL sockets.
+	VError SendFile(int inFd, sLONG8 inOffset, uLONG* ioLen, sLONG inMsTimeout=0, sLONG* outMsSpent=NULL);
+#endif
+
 	XBOX::VError SetNoDelay (bool inYesNo);
 	
 	VError PromoteToSSL(VKeyCertChain* inKeyCertChain=NULL);
@@ -76,13 +85,14 @@ class XTOOLBOX_API XBsdTCPSocket : public VObject
  private :
 	
 	XBsdTCPSocket(Socket inSock) :
-		fSock(inSock), fServicePort(kBAD_PORT), fProfile(NewSock), fSslDelegate(NULL) {}
+		fSock(inSock), fServicePort(kBAD_PORT), fProfile(NewSock), fSslDelegate(NULL), fSslRecord(NULL) {}
 	
 	VError DoRead(void* outBuff, uLONG* ioLen);
 	VError DoReadWithTimeout(void* outBuff, uLONG* ioLen, sLONG inMsTimeout, sLONG* outMsSpent=NULL);
 
 	VError DoWrite(const void* inBuff, uLONG* ioLen);
 	VError DoWriteWithTimeout(const void* inBuff, uLONG* ioLen, sLONG inMsTimeout, sLONG* outMsSpent=NULL);
+	VError DoWriteBuffers(const VNetBuffer* inBuffers, uLONG inCount, uLONG* ioLen);
 	
 	//Reads and discard data on Close with receive loop. Helps prevent TCP RST flag.
 	static void TrashWithTimeout(Socket inFd, sLONG inMsTimeout, sLONG* outMsSpent=NULL);
@@ -116,6 +126,9 @@ class XTOOLBOX_API XBsdTCPSocket : public VObject
 	SockProfile fProfile;
 	
 	VSslDelegate*	fSslDelegate;
+	
+	//Coalescing buffer for scatter/gather writes on SSL sockets ; its address must stay the same when SSL asks to retry a write.
+	char*			fSslRecord;
 };
 
 
@@ -97,6 +97,8 @@ XWinTCPSocket::~XWinTCPSocket()
 	
 	if(fSslDelegate!=NULL)
 		delete fSslDelegate;
+
+	delete[] fSslRecord;
 }
 
 
@@ -573,6 +575,141 @@ VError XWinTCPSocket::Write(const void* inBuff, uLONG* ioLen, bool inWithEmptyTa
 }
 
 
+VError XWinTCPSocket::WriteBuffers(const VNetBuffer* inBuffers, uLONG inCount, uLONG* outLen, sLONG inMsTimeout, sLONG* outMsSpent)
+{
+	// - inBuffers and outLen are mandatory ; outLen is always modified (set to 0 on error)
+	// - Partial write is not an error ; caller resumes after the *outLen first bytes.
+	// - With inMsTimeout <= 0, caller should deal with special error VE_SOCK_WOULD_BLOCK (as with Write)
+
+	if(inBuffers==NULL || outLen==NULL)
+		return vThrowError(VE_INVALID_PARAMETER);
+
+	*outLen=0;
+
+	if(outMsSpent!=NULL)
+		*outMsSpent=0;
+
+	while(inCount>0 && inBuffers->fLength==0)
+	{
+		inBuffers++;
+		inCount--;
+	}
+
+	if(inCount==0)
+		return VE_OK;
+
+	if(fSslDelegate!=NULL)
+	{
+		//Small buffers are coalesced in a single TLS record ; a large buffer is sent as is.
+		const void* buff=inBuffers[0].fData;
+		uLONG len=inBuffers[0].fLength;
+
+		if(inCount>1 && len<kMAX_COALESCED_SSL_WRITE)
+		{
+			if(fSslRecord==NULL)
+				fSslRecord=new char[kMAX_COALESCED_SSL_WRITE];
+
+			if(fSslRecord==NULL)
+				return vThrowError(VE_MEMORY_FULL);
+
+			len=CoalesceNetBuffers(inBuffers, inCount, fSslRecord, kMAX_COALESCED_SSL_WRITE);
+			buff=fSslRecord;
+		}
+
+		VError verr=(inMsTimeout>0) ? WriteWithTimeout(buff, &len, inMsTimeout, outMsSpent) : Write(buff, &len, false);
+
+		*outLen=len;
+
+		return verr;
+	}
+
+	if(inMsTimeout<=0)
+		return DoWriteBuffers(inBuffers, inCount, outLen);
+
+	VError verr=VE_OK;
+	uLONG len=0;
+	sLONG timeout=inMsTimeout;
+	sLONG spentTotal=0;
+
+	do
+	{
+		len=0;
+
+		sLONG spentOnStep=0;
+
+		verr=WaitForWrite(timeout, &spentOnStep);
+
+		if(verr==VE_OK)
+			verr=DoWriteBuffers(inBuffers, inCount, &len);
+
+		if(len>0)	//We sent some data ; that's enough for now.
+			break;
+
+		if(verr==VE_SOCK_WOULD_BLOCK)
+		{
+			//Prevent a mad loop with a small sleep, and retry...
+			VTask::Sleep(100);
+			timeout-=100;
+			spentTotal+=100;
+			verr=VE_OK;
+		}
+
+		timeout-=spentOnStep;
+		spentTotal+=spentOnStep;
+	}
+	while(verr==VE_OK);
+
+	*outLen=len;
+
+	if(outMsSpent!=NULL)
+		*outMsSpent=spentTotal;
+
+	return vThrowError(verr);	//might be VE_OK, which throws nothing.
+}
+
+
+VError XWinTCPSocket::DoWriteBuffers(const VNetBuffer* inBuffers, uLONG inCount, uLONG* ioLen)
+{
+	const uLONG kMaxBuf=64;	//Remaining buffers go with the next call
+
+	WSABUF bufs[kMaxBuf];
+
+	DWORD count=0;
+
+	for(uLONG i=0 ; i<inCount && count<kMaxBuf ; i++)
+	{
+		if(inBuffers[i].fLength==0)
+			continue;
+
+		bufs[count].buf=reinterpret_cast<char*>(const_cast<void*>(inBuffers[i].fData));
+		bufs[count].len=inBuffers[i].fLength;
+		count++;
+	}
+
+	DWORD sent=0;
+
+	int res=WSASend(fSock, bufs, count, &sent, 0 /*flags*/, NULL, NULL);
+
+	if(res==0)
+	{
+		*ioLen=sent;
+		return VE_OK;
+	}
+
+	*ioLen=0;
+
+	int	lastError	= WSAGetLastError();
+
+	if(lastError==WSAEWOULDBLOCK)
+		return VE_SOCK_WOULD_BLOCK;
+
+	if(lastError==WSAECONNRESET || lastError==WSAENOTSOCK || lastError==WSAEBADF)
+		return vThrowNativeCombo(VE_SOCK_CONNECTION_BROKEN, lastError);
+
+	return vThrowNativeCombo(VE_SOCK_WRITE_FAILED, lastError);
+}
+
+
 VError XWinTCPSocket::ReadWithTimeout(void* outBuff, uLONG* ioLen, sLONG inMsTimeout, sLONG* outMsSpent)
 {
 	if(outBuff==NULL || ioLen==NULL)
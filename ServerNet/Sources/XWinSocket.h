@@ -62,6 +62,10 @@ class XTOOLBOX_API XWinTCPSocket : public VObject
 	VError ReadWithTimeout(void* outBuff, uLONG* ioLen, sLONG inMsTimeout, sLONG* outMsSpent=NULL);
 	VError WriteWithTimeout(const void* inBuff, uLONG* ioLen, sLONG inMsTimeout, sLONG* outMsSpent=NULL, bool unusedWithEmptyTail=false);
 
+	//Scatter/gather write : sends as much of inBuffers as possible with a single system call (WSASend), or as a single
+	//record with SSL. *outLen receives the count of bytes sent ; inMsTimeout <= 0 behaves like Write, > 0 like WriteWithTimeout.
+	VError WriteBuffers(const VNetBuffer* inBuffers, uLONG inCount, uLONG* outLen, sLONG inMsTimeout=0, sLONG* outMsSpent=NULL);
+
 	XBOX::VError SetNoDelay (bool inYesNo);
 	
 	VError PromoteToSSL(VKeyCertChain* inKeyCertChain=NULL);
@@ -76,7 +80,9 @@ class XTOOLBOX_API XWinTCPSocket : public VObject
  private :
 
 	XWinTCPSocket(Socket inSock) :
-		fSock(inSock), fServicePort(kBAD_PORT), fProfile(NewSock), fSslDelegate(NULL) {}
+		fSock(inSock), fServicePort(kBAD_PORT), fProfile(NewSock), fSslDelegate(NULL), fSslRecord(NULL) {}
+
+	VError DoWriteBuffers(const VNetBuffer* inBuffers, uLONG inCount, uLONG* ioLen);
 
 	//Reads and discard data on Close with receive loop. Helps prevent TCP RST flag.
 	static void TrashWithTimeout(Socket inFd, sLONG inMsTimeout, sLONG* outMsSpent=NULL);
@@ -111,6 +117,9 @@ class XTOOLBOX_API XWinTCPSocket : public VObject
 	bool fIsBlocking;
 
 	VSslDelegate*	fSslDelegate;
+
+	//Coalescing buffer for scatter/gather writes on SSL sockets ; its address must stay the same when SSL asks to retry a write.
+	char*			fSslRecord;
 };
 
 